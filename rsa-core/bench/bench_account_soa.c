@@ -0,0 +1,134 @@
+#include "rsa_account_soa.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Payment apply over rsa_account_t records vs the hot/cold SoA layout:
+// debit the source, credit the destination, bump the source sequence.
+//
+//   rsa-bench-account-soa [accounts]      default: 500000
+
+#define BENCH_PAYMENTS 5000000
+
+// With an index store: a re-appended id updates its row, and set keeps the
+// store's cached fields current. Returns true when both hold.
+static bool check_store_sync(const rsa_account_t *records, size_t count) {
+    rsa_account_soa_t soa;
+    rsa_account_store_t store;
+    if (!rsa_account_soa_init(&soa, count) || !rsa_account_store_init(&store, count)) return false;
+
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) {
+        ok &= rsa_account_soa_append(&soa, &records[i], &store) == (uint32_t)i;
+    }
+
+    rsa_account_t account = records[1];
+    account.balance += 7;
+    ok &= rsa_account_soa_append(&soa, &account, &store) == 1 && soa.count == count;
+    const rsa_account_entry_t *entry = rsa_account_store_find(&store, account.account_id);
+    ok &= entry && entry->index == 1 && entry->balance == account.balance &&
+          soa.balances[1] == account.balance;
+
+    account.seq_num += 3;
+    account.flags = RSA_AUTH_REQUIRED_FLAG;
+    ok &= rsa_account_soa_set(&soa, 1, &account, &store);
+    ok &= entry->seq_num == account.seq_num && entry->flags == account.flags;
+
+    // A different id at row 1 would strand the store's entry for it
+    ok &= !rsa_account_soa_set(&soa, 1, &records[0], &store);
+
+    rsa_account_store_free(&store);
+    rsa_account_soa_free(&soa);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    size_t accounts = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 500000;
+    if (accounts < 2) {
+        fprintf(stderr, "need at least 2 accounts\n");
+        return 1;
+    }
+
+    rsa_account_t *records = calloc(accounts, sizeof(rsa_account_t));
+    uint32_t *pairs = malloc(2 * BENCH_PAYMENTS * sizeof(uint32_t));
+    rsa_account_soa_t soa;
+    if (!records || !pairs || !rsa_account_soa_init(&soa, accounts)) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+
+    uint64_t seed = 0x243F6A8885A308D3ULL;
+    for (size_t i = 0; i < accounts; i++) {
+        rsa_account_t *account = &records[i];
+        for (int w = 0; w < 8; w++) account->account_id[w] = (uint32_t)bench_rand(&seed);
+        account->balance = 1000000000;
+        account->seq_num = 1;
+        account->thresholds.master_weight = 1;
+        // One account in 16 has signers and a home domain
+        if (i % 16 == 0) {
+            account->signer_count = 2;
+            account->home_domain_len = 11;
+            memcpy(account->home_domain, "example.com", 11);
+        }
+        if (rsa_account_soa_append(&soa, account, NULL) == RSA_ACCOUNT_NO_INDEX) {
+            fprintf(stderr, "append failed\n");
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < 2 * BENCH_PAYMENTS; i++) {
+        pairs[i] = (uint32_t)(bench_rand(&seed) % accounts);
+    }
+
+    printf("-- %zu accounts, %d payments\n", accounts, BENCH_PAYMENTS);
+    printf("%-40s %10.2f MB\n", "  rsa_account_t records",
+           (double)(accounts * sizeof(rsa_account_t)) / (1024.0 * 1024.0));
+    printf("%-40s %10.2f MB\n", "  SoA hot + cold",
+           (double)rsa_account_soa_memory(&soa) / (1024.0 * 1024.0));
+
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < BENCH_PAYMENTS; i++) {
+        rsa_account_t *from = &records[pairs[2 * i]];
+        rsa_account_t *to = &records[pairs[2 * i + 1]];
+        if (from->balance >= 100 && !(from->flags & RSA_AUTH_REQUIRED_FLAG)) {
+            from->balance -= 100;
+            from->seq_num++;
+            to->balance += 100;
+        }
+    }
+    bench_report("payment apply (rsa_account_t)", bench_now_ns() - start, BENCH_PAYMENTS);
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < BENCH_PAYMENTS; i++) {
+        uint32_t from = pairs[2 * i];
+        uint32_t to = pairs[2 * i + 1];
+        if (soa.balances[from] >= 100 && !(soa.flags[from] & RSA_AUTH_REQUIRED_FLAG)) {
+            soa.balances[from] -= 100;
+            soa.seq_nums[from]++;
+            soa.balances[to] += 100;
+        }
+    }
+    bench_report("payment apply (SoA)", bench_now_ns() - start, BENCH_PAYMENTS);
+
+    // Round trip through the full record must be lossless
+    size_t mismatches = 0;
+    rsa_account_t converted;
+    for (size_t i = 0; i < accounts; i++) {
+        rsa_account_soa_get(&soa, (uint32_t)i, &converted);
+        if (memcmp(&converted, &records[i], sizeof(converted)) != 0) mismatches++;
+    }
+    if (mismatches) {
+        fprintf(stderr, "%zu accounts differ between layouts\n", mismatches);
+        return 1;
+    }
+    if (!check_store_sync(records, accounts < 1024 ? accounts : 1024)) {
+        fprintf(stderr, "index store out of sync with the rows\n");
+        return 1;
+    }
+
+    bench_sink = (uint64_t)soa.balances[0];
+    rsa_account_soa_free(&soa);
+    free(records);
+    free(pairs);
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "rsa_account_store.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Account store benchmark: insert (with incremental growth), point lookup
+// hits and misses, prefetched batch lookup and balance/sequence updates.
+// First, crafted ids that vary in one 64-bit lane only, the others pinned
+// to zero and to constants an unkeyed mix would cancel, are inserted under
+// several keys; their hashes must spread over both halves like random ids
+// or the run fails.
+//
+//   rsa-bench-account-store [entries...]     default: 1000000 10000000
+//
+// 50M entries need about 6 GB of RAM (4.2 GB table plus the old table
+// while the last resize drains).
+
+#define BENCH_LOOKUPS 5000000
+#define BENCH_BATCH 1024
+#define BENCH_CRAFTED 16384             // ids per crafted family
+#define BENCH_CRAFTED_BUCKETS 1024      // 16 ids per bucket expected
+#define BENCH_CRAFTED_KEYS 4
+
+// Account ids are derived from an index so no key array is kept around
+static void bench_account_id(uint64_t index, uint32_t id[8]) {
+    uint64_t state = index * 0x9E3779B97F4A7C15ULL + 1;
+    uint64_t words[4];
+    for (int i = 0; i < 4; i++) {
+        words[i] = bench_rand(&state);
+    }
+    memcpy(id, words, sizeof(words));
+}
+
+// Most ids sharing one bucket of the low or the high 10 bits of the hash
+static size_t bench_crafted_crowding(const rsa_hash_key_t *key, uint32_t (*ids)[8]) {
+    static uint32_t low[BENCH_CRAFTED_BUCKETS], high[BENCH_CRAFTED_BUCKETS];
+    size_t worst = 0;
+    memset(low, 0, sizeof(low));
+    memset(high, 0, sizeof(high));
+    for (size_t i = 0; i < BENCH_CRAFTED; i++) {
+        uint64_t hash = rsa_hash_32(key, ids[i]);
+        size_t l = ++low[hash % BENCH_CRAFTED_BUCKETS];
+        size_t h = ++high[hash >> 54];
+        if (l > worst) worst = l;
+        if (h > worst) worst = h;
+    }
+    return worst;
+}
+
+static int bench_crafted(void) {
+    static const uint64_t pinned[4] = {0, 0xE7037ED1A0B428DBULL, 0x8EBC6AF09C88C6E3ULL,
+                                       0x589965CC75374CC3ULL};
+    uint32_t (*ids)[8] = malloc(BENCH_CRAFTED * sizeof(*ids));
+    if (!ids) return 1;
+    printf("-- %d crafted ids per lane\n", BENCH_CRAFTED);
+
+    int rc = 0;
+    for (int k = 0; k < BENCH_CRAFTED_KEYS && rc == 0; k++) {
+        rsa_account_store_t store;
+        if (!rsa_account_store_init(&store, 4 * BENCH_CRAFTED)) {
+            rc = 1;
+            break;
+        }
+        for (int lane = 0; lane < 4 && rc == 0; lane++) {
+            for (size_t i = 0; i < BENCH_CRAFTED; i++) {
+                uint64_t words[4];
+                memcpy(words, pinned, sizeof(words));
+                words[lane] ^= i + (uint64_t)lane * BENCH_CRAFTED;  // distinct across lanes
+                memcpy(ids[i], words, sizeof(words));
+            }
+            size_t worst = bench_crafted_crowding(&store.key, ids);
+            uint64_t start = bench_now_ns();
+            for (size_t i = 0; i < BENCH_CRAFTED && rc == 0; i++) {
+                bool inserted = false;
+                if (!rsa_account_store_upsert(&store, ids[i], &inserted) || !inserted) {
+                    fprintf(stderr, "crafted insert %zu failed\n", i);
+                    rc = 1;
+                }
+            }
+            if (k == 0) {
+                char name[64];
+                snprintf(name, sizeof(name), "insert crafted, lane %d", lane);
+                bench_report(name, bench_now_ns() - start, BENCH_CRAFTED);
+            }
+            if (rc == 0 && worst > 4 * BENCH_CRAFTED / BENCH_CRAFTED_BUCKETS) {
+                fprintf(stderr, "crafted ids varying lane %d collide: %zu in one bucket\n",
+                        lane, worst);
+                rc = 1;
+            }
+        }
+        rsa_account_store_free(&store);
+    }
+    free(ids);
+    return rc;
+}
+
+static int bench_store(size_t entries) {
+    rsa_account_store_t store;
+    if (!rsa_account_store_init(&store, 0)) {
+        fprintf(stderr, "store init failed\n");
+        return 1;
+    }
+
+    char name[64];
+    uint32_t id[8];
+    printf("-- %zu entries\n", entries);
+
+    // Insert from an empty store; the worst single insert shows that no
+    // resize stops the world
+    uint64_t worst_ns = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < entries; i++) {
+        bench_account_id(i, id);
+        uint64_t t0 = (i & 1023) == 0 ? bench_now_ns() : 0;
+        bool inserted = false;
+        rsa_account_entry_t *entry = rsa_account_store_upsert(&store, id, &inserted);
+        if (!entry || !inserted) {
+            fprintf(stderr, "insert %zu failed\n", i);
+            rsa_account_store_free(&store);
+            return 1;
+        }
+        entry->balance = (int64_t)i;
+        entry->seq_num = 1;
+        if (t0) {
+            uint64_t dt = bench_now_ns() - t0;
+            if (dt > worst_ns) worst_ns = dt;
+        }
+    }
+    snprintf(name, sizeof(name), "insert");
+    bench_report(name, bench_now_ns() - start, entries);
+    printf("%-40s %10.2f us (sampled)\n", "  worst single insert", (double)worst_ns / 1000.0);
+    printf("%-40s %10.2f MB\n", "  table memory",
+           (double)rsa_account_store_memory(&store) / (1024.0 * 1024.0));
+
+    uint64_t seed = 0xD1B54A32D192ED03ULL;
+    uint64_t sum = 0;
+    size_t misses = 0;
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        bench_account_id(bench_rand(&seed) % entries, id);
+        rsa_account_entry_t *entry = rsa_account_store_find(&store, id);
+        if (entry) sum += (uint64_t)entry->balance; else misses++;
+    }
+    bench_report("lookup hit", bench_now_ns() - start, BENCH_LOOKUPS);
+
+    uint32_t (*batch_ids)[8] = malloc(BENCH_BATCH * sizeof(*batch_ids));
+    rsa_account_entry_t **batch_out = malloc(BENCH_BATCH * sizeof(*batch_out));
+    if (!batch_ids || !batch_out) {
+        fprintf(stderr, "allocation failed\n");
+        free(batch_ids);
+        free(batch_out);
+        rsa_account_store_free(&store);
+        return 1;
+    }
+    start = bench_now_ns();
+    for (size_t done = 0; done < BENCH_LOOKUPS; done += BENCH_BATCH) {
+        for (size_t i = 0; i < BENCH_BATCH; i++) {
+            bench_account_id(bench_rand(&seed) % entries, batch_ids[i]);
+        }
+        size_t hits = rsa_account_store_find_batch(&store, (const uint32_t (*)[8])batch_ids,
+                                                   BENCH_BATCH, batch_out);
+        misses += BENCH_BATCH - hits;
+        sum += (uint64_t)batch_out[0]->balance;
+    }
+    bench_report("lookup hit (batch)", bench_now_ns() - start,
+                 (BENCH_LOOKUPS + BENCH_BATCH - 1) / BENCH_BATCH * BENCH_BATCH);
+
+    start = bench_now_ns();
+    size_t found = 0;
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        bench_account_id(entries + bench_rand(&seed) % entries, id);
+        found += rsa_account_store_find(&store, id) != NULL;
+    }
+    bench_report("lookup miss", bench_now_ns() - start, BENCH_LOOKUPS);
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        bench_account_id(bench_rand(&seed) % entries, id);
+        rsa_account_entry_t *entry = rsa_account_store_find(&store, id);
+        if (entry) {
+            entry->balance -= 100;
+            entry->seq_num++;
+        }
+    }
+    bench_report("update (balance, seq_num)", bench_now_ns() - start, BENCH_LOOKUPS);
+
+    if (misses != 0 || found != 0 || rsa_account_store_size(&store) != entries) {
+        fprintf(stderr, "consistency check failed: %zu false misses, %zu false hits\n",
+                misses, found);
+        free(batch_ids);
+        free(batch_out);
+        rsa_account_store_free(&store);
+        return 1;
+    }
+
+    bench_sink = sum;
+    free(batch_ids);
+    free(batch_out);
+    rsa_account_store_free(&store);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t defaults[] = {1000000, 10000000};
+    int rc = bench_crafted();
+
+    if (argc > 1) {
+        for (int i = 1; i < argc && rc == 0; i++) {
+            size_t entries = (size_t)strtoull(argv[i], NULL, 10);
+            if (entries == 0) {
+                fprintf(stderr, "invalid entry count: %s\n", argv[i]);
+                return 1;
+            }
+            rc = bench_store(entries);
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]) && rc == 0; i++) {
+            rc = bench_store(defaults[i]);
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,228 @@
+#include "rsa_token.h"
+#include "rsa_amount.h"
+#include "rsa_price.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Amount codec benchmark: exact SWAR codec vs the previous double-based
+// rsa_parse_amount()/rsa_format_amount() implementations. Also self-checks the
+// exact price arithmetic on its rounding and overflow edges.
+
+#define BENCH_AMOUNT_COUNT 1000000
+#define BENCH_AMOUNT_ROUNDS 5
+
+// Previous implementations, kept here as the baseline
+static int64_t legacy_parse_amount(const char *amount_str) {
+    double amount = atof(amount_str);
+    return (int64_t)(amount * 10000000.0);
+}
+
+static void legacy_format_amount(int64_t amount, char *amount_str) {
+    double value = (double)amount / 10000000.0;
+    sprintf(amount_str, "%.7f", value);
+
+    int len = strlen(amount_str);
+    while (len > 0 && amount_str[len-1] == '0') {
+        len--;
+    }
+    if (len > 0 && amount_str[len-1] == '.') {
+        len--;
+    }
+    amount_str[len] = '\0';
+}
+
+// Edge cases of the exact price math; returns the number of failures
+static size_t check_price_math(void) {
+    static const struct {
+        int64_t amount;
+        rsa_price_t price;
+        rsa_rounding_t mode;
+        bool divide;
+        rsa_price_status_t status;
+        int64_t expect;
+    } cases[] = {
+        // 7 * 1/2 = 3.5 and -3.5
+        { 7, { 1, 2 }, RSA_ROUND_FLOOR, false, RSA_PRICE_OK, 3 },
+        { 7, { 1, 2 }, RSA_ROUND_CEIL, false, RSA_PRICE_OK, 4 },
+        { 7, { 1, 2 }, RSA_ROUND_HALF_EVEN, false, RSA_PRICE_OK, 4 },
+        { 5, { 1, 2 }, RSA_ROUND_HALF_EVEN, false, RSA_PRICE_OK, 2 },
+        { -7, { 1, 2 }, RSA_ROUND_FLOOR, false, RSA_PRICE_OK, -4 },
+        { -7, { 1, 2 }, RSA_ROUND_CEIL, false, RSA_PRICE_OK, -3 },
+        { -7, { 1, 2 }, RSA_ROUND_HALF_EVEN, false, RSA_PRICE_OK, -4 },
+        { -5, { 1, 2 }, RSA_ROUND_HALF_EVEN, false, RSA_PRICE_OK, -2 },
+        // 10 / (3/1): not a tie, nearest is 3
+        { 10, { 3, 1 }, RSA_ROUND_HALF_EVEN, true, RSA_PRICE_OK, 3 },
+        { 10, { 3, 1 }, RSA_ROUND_CEIL, true, RSA_PRICE_OK, 4 },
+        // The same ties above the 2^32 fast path
+        { (1LL << 40) + 1, { 1, 2 }, RSA_ROUND_HALF_EVEN, false, RSA_PRICE_OK, 1LL << 39 },
+        { (1LL << 40) + 3, { 1, 2 }, RSA_ROUND_HALF_EVEN, false, RSA_PRICE_OK, (1LL << 39) + 2 },
+        { -(1LL << 40) - 1, { 1, 2 }, RSA_ROUND_FLOOR, false, RSA_PRICE_OK, -(1LL << 39) - 1 },
+        // Exact at the int64 limits, overflow one step past them
+        { INT64_MAX, { 1, 1 }, RSA_ROUND_FLOOR, false, RSA_PRICE_OK, INT64_MAX },
+        { INT64_MIN, { 1, 1 }, RSA_ROUND_FLOOR, true, RSA_PRICE_OK, INT64_MIN },
+        { INT64_MAX, { 2, 1 }, RSA_ROUND_FLOOR, false, RSA_PRICE_ERR_OVERFLOW, 0 },
+        { INT64_MIN, { 1, 2 }, RSA_ROUND_FLOOR, true, RSA_PRICE_ERR_OVERFLOW, 0 },
+        { INT64_MAX / 2 + 1, { 2, 1 }, RSA_ROUND_FLOOR, false, RSA_PRICE_ERR_OVERFLOW, 0 },
+        { INT64_MAX, { INT32_MAX, INT32_MAX }, RSA_ROUND_CEIL, false, RSA_PRICE_OK, INT64_MAX },
+        // Invalid prices
+        { 1, { 0, 1 }, RSA_ROUND_FLOOR, false, RSA_PRICE_ERR_INVALID, 0 },
+        { 1, { 1, 0 }, RSA_ROUND_FLOOR, true, RSA_PRICE_ERR_INVALID, 0 },
+        { 1, { -1, 2 }, RSA_ROUND_FLOOR, false, RSA_PRICE_ERR_INVALID, 0 },
+    };
+
+    size_t failures = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int64_t out = -1;
+        rsa_price_status_t s = cases[i].divide
+            ? rsa_amount_div_price(cases[i].amount, &cases[i].price, cases[i].mode, &out)
+            : rsa_amount_mul_price(cases[i].amount, &cases[i].price, cases[i].mode, &out);
+        if (s != cases[i].status || out != cases[i].expect) {
+            fprintf(stderr, "price case %zu: status %d value %lld, expected %d %lld\n",
+                    i, (int)s, (long long)out, (int)cases[i].status,
+                    (long long)cases[i].expect);
+            failures++;
+        }
+    }
+
+    // mul_div: a negative divisor flips the sign, zero is refused
+    int64_t out = 0;
+    if (rsa_amount_mul_div(7, 1, -2, RSA_ROUND_FLOOR, &out) != RSA_PRICE_OK || out != -4) failures++;
+    if (rsa_amount_mul_div(INT64_MAX, INT64_MAX, INT64_MAX, RSA_ROUND_FLOOR, &out) != RSA_PRICE_OK ||
+        out != INT64_MAX) failures++;
+    if (rsa_amount_mul_div(1, 1, 0, RSA_ROUND_FLOOR, &out) != RSA_PRICE_ERR_INVALID) failures++;
+
+    // The 64-bit fast path must agree with the 128-bit path around 2^32
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 100000; i++) {
+        uint64_t r = bench_rand(&seed);
+        int64_t amount = (int64_t)(1ULL << 32) - 512 + (int64_t)(r % 1024);
+        if (r & (1ULL << 40)) amount = -amount;
+        rsa_price_t price = { (int32_t)(bench_rand(&seed) % INT32_MAX) + 1,
+                              (int32_t)(bench_rand(&seed) % INT32_MAX) + 1 };
+        rsa_rounding_t mode = (rsa_rounding_t)(r % 3);
+        int64_t fast = 0, wide = 0;
+        rsa_price_status_t a = rsa_amount_mul_price(amount, &price, mode, &fast);
+        rsa_price_status_t b = rsa_amount_mul_div(amount, price.n, price.d, mode, &wide);
+        if (a != b || fast != wide) failures++;
+    }
+
+    // Batch forms count the failed entries and zero their outputs
+    const int64_t amounts[3] = { 10, INT64_MAX, 10 };
+    const rsa_price_t prices[3] = { { 3, 2 }, { 3, 2 }, { 0, 2 } };
+    int64_t results[3];
+    uint8_t status[3];
+    if (rsa_amount_mul_price_batch(amounts, prices, 3, RSA_ROUND_FLOOR, results, status) != 2 ||
+        results[0] != 15 || results[1] != 0 || results[2] != 0 ||
+        status[0] != RSA_PRICE_OK || status[1] != RSA_PRICE_ERR_OVERFLOW ||
+        status[2] != RSA_PRICE_ERR_INVALID) failures++;
+    if (rsa_amount_div_price_batch(amounts, prices, 3, RSA_ROUND_CEIL, results, NULL) != 1 ||
+        results[0] != 7 || results[1] != 6148914691236517205LL) failures++;
+
+    return failures;
+}
+
+int main(void) {
+    int64_t *amounts = malloc(BENCH_AMOUNT_COUNT * sizeof(int64_t));
+    int64_t *parsed = malloc(BENCH_AMOUNT_COUNT * sizeof(int64_t));
+    char *text = malloc((size_t)BENCH_AMOUNT_COUNT * RSA_AMOUNT_BUFFER_SIZE);
+    const char **strs = malloc(BENCH_AMOUNT_COUNT * sizeof(char *));
+    size_t *lens = malloc(BENCH_AMOUNT_COUNT * sizeof(size_t));
+    if (!amounts || !parsed || !text || !strs || !lens) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+
+    // Mix of small payments and large balances up to the full int64 range
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < BENCH_AMOUNT_COUNT; i++) {
+        uint64_t r = bench_rand(&seed);
+        int64_t v = (i & 1) ? (int64_t)(r % 100000000000ULL) : (int64_t)(r >> 1);
+        amounts[i] = (i % 7 == 0) ? -v : v;
+    }
+
+    rsa_amount_format_batch(amounts, BENCH_AMOUNT_COUNT, text, RSA_AMOUNT_BUFFER_SIZE,
+                            lens, RSA_AMOUNT_FORMAT_FIXED);
+    for (size_t i = 0; i < BENCH_AMOUNT_COUNT; i++) {
+        strs[i] = text + i * RSA_AMOUNT_BUFFER_SIZE;
+    }
+
+    // Correctness: exact round trip, and how often the legacy path is off
+    size_t exact_mismatch = 0, legacy_mismatch = 0;
+    for (size_t i = 0; i < BENCH_AMOUNT_COUNT; i++) {
+        int64_t v = 0;
+        if (rsa_amount_parse(strs[i], lens[i], &v) != RSA_AMOUNT_OK || v != amounts[i]) {
+            exact_mismatch++;
+        }
+        if (legacy_parse_amount(strs[i]) != amounts[i]) {
+            legacy_mismatch++;
+        }
+    }
+    printf("round trip mismatches: exact %zu, legacy %zu (of %d)\n",
+           exact_mismatch, legacy_mismatch, BENCH_AMOUNT_COUNT);
+
+    size_t price_failures = check_price_math();
+    printf("price math edge cases: %s\n\n", price_failures == 0 ? "ok" : "FAILED");
+
+    const uint64_t items = (uint64_t)BENCH_AMOUNT_COUNT * BENCH_AMOUNT_ROUNDS;
+    uint64_t acc = 0, start;
+    char buf[64];
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_AMOUNT_ROUNDS; r++) {
+        for (size_t i = 0; i < BENCH_AMOUNT_COUNT; i++) {
+            acc += (uint64_t)legacy_parse_amount(strs[i]);
+        }
+    }
+    bench_report("parse   legacy atof", bench_now_ns() - start, items);
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_AMOUNT_ROUNDS; r++) {
+        for (size_t i = 0; i < BENCH_AMOUNT_COUNT; i++) {
+            acc += (uint64_t)rsa_parse_amount(strs[i]);
+        }
+    }
+    bench_report("parse   rsa_parse_amount", bench_now_ns() - start, items);
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_AMOUNT_ROUNDS; r++) {
+        acc += rsa_amount_parse_batch(strs, lens, BENCH_AMOUNT_COUNT, parsed, NULL);
+    }
+    bench_report("parse   rsa_amount_parse_batch", bench_now_ns() - start, items);
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_AMOUNT_ROUNDS; r++) {
+        for (size_t i = 0; i < BENCH_AMOUNT_COUNT; i++) {
+            legacy_format_amount(amounts[i], buf);
+            acc += (uint64_t)buf[0];
+        }
+    }
+    bench_report("format  legacy sprintf", bench_now_ns() - start, items);
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_AMOUNT_ROUNDS; r++) {
+        for (size_t i = 0; i < BENCH_AMOUNT_COUNT; i++) {
+            rsa_format_amount(amounts[i], buf);
+            acc += (uint64_t)buf[0];
+        }
+    }
+    bench_report("format  rsa_format_amount", bench_now_ns() - start, items);
+
+    start = bench_now_ns();
+    for (int r = 0; r < BENCH_AMOUNT_ROUNDS; r++) {
+        rsa_amount_format_batch(amounts, BENCH_AMOUNT_COUNT, text, RSA_AMOUNT_BUFFER_SIZE,
+                                lens, RSA_AMOUNT_FORMAT_FIXED);
+        acc += lens[r];
+    }
+    bench_report("format  rsa_amount_format_batch", bench_now_ns() - start, items);
+
+    bench_sink = acc;
+
+    free(amounts);
+    free(parsed);
+    free(text);
+    free(strs);
+    free(lens);
+    return exact_mismatch == 0 && price_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include "rsa_arena.h"
+#include "bench_util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per-ledger transient objects: every "ledger", each of `threads` workers
+// allocates its share of `objects` small objects (16 to 256 bytes, as
+// undo records and result buffers are) and writes them; then everything
+// is released, by rsa_arena_reset() for the arena and by free() of each
+// object for malloc. The first ledger is not timed, so both allocators
+// start warm. Per-object cost should stay flat as threads are added for
+// the arena; malloc pays for its arenas and frees.
+//
+//   rsa-bench-arena [objects per ledger] [ledgers] [threads]     default: 100000 100 4
+
+#define BENCH_MAX_THREADS 64
+
+typedef struct {
+    rsa_arena_t *arena;                 // NULL = malloc
+    void **objects;                     // malloc only, freed per ledger
+    size_t count;
+    uint64_t seed;
+    uint64_t sum;
+    bool failed;
+} bench_worker_t;
+
+static void *bench_alloc_worker(void *arg) {
+    bench_worker_t *worker = arg;
+    for (size_t i = 0; i < worker->count; i++) {
+        size_t size = 16 + (size_t)(bench_rand(&worker->seed) % 241);
+        uint8_t *p = worker->arena ? rsa_arena_alloc(worker->arena, size, 16) : malloc(size);
+        if (!p) {
+            worker->failed = true;
+            return NULL;
+        }
+        memset(p, (int)i, size);
+        worker->sum += p[size - 1];
+        if (!worker->arena) worker->objects[i] = p;
+    }
+    if (!worker->arena) {
+        for (size_t i = 0; i < worker->count; i++) free(worker->objects[i]);
+    }
+    return NULL;
+}
+
+// Runs one ledger's allocations on `threads` workers; false on failure
+static bool bench_ledger(bench_worker_t *workers, unsigned threads, uint64_t *sum) {
+    pthread_t handles[BENCH_MAX_THREADS];
+    for (unsigned t = 1; t < threads; t++) {
+        pthread_create(&handles[t], NULL, bench_alloc_worker, &workers[t]);
+    }
+    bench_alloc_worker(&workers[0]);
+    bool ok = !workers[0].failed;
+    for (unsigned t = 1; t < threads; t++) {
+        pthread_join(handles[t], NULL);
+        ok = ok && !workers[t].failed;
+    }
+    for (unsigned t = 0; t < threads; t++) *sum += workers[t].sum;
+    return ok;
+}
+
+static bool bench_run(const char *name, rsa_arena_t *arena, size_t objects, size_t ledgers,
+                      unsigned threads) {
+    bench_worker_t workers[BENCH_MAX_THREADS];
+    size_t share = objects / threads;
+    memset(workers, 0, sizeof(workers));
+    for (unsigned t = 0; t < threads; t++) {
+        workers[t].arena = arena;
+        workers[t].count = share;
+        workers[t].seed = 0x9E3779B97F4A7C15ULL * (t + 1);
+        if (!arena && !(workers[t].objects = malloc(share * sizeof(void *)))) return false;
+    }
+
+    uint64_t sum = 0, elapsed = 0;
+    bool ok = true;
+    for (size_t l = 0; ok && l <= ledgers; l++) {
+        uint64_t start = bench_now_ns();
+        ok = bench_ledger(workers, threads, &sum);
+        if (arena) rsa_arena_reset(arena);
+        if (l > 0) elapsed += bench_now_ns() - start;
+    }
+    for (unsigned t = 0; t < threads; t++) free(workers[t].objects);
+    if (!ok) return false;
+    bench_report(name, elapsed, (uint64_t)share * threads * ledgers);
+    bench_sink = sum;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    size_t objects = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    size_t ledgers = argc > 2 ? strtoull(argv[2], NULL, 10) : 100;
+    unsigned threads = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 4;
+    if (threads < 1) threads = 1;
+    if (threads > BENCH_MAX_THREADS) threads = BENCH_MAX_THREADS;
+
+    printf("-- %zu objects per ledger, %zu ledgers, %u threads\n", objects, ledgers, threads);
+    for (unsigned t = 1; t <= threads; t *= 2) {
+        char name[64];
+        rsa_arena_t arena;
+        if (!rsa_arena_init(&arena, NULL)) {
+            fprintf(stderr, "arena init failed\n");
+            return 1;
+        }
+        snprintf(name, sizeof(name), "arena, %u thread(s)", t);
+        bool ok = bench_run(name, &arena, objects, ledgers, t);
+        if (ok) {
+            printf("%-40s %10zu chunks %10.1f MB reserved\n", "", arena.chunks,
+                   (double)arena.reserved / 1e6);
+        }
+        rsa_arena_free(&arena);
+        snprintf(name, sizeof(name), "malloc/free, %u thread(s)", t);
+        ok = ok && bench_run(name, NULL, objects, ledgers, t);
+        if (!ok) {
+            fprintf(stderr, "allocation failed\n");
+            return 1;
+        }
+        if (t < threads && t * 2 > threads) t = threads / 2;  // end on `threads`
+    }
+
+    rsa_arena_t huge;
+    rsa_arena_config_t config = {0, true};
+    if (rsa_arena_init(&huge, &config)) {
+        char name[64];
+        snprintf(name, sizeof(name), "arena, huge pages, %u thread(s)", threads);
+        bench_run(name, &huge, objects, ledgers, threads);
+        rsa_arena_free(&huge);
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "rsa_csv.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// CSV codec benchmark: write N (address, amount) rows, read them back in
+// batches and verify every row. Usage: rsa-bench-csv [rows] [path]
+
+#define BENCH_CSV_DEFAULT_ROWS 1000000
+
+int main(int argc, char **argv) {
+    size_t rows = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : BENCH_CSV_DEFAULT_ROWS;
+    const char *path = argc > 2 ? argv[2] : "/tmp/rsa-bench-payout.csv";
+
+    uint8_t (*keys)[RSA_PUBLIC_KEY_LENGTH] = malloc(rows * sizeof(*keys));
+    int64_t *amounts = malloc(rows * sizeof(*amounts));
+    if (!keys || !amounts) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+
+    uint64_t seed = 0xC0FFEEULL;
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t k = 0; k < RSA_PUBLIC_KEY_LENGTH; k += 8) {
+            uint64_t r = bench_rand(&seed);
+            memcpy(keys[i] + k, &r, 8);
+        }
+        amounts[i] = (int64_t)(bench_rand(&seed) % 1000000000000000ULL);
+    }
+
+    rsa_csv_writer_t writer;
+    uint64_t start = bench_now_ns();
+    if (!rsa_csv_writer_open(&writer, path, "address,amount", 0) ||
+        !rsa_csv_write_batch(&writer, (const uint8_t (*)[RSA_PUBLIC_KEY_LENGTH])keys, amounts, rows) ||
+        !rsa_csv_writer_close(&writer)) {
+        fprintf(stderr, "write failed: %s\n", path);
+        return 1;
+    }
+    bench_report("csv write", bench_now_ns() - start, rows);
+
+    rsa_csv_reader_t reader;
+    rsa_csv_batch_t batch;
+    if (!rsa_csv_batch_init(&batch, RSA_CSV_DEFAULT_BATCH_ROWS) ||
+        !rsa_csv_reader_open(&reader, path, true)) {
+        fprintf(stderr, "read setup failed: %s\n", path);
+        return 1;
+    }
+
+    size_t total = 0, bad = 0;
+    start = bench_now_ns();
+    while (rsa_csv_read_batch(&reader, &batch) > 0) {
+        for (size_t i = 0; i < batch.count; i++) {
+            size_t row = batch.first_row + i;
+            if (batch.status[i] != RSA_CSV_ROW_OK || row >= rows ||
+                batch.amounts[i] != amounts[row] ||
+                memcmp(batch.public_keys[i], keys[row], RSA_PUBLIC_KEY_LENGTH) != 0) {
+                bad++;
+            }
+        }
+        total += batch.count;
+    }
+    bench_report("csv read", bench_now_ns() - start, total);
+    printf("rows read %zu of %zu, mismatches %zu\n", total, rows, bad);
+
+    rsa_csv_reader_close(&reader);
+    rsa_csv_batch_free(&batch);
+    unlink(path);
+    free(keys);
+    free(amounts);
+    bench_sink = total;
+    return (bad == 0 && total == rows) ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+#include "rsa_envelope.h"
+#include "rsa_ledger.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Envelope wire format: encoding payment transactions (one to three
+// operations, native and credit assets) back to back into one stream, so
+// most envelopes start unaligned; parsing every envelope in place and
+// reading its fee and seq_num; decoding into structs; hashing the encoded
+// body against hashing the structs (rsa_ledger_tx_hash()). Bytes per
+// transaction are printed against the in-memory size.
+//
+//   rsa-bench-envelope [transactions]     default: 1000000
+
+#define BENCH_MAX_OPS 3
+
+static void bench_fill(uint64_t n, rsa_transaction_t *tx, rsa_operation_t *ops) {
+    uint64_t seed = n * 0x9E3779B97F4A7C15ULL + 1;
+    memset(tx, 0, sizeof(*tx));
+    for (int w = 0; w < 8; w++) tx->tx_source_account[w] = (uint32_t)bench_rand(&seed);
+    tx->fee = RSA_BASE_FEE + (uint32_t)(bench_rand(&seed) % 1000);
+    tx->seq_num = n + 1;
+    tx->operations_count = 1 + (uint32_t)(n % BENCH_MAX_OPS);
+    if (n % 4 == 0) {
+        tx->memo.type = RSA_MEMO_ID;
+        tx->memo.memo.id = n;
+    }
+    for (uint32_t i = 0; i < tx->operations_count; i++) {
+        rsa_operation_t *op = &ops[i];
+        memset(op, 0, sizeof(*op));
+        op->type = RSA_OP_PAYMENT;
+        if (bench_rand(&seed) % 3 == 0) {
+            op->operation.payment.asset.type = RSA_ASSET_TYPE_CREDIT_ALPHANUM4;
+            memcpy(op->operation.payment.asset.asset.credit_alphanum4.code, "USDT", 4);
+            memset(op->operation.payment.asset.asset.credit_alphanum4.issuer, 0x42, 32);
+        }
+        memcpy(op->operation.payment.from, tx->tx_source_account, 32);
+        for (int w = 0; w < 8; w++) op->operation.payment.to[w] = (uint32_t)bench_rand(&seed);
+        op->operation.payment.amount = (int64_t)(bench_rand(&seed) % 1000000000);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+
+    // Sizes first, so the stream is a single allocation as well
+    size_t *offsets = malloc((count + 1) * sizeof(size_t));
+    rsa_transaction_t *txs = malloc(count * sizeof(rsa_transaction_t));
+    rsa_operation_t *ops = malloc(count * BENCH_MAX_OPS * sizeof(rsa_operation_t));
+    if (!offsets || !txs || !ops) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    size_t op_total = 0;
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        bench_fill(i, &txs[i], &ops[i * BENCH_MAX_OPS]);
+        op_total += txs[i].operations_count;
+        offsets[i + 1] = offsets[i] + rsa_envelope_body_size(&txs[i], &ops[i * BENCH_MAX_OPS]);
+    }
+    uint8_t *stream = malloc(offsets[count]);
+    if (!stream) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    memset(stream, 0, offsets[count]);  // fault the pages in outside the timings
+    printf("-- %zu transactions, %zu payments\n", count, op_total);
+    printf("%-40s %10.1f bytes/tx %10.1f in structs\n", "encoded size",
+           (double)offsets[count] / (double)count,
+           (double)(count * sizeof(rsa_transaction_t) + op_total * sizeof(rsa_operation_t)) /
+               (double)count);
+
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        if (!rsa_envelope_encode(&txs[i], &ops[i * BENCH_MAX_OPS], stream + offsets[i],
+                                 offsets[i + 1] - offsets[i])) {
+            fprintf(stderr, "encode failed\n");
+            return 1;
+        }
+    }
+    bench_report("encode", bench_now_ns() - start, count);
+
+    uint64_t acc = 0;
+    start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        rsa_envelope_view_t view;
+        if (!rsa_envelope_parse(stream + offsets[i], offsets[i + 1] - offsets[i], &view)) {
+            fprintf(stderr, "parse failed\n");
+            return 1;
+        }
+        acc += rsa_envelope_fee(&view) + rsa_envelope_seq_num(&view);
+    }
+    bench_report("parse (view, fee, seq_num)", bench_now_ns() - start, count);
+
+    rsa_transaction_t tx;
+    rsa_operation_t decoded[BENCH_MAX_OPS];
+    size_t mismatches = 0;
+    start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        rsa_envelope_view_t view;
+        rsa_envelope_parse(stream + offsets[i], offsets[i + 1] - offsets[i], &view);
+        rsa_envelope_decode(&view, &tx, decoded);
+        acc += (uint64_t)decoded[0].operation.payment.amount;
+        if (i % 64 == 0 &&
+            (memcmp(&tx, &txs[i], sizeof(tx)) != 0 ||
+             memcmp(decoded, &ops[i * BENCH_MAX_OPS],
+                    tx.operations_count * sizeof(rsa_operation_t)) != 0)) {
+            mismatches++;
+        }
+    }
+    bench_report("parse + decode to structs", bench_now_ns() - start, count);
+    if (mismatches) fprintf(stderr, "%zu decoded transactions differ\n", mismatches);
+
+    uint8_t hash[32];
+    start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        rsa_envelope_view_t view;
+        rsa_envelope_parse(stream + offsets[i], offsets[i + 1] - offsets[i], &view);
+        rsa_envelope_hash(&view, hash);
+        acc += hash[0];
+    }
+    bench_report("hash encoded body", bench_now_ns() - start, count);
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        rsa_tx_envelope_ref_t ref = {&txs[i], &ops[i * BENCH_MAX_OPS], NULL, NULL};
+        rsa_ledger_tx_hash(&ref, hash);
+        acc += hash[0];
+    }
+    bench_report("hash structs (rsa_ledger_tx_hash)", bench_now_ns() - start, count);
+
+    bench_sink = acc;
+    free(stream);
+    free(ops);
+    free(txs);
+    free(offsets);
+    return mismatches != 0;
+}
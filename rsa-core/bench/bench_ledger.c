@@ -0,0 +1,446 @@
+#include "rsa_ledger.h"
+#include "rsa_ledger_pipeline.h"
+#include "bench_util.h"
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Closes synthetic ledgers back to back: BENCH_TX_PER_LEDGER single-op
+// native payments between random funded accounts per ledger, every phase
+// included (validation, apply, state tree, header). Reports the close
+// interval (set generation included) and the average time of each phase;
+// compare apply across thread counts. With a pipeline depth the validate
+// phase of the next sets overlaps apply and commit of the current one.
+// With `check`, every close also applies serially to a shadow state and
+// compares (included in apply), and publishes to versioned reader stores
+// (rsa_mvcc.h) whose final view must match the ledger account for account.
+// It also logs every close and snapshots every BENCH_SNAPSHOT_INTERVAL
+// ledgers into a directory under the current one, then crashes partway
+// through a ledger: a ledger reopened from the snapshot and log must match
+// the live one, header and accounts, and close the next set to the same
+// hash. The run fails on any mismatch.
+//
+//   rsa-bench-ledger [accounts] [ledgers] [apply threads] [pipeline depth] [check]
+//                                                    default: 100000 200 1 0 0
+
+#define BENCH_TX_PER_LEDGER 1000
+#define BENCH_CREATE_OPS 10             // create_account operations per funding tx
+#define BENCH_SNAPSHOT_INTERVAL 16
+#define BENCH_WAL_SEGMENT_SIZE (16u << 20)  // fits a funding ledger's changes
+#define BENCH_TRUSTLINES 100            // check: accounts holding a credit balance
+
+static void bench_account_id(uint64_t n, uint32_t id[8]) {
+    uint64_t seed = n * 0x9E3779B97F4A7C15ULL + 1;
+    for (int w = 0; w < 4; w++) {
+        uint64_t word = bench_rand(&seed);
+        memcpy(id + 2 * w, &word, 8);
+    }
+}
+
+typedef struct {
+    rsa_transaction_t *txs;
+    rsa_operation_t *ops;               // BENCH_CREATE_OPS per transaction
+    rsa_tx_envelope_ref_t *envelopes;
+    rsa_tx_result_t *results;
+} bench_set_t;
+
+static bool bench_set_alloc(bench_set_t *set) {
+    set->txs = malloc(BENCH_TX_PER_LEDGER * sizeof(rsa_transaction_t));
+    set->ops = malloc(BENCH_TX_PER_LEDGER * BENCH_CREATE_OPS * sizeof(rsa_operation_t));
+    set->envelopes = malloc(BENCH_TX_PER_LEDGER * sizeof(rsa_tx_envelope_ref_t));
+    set->results = malloc(BENCH_TX_PER_LEDGER * sizeof(rsa_tx_result_t));
+    return set->txs && set->ops && set->envelopes && set->results;
+}
+
+static void bench_set_free(bench_set_t *set) {
+    free(set->txs);
+    free(set->ops);
+    free(set->envelopes);
+    free(set->results);
+}
+
+// Zeroes transaction `i` of the set and points its envelope at its operations
+static rsa_transaction_t *bench_tx(bench_set_t *set, size_t i, const uint32_t source[8],
+                                   uint64_t seq_num, uint32_t op_count) {
+    rsa_transaction_t *tx = &set->txs[i];
+    memset(tx, 0, sizeof(*tx));
+    memset(&set->ops[i * BENCH_CREATE_OPS], 0, BENCH_CREATE_OPS * sizeof(rsa_operation_t));
+    memcpy(tx->tx_source_account, source, 32);
+    tx->seq_num = seq_num;
+    tx->fee = RSA_BASE_FEE * op_count;
+    tx->operations_count = op_count;
+    set->envelopes[i] = (rsa_tx_envelope_ref_t){tx, &set->ops[i * BENCH_CREATE_OPS], NULL, NULL};
+    return tx;
+}
+
+static bool bench_check(const rsa_tx_result_t *results, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].code != RSA_TX_RESULT_SUCCESS) {
+            fprintf(stderr, "tx %zu: %s\n", i,
+                    rsa_tx_result_str((rsa_tx_result_code_t)results[i].code));
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool bench_close(rsa_ledger_t *ledger, bench_set_t *set, size_t count) {
+    if (!rsa_ledger_close(ledger, set->envelopes, count, ledger->header.close_time + 5,
+                          set->results)) {
+        fprintf(stderr, "ledger close failed\n");
+        return false;
+    }
+    return bench_check(set->results, count);
+}
+
+// BENCH_TX_PER_LEDGER payments between distinct random accounts
+static void bench_payments(bench_set_t *set, size_t count, uint64_t *seqs, uint64_t *seed) {
+    uint32_t id[8];
+    for (size_t i = 0; i < BENCH_TX_PER_LEDGER; i++) {
+        uint64_t from = bench_rand(seed) % count;
+        uint64_t to = (from + 1 + bench_rand(seed) % (count - 1)) % count;
+        bench_account_id(from, id);
+        bench_tx(set, i, id, ++seqs[from], 1);
+        rsa_operation_t *op = &set->ops[i * BENCH_CREATE_OPS];
+        op->type = RSA_OP_PAYMENT;
+        op->operation.payment.asset.type = RSA_ASSET_TYPE_NATIVE;
+        bench_account_id(to, op->operation.payment.to);
+        op->operation.payment.amount = 1 + (int64_t)(bench_rand(seed) % 1000);
+    }
+}
+
+// A payment naming another account as `from` must fail with BAD_AUTH and
+// leave that account untouched
+static bool bench_check_auth(rsa_ledger_t *ledger, bench_set_t *set) {
+    uint32_t thief[8], victim[8];
+    rsa_account_t account;
+    bench_account_id(0, thief);
+    bench_account_id(1, victim);
+    if (!rsa_ledger_get_account(ledger, thief, &account)) return false;
+    bench_tx(set, 0, thief, account.seq_num + 1, 1);
+    rsa_operation_t *op = &set->ops[0];
+    op->type = RSA_OP_PAYMENT;
+    op->operation.payment.asset.type = RSA_ASSET_TYPE_NATIVE;
+    memcpy(op->operation.payment.from, victim, 32);
+    memcpy(op->operation.payment.to, thief, 32);
+    op->operation.payment.amount = RSA_LEDGER_STROOPS_PER_UNIT;
+
+    if (!rsa_ledger_get_account(ledger, victim, &account)) return false;
+    int64_t before = account.balance;
+    if (!rsa_ledger_close(ledger, set->envelopes, 1, ledger->header.close_time + 5,
+                          set->results) ||
+        !rsa_ledger_get_account(ledger, victim, &account)) {
+        return false;
+    }
+    if (set->results[0].code != RSA_TX_RESULT_FAILED ||
+        set->results[0].op_results[0] != RSA_OP_RESULT_BAD_AUTH || account.balance != before) {
+        fprintf(stderr, "payment from another account was not refused: %s, %s\n",
+                rsa_tx_result_str((rsa_tx_result_code_t)set->results[0].code),
+                rsa_op_result_str((rsa_op_result_code_t)set->results[0].op_results[0]));
+        return false;
+    }
+    return true;
+}
+
+// Accounts as a reader sees them at the last closed ledger, against the
+// ledger itself; returns the number that differ
+static size_t bench_check_view(const rsa_ledger_t *ledger, rsa_mvcc_domain_t *domain,
+                               const rsa_mvcc_store_t *accounts, size_t count,
+                               const uint32_t root[8]) {
+    rsa_mvcc_view_t view;
+    if (!rsa_mvcc_view_open(domain, &view)) return count + 1;
+    size_t mismatches = view.seq != ledger->header.ledger_seq || accounts->live != count + 1;
+    uint32_t id[8];
+    rsa_account_t account;
+    for (size_t i = 0; i <= count; i++) {
+        if (i < count) bench_account_id(i, id);
+        else memcpy(id, root, sizeof(id));
+        const rsa_account_t *seen = rsa_mvcc_get_account(&view, accounts, id);
+        mismatches += !seen || !rsa_ledger_get_account(ledger, id, &account) ||
+                      seen->balance != account.balance || seen->seq_num != account.seq_num ||
+                      seen->num_sub_entries != account.num_sub_entries;
+    }
+    rsa_mvcc_view_close(&view);
+    return mismatches;
+}
+
+// The first BENCH_TRUSTLINES accounts trust a root-issued asset and get
+// paid some, so the persisted state holds trustlines too
+static bool bench_trustlines(rsa_ledger_t *ledger, bench_set_t *set, size_t count,
+                             uint64_t *seqs, const uint32_t root[8]) {
+    rsa_asset_t asset;
+    memset(&asset, 0, sizeof(asset));
+    asset.type = RSA_ASSET_TYPE_CREDIT_ALPHANUM4;
+    memcpy(asset.asset.credit_alphanum4.code, "BNCH", 4);
+    memcpy(asset.asset.credit_alphanum4.issuer, root, 32);
+
+    size_t lines = count < BENCH_TRUSTLINES ? count : BENCH_TRUSTLINES;
+    uint32_t id[8];
+    for (size_t i = 0; i < lines; i++) {
+        bench_account_id(i, id);
+        bench_tx(set, i, id, ++seqs[i], 1);
+        rsa_operation_t *op = &set->ops[i * BENCH_CREATE_OPS];
+        op->type = RSA_OP_CHANGE_TRUST;
+        op->operation.change_trust.asset = asset;
+        op->operation.change_trust.limit = 1000000 * RSA_LEDGER_STROOPS_PER_UNIT;
+    }
+    if (!bench_close(ledger, set, lines)) return false;
+
+    rsa_account_t account;
+    if (!rsa_ledger_get_account(ledger, root, &account)) return false;
+    for (size_t i = 0; i < lines; i++) {
+        bench_tx(set, i, root, account.seq_num + 1 + i, 1);
+        rsa_operation_t *op = &set->ops[i * BENCH_CREATE_OPS];
+        op->type = RSA_OP_PAYMENT;
+        op->operation.payment.asset = asset;
+        bench_account_id(i, op->operation.payment.to);
+        op->operation.payment.amount = (int64_t)(i + 1) * RSA_LEDGER_STROOPS_PER_UNIT;
+    }
+    return bench_close(ledger, set, lines);
+}
+
+// Crashes partway through the next ledger: its changes reach the log but
+// its close record does not. A ledger reopened from the snapshot and log
+// must match the live one, header and accounts; both then close the same
+// set to the same hash, the reopened one also against its own serial
+// shadow. Returns the number of mismatches.
+static size_t bench_check_restart(rsa_ledger_t *ledger, bench_set_t *set, size_t count,
+                                  uint64_t *seqs, uint64_t *seed, const uint32_t root[8]) {
+    rsa_wal_t *wal = ledger->config.wal;
+    rsa_wal_batch_t partial;
+    rsa_wal_batch_init(&partial);
+    rsa_account_t account, restored;
+    uint64_t lsn;
+    bool crashed = rsa_ledger_get_account(ledger, root, &account);
+    account.balance = 0;
+    crashed = crashed && rsa_wal_batch_create(&partial, RSA_WAL_ACCOUNT, &account) &&
+              rsa_wal_append(wal, ledger->header.ledger_seq + 1, &partial, &lsn) &&
+              rsa_wal_sync(wal, lsn);
+    rsa_wal_batch_free(&partial);
+    rsa_wal_close(wal);
+    ledger->config.wal = NULL;          // the crashed ledger carries on as the reference
+    if (!crashed) return count + 2;
+
+    rsa_ledger_config_t config = ledger->config;
+    rsa_wal_t restarted;
+    rsa_wal_options_t options = {BENCH_WAL_SEGMENT_SIZE, 0};
+    config.wal = &restarted;
+    config.mvcc_accounts = NULL;
+    config.mvcc_trustlines = NULL;
+    rsa_ledger_t reopened;
+    if (!rsa_ledger_open(&reopened, &config, config.snapshot_dir)) return count + 2;
+    if (!rsa_wal_open(&restarted, config.snapshot_dir, &options)) {
+        rsa_ledger_free(&reopened);
+        return count + 2;
+    }
+
+    size_t mismatches = memcmp(reopened.header_hash, ledger->header_hash, 32) != 0;
+    uint32_t id[8];
+    for (size_t i = 0; i <= count; i++) {
+        if (i < count) bench_account_id(i, id);
+        else memcpy(id, root, sizeof(id));
+        mismatches += !rsa_ledger_get_account(&reopened, id, &restored) ||
+                      !rsa_ledger_get_account(ledger, id, &account) ||
+                      memcmp(&restored, &account, sizeof(account)) != 0;
+    }
+    bench_payments(set, count, seqs, seed);
+    uint64_t close_time = ledger->header.close_time + 5;
+    mismatches += !rsa_ledger_close(ledger, set->envelopes, BENCH_TX_PER_LEDGER, close_time,
+                                    set->results) ||
+                  !rsa_ledger_close(&reopened, set->envelopes, BENCH_TX_PER_LEDGER, close_time,
+                                    set->results) ||
+                  memcmp(reopened.header_hash, ledger->header_hash, 32) != 0;
+    rsa_wal_close(&restarted);
+    rsa_ledger_free(&reopened);
+    return mismatches;
+}
+
+static void bench_remove_dir(const char *dir) {
+    DIR *handle = opendir(dir);
+    if (!handle) return;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char path[600];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        unlink(path);
+    }
+    closedir(handle);
+    rmdir(dir);
+}
+
+// Retires the oldest ledger in the pipeline
+static bool bench_collect(rsa_ledger_pipeline_t *pipeline, uint64_t *phase_ns) {
+    rsa_ledger_completion_t done;
+    if (!rsa_ledger_pipeline_wait(pipeline, &done)) return false;
+    if (!done.closed) {
+        fprintf(stderr, "ledger close failed\n");
+        return false;
+    }
+    for (int p = 0; p < RSA_LEDGER_PHASE_COUNT; p++) phase_ns[p] += done.phase_ns[p];
+    return bench_check(done.results, done.count);
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    int ledgers = argc > 2 ? atoi(argv[2]) : 200;
+    unsigned threads = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 1;
+    size_t depth = argc > 4 ? strtoull(argv[4], NULL, 10) : 0;
+    bool check = argc > 5 && atoi(argv[5]) != 0;
+    if (count < 2) count = 2;
+    if (ledgers <= 0) ledgers = 1;
+
+    size_t buffers = depth + 1;         // one being generated, `depth` in flight
+    bench_set_t *sets = calloc(buffers, sizeof(*sets));
+    uint64_t *seqs = malloc(count * sizeof(uint64_t));
+    rsa_ledger_config_t config = {0};
+    config.account_capacity = count + 1;
+    config.apply_threads = threads;
+    config.check_determinism = check;
+    rsa_mvcc_domain_t *domain = check ? malloc(sizeof(*domain)) : NULL;
+    rsa_mvcc_store_t mvcc_accounts, mvcc_trustlines;
+    char dir[] = "rsa-bench-ledger.XXXXXX";
+    rsa_wal_t wal;                      // check: log and snapshots in `dir`
+    if (check) {
+        if (!mkdtemp(dir)) {
+            fprintf(stderr, "cannot create a directory here\n");
+            return 1;
+        }
+        rsa_wal_options_t options = {BENCH_WAL_SEGMENT_SIZE, 0};
+        if (!rsa_wal_open(&wal, dir, &options)) {
+            fprintf(stderr, "cannot open a log in %s\n", dir);
+            return 1;
+        }
+        config.wal = &wal;
+        config.snapshot_dir = dir;
+        config.snapshot_interval = BENCH_SNAPSHOT_INTERVAL;
+        if (!domain || !rsa_mvcc_domain_init(domain, 0, 0) ||
+            !rsa_mvcc_store_init(&mvcc_accounts, domain, RSA_WAL_ACCOUNT, count + 1) ||
+            !rsa_mvcc_store_init(&mvcc_trustlines, domain, RSA_WAL_TRUSTLINE, 0)) {
+            fprintf(stderr, "allocation failed\n");
+            return 1;
+        }
+        config.mvcc_accounts = &mvcc_accounts;
+        config.mvcc_trustlines = &mvcc_trustlines;
+    }
+    rsa_ledger_t ledger;
+    uint32_t root[8], id[8];
+    bench_account_id(UINT64_MAX, root);
+    bool ok = sets && seqs;
+    for (size_t b = 0; ok && b < buffers; b++) ok = bench_set_alloc(&sets[b]);
+    if (!ok || !rsa_ledger_init(&ledger, &config) || !rsa_ledger_genesis(&ledger, root, 1)) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+
+    // Funding: root creates the accounts, BENCH_CREATE_OPS per transaction
+    bench_set_t *set = &sets[0];
+    rsa_account_t account;
+    rsa_ledger_get_account(&ledger, root, &account);
+    uint64_t root_seq = account.seq_num, start = bench_now_ns();
+    for (size_t next = 0; next < count;) {
+        size_t txs = 0;
+        while (txs < BENCH_TX_PER_LEDGER && next < count) {
+            uint32_t ops = (uint32_t)(count - next < BENCH_CREATE_OPS ? count - next
+                                                                      : BENCH_CREATE_OPS);
+            bench_tx(set, txs, root, ++root_seq, ops);
+            for (uint32_t o = 0; o < ops; o++, next++) {
+                rsa_operation_t *op = &set->ops[txs * BENCH_CREATE_OPS + o];
+                op->type = RSA_OP_CREATE_ACCOUNT;
+                bench_account_id(next, op->operation.create_account.destination);
+                op->operation.create_account.starting_balance = 1000 * RSA_LEDGER_STROOPS_PER_UNIT;
+            }
+            txs++;
+        }
+        if (!bench_close(&ledger, set, txs)) return 1;
+    }
+    if (!bench_check_auth(&ledger, set)) return 1;
+    for (size_t i = 0; i < count; i++) {
+        bench_account_id(i, id);
+        rsa_ledger_get_account(&ledger, id, &account);
+        seqs[i] = account.seq_num;
+    }
+    printf("-- %zu accounts, %d ledgers of %d payments, %u apply thread%s, pipeline depth %zu\n",
+           count, ledgers, BENCH_TX_PER_LEDGER, threads, threads == 1 ? "" : "s", depth);
+    bench_report("fund (create_account ops)", bench_now_ns() - start, count);
+
+    rsa_ledger_pipeline_t pipeline;
+    if (depth && !rsa_ledger_pipeline_start(&pipeline, &ledger, depth)) {
+        fprintf(stderr, "pipeline start failed\n");
+        return 1;
+    }
+    uint64_t seed = 0x243F6A8885A308D3ULL, groups = 0, close_time = ledger.header.close_time;
+    uint64_t phase_ns[RSA_LEDGER_PHASE_COUNT] = {0};
+    start = bench_now_ns();
+    for (int l = 0; l < ledgers; l++) {
+        set = &sets[(size_t)l % buffers];
+        bench_payments(set, count, seqs, &seed);
+        close_time += 5;
+        if (depth == 0) {
+            if (!rsa_ledger_close(&ledger, set->envelopes, BENCH_TX_PER_LEDGER, close_time,
+                                  set->results) ||
+                !bench_check(set->results, BENCH_TX_PER_LEDGER)) {
+                fprintf(stderr, "ledger close failed\n");
+                return 1;
+            }
+            for (int p = 0; p < RSA_LEDGER_PHASE_COUNT; p++) phase_ns[p] += ledger.phase_ns[p];
+            groups += ledger.apply_groups;
+            continue;
+        }
+        if ((size_t)l >= depth && !bench_collect(&pipeline, phase_ns)) return 1;
+        rsa_ledger_pipeline_submit(&pipeline, set->envelopes, BENCH_TX_PER_LEDGER, close_time, 0,
+                                   set->results, NULL);
+    }
+    for (size_t left = depth < (size_t)ledgers ? depth : (size_t)ledgers; depth && left > 0; left--) {
+        if (!bench_collect(&pipeline, phase_ns)) return 1;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    if (depth) rsa_ledger_pipeline_stop(&pipeline);
+
+    bench_report("close (per tx)", elapsed, (uint64_t)ledgers * BENCH_TX_PER_LEDGER);
+    printf("%-40s %10.3f ms/ledger %10.0f tx/s\n", "interval", (double)elapsed / ledgers / 1e6,
+           elapsed ? (double)ledgers * BENCH_TX_PER_LEDGER * 1e9 / (double)elapsed : 0.0);
+    for (int p = 0; p < RSA_LEDGER_PHASE_COUNT; p++) {
+        char name[40];
+        snprintf(name, sizeof(name), "  %s", rsa_ledger_phase_str((rsa_ledger_phase_t)p));
+        printf("%-40s %10.3f ms/ledger\n", name, (double)phase_ns[p] / ledgers / 1e6);
+    }
+    if (threads > 1 && depth == 0) {
+        printf("%-40s %10.1f groups/ledger\n", "  conflict groups", (double)groups / ledgers);
+    }
+    if (check) {
+        uint64_t mismatches = __atomic_load_n(&g_rsa_monitor.ledger_apply_mismatches,
+                                              __ATOMIC_RELAXED);
+        printf("%-40s %10" PRIu64 " mismatches\n", "  serial determinism check", mismatches);
+        size_t stale = bench_check_view(&ledger, domain, &mvcc_accounts, count, root);
+        printf("%-40s %10zu mismatches\n", "  reader view vs ledger", stale);
+
+        // At least one snapshot, then ledgers only the log holds
+        bool ok = true;
+        while (ok && ledger.header.ledger_seq % BENCH_SNAPSHOT_INTERVAL != 0) {
+            ok = rsa_ledger_close(&ledger, NULL, 0, ledger.header.close_time + 5, NULL);
+        }
+        ok = ok && bench_trustlines(&ledger, &sets[0], count, seqs, root);
+        size_t reopen = ok ? bench_check_restart(&ledger, &sets[0], count, seqs, &seed, root)
+                           : count + 2;
+        printf("%-40s %10zu mismatches\n", "  restart from snapshot and log", reopen);
+        bench_remove_dir(dir);
+        if (mismatches != 0 || stale != 0 || reopen != 0) return 1;
+    }
+    bench_sink = ledger.header.ledger_seq;
+
+    rsa_ledger_free(&ledger);
+    if (check) {
+        rsa_mvcc_store_free(&mvcc_accounts);
+        rsa_mvcc_store_free(&mvcc_trustlines);
+        rsa_mvcc_domain_free(domain);
+        free(domain);
+    }
+    for (size_t b = 0; b < buffers; b++) bench_set_free(&sets[b]);
+    free(sets);
+    free(seqs);
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include "rsa_mempool.h"
+#include "bench_util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Pending pool at full size: submissions of single-payment transactions
+// with random fee bids, chained per account, from `threads` submitters
+// (disjoint accounts); replace-by-fee of a tenth of them; building
+// surge-priced sets of RSA_MAX_TX_SET_SIZE from the full pool (cost should
+// not depend on the pool size); submissions into the full pool that each
+// evict the lowest bid; popping everything in fee order; then a tenth as
+// many time-bounded transactions expiring over an hour of 5-second
+// closes; finally short queues whose first transaction is parked until
+// its min_time, which must stay out of built sets until the pool's time
+// reaches it and then come back in seq_num order, and one transaction
+// bidding under the base fee, which no set may include. Per-transaction
+// costs should stay flat as the pool grows.
+//
+//   rsa-bench-mempool [transactions] [accounts] [threads]     default: 1000000 100000 1
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_BUILDS 100
+#define BENCH_NOW 1700000000ULL         // pool time, seconds
+#define BENCH_EXPIRY_WINDOW 3600
+#define BENCH_CLOSE_INTERVAL 5
+#define BENCH_PARKED_ACCOUNTS 10000
+#define BENCH_PARKED_DEPTH 3            // transactions per parked-phase account
+#define BENCH_PARK_DELAY 60
+#define BENCH_BASE_FEE RSA_BASE_FEE     // the ledger's configured base fee
+
+typedef struct {
+    rsa_mempool_t *pool;
+    size_t count;
+    size_t accounts;
+    unsigned thread;
+    unsigned threads;
+    uint32_t fee_boost;                 // added to every bid
+    uint64_t expiry_window;             // max_time within this many seconds of BENCH_NOW; 0 = none
+    uint64_t park_until;                // min_time of every other account's first transaction; 0 = none
+    uint64_t first_account;
+    size_t accepted;
+} bench_submitter_t;
+
+static void bench_account_id(uint64_t n, uint32_t id[8]) {
+    uint64_t seed = n * 0x9E3779B97F4A7C15ULL + 1;
+    for (int w = 0; w < 4; w++) {
+        uint64_t word = bench_rand(&seed);
+        memcpy(id + 2 * w, &word, 8);
+    }
+}
+
+// Transaction `n` is the (n / accounts + 1)th of account n % accounts
+static rsa_mempool_result_t bench_submit(bench_submitter_t *submitter, uint64_t n,
+                                         uint32_t fee_boost) {
+    rsa_transaction_t tx;
+    rsa_operation_t op;
+    memset(&tx, 0, sizeof(tx));
+    memset(&op, 0, sizeof(op));
+    uint64_t account = submitter->first_account + n % submitter->accounts;
+    uint64_t seed = n * 0xD1B54A32D192ED03ULL + 7;
+    bench_account_id(account, tx.tx_source_account);
+    tx.seq_num = n / submitter->accounts + 1;
+    tx.fee = RSA_BASE_FEE + (uint32_t)(bench_rand(&seed) % 10000) + fee_boost;
+    tx.operations_count = 1;
+    if (submitter->expiry_window) {
+        tx.time_bounds.max_time = BENCH_NOW + 1 + bench_rand(&seed) % submitter->expiry_window;
+    }
+    if (submitter->park_until) {
+        // The memo names the account so built sets can be checked
+        tx.memo.type = RSA_MEMO_ID;
+        tx.memo.memo.id = n % submitter->accounts;
+        if (tx.seq_num == 1 && tx.memo.memo.id % 2 == 0) tx.time_bounds.min_time = submitter->park_until;
+    }
+    op.type = RSA_OP_PAYMENT;
+    op.operation.payment.asset.type = RSA_ASSET_TYPE_NATIVE;
+    bench_account_id(account + 1, op.operation.payment.to);
+    op.operation.payment.amount = 1 + (int64_t)(bench_rand(&seed) % 1000);
+    rsa_tx_envelope_ref_t envelope = {&tx, &op, NULL, NULL};
+    return rsa_mempool_submit(submitter->pool, &envelope, 0);
+}
+
+static void *bench_submit_worker(void *arg) {
+    bench_submitter_t *submitter = arg;
+    for (uint64_t n = 0; n < submitter->count; n++) {
+        if (n % submitter->accounts % submitter->threads != submitter->thread) continue;
+        rsa_mempool_result_t result = bench_submit(submitter, n, submitter->fee_boost);
+        submitter->accepted += result == RSA_MEMPOOL_ADDED || result == RSA_MEMPOOL_REPLACED;
+    }
+    return NULL;
+}
+
+// Runs `threads` submitters over transactions [0, count) and returns the
+// number accepted
+static size_t bench_submit_all(bench_submitter_t *base, unsigned threads) {
+    bench_submitter_t submitters[BENCH_MAX_THREADS];
+    pthread_t workers[BENCH_MAX_THREADS];
+    for (unsigned t = 0; t < threads; t++) {
+        submitters[t] = *base;
+        submitters[t].thread = t;
+        submitters[t].threads = threads;
+        if (t > 0) pthread_create(&workers[t], NULL, bench_submit_worker, &submitters[t]);
+    }
+    bench_submit_worker(&submitters[0]);
+    size_t accepted = submitters[0].accepted;
+    for (unsigned t = 1; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+        accepted += submitters[t].accepted;
+    }
+    return accepted;
+}
+
+// A set built in the parked phase: the parked (even) accounts are absent
+// until `released`, every other account is complete, and each account's
+// transactions follow in seq_num order
+static bool bench_check_parked(const rsa_mempool_tx_set_t *set, const bench_submitter_t *submitter,
+                               bool released) {
+    size_t depth = submitter->count / submitter->accounts;
+    uint64_t *last_seq = calloc(submitter->accounts, sizeof(*last_seq));
+    if (!last_seq) return false;
+
+    bool ok = true;
+    for (size_t i = 0; i < set->count; i++) {
+        const rsa_transaction_t *tx = set->envelopes[i].tx;
+        uint64_t account = tx->memo.memo.id;
+        if (tx->memo.type != RSA_MEMO_ID || account >= submitter->accounts ||
+            (!released && account % 2 == 0) || tx->seq_num != last_seq[account] + 1) {
+            ok = false;
+            break;
+        }
+        last_seq[account] = tx->seq_num;
+    }
+    for (size_t a = 0; ok && a < submitter->accounts; a++) {
+        ok = last_seq[a] == ((released || a % 2) ? depth : 0);
+    }
+    free(last_seq);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t accounts = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000;
+    unsigned threads = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 1;
+    if (accounts == 0) accounts = 1;
+    if (count < accounts) count = accounts;
+    if (count < 10) count = 10;         // every phase gets at least one transaction
+    if (threads == 0) threads = 1;
+    if (threads > BENCH_MAX_THREADS) threads = BENCH_MAX_THREADS;
+
+    rsa_mempool_config_t config = {0};
+    config.capacity = count;
+    config.max_per_account = (uint32_t)((count + accounts - 1) / accounts);
+    config.start_time = BENCH_NOW;
+    rsa_mempool_t pool;
+    if (!rsa_mempool_init(&pool, &config)) {
+        fprintf(stderr, "mempool init failed\n");
+        return 1;
+    }
+    printf("-- %zu transactions over %zu accounts, %u submitter thread%s\n", count, accounts,
+           threads, threads == 1 ? "" : "s");
+
+    bench_submitter_t base = {&pool, count, accounts, 0, 1, 0, 0, 0, 0, 0};
+    uint64_t start = bench_now_ns();
+    size_t accepted = bench_submit_all(&base, threads);
+    bench_report("submit", bench_now_ns() - start, count);
+    if (accepted != count) {
+        fprintf(stderr, "only %zu of %zu accepted\n", accepted, count);
+        return 1;
+    }
+
+    // Same seq_nums with a doubled bid: every tenth account's queue
+    size_t replace = count / 10;
+    bench_submitter_t bump = base;
+    bump.fee_boost = 20000;
+    start = bench_now_ns();
+    for (uint64_t n = 0; n < replace; n++) bench_submit(&bump, n * 10 % count, bump.fee_boost);
+    bench_report("replace-by-fee", bench_now_ns() - start, replace);
+
+    rsa_mempool_tx_set_t set;
+    memset(&set, 0, sizeof(set));
+    start = bench_now_ns();
+    for (int b = 0; b < BENCH_BUILDS; b++) {
+        if (!rsa_mempool_build_tx_set(&pool, 0, BENCH_BASE_FEE, &set)) {
+            fprintf(stderr, "tx set build failed\n");
+            return 1;
+        }
+    }
+    bench_report("build tx set (per set)", bench_now_ns() - start, BENCH_BUILDS);
+    printf("%-40s %10zu txs %10u base fee%s\n", "", set.count, set.base_fee,
+           set.surged ? " (surge)" : "");
+    rsa_mempool_tx_set_free(&set);
+
+    // Fresh accounts outbidding the pool's floor; each submission evicts
+    size_t extra = count / 10;
+    bench_submitter_t outbid = base;
+    outbid.count = extra;
+    outbid.accounts = accounts < extra ? accounts : extra;
+    outbid.first_account = accounts + 1;
+    outbid.fee_boost = 10000;
+    start = bench_now_ns();
+    accepted = bench_submit_all(&outbid, threads);
+    bench_report("submit into full pool (evicting)", bench_now_ns() - start, extra);
+    printf("%-40s %10zu accepted %10llu evicted\n", "", accepted,
+           (unsigned long long)pool.evicted);
+
+    rsa_mempool_tx_t *tx = malloc(sizeof(*tx));
+    size_t popped = 0;
+    uint64_t checksum = 0;
+    start = bench_now_ns();
+    while (tx && rsa_mempool_pop(&pool, tx)) {
+        checksum += tx->tx.fee;
+        popped++;
+    }
+    bench_report("pop (best account head)", bench_now_ns() - start, popped);
+    bench_sink = checksum;
+
+    // Fresh accounts again, every transaction with a max_time
+    bench_submitter_t bounded = outbid;
+    bounded.first_account = 2 * accounts + 2;
+    bounded.fee_boost = 0;
+    bounded.expiry_window = BENCH_EXPIRY_WINDOW;
+    accepted = bench_submit_all(&bounded, threads);
+    size_t expired = 0;
+    uint64_t now = BENCH_NOW;
+    start = bench_now_ns();
+    while (now <= BENCH_NOW + BENCH_EXPIRY_WINDOW) {
+        now += BENCH_CLOSE_INTERVAL;
+        expired += rsa_mempool_set_time(&pool, now);
+    }
+    bench_report("expire by max_time (per tx)", bench_now_ns() - start, expired);
+    if (expired != accepted || rsa_mempool_size(&pool) != 0) {
+        fprintf(stderr, "%zu of %zu expired\n", expired, accepted);
+        return 1;
+    }
+
+    // Fresh accounts with short queues; the first transaction of every
+    // other account is parked and holds back the ones behind it
+    bench_submitter_t parked = base;
+    size_t depth = config.max_per_account < BENCH_PARKED_DEPTH ? config.max_per_account
+                                                               : BENCH_PARKED_DEPTH;
+    parked.accounts = accounts < BENCH_PARKED_ACCOUNTS ? accounts : BENCH_PARKED_ACCOUNTS;
+    // One slot stays free for the underbid check below
+    if (parked.accounts > (count - 1) / depth) parked.accounts = (count - 1) / depth;
+    parked.count = depth * parked.accounts;
+    parked.first_account = 3 * accounts + 3;
+    parked.park_until = now + BENCH_PARK_DELAY;
+    accepted = bench_submit_all(&parked, threads);
+    if (accepted != parked.count) {
+        fprintf(stderr, "parked phase: only %zu of %zu accepted\n", accepted, parked.count);
+        return 1;
+    }
+
+    memset(&set, 0, sizeof(set));
+    if (!rsa_mempool_build_tx_set(&pool, parked.count, BENCH_BASE_FEE, &set) ||
+        !bench_check_parked(&set, &parked, false)) {
+        fprintf(stderr, "parked transactions offered before their min_time\n");
+        return 1;
+    }
+    start = bench_now_ns();
+    size_t dropped = rsa_mempool_set_time(&pool, parked.park_until);
+    bench_report("release parked (per tx)", bench_now_ns() - start, parked.count / 2);
+    if (dropped != 0 || !rsa_mempool_build_tx_set(&pool, parked.count, BENCH_BASE_FEE, &set) ||
+        !bench_check_parked(&set, &parked, true)) {
+        fprintf(stderr, "parked transactions not released in seq_num order\n");
+        return 1;
+    }
+    printf("%-40s %10zu txs released in order\n", "", set.count);
+
+    // A bid under the base fee is pooled but never offered
+    rsa_transaction_t cheap;
+    rsa_operation_t op;
+    memset(&cheap, 0, sizeof(cheap));
+    memset(&op, 0, sizeof(op));
+    bench_account_id(4 * accounts + 4, cheap.tx_source_account);
+    cheap.seq_num = 1;
+    cheap.fee = BENCH_BASE_FEE - 1;
+    cheap.operations_count = 1;
+    op.type = RSA_OP_PAYMENT;
+    op.operation.payment.asset.type = RSA_ASSET_TYPE_NATIVE;
+    op.operation.payment.amount = 1;
+    bench_account_id(4 * accounts + 5, op.operation.payment.to);
+    rsa_tx_envelope_ref_t envelope = {&cheap, &op, NULL, NULL};
+    if (rsa_mempool_submit(&pool, &envelope, 0) != RSA_MEMPOOL_ADDED ||
+        !rsa_mempool_build_tx_set(&pool, parked.count + 1, BENCH_BASE_FEE, &set) ||
+        set.count != parked.count || set.surged) {
+        fprintf(stderr, "transaction under the base fee offered\n");
+        return 1;
+    }
+    rsa_mempool_tx_set_free(&set);
+
+    free(tx);
+    rsa_mempool_free(&pool);
+    return 0;
+}
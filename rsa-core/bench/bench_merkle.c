@@ -0,0 +1,91 @@
+#include "rsa_merkle.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Per-ledger state-root update cost against total state size: bulk load,
+// then ledgers of 1000 payments (2000 dirtied entries) on 1 and all cores.
+// The per-ledger time should stay flat as the state grows.
+//
+//   rsa-bench-merkle [entries...]     default: 100000 1000000
+
+#define BENCH_LEDGERS 50
+#define BENCH_DIRTY 2000
+
+static void bench_key(uint64_t n, uint8_t key[32]) {
+    uint64_t seed = n * 0x9E3779B97F4A7C15ULL + 1;
+    for (int w = 0; w < 4; w++) {
+        uint64_t word = bench_rand(&seed);
+        memcpy(key + 8 * w, &word, 8);
+    }
+}
+
+static int bench_state(size_t entries, unsigned cores) {
+    rsa_merkle_tree_t tree;
+    rsa_merkle_batch_t batch;
+    rsa_worker_pool_t workers;
+    rsa_merkle_tree_init(&tree);
+    rsa_merkle_batch_init(&batch);
+    if (!rsa_worker_pool_init(&workers, cores)) return 1;
+
+    uint8_t key[32], value[32] = {0};
+    uint64_t seed = 0x243F6A8885A308D3ULL;
+    for (size_t i = 0; i < entries; i++) {
+        bench_key(i, key);
+        if (!rsa_merkle_batch_put(&batch, key, value)) return 1;
+    }
+    printf("-- %zu entries\n", entries);
+    uint64_t start = bench_now_ns();
+    if (!rsa_merkle_apply(&tree, &batch, &workers, cores)) return 1;
+    bench_report("bulk load", bench_now_ns() - start, entries);
+    printf("%-40s %10.2f MB\n", "  tree memory", (double)rsa_merkle_memory(&tree) / (1024.0 * 1024.0));
+
+    unsigned thread_counts[2] = {1, cores};
+    for (int t = 0; t < (cores > 1 ? 2 : 1); t++) {
+        uint64_t elapsed = 0;
+        for (int l = 0; l < BENCH_LEDGERS; l++) {
+            for (int i = 0; i < BENCH_DIRTY; i++) {
+                bench_key(bench_rand(&seed) % entries, key);
+                uint64_t version = bench_rand(&seed);
+                memcpy(value, &version, sizeof(version));
+                rsa_merkle_batch_put(&batch, key, value);
+            }
+            start = bench_now_ns();
+            if (!rsa_merkle_apply(&tree, &batch, &workers, thread_counts[t])) return 1;
+            elapsed += bench_now_ns() - start;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "ledger update, %u thread%s", thread_counts[t],
+                 thread_counts[t] == 1 ? "" : "s");
+        bench_report(name, elapsed, (uint64_t)BENCH_LEDGERS * BENCH_DIRTY);
+        printf("%-40s %10.3f ms/ledger\n", "", (double)elapsed / BENCH_LEDGERS / 1e6);
+    }
+
+    uint8_t root[32];
+    rsa_merkle_root(&tree, root);
+    bench_sink = root[0];
+    rsa_merkle_batch_free(&batch);
+    rsa_merkle_tree_free(&tree);
+    rsa_worker_pool_free(&workers);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned cores = online > 0 ? (unsigned)online : 1;
+    if (cores > RSA_MERKLE_MAX_THREADS) cores = RSA_MERKLE_MAX_THREADS;
+
+    size_t defaults[] = {100000, 1000000};
+    int rc = 0;
+    if (argc > 1) {
+        for (int i = 1; i < argc && rc == 0; i++) rc = bench_state(strtoull(argv[i], NULL, 10), cores);
+    } else {
+        for (size_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]) && rc == 0; i++) {
+            rc = bench_state(defaults[i], cores);
+        }
+    }
+    if (rc) fprintf(stderr, "allocation failed\n");
+    return rc;
+}
@@ -0,0 +1,230 @@
+#include "rsa_mvcc.h"
+#include "bench_util.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Versioned account reads while ledgers are applied: point lookups from
+// reader threads with the writer idle, then the same readers running
+// against ledgers of 2000 account updates. Reader cost should barely move
+// and commit (publish + reclaim) should stay small.
+//
+// Last, ledgers of 2000 erasures, each followed by compaction, against
+// readers that open short views with pauses between them, as request
+// handlers do. Compaction runs whenever no view is open and views refused
+// meanwhile are retried; every account read must still be the one asked
+// for, or the run fails.
+//
+//   rsa-bench-mvcc [accounts] [readers]     default: 1000000 2
+
+#define BENCH_LEDGERS 200
+#define BENCH_DIRTY 2000
+#define BENCH_GETS_PER_VIEW 1000
+#define BENCH_PACED_GETS 100            // per view while compacting
+#define BENCH_PAUSE_NS 20000            // between paced views
+#define BENCH_COMPACT_TRIES 100000      // per ledger, before giving up
+
+typedef struct {
+    rsa_mvcc_domain_t *domain;
+    rsa_mvcc_store_t *accounts;
+    size_t count;
+    uint64_t seed;
+    volatile int *stop;
+    bool paced;
+    uint64_t gets;
+    uint64_t elapsed_ns;
+    uint64_t refused;                   // opens refused (slots full or compacting)
+    uint64_t wrong;                     // gets returning another account
+} bench_reader_t;
+
+static void bench_account_id(uint64_t n, uint32_t id[8]) {
+    uint64_t seed = n * 0x9E3779B97F4A7C15ULL + 1;
+    for (int w = 0; w < 4; w++) {
+        uint64_t word = bench_rand(&seed);
+        memcpy(id + 2 * w, &word, 8);
+    }
+}
+
+static void *bench_reader(void *arg) {
+    bench_reader_t *reader = arg;
+    struct timespec pause = {0, BENCH_PAUSE_NS};
+    int per_view = reader->paced ? BENCH_PACED_GETS : BENCH_GETS_PER_VIEW;
+    uint64_t found = 0, start = bench_now_ns();
+    uint32_t id[8];
+    while (!__atomic_load_n(reader->stop, __ATOMIC_RELAXED)) {
+        rsa_mvcc_view_t view;
+        if (!rsa_mvcc_view_open(reader->domain, &view)) {
+            reader->refused++;
+            if (reader->paced) nanosleep(&pause, NULL);
+            continue;
+        }
+        for (int i = 0; i < per_view; i++) {
+            bench_account_id(bench_rand(&reader->seed) % reader->count, id);
+            const rsa_account_t *account = rsa_mvcc_get_account(&view, reader->accounts, id);
+            if (account && memcmp(account->account_id, id, 32) != 0) reader->wrong++;
+            found += account != NULL;
+        }
+        rsa_mvcc_view_close(&view);
+        reader->gets += (uint64_t)per_view;
+        if (reader->paced) nanosleep(&pause, NULL);
+    }
+    reader->elapsed_ns = bench_now_ns() - start;
+    bench_sink = found;
+    return NULL;
+}
+
+// Runs the readers for `ledgers` writer ledgers, or for ~1 s when 0
+static int bench_round(const char *name, rsa_mvcc_domain_t *domain, rsa_mvcc_store_t *accounts,
+                       size_t count, unsigned readers, int ledgers) {
+    volatile int stop = 0;
+    pthread_t threads[RSA_MVCC_MAX_READERS];
+    bench_reader_t state[RSA_MVCC_MAX_READERS];
+    for (unsigned r = 0; r < readers; r++) {
+        state[r] = (bench_reader_t){.domain = domain, .accounts = accounts, .count = count,
+                                    .seed = 0x243F6A8885A308D3ULL + r, .stop = &stop};
+        pthread_create(&threads[r], NULL, bench_reader, &state[r]);
+    }
+
+    uint64_t seed = 0x13198A2E03707344ULL, put_ns = 0, commit_ns = 0, retired_peak = 0;
+    rsa_account_t account;
+    if (ledgers == 0) {
+        struct timespec second = {1, 0};
+        nanosleep(&second, NULL);
+    }
+    bool ok = true;
+    for (int l = 0; ok && l < ledgers; l++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; ok && i < BENCH_DIRTY; i++) {
+            uint32_t id[8];
+            bench_account_id(bench_rand(&seed) % count, id);
+            account = *(const rsa_account_t *)rsa_mvcc_latest(accounts, id);
+            account.balance += 1;
+            account.seq_num++;
+            ok = rsa_mvcc_put(accounts, &account);
+        }
+        uint64_t mid = bench_now_ns();
+        if (domain->retired_count > retired_peak) retired_peak = domain->retired_count;
+        rsa_mvcc_commit(domain);
+        commit_ns += bench_now_ns() - mid;
+        put_ns += mid - start;
+    }
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+    uint64_t gets = 0, elapsed = 0;
+    for (unsigned r = 0; r < readers; r++) {
+        pthread_join(threads[r], NULL);
+        gets += state[r].gets;
+        elapsed += state[r].elapsed_ns;
+    }
+    // Readers are joined first, so a failed put never leaves them running
+    if (!ok) return 1;
+    bench_report(name, gets ? elapsed : 0, gets);
+    if (ledgers > 0) {
+        bench_report("  writer put", put_ns, (uint64_t)ledgers * BENCH_DIRTY);
+        printf("%-40s %10.3f ms/ledger\n", "  commit + reclaim", (double)commit_ns / ledgers / 1e6);
+        printf("%-40s %10" PRIu64 " versions\n", "  retired peak", retired_peak);
+    }
+    return 0;
+}
+
+// Erases and compacts under paced readers; nonzero if a reader saw the
+// wrong account or compaction never found the domain quiet
+static int bench_compact_round(rsa_mvcc_domain_t *domain, rsa_mvcc_store_t *accounts,
+                               size_t count, unsigned readers) {
+    volatile int stop = 0;
+    pthread_t threads[RSA_MVCC_MAX_READERS];
+    bench_reader_t state[RSA_MVCC_MAX_READERS];
+    for (unsigned r = 0; r < readers; r++) {
+        state[r] = (bench_reader_t){.domain = domain, .accounts = accounts, .count = count,
+                                    .seed = 0xA4093822299F31D0ULL + r, .stop = &stop, .paced = true};
+        pthread_create(&threads[r], NULL, bench_reader, &state[r]);
+    }
+
+    uint64_t seed = 0x082EFA98EC4E6C89ULL, compact_ns = 0, tries = 0, moved = 0;
+    int compactions = 0;
+    bool ok = true;
+    for (int l = 0; ok && l < BENCH_LEDGERS; l++) {
+        for (int i = 0; i < BENCH_DIRTY; i++) {
+            rsa_account_t account;
+            bench_account_id(bench_rand(&seed) % count, account.account_id);
+            rsa_mvcc_erase(accounts, &account);  // false when already erased
+        }
+        rsa_mvcc_commit(domain);
+
+        size_t n = 0;
+        uint64_t start = bench_now_ns();
+        int t = 0;
+        while (t < BENCH_COMPACT_TRIES && !rsa_mvcc_compact(accounts, &n)) t++;
+        compact_ns += bench_now_ns() - start;
+        tries += (uint64_t)t + 1;
+        if (t < BENCH_COMPACT_TRIES) {
+            compactions++;
+            moved += n;
+        }
+    }
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+    uint64_t gets = 0, elapsed = 0, refused = 0, wrong = 0;
+    for (unsigned r = 0; r < readers; r++) {
+        pthread_join(threads[r], NULL);
+        gets += state[r].gets;
+        elapsed += state[r].elapsed_ns;
+        refused += state[r].refused;
+        wrong += state[r].wrong;
+    }
+    bench_report("view get, during compaction", gets ? elapsed : 0, gets);
+    bench_report("  compact (incl. waiting for quiet)", compact_ns, moved);
+    printf("%-40s %10d compactions %10" PRIu64 " tries\n", "", compactions, tries);
+    printf("%-40s %10" PRIu64 " views refused\n", "", refused);
+    if (wrong || compactions == 0) {
+        fprintf(stderr, "compaction with readers failed: %" PRIu64 " wrong reads, %d compactions\n",
+                wrong, compactions);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    unsigned readers = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 2;
+    if (count == 0) count = 1;
+    if (readers == 0) readers = 1;
+    if (readers > RSA_MVCC_MAX_READERS) readers = RSA_MVCC_MAX_READERS;
+
+    rsa_mvcc_domain_t *domain = malloc(sizeof(*domain));
+    rsa_mvcc_store_t accounts;
+    if (!domain || !rsa_mvcc_domain_init(domain, 1, 0) ||
+        !rsa_mvcc_store_init(&accounts, domain, RSA_WAL_ACCOUNT, count)) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+
+    rsa_account_t account;
+    memset(&account, 0, sizeof(account));
+    account.balance = 1000000000;
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        bench_account_id(i, account.account_id);
+        if (!rsa_mvcc_put(&accounts, &account)) {
+            fprintf(stderr, "allocation failed\n");
+            return 1;
+        }
+    }
+    rsa_mvcc_commit(domain);
+    printf("-- %zu accounts, %u reader%s\n", count, readers, readers == 1 ? "" : "s");
+    bench_report("load", bench_now_ns() - start, count);
+
+    int rc = bench_round("view get, writer idle", domain, &accounts, count, readers, 0);
+    if (rc == 0) {
+        rc = bench_round("view get, during apply", domain, &accounts, count, readers, BENCH_LEDGERS);
+    }
+    if (rc) fprintf(stderr, "allocation failed\n");
+    if (rc == 0) rc = bench_compact_round(domain, &accounts, count, readers);
+
+    rsa_mvcc_store_free(&accounts);
+    rsa_mvcc_domain_free(domain);
+    free(domain);
+    return rc;
+}
@@ -0,0 +1,147 @@
+#include "rsa_slab.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Slab pools against malloc for long-lived ledger entries, trust lines
+// (the most numerous) then a quarter as many accounts: filling; churn
+// rounds that each free a random tenth and allocate as many again, as
+// weeks of uptime do; then three quarters freed at random and the rest
+// iterated before and after compaction (malloc cannot compact). Memory is
+// what each holds from the OS: mapped slabs, or glibc's heap.
+//
+//   rsa-bench-slab [entries] [churn rounds]     default: 1000000 20
+
+// Heap held by glibc; trimmed first so the previous run does not count
+static double bench_malloc_mb(bool trim) {
+#if defined(__GLIBC__)
+    if (trim) malloc_trim(0);
+    struct mallinfo2 info = mallinfo2();
+    return (double)(info.arena + info.hblkhd) / 1e6;
+#else
+    (void)trim;
+    return 0.0;
+#endif
+}
+
+static double bench_slab_mb(const rsa_slab_pool_t *pool) {
+    return (double)((pool->slab_count + pool->evacuated_count) * (size_t)RSA_SLAB_BYTES) / 1e6;
+}
+
+// Frees a random tenth and allocates as many again, into the same handles
+static uint64_t bench_churn(rsa_slab_pool_t *pool, void **objects, size_t count, size_t size,
+                            size_t rounds, uint64_t *seed) {
+    uint64_t start = bench_now_ns();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t n = 0; n < count / 10; n++) {
+            size_t i = bench_rand(seed) % count;
+            if (pool) {
+                rsa_slab_free(pool, objects[i]);
+                objects[i] = rsa_slab_alloc(pool);
+            } else {
+                free(objects[i]);
+                objects[i] = malloc(size);
+            }
+            memset(objects[i], (int)n, size);
+        }
+    }
+    return bench_now_ns() - start;
+}
+
+static uint64_t bench_sum(rsa_slab_pool_t *pool, void **objects, size_t count, uint64_t *elapsed) {
+    uint64_t sum = 0, start = bench_now_ns();
+    if (pool) {
+        rsa_slab_iter_t iter = {0};
+        for (const uint64_t *p; (p = rsa_slab_iter_next(pool, &iter)) != NULL;) sum += p[1];
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            if (objects[i]) sum += ((const uint64_t *)objects[i])[1];
+        }
+    }
+    *elapsed = bench_now_ns() - start;
+    return sum;
+}
+
+static int bench_type(const char *type, size_t size, size_t count, size_t rounds) {
+    void **objects = malloc(count * sizeof(void *));
+    if (!objects) return 1;
+    printf("-- %zu %s of %zu bytes\n", count, type, size);
+
+    for (int use_pool = 1; use_pool >= 0; use_pool--) {
+        rsa_slab_pool_t slab;
+        rsa_slab_config_t config = {.object_size = size, .monitor_type = RSA_SLAB_UNMONITORED};
+        rsa_slab_pool_t *pool = use_pool && rsa_slab_pool_init(&slab, &config) ? &slab : NULL;
+        if (use_pool && !pool) return 1;
+        const char *name = pool ? "slab" : "malloc";
+        double base_mb = bench_malloc_mb(true);
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        char label[64];
+
+        uint64_t start = bench_now_ns();
+        for (size_t i = 0; i < count; i++) {
+            objects[i] = pool ? rsa_slab_alloc(pool) : malloc(size);
+            if (!objects[i]) {
+                fprintf(stderr, "allocation failed\n");
+                return 1;
+            }
+            memset(objects[i], (int)i, size);
+        }
+        snprintf(label, sizeof(label), "%s fill", name);
+        bench_report(label, bench_now_ns() - start, count);
+
+        uint64_t elapsed = bench_churn(pool, objects, count, size, rounds, &seed);
+        snprintf(label, sizeof(label), "%s churn (free + alloc)", name);
+        bench_report(label, elapsed, rounds * (count / 10));
+        printf("%-40s %10.1f MB held\n", "",
+               pool ? bench_slab_mb(pool) : bench_malloc_mb(false) - base_mb);
+
+        size_t live = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (bench_rand(&seed) % 4 != 0) {
+                if (pool) rsa_slab_free(pool, objects[i]);
+                else free(objects[i]);
+                objects[i] = NULL;
+            } else {
+                live++;
+            }
+        }
+        bench_sink += bench_sum(pool, objects, count, &elapsed);
+        snprintf(label, sizeof(label), "%s iterate, a quarter live", name);
+        bench_report(label, elapsed, live);
+        printf("%-40s %10.1f MB held\n", "",
+               pool ? bench_slab_mb(pool) : bench_malloc_mb(false) - base_mb);
+
+        if (pool) {
+            start = bench_now_ns();
+            size_t moved = rsa_slab_compact(pool);
+            for (size_t i = 0; i < count; i++) objects[i] = rsa_slab_forward(pool, objects[i]);
+            rsa_slab_compact_finish(pool);
+            bench_report("slab compact + forward", bench_now_ns() - start, moved);
+            bench_sink += bench_sum(pool, objects, count, &elapsed);
+            bench_report("slab iterate, compacted", elapsed, live);
+            printf("%-40s %10.1f MB held\n", "", bench_slab_mb(pool));
+            rsa_slab_pool_free(pool);
+        } else {
+            for (size_t i = 0; i < count; i++) free(objects[i]);
+        }
+    }
+    free(objects);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t rounds = argc > 2 ? strtoull(argv[2], NULL, 10) : 20;
+    if (count < 10) count = 10;
+
+    if (bench_type("trust lines", sizeof(rsa_trustline_t), count, rounds) != 0 ||
+        bench_type("accounts", sizeof(rsa_account_t), count / 4, rounds) != 0) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "rsa_snapshot.h"
+#include "bench_util.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Snapshot write, open and cold point lookups. The file is dropped from
+// the page cache before opening so lookups pay the real fault cost. Last,
+// a header with a correct checksum but a data offset that wraps past the
+// end of the address space must be refused.
+//
+//   rsa-bench-snapshot [accounts] [path]   default: 1000000 ./rsa-bench.snapshot
+
+#define BENCH_LOOKUPS 200000
+
+static void fill_id(uint32_t account_id[8], uint64_t n) {
+    uint64_t seed = n * 0x9E3779B97F4A7C15ULL + 1;
+    for (int w = 0; w < 8; w++) account_id[w] = (uint32_t)bench_rand(&seed);
+}
+
+// Rewrites the header so data_offset + data_length wraps to a small value,
+// re-signs it, and checks the file no longer opens
+static bool bench_crafted_refused(const char *path) {
+    rsa_snapshot_header_t header;
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return false;
+    bool ok = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    rsa_snapshot_section_t *section = &header.sections[RSA_SNAPSHOT_ACCOUNTS];
+    section->data_offset = (uint64_t)0 - (section->data_length & ~(uint64_t)(RSA_SNAPSHOT_PAGE_SIZE - 1));
+    SHA256((const unsigned char *)&header, offsetof(rsa_snapshot_header_t, header_checksum),
+           header.header_checksum);
+    ok = ok && pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    close(fd);
+    if (!ok) return false;
+
+    rsa_snapshot_t snapshot;
+    if (!rsa_snapshot_open(&snapshot, path)) return true;
+    rsa_snapshot_close(&snapshot);
+    return false;
+}
+
+int main(int argc, char **argv) {
+    uint64_t accounts = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    const char *path = argc > 2 ? argv[2] : "rsa-bench.snapshot";
+    if (accounts == 0) {
+        fprintf(stderr, "need at least 1 account\n");
+        return 1;
+    }
+
+    uint8_t ledger_hash[32] = {0};
+    rsa_snapshot_writer_t writer;
+    if (!rsa_snapshot_writer_open(&writer, path, 1, ledger_hash) ||
+        !rsa_snapshot_writer_begin(&writer, RSA_SNAPSHOT_ACCOUNTS)) {
+        fprintf(stderr, "cannot create %s\n", path);
+        return 1;
+    }
+
+    printf("-- %llu accounts\n", (unsigned long long)accounts);
+    uint64_t start = bench_now_ns();
+    rsa_account_t account;
+    memset(&account, 0, sizeof(account));
+    account.thresholds.master_weight = 1;
+    for (uint64_t i = 0; i < accounts; i++) {
+        fill_id(account.account_id, i);
+        account.balance = (int64_t)i;
+        account.seq_num = 1;
+        if (!rsa_snapshot_write_account(&writer, &account)) {
+            fprintf(stderr, "write failed\n");
+            rsa_snapshot_writer_abort(&writer);
+            return 1;
+        }
+    }
+    if (!rsa_snapshot_writer_commit(&writer)) {
+        fprintf(stderr, "commit failed\n");
+        rsa_snapshot_writer_abort(&writer);
+        return 1;
+    }
+    bench_report("write + commit", bench_now_ns() - start, accounts);
+
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+
+    rsa_snapshot_t snapshot;
+    start = bench_now_ns();
+    if (!rsa_snapshot_open(&snapshot, path)) {
+        fprintf(stderr, "open failed\n");
+        return 1;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    printf("%-40s %10.3f ms  (%.1f MB file)\n", "open", (double)elapsed / 1e6,
+           (double)snapshot.length / (1024.0 * 1024.0));
+
+    uint64_t seed = 0x243F6A8885A308D3ULL;
+    uint64_t found = 0;
+    uint32_t account_id[8];
+    start = bench_now_ns();
+    for (int i = 0; i < BENCH_LOOKUPS; i++) {
+        fill_id(account_id, bench_rand(&seed) % accounts);
+        const rsa_account_t *hit = rsa_snapshot_find_account(&snapshot, account_id);
+        found += hit ? (uint64_t)hit->balance + 1 : 0;
+    }
+    bench_report("lookup (cold, random)", bench_now_ns() - start, BENCH_LOOKUPS);
+
+    start = bench_now_ns();
+    for (int i = 0; i < BENCH_LOOKUPS; i++) {
+        fill_id(account_id, bench_rand(&seed) % accounts);
+        const rsa_account_t *hit = rsa_snapshot_find_account(&snapshot, account_id);
+        found += hit ? (uint64_t)hit->balance + 1 : 0;
+    }
+    bench_report("lookup (warm, random)", bench_now_ns() - start, BENCH_LOOKUPS);
+    bench_sink = found;
+
+    start = bench_now_ns();
+    bool valid = rsa_snapshot_verify(&snapshot);
+    bench_report(valid ? "verify" : "verify (FAILED)", bench_now_ns() - start, accounts);
+
+    rsa_snapshot_close(&snapshot);
+
+    bool refused = bench_crafted_refused(path);
+    printf("%-40s %10s\n", "crafted section offset", refused ? "refused" : "ACCEPTED");
+    unlink(path);
+    return valid && refused ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#ifndef RSA_BENCH_UTIL_H
+#define RSA_BENCH_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Shared helpers for the rsa-core micro-benchmarks
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64* - deterministic input generation
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static inline void bench_report(const char *name, uint64_t elapsed_ns, uint64_t items) {
+    double ns_per_item = items ? (double)elapsed_ns / (double)items : 0.0;
+    double mitems_per_sec = elapsed_ns ? (double)items * 1000.0 / (double)elapsed_ns : 0.0;
+    printf("%-40s %10.2f ns/item %10.2f M items/s\n", name, ns_per_item, mitems_per_sec);
+}
+
+// Keeps results observable so the optimizer cannot drop the measured work
+static volatile uint64_t bench_sink;
+
+#endif // RSA_BENCH_UTIL_H
@@ -0,0 +1,184 @@
+#include "rsa_wal.h"
+#include "bench_util.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Durable ledger commit latency vs transactions per ledger (each payment
+// logs two account updates), then group commit across concurrent writers.
+// Run it on the device that will hold the log; tmpfs makes fdatasync free.
+// The log goes in a fresh directory under `parent`, and only the segments
+// it wrote are removed afterwards.
+//
+//   rsa-bench-wal [parent]      default: .
+
+#define BENCH_ACCOUNTS 100000
+#define BENCH_LEDGERS 200
+#define BENCH_WRITER_RECORDS 2000
+
+static rsa_account_t accounts[BENCH_ACCOUNTS];
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void report_latency(const char *name, uint64_t *samples, size_t count) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) total += samples[i];
+    qsort(samples, count, sizeof(uint64_t), compare_u64);
+    printf("%-28s mean %8.3f ms  p50 %8.3f ms  p99 %8.3f ms\n", name,
+           (double)total / (double)count / 1e6, (double)samples[count / 2] / 1e6,
+           (double)samples[count * 99 / 100] / 1e6);
+}
+
+static bool bench_ledgers(rsa_wal_t *wal, uint64_t *ledger_seq, size_t txs, uint64_t *seed) {
+    uint64_t encode[BENCH_LEDGERS], commit[BENCH_LEDGERS];
+    rsa_wal_batch_t batch;
+    rsa_wal_batch_init(&batch);
+    uint8_t ledger_hash[32] = {0};
+
+    for (int l = 0; l < BENCH_LEDGERS; l++) {
+        uint64_t start = bench_now_ns();
+        rsa_wal_batch_reset(&batch);
+        for (size_t t = 0; t < txs; t++) {
+            rsa_account_t *from = &accounts[bench_rand(seed) % BENCH_ACCOUNTS];
+            rsa_account_t *to = &accounts[bench_rand(seed) % BENCH_ACCOUNTS];
+            rsa_account_t before = *from;
+            from->balance -= 100;
+            from->seq_num++;
+            rsa_wal_batch_update(&batch, RSA_WAL_ACCOUNT, &before, from);
+            before = *to;
+            to->balance += 100;
+            rsa_wal_batch_update(&batch, RSA_WAL_ACCOUNT, &before, to);
+        }
+        uint64_t encoded = bench_now_ns();
+        memcpy(ledger_hash, ledger_seq, sizeof(*ledger_seq));
+        if (!rsa_wal_commit_ledger(wal, ++*ledger_seq, ledger_hash, NULL, &batch)) {
+            rsa_wal_batch_free(&batch);
+            return false;
+        }
+        encode[l] = encoded - start;
+        commit[l] = bench_now_ns() - encoded;
+    }
+
+    char name[64];
+    printf("-- %zu tx/ledger (%zu bytes logged)\n", txs, batch.length);
+    snprintf(name, sizeof(name), "  encode changes");
+    report_latency(name, encode, BENCH_LEDGERS);
+    snprintf(name, sizeof(name), "  durable commit");
+    report_latency(name, commit, BENCH_LEDGERS);
+    rsa_wal_batch_free(&batch);
+    return true;
+}
+
+typedef struct {
+    rsa_wal_t *wal;
+    uint64_t ledger_seq;
+    bool ok;
+} writer_arg_t;
+
+static void *writer_main(void *arg) {
+    writer_arg_t *w = arg;
+    rsa_wal_batch_t batch;
+    rsa_wal_batch_init(&batch);
+    rsa_account_t account = accounts[0];
+    rsa_account_t before = account;
+    account.balance++;
+    rsa_wal_batch_update(&batch, RSA_WAL_ACCOUNT, &before, &account);
+
+    w->ok = true;
+    for (int i = 0; i < BENCH_WRITER_RECORDS && w->ok; i++) {
+        uint64_t lsn;
+        w->ok = rsa_wal_append(w->wal, w->ledger_seq, &batch, &lsn) && rsa_wal_sync(w->wal, lsn);
+    }
+    rsa_wal_batch_free(&batch);
+    return NULL;
+}
+
+static bool bench_writers(rsa_wal_t *wal, uint64_t *ledger_seq, int threads) {
+    pthread_t tids[16];
+    writer_arg_t args[16];
+    uint64_t syncs = wal->sync_count;
+    uint64_t start = bench_now_ns();
+
+    ++*ledger_seq;
+    for (int i = 0; i < threads; i++) {
+        args[i] = (writer_arg_t){wal, *ledger_seq, false};
+        pthread_create(&tids[i], NULL, writer_main, &args[i]);
+    }
+    bool ok = true;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        ok = ok && args[i].ok;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    uint8_t ledger_hash[32] = {0};
+    if (!ok || !rsa_wal_commit_ledger(wal, *ledger_seq, ledger_hash, NULL, NULL)) return false;
+
+    uint64_t records = (uint64_t)threads * BENCH_WRITER_RECORDS;
+    char name[64];
+    snprintf(name, sizeof(name), "%d writers, append + sync", threads);
+    bench_report(name, elapsed, records);
+    printf("%-40s %10.2f records/sync\n", "",
+           (double)records / (double)(wal->sync_count - syncs - 1));
+    return true;
+}
+
+// Deletes the segments the log wrote, then its directory if that left it
+// empty
+static void bench_remove_log(const char *dir, const uint64_t *firsts, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        char path[600];
+        snprintf(path, sizeof(path), "%s/%016" PRIx64 ".wal", dir, firsts[i]);
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+int main(int argc, char **argv) {
+    const char *parent = argc > 1 ? argv[1] : ".";
+    uint64_t seed = 0x243F6A8885A308D3ULL;
+    for (size_t i = 0; i < BENCH_ACCOUNTS; i++) {
+        for (int w = 0; w < 8; w++) accounts[i].account_id[w] = (uint32_t)bench_rand(&seed);
+        accounts[i].balance = 1000000000;
+        accounts[i].thresholds.master_weight = 1;
+    }
+
+    char dir[480];
+    snprintf(dir, sizeof(dir), "%s/rsa-bench-wal.XXXXXX", parent);
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "cannot create a directory in %s\n", parent);
+        return 1;
+    }
+
+    rsa_wal_t wal;
+    if (!rsa_wal_open(&wal, dir, NULL)) {
+        fprintf(stderr, "cannot open log in %s\n", dir);
+        rmdir(dir);
+        return 1;
+    }
+
+    uint64_t ledger_seq = 0;
+    size_t sizes[] = {1, 10, 100, 1000, 5000};
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && ok; i++) {
+        ok = bench_ledgers(&wal, &ledger_seq, sizes[i], &seed);
+    }
+    printf("-- group commit\n");
+    for (int threads = 1; threads <= 8 && ok; threads *= 2) {
+        ok = bench_writers(&wal, &ledger_seq, threads);
+    }
+
+    size_t segments = wal.segment_count;
+    uint64_t *firsts = malloc((segments ? segments : 1) * sizeof(*firsts));
+    for (size_t i = 0; firsts && i < segments; i++) firsts[i] = wal.segments[i].first_lsn;
+    ok = rsa_wal_close(&wal) && ok;
+    if (firsts) bench_remove_log(dir, firsts, segments);
+    free(firsts);
+    if (!ok) fprintf(stderr, "log write failed\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#include "rsa_xdr.h"
+#include "bench_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// XDR codec at catchup scale: a stream of account entries (a quarter with
+// signers and a home domain) and trust lines, encoded back to back and
+// decoded again, as a history archive bucket would be. Throughput is
+// reported in encoded bytes per second next to a plain memcpy of the same
+// stream, the memory-bandwidth ceiling.
+//
+//   rsa-bench-xdr [entries]     default: 1000000 (as many of each)
+
+static void bench_account(uint64_t n, rsa_account_t *account) {
+    uint64_t seed = n * 0x9E3779B97F4A7C15ULL + 1;
+    memset(account, 0, sizeof(*account));
+    for (int w = 0; w < 8; w++) account->account_id[w] = (uint32_t)bench_rand(&seed);
+    account->balance = (int64_t)(bench_rand(&seed) % 100000000000ULL);
+    account->seq_num = bench_rand(&seed) >> 16;
+    account->thresholds.master_weight = 1;
+    if (n % 4 == 0) {
+        account->home_domain_len = 11;
+        memcpy(account->home_domain, "example.com", 11);
+        account->signer_count = 1 + (uint32_t)(n % 3);
+        for (uint32_t i = 0; i < account->signer_count; i++) {
+            for (int b = 0; b < 32; b++) account->signers[i].key[b] = (uint8_t)bench_rand(&seed);
+            account->signers[i].weight = 1;
+        }
+        account->num_sub_entries = account->signer_count;
+    }
+}
+
+static void bench_trustline(uint64_t n, rsa_trustline_t *trustline) {
+    uint64_t seed = n * 0xD1B54A32D192ED03ULL + 7;
+    memset(trustline, 0, sizeof(*trustline));
+    for (int w = 0; w < 8; w++) trustline->account_id[w] = (uint32_t)bench_rand(&seed);
+    trustline->asset.type = RSA_ASSET_TYPE_CREDIT_ALPHANUM4;
+    memcpy(trustline->asset.asset.credit_alphanum4.code, "USDT", 4);
+    memset(trustline->asset.asset.credit_alphanum4.issuer, 0x42, 32);
+    trustline->balance = (int64_t)(bench_rand(&seed) % 1000000000);
+    trustline->limit = INT64_MAX;
+    trustline->flags = 1;
+}
+
+static void bench_mbps(const char *name, uint64_t ns, size_t bytes, size_t items) {
+    bench_report(name, ns, items);
+    printf("%-40s %10.1f MB/s\n", "", ns ? (double)bytes * 1000.0 / (double)ns : 0.0);
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+
+    rsa_account_t *accounts = malloc(count * sizeof(rsa_account_t));
+    rsa_trustline_t *trustlines = malloc(count * sizeof(rsa_trustline_t));
+    if (!accounts || !trustlines) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        bench_account(i, &accounts[i]);
+        bench_trustline(i, &trustlines[i]);
+        size += rsa_xdr_account_size(&accounts[i]) + rsa_xdr_trustline_size(&trustlines[i]);
+    }
+    uint8_t *stream = malloc(size);
+    uint8_t *copy = malloc(size);
+    if (!stream || !copy) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    memset(stream, 0, size);  // fault the pages in outside the timings
+    memset(copy, 0, size);
+    printf("-- %zu accounts, %zu trust lines, %.1f MB encoded\n", count, count, (double)size / 1e6);
+
+    rsa_xdr_writer_t writer;
+    rsa_xdr_writer_init(&writer, stream, size);
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        rsa_xdr_put_account(&writer, &accounts[i]);
+        rsa_xdr_put_trustline(&writer, &trustlines[i]);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    if (writer.overflow || writer.size != size) {
+        fprintf(stderr, "encode failed\n");
+        return 1;
+    }
+    bench_mbps("encode", elapsed, size, 2 * count);
+
+    // Decoding into fresh structs each time, as catchup applies them
+    rsa_account_t account;
+    rsa_trustline_t trustline;
+    size_t mismatches = 0;
+    uint64_t acc = 0;
+    rsa_xdr_reader_t reader;
+    rsa_xdr_reader_init(&reader, stream, size);
+    start = bench_now_ns();
+    for (size_t i = 0; i < count; i++) {
+        rsa_xdr_get_account(&reader, &account);
+        rsa_xdr_get_trustline(&reader, &trustline);
+        acc += (uint64_t)account.balance + (uint64_t)trustline.balance;
+        if (i % 64 == 0 && (memcmp(&account, &accounts[i], sizeof(account)) != 0 ||
+                            memcmp(&trustline, &trustlines[i], sizeof(trustline)) != 0)) {
+            mismatches++;
+        }
+    }
+    elapsed = bench_now_ns() - start;
+    if (reader.error || reader.pos != size) {
+        fprintf(stderr, "decode failed\n");
+        return 1;
+    }
+    bench_mbps("decode", elapsed, size, 2 * count);
+    if (mismatches) fprintf(stderr, "%zu decoded entries differ\n", mismatches);
+
+    start = bench_now_ns();
+    memcpy(copy, stream, size);
+    elapsed = bench_now_ns() - start;
+    acc += copy[size / 2];
+    bench_mbps("memcpy (bandwidth ceiling)", elapsed, size, 2 * count);
+
+    bench_sink = acc;
+    free(copy);
+    free(stream);
+    free(trustlines);
+    free(accounts);
+    return mismatches != 0;
+}
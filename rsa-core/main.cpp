@@ -2,6 +2,10 @@
 #include <iomanip>
 #include <cstring>
 #include "rsa_token.h"
+#include "rsa_price.h"
+#include "rsa_envelope.h"
+#include "rsa_arena.h"
+#include <vector>
 
 void print_hex(const uint8_t *data, size_t len) {
     for (size_t i = 0; i < len; i++) {
@@ -57,6 +61,7 @@ void demo_transaction_signing() {
     memset(&tx, 0, sizeof(tx));
     
     // Set transaction details
+    memcpy(tx.tx_source_account, public_key, sizeof(tx.tx_source_account));
     tx.fee = RSA_BASE_FEE;
     tx.seq_num = 1;
     tx.operations_count = 1;
@@ -69,40 +74,118 @@ void demo_transaction_signing() {
     tx.memo.type = RSA_MEMO_TEXT;
     strcpy(tx.memo.memo.text, "Test transaction");
     
-    // Create payment operation
-    rsa_operation_t *op = (rsa_operation_t*)(&tx + 1);
-    op->type = RSA_OP_PAYMENT;
-    op->operation.payment.amount = rsa_parse_amount("100.0000000"); // 100 RSA
+    // Create payment operation; operations travel next to the transaction
+    // in an envelope, not inside the struct
+    rsa_operation_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = RSA_OP_PAYMENT;
+    op.operation.payment.amount = rsa_parse_amount("100.0000000"); // 100 RSA
     
     // Set destination (same as source for demo)
-    memcpy(op->operation.payment.to, public_key, 32);
-    memcpy(op->operation.payment.from, public_key, 32);
+    memcpy(op.operation.payment.to, public_key, 32);
+    memcpy(op.operation.payment.from, public_key, 32);
     
     // Set asset to native RSA
-    op->operation.payment.asset.type = RSA_ASSET_TYPE_NATIVE;
+    op.operation.payment.asset.type = RSA_ASSET_TYPE_NATIVE;
     
     // Sign transaction
     uint8_t signature[256];
-    if (rsa_sign_transaction(private_key, &tx, signature)) {
-        std::cout << "✓ Transaction signed successfully" << std::endl;
-        std::cout << "Transaction hash: ";
-        
-        uint8_t tx_hash[32];
-        rsa_hash_transaction(&tx, tx_hash);
-        print_hex(tx_hash, 32);
-        
-        std::cout << "Signature: ";
-        print_hex(signature, 256);
-        
-        // Verify signature
-        if (rsa_verify_signature(public_key, &tx, signature)) {
+    if (!rsa_sign_transaction(private_key, &tx, signature)) {
+        std::cout << "✗ Failed to sign transaction" << std::endl;
+        return;
+    }
+    std::cout << "✓ Transaction signed successfully" << std::endl;
+    std::cout << "Transaction hash: ";
+    
+    uint8_t tx_hash[32];
+    rsa_hash_transaction(&tx, tx_hash);
+    print_hex(tx_hash, 32);
+    
+    std::cout << "Signature: ";
+    print_hex(signature, 256);
+    
+    // Ship the transaction, its payment and the signature as one envelope;
+    // the signer key slot is sized as rsa_verify_signature() reads it
+    uint8_t signer_key[RSA_ENVELOPE_PUBLIC_KEY_BYTES] = {0};
+    memcpy(signer_key, public_key, sizeof(public_key));
+    rsa_envelope_t envelope;
+    if (!rsa_envelope_build(&envelope, &tx, &op, 1)) {
+        std::cout << "✗ Failed to build envelope" << std::endl;
+        return;
+    }
+    if (!rsa_envelope_add_signature(&envelope, signer_key, signature)) {
+        std::cout << "✗ Failed to add signature to envelope" << std::endl;
+        rsa_envelope_free(&envelope);
+        return;
+    }
+    std::cout << "✓ Signed envelope: " << envelope.size << " bytes" << std::endl;
+    
+    // Verify signature as a receiver would, from the decoded envelope
+    rsa_envelope_view_t view;
+    rsa_transaction_t decoded_tx;
+    rsa_operation_t decoded_op;
+    if (rsa_envelope_view(&envelope, &view)) {
+        rsa_tx_envelope_ref_t ref = rsa_envelope_decode(&view, &decoded_tx, &decoded_op);
+        if (rsa_verify_signature(ref.public_key, ref.tx, ref.signature)) {
             std::cout << "✓ Signature verified successfully" << std::endl;
         } else {
             std::cout << "✗ Signature verification failed" << std::endl;
         }
     } else {
-        std::cout << "✗ Failed to sign transaction" << std::endl;
+        std::cout << "✗ Failed to parse envelope" << std::endl;
     }
+    rsa_envelope_free(&envelope);
+}
+
+void demo_transaction_envelope() {
+    std::cout << "\n=== RSA Transaction Envelope Demo ===" << std::endl;
+    
+    // A payment between two demo accounts
+    rsa_transaction_t tx;
+    memset(&tx, 0, sizeof(tx));
+    memset(tx.tx_source_account, 0x11, sizeof(tx.tx_source_account));
+    tx.fee = RSA_BASE_FEE;
+    tx.seq_num = 1;
+    tx.operations_count = 1;
+    tx.memo.type = RSA_MEMO_ID;
+    tx.memo.memo.id = 42;
+    
+    rsa_operation_t op;
+    memset(&op, 0, sizeof(op));
+    op.type = RSA_OP_PAYMENT;
+    op.operation.payment.asset.type = RSA_ASSET_TYPE_NATIVE;
+    memcpy(op.operation.payment.from, tx.tx_source_account, 32);
+    memset(op.operation.payment.to, 0x22, 32);
+    op.operation.payment.amount = rsa_parse_amount("100.0000000");
+    
+    // Encode into one buffer, then read it back in place
+    rsa_envelope_t envelope;
+    if (!rsa_envelope_build(&envelope, &tx, &op, 1)) {
+        std::cout << "✗ Failed to build envelope" << std::endl;
+        return;
+    }
+    std::cout << "✓ Envelope encoded: " << envelope.size << " bytes (structs: "
+              << sizeof(tx) + sizeof(op) << " bytes)" << std::endl;
+    
+    rsa_envelope_view_t view;
+    if (rsa_envelope_view(&envelope, &view)) {
+        rsa_transaction_t decoded_tx;
+        rsa_operation_t decoded_op;
+        rsa_envelope_decode(&view, &decoded_tx, &decoded_op);
+        if (memcmp(&decoded_tx, &tx, sizeof(tx)) == 0 && memcmp(&decoded_op, &op, sizeof(op)) == 0) {
+            std::cout << "✓ Envelope decodes to the original transaction" << std::endl;
+        } else {
+            std::cout << "✗ Decoded envelope differs" << std::endl;
+        }
+        
+        uint8_t hash[32];
+        rsa_envelope_hash(&view, hash);
+        std::cout << "Envelope hash: ";
+        print_hex(hash, 32);
+    } else {
+        std::cout << "✗ Failed to parse envelope" << std::endl;
+    }
+    rsa_envelope_free(&envelope);
 }
 
 void demo_amount_operations() {
@@ -118,15 +201,25 @@ void demo_amount_operations() {
     rsa_format_amount(amount, formatted);
     std::cout << "Formatted amount: " << formatted << std::endl;
     
-    // Multiply amount
-    int64_t multiplied = rsa_multiply_amount(amount, 2.5);
-    rsa_format_amount(multiplied, formatted);
-    std::cout << "Amount × 2.5: " << formatted << std::endl;
+    // Multiply amount (exact: 2.5 as the ratio 5/2)
+    const rsa_price_t times_two_and_half = {5, 2};
+    int64_t multiplied = 0;
+    if (rsa_amount_mul_price(amount, &times_two_and_half, RSA_ROUND_HALF_EVEN, &multiplied) == RSA_PRICE_OK) {
+        rsa_format_amount(multiplied, formatted);
+        std::cout << "Amount × 2.5: " << formatted << std::endl;
+    } else {
+        std::cout << "Amount × 2.5: overflow" << std::endl;
+    }
     
-    // Divide amount
-    int64_t divided = rsa_divide_amount(amount, 3.0);
-    rsa_format_amount(divided, formatted);
-    std::cout << "Amount ÷ 3.0: " << formatted << std::endl;
+    // Divide amount (rounded to the nearest unit)
+    const rsa_price_t three = {3, 1};
+    int64_t divided = 0;
+    if (rsa_amount_div_price(amount, &three, RSA_ROUND_HALF_EVEN, &divided) == RSA_PRICE_OK) {
+        rsa_format_amount(divided, formatted);
+        std::cout << "Amount ÷ 3: " << formatted << std::endl;
+    } else {
+        std::cout << "Amount ÷ 3: overflow" << std::endl;
+    }
     
     // Fee calculation
     uint32_t fee = RSA_BASE_FEE * 2; // 2 operations
@@ -187,7 +280,7 @@ void demo_asset_operations() {
     // Create custom asset
     rsa_asset_t custom_asset;
     custom_asset.type = RSA_ASSET_TYPE_CREDIT_ALPHANUM4;
-    strncpy(custom_asset.asset.credit_alphanum4.code, "USDT", 4);
+    memcpy(custom_asset.asset.credit_alphanum4.code, "USDT", 4);  // not NUL-terminated
     memset(custom_asset.asset.credit_alphanum4.issuer, 0x42, 32); // Demo issuer
     
     // Test asset equality
@@ -211,6 +304,35 @@ void demo_asset_operations() {
     }
 }
 
+void demo_transient_arena() {
+    std::cout << "\n=== RSA Transient Arena Demo ===" << std::endl;
+    
+    rsa_arena_t arena;
+    if (!rsa_arena_init(&arena, NULL)) {
+        std::cout << "✗ Failed to initialize arena" << std::endl;
+        return;
+    }
+    
+    // Three ledgers' worth of per-close objects; each reset reuses the chunk
+    rsa::arena_resource resource(&arena);
+    for (uint32_t ledger = 1; ledger <= 3; ledger++) {
+        {
+            std::pmr::vector<rsa_asset_t> assets(&resource);
+            for (uint32_t i = 0; i < 1000 * ledger; i++) {
+                rsa_asset_t asset = {};
+                asset.type = RSA_ASSET_TYPE_CREDIT_ALPHANUM4;
+                memcpy(asset.asset.credit_alphanum4.code, "USDT", 4);  // not NUL-terminated
+                assets.push_back(asset);
+            }
+            std::cout << "Ledger " << ledger << ": " << assets.size() << " assets, "
+                      << arena.chunks << " chunk(s), " << arena.reserved / 1024 << " KB reserved"
+                      << std::endl;
+        }
+        rsa_arena_reset(&arena);  // after the vector is gone
+    }
+    rsa_arena_free(&arena);
+}
+
 void print_token_info() {
     std::cout << "\n=== RSA Token Information ===" << std::endl;
     std::cout << "Token Name: " << RSA_TOKEN_NAME << std::endl;
@@ -264,9 +386,11 @@ int main() {
     try {
         demo_wallet_creation();
         demo_transaction_signing();
+        demo_transaction_envelope();
         demo_amount_operations();
         demo_address_validation();
         demo_asset_operations();
+        demo_transient_arena();
     } catch (const std::exception& e) {
         std::cerr << "❌ SECURITY: Exception caught: " << e.what() << std::endl;
         rsa_trigger_alert("DEMO_EXCEPTION", e.what());
@@ -0,0 +1,253 @@
+#include "rsa_account_soa.h"
+#include <stdlib.h>
+#include <string.h>
+
+// HOT/COLD ACCOUNT LAYOUT
+// =======================
+
+static bool soa_grow_column(void **column, size_t element_size, size_t capacity) {
+    void *grown = realloc(*column, element_size * capacity);
+    if (!grown) return false;
+    *column = grown;
+    return true;
+}
+
+bool rsa_account_soa_reserve(rsa_account_soa_t *soa, size_t capacity) {
+    if (!soa) return false;
+    if (capacity <= soa->capacity) return true;
+
+    // Each column is resized on its own; a failure leaves the already grown
+    // ones larger than `capacity`, which is harmless
+    if (!soa_grow_column((void **)&soa->account_ids, sizeof(*soa->account_ids), capacity) ||
+        !soa_grow_column((void **)&soa->balances, sizeof(*soa->balances), capacity) ||
+        !soa_grow_column((void **)&soa->seq_nums, sizeof(*soa->seq_nums), capacity) ||
+        !soa_grow_column((void **)&soa->flags, sizeof(*soa->flags), capacity) ||
+        !soa_grow_column((void **)&soa->num_sub_entries, sizeof(*soa->num_sub_entries), capacity) ||
+        !soa_grow_column((void **)&soa->thresholds, sizeof(*soa->thresholds), capacity) ||
+        !soa_grow_column((void **)&soa->cold_index, sizeof(*soa->cold_index), capacity)) {
+        return false;
+    }
+    soa->capacity = capacity;
+    return true;
+}
+
+bool rsa_account_soa_init(rsa_account_soa_t *soa, size_t capacity) {
+    if (!soa) return false;
+    memset(soa, 0, sizeof(*soa));
+    return rsa_account_soa_reserve(soa, capacity > 0 ? capacity : 1024);
+}
+
+void rsa_account_soa_free(rsa_account_soa_t *soa) {
+    if (!soa) return;
+    free(soa->account_ids);
+    free(soa->balances);
+    free(soa->seq_nums);
+    free(soa->flags);
+    free(soa->num_sub_entries);
+    free(soa->thresholds);
+    free(soa->cold_index);
+    free(soa->cold);
+    free(soa->cold_free);
+    memset(soa, 0, sizeof(*soa));
+}
+
+static bool account_has_cold_data(const rsa_account_t *account) {
+    static const uint32_t zero_dest[8] = {0};
+    return account->signer_count > 0 || account->home_domain_len > 0 ||
+           memcmp(account->inflation_dest, zero_dest, sizeof(zero_dest)) != 0 ||
+           (account->reserved[0] | account->reserved[1] |
+            account->reserved[2] | account->reserved[3]) != 0;
+}
+
+static uint32_t soa_cold_alloc(rsa_account_soa_t *soa) {
+    uint32_t slot;
+    if (soa->cold_free_count > 0) {
+        slot = soa->cold_free[--soa->cold_free_count];
+    } else {
+        if (soa->cold_count == soa->cold_capacity) {
+            size_t capacity = soa->cold_capacity ? soa->cold_capacity * 2 : 256;
+            if (!soa_grow_column((void **)&soa->cold, sizeof(*soa->cold), capacity) ||
+                !soa_grow_column((void **)&soa->cold_free, sizeof(*soa->cold_free), capacity)) {
+                return RSA_ACCOUNT_NO_COLD;
+            }
+            soa->cold_capacity = capacity;
+        }
+        slot = (uint32_t)soa->cold_count++;
+    }
+    memset(&soa->cold[slot], 0, sizeof(soa->cold[slot]));
+    return slot;
+}
+
+static void soa_cold_release(rsa_account_soa_t *soa, uint32_t row) {
+    uint32_t slot = soa->cold_index[row];
+    if (slot == RSA_ACCOUNT_NO_COLD) return;
+    soa->cold_free[soa->cold_free_count++] = slot;
+    soa->cold_index[row] = RSA_ACCOUNT_NO_COLD;
+}
+
+// Cold entry of a row below capacity, allocated on first use
+static rsa_account_cold_t *soa_cold_for_row(rsa_account_soa_t *soa, uint32_t row) {
+    if (soa->cold_index[row] == RSA_ACCOUNT_NO_COLD) {
+        uint32_t slot = soa_cold_alloc(soa);
+        if (slot == RSA_ACCOUNT_NO_COLD) return NULL;
+        soa->cold_index[row] = slot;
+    }
+    return &soa->cold[soa->cold_index[row]];
+}
+
+static bool soa_write_row(rsa_account_soa_t *soa, uint32_t row, const rsa_account_t *account) {
+    memcpy(soa->account_ids[row], account->account_id, sizeof(soa->account_ids[row]));
+    soa->balances[row] = account->balance;
+    soa->seq_nums[row] = account->seq_num;
+    soa->flags[row] = account->flags;
+    soa->num_sub_entries[row] = account->num_sub_entries;
+    soa->thresholds[row] = account->thresholds;
+
+    if (!account_has_cold_data(account)) {
+        soa_cold_release(soa, row);
+        return true;
+    }
+
+    rsa_account_cold_t *cold = soa_cold_for_row(soa, row);
+    if (!cold) return false;
+    memcpy(cold->inflation_dest, account->inflation_dest, sizeof(cold->inflation_dest));
+    cold->home_domain_len = account->home_domain_len;
+    memcpy(cold->home_domain, account->home_domain, sizeof(cold->home_domain));
+    cold->signer_count = account->signer_count;
+    memcpy(cold->signers, account->signers, sizeof(cold->signers));
+    memcpy(cold->reserved, account->reserved, sizeof(cold->reserved));
+    return true;
+}
+
+static void soa_index_row(const rsa_account_soa_t *soa, uint32_t row, rsa_account_entry_t *entry) {
+    entry->index = row;
+    entry->balance = soa->balances[row];
+    entry->seq_num = soa->seq_nums[row];
+    entry->flags = soa->flags[row];
+    entry->num_sub_entries = soa->num_sub_entries[row];
+}
+
+uint32_t rsa_account_soa_append(rsa_account_soa_t *soa, const rsa_account_t *account,
+                                rsa_account_store_t *store) {
+    if (!soa || !account || soa->count >= RSA_ACCOUNT_NO_INDEX) return RSA_ACCOUNT_NO_INDEX;
+
+    // An id the store already maps to a row is updated in place; a second
+    // row would leave the first one unreachable
+    if (store) {
+        rsa_account_entry_t *entry = rsa_account_store_find(store, account->account_id);
+        if (entry && entry->index < soa->count) {
+            uint32_t row = entry->index;
+            if (!soa_write_row(soa, row, account)) return RSA_ACCOUNT_NO_INDEX;
+            soa_index_row(soa, row, entry);
+            return row;
+        }
+    }
+
+    if (soa->count == soa->capacity &&
+        !rsa_account_soa_reserve(soa, soa->capacity ? soa->capacity * 2 : 1024)) {
+        return RSA_ACCOUNT_NO_INDEX;
+    }
+
+    uint32_t row = (uint32_t)soa->count;
+    soa->cold_index[row] = RSA_ACCOUNT_NO_COLD;
+    if (!soa_write_row(soa, row, account)) {
+        return RSA_ACCOUNT_NO_INDEX;
+    }
+
+    if (store) {
+        rsa_account_entry_t *entry = rsa_account_store_upsert(store, account->account_id, NULL);
+        if (!entry) {
+            soa_cold_release(soa, row);
+            return RSA_ACCOUNT_NO_INDEX;
+        }
+        soa_index_row(soa, row, entry);
+    }
+    soa->count++;
+    return row;
+}
+
+bool rsa_account_soa_get(const rsa_account_soa_t *soa, uint32_t row, rsa_account_t *account) {
+    if (!soa || !account || row >= soa->count) return false;
+
+    memset(account, 0, sizeof(*account));
+    memcpy(account->account_id, soa->account_ids[row], sizeof(account->account_id));
+    account->balance = soa->balances[row];
+    account->seq_num = soa->seq_nums[row];
+    account->flags = soa->flags[row];
+    account->num_sub_entries = soa->num_sub_entries[row];
+    account->thresholds = soa->thresholds[row];
+
+    const rsa_account_cold_t *cold = rsa_account_soa_cold(soa, row);
+    if (cold) {
+        memcpy(account->inflation_dest, cold->inflation_dest, sizeof(account->inflation_dest));
+        account->home_domain_len = cold->home_domain_len;
+        memcpy(account->home_domain, cold->home_domain, sizeof(account->home_domain));
+        account->signer_count = cold->signer_count;
+        memcpy(account->signers, cold->signers, sizeof(account->signers));
+        memcpy(account->reserved, cold->reserved, sizeof(account->reserved));
+    }
+    return true;
+}
+
+bool rsa_account_soa_set(rsa_account_soa_t *soa, uint32_t row, const rsa_account_t *account,
+                         rsa_account_store_t *store) {
+    if (!soa || !account || row >= soa->count) return false;
+    if (memcmp(soa->account_ids[row], account->account_id, sizeof(soa->account_ids[row])) != 0) {
+        return false;
+    }
+    if (!soa_write_row(soa, row, account)) return false;
+
+    if (store) {
+        rsa_account_entry_t *entry = rsa_account_store_find(store, account->account_id);
+        if (entry) soa_index_row(soa, row, entry);
+    }
+    return true;
+}
+
+bool rsa_account_soa_remove(rsa_account_soa_t *soa, uint32_t row, rsa_account_store_t *store) {
+    if (!soa || row >= soa->count) return false;
+
+    if (store) {
+        rsa_account_store_erase(store, soa->account_ids[row]);
+    }
+    soa_cold_release(soa, row);
+
+    uint32_t last = (uint32_t)soa->count - 1;
+    if (row != last) {
+        memcpy(soa->account_ids[row], soa->account_ids[last], sizeof(soa->account_ids[row]));
+        soa->balances[row] = soa->balances[last];
+        soa->seq_nums[row] = soa->seq_nums[last];
+        soa->flags[row] = soa->flags[last];
+        soa->num_sub_entries[row] = soa->num_sub_entries[last];
+        soa->thresholds[row] = soa->thresholds[last];
+        soa->cold_index[row] = soa->cold_index[last];
+
+        if (store) {
+            rsa_account_entry_t *moved = rsa_account_store_find(store, soa->account_ids[row]);
+            if (moved) moved->index = row;
+        }
+    }
+    soa->count--;
+    return true;
+}
+
+const rsa_account_cold_t *rsa_account_soa_cold(const rsa_account_soa_t *soa, uint32_t row) {
+    if (!soa || row >= soa->count) return NULL;
+    uint32_t slot = soa->cold_index[row];
+    return slot == RSA_ACCOUNT_NO_COLD ? NULL : &soa->cold[slot];
+}
+
+rsa_account_cold_t *rsa_account_soa_cold_mut(rsa_account_soa_t *soa, uint32_t row) {
+    if (!soa || row >= soa->count) return NULL;
+    return soa_cold_for_row(soa, row);
+}
+
+size_t rsa_account_soa_memory(const rsa_account_soa_t *soa) {
+    if (!soa) return 0;
+    size_t hot_row = sizeof(*soa->account_ids) + sizeof(*soa->balances) +
+                     sizeof(*soa->seq_nums) + sizeof(*soa->flags) +
+                     sizeof(*soa->num_sub_entries) + sizeof(*soa->thresholds) +
+                     sizeof(*soa->cold_index);
+    return soa->capacity * hot_row +
+           soa->cold_capacity * (sizeof(*soa->cold) + sizeof(*soa->cold_free));
+}
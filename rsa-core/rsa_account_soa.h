@@ -0,0 +1,89 @@
+#ifndef RSA_ACCOUNT_SOA_H
+#define RSA_ACCOUNT_SOA_H
+
+#include "rsa_token.h"
+#include "rsa_account_store.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// HOT/COLD ACCOUNT LAYOUT
+// =======================
+// Struct-of-arrays form of rsa_account_t. Rows are dense indices; the
+// fields payment apply touches (balance, seq_num, flags, num_sub_entries)
+// and the 4-byte thresholds live in parallel arrays, so a payment pulls a
+// few bytes per account instead of the ~850-byte record. Inflation
+// destination, home domain and signers move to a cold side table that only
+// accounts actually using them occupy.
+//
+// Rows are kept dense: removal moves the last row into the hole. When an
+// rsa_account_store_t is passed, its entries' `index` follows the rows.
+
+#define RSA_ACCOUNT_NO_COLD UINT32_MAX
+
+typedef struct {
+    uint32_t inflation_dest[8];
+    uint32_t home_domain_len;
+    char home_domain[32];
+    uint32_t signer_count;
+    rsa_signer_t signers[20];
+    uint32_t reserved[4];
+} rsa_account_cold_t;
+
+typedef struct {
+    size_t count;
+    size_t capacity;
+
+    // Hot columns, indexed by row
+    uint32_t (*account_ids)[8];
+    int64_t *balances;
+    uint64_t *seq_nums;
+    uint32_t *flags;
+    uint32_t *num_sub_entries;
+    rsa_thresholds_t *thresholds;
+    uint32_t *cold_index;           // RSA_ACCOUNT_NO_COLD when unused
+
+    // Cold side table with a free list of released entries
+    rsa_account_cold_t *cold;
+    size_t cold_count;
+    size_t cold_capacity;
+    uint32_t *cold_free;
+    size_t cold_free_count;
+} rsa_account_soa_t;
+
+bool rsa_account_soa_init(rsa_account_soa_t *soa, size_t capacity);
+void rsa_account_soa_free(rsa_account_soa_t *soa);
+bool rsa_account_soa_reserve(rsa_account_soa_t *soa, size_t capacity);
+
+// Appends an account and returns its row (RSA_ACCOUNT_NO_INDEX on failure).
+// With a store, the account is upserted there with `index` set to the row; an
+// account the store already maps to a row overwrites that row instead.
+// Without a store, duplicates are not detected.
+uint32_t rsa_account_soa_append(rsa_account_soa_t *soa, const rsa_account_t *account,
+                                rsa_account_store_t *store);
+
+// Conversion to and from the full record. set refuses an account whose id
+// differs from the row's; with a store, it refreshes the entry's cached fields.
+bool rsa_account_soa_get(const rsa_account_soa_t *soa, uint32_t row, rsa_account_t *account);
+bool rsa_account_soa_set(rsa_account_soa_t *soa, uint32_t row, const rsa_account_t *account,
+                         rsa_account_store_t *store);
+
+// Removes a row by moving the last row into it. With a store, the removed
+// account is erased and the moved account's entry is re-pointed.
+bool rsa_account_soa_remove(rsa_account_soa_t *soa, uint32_t row, rsa_account_store_t *store);
+
+// Cold data of a row; NULL when the account has none
+const rsa_account_cold_t *rsa_account_soa_cold(const rsa_account_soa_t *soa, uint32_t row);
+// Cold data for writing, allocated (zeroed) on first use
+rsa_account_cold_t *rsa_account_soa_cold_mut(rsa_account_soa_t *soa, uint32_t row);
+
+// Bytes allocated for hot columns and the cold table
+size_t rsa_account_soa_memory(const rsa_account_soa_t *soa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_ACCOUNT_SOA_H
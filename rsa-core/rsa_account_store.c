@@ -0,0 +1,400 @@
+#include "rsa_account_store.h"
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// IN-MEMORY ACCOUNT STORE
+// =======================
+
+_Static_assert(sizeof(rsa_account_entry_t) == 64, "account slot must be one cache line");
+
+// Control bytes: 0 is empty so fresh anonymous mappings need no
+// initialization; full slots carry 0x80 | 7 hash bits
+#define CTRL_EMPTY 0x00
+#define CTRL_DELETED 0x7F
+#define CTRL_FULL_BIT 0x80
+
+static inline uint64_t store_hash(const rsa_account_store_t *store, const uint32_t id[8]) {
+    return rsa_hash_32(&store->key, id);
+}
+
+static inline uint8_t store_tag(uint64_t hash) {
+    return (uint8_t)(CTRL_FULL_BIT | (hash & 0x7F));
+}
+
+static inline bool store_key_equal(const uint32_t a[8], const uint32_t b[8]) {
+    uint64_t x[4], y[4];
+    memcpy(x, a, sizeof(x));
+    memcpy(y, b, sizeof(y));
+    return ((x[0] ^ y[0]) | (x[1] ^ y[1]) | (x[2] ^ y[2]) | (x[3] ^ y[3])) == 0;
+}
+
+// Bit i set for each control byte of the group equal to `value`
+static inline uint32_t group_match(const uint8_t *group, uint8_t value) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_load_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < RSA_ACCOUNT_STORE_GROUP_SIZE; i++) {
+        mask |= (uint32_t)(group[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+// Bit i set for each empty or deleted control byte
+static inline uint32_t group_match_free(const uint8_t *group) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_load_si128((const __m128i *)group);
+    return (uint32_t)~_mm_movemask_epi8(ctrl) & 0xFFFFu;
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < RSA_ACCOUNT_STORE_GROUP_SIZE; i++) {
+        mask |= (uint32_t)((group[i] & CTRL_FULL_BIT) == 0) << i;
+    }
+    return mask;
+#endif
+}
+
+// Tables live in one anonymous mapping: slots first (page aligned, hence
+// cache-line aligned), control bytes after
+static bool table_alloc(rsa_account_table_t *table, size_t capacity) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t bytes = capacity * sizeof(rsa_account_entry_t) + capacity;
+    bytes = (bytes + page - 1) & ~(page - 1);
+
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+#ifdef MADV_HUGEPAGE
+    if (bytes >= (2u << 20)) {
+        madvise(map, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    table->slots = map;
+    table->ctrl = (uint8_t *)map + capacity * sizeof(rsa_account_entry_t);
+    table->capacity = capacity;
+    table->size = 0;
+    table->used = 0;
+    table->map_bytes = bytes;
+    return true;
+}
+
+static void table_release(rsa_account_table_t *table) {
+    if (table->slots) {
+        munmap(table->slots, table->map_bytes);
+    }
+    memset(table, 0, sizeof(*table));
+}
+
+static inline size_t table_max_used(size_t capacity) {
+    return capacity - capacity / 8;
+}
+
+// Triangular probing over groups visits every group of a power-of-two table
+static rsa_account_entry_t *table_find(const rsa_account_table_t *table,
+                                       const uint32_t id[8], uint64_t hash) {
+    if (!table->ctrl || table->size == 0) return NULL;
+
+    size_t group_mask = table->capacity / RSA_ACCOUNT_STORE_GROUP_SIZE - 1;
+    size_t group = (size_t)(hash >> 7) & group_mask;
+    uint8_t tag = store_tag(hash);
+
+    for (size_t step = 1;; step++) {
+        const uint8_t *ctrl = table->ctrl + group * RSA_ACCOUNT_STORE_GROUP_SIZE;
+        uint32_t matches = group_match(ctrl, tag);
+        while (matches) {
+            size_t slot = group * RSA_ACCOUNT_STORE_GROUP_SIZE + (size_t)__builtin_ctz(matches);
+            if (store_key_equal(table->slots[slot].account_id, id)) {
+                return &table->slots[slot];
+            }
+            matches &= matches - 1;
+        }
+        if (group_match(ctrl, CTRL_EMPTY)) {
+            return NULL;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+// Places a key known to be absent; the caller guarantees room
+static rsa_account_entry_t *table_insert(rsa_account_table_t *table, uint64_t hash) {
+    size_t group_mask = table->capacity / RSA_ACCOUNT_STORE_GROUP_SIZE - 1;
+    size_t group = (size_t)(hash >> 7) & group_mask;
+
+    for (size_t step = 1;; step++) {
+        uint8_t *ctrl = table->ctrl + group * RSA_ACCOUNT_STORE_GROUP_SIZE;
+        uint32_t free_mask = group_match_free(ctrl);
+        if (free_mask) {
+            size_t offset = (size_t)__builtin_ctz(free_mask);
+            if (ctrl[offset] == CTRL_EMPTY) {
+                table->used++;
+            }
+            ctrl[offset] = store_tag(hash);
+            table->size++;
+            return &table->slots[group * RSA_ACCOUNT_STORE_GROUP_SIZE + offset];
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+static void table_erase_slot(rsa_account_table_t *table, rsa_account_entry_t *entry) {
+    size_t slot = (size_t)(entry - table->slots);
+    uint8_t *group = table->ctrl + (slot & ~(size_t)(RSA_ACCOUNT_STORE_GROUP_SIZE - 1));
+
+    // A group that still has an empty byte was never full, so no probe
+    // sequence continued past it and the slot can go straight back to empty
+    if (group_match(group, CTRL_EMPTY)) {
+        table->ctrl[slot] = CTRL_EMPTY;
+        table->used--;
+    } else {
+        table->ctrl[slot] = CTRL_DELETED;
+    }
+    table->size--;
+}
+
+static size_t store_capacity_for(size_t entries) {
+    size_t capacity = RSA_ACCOUNT_STORE_MIN_CAPACITY;
+    while (table_max_used(capacity) < entries) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Moves up to `budget` old slots into the current table
+static void store_migrate(rsa_account_store_t *store, size_t budget) {
+    rsa_account_table_t *old = &store->old;
+    if (!old->ctrl) return;
+
+    size_t remaining = old->capacity - store->migrate_cursor;
+    size_t end = store->migrate_cursor + (budget < remaining ? budget : remaining);
+
+    for (size_t slot = store->migrate_cursor; slot < end; slot++) {
+        if (!(old->ctrl[slot] & CTRL_FULL_BIT)) continue;
+        rsa_account_entry_t *src = &old->slots[slot];
+        rsa_account_entry_t *dst = table_insert(&store->current,
+                                                store_hash(store, src->account_id));
+        *dst = *src;
+        // Tombstone rather than empty: unmigrated keys may probe through here
+        old->ctrl[slot] = CTRL_DELETED;
+        old->size--;
+    }
+    store->migrate_cursor = end;
+
+    if (store->migrate_cursor >= old->capacity || old->size == 0) {
+        table_release(old);
+        store->migrate_cursor = 0;
+    }
+}
+
+// Starts an incremental resize sized for `entries` live entries
+static bool store_begin_resize(rsa_account_store_t *store, size_t entries) {
+    // A resize still in flight is finished first
+    store_migrate(store, SIZE_MAX);
+
+    // 25% headroom over the live size doubles a full table and keeps a
+    // tombstone-heavy one at its size; the migration finishes long before
+    // the new table fills up
+    rsa_account_table_t next;
+    if (!table_alloc(&next, store_capacity_for(entries + entries / 4))) {
+        return false;
+    }
+    store->old = store->current;
+    store->current = next;
+    store->migrate_cursor = 0;
+    if (store->old.size == 0) {
+        table_release(&store->old);
+    }
+    return true;
+}
+
+bool rsa_account_store_init(rsa_account_store_t *store, size_t capacity) {
+    if (!store) return false;
+    memset(store, 0, sizeof(*store));
+
+    rsa_hash_key_init(&store->key, store);
+    return table_alloc(&store->current, store_capacity_for(capacity));
+}
+
+void rsa_account_store_free(rsa_account_store_t *store) {
+    if (!store) return;
+    table_release(&store->current);
+    table_release(&store->old);
+    store->migrate_cursor = 0;
+}
+
+bool rsa_account_store_reserve(rsa_account_store_t *store, size_t entries) {
+    if (!store || !store->current.ctrl) return false;
+    store_migrate(store, SIZE_MAX);
+    if (table_max_used(store->current.capacity) >= entries) {
+        return true;
+    }
+
+    rsa_account_table_t next;
+    if (!table_alloc(&next, store_capacity_for(entries))) {
+        return false;
+    }
+    store->old = store->current;
+    store->current = next;
+    store->migrate_cursor = 0;
+    store_migrate(store, SIZE_MAX);
+    return true;
+}
+
+size_t rsa_account_store_size(const rsa_account_store_t *store) {
+    return store ? store->current.size + store->old.size : 0;
+}
+
+size_t rsa_account_store_memory(const rsa_account_store_t *store) {
+    return store ? store->current.map_bytes + store->old.map_bytes : 0;
+}
+
+rsa_account_entry_t *rsa_account_store_find(const rsa_account_store_t *store,
+                                            const uint32_t account_id[8]) {
+    if (!store || !account_id) return NULL;
+    uint64_t hash = store_hash(store, account_id);
+    rsa_account_entry_t *entry = table_find(&store->current, account_id, hash);
+    if (!entry && store->old.ctrl) {
+        entry = table_find(&store->old, account_id, hash);
+    }
+    return entry;
+}
+
+#define STORE_BATCH_WINDOW 16
+
+size_t rsa_account_store_find_batch(const rsa_account_store_t *store,
+                                    const uint32_t (*account_ids)[8], size_t count,
+                                    rsa_account_entry_t **out) {
+    if (!store || !account_ids || !out) return 0;
+
+    const rsa_account_table_t *table = &store->current;
+    size_t group_mask = table->capacity / RSA_ACCOUNT_STORE_GROUP_SIZE - 1;
+    uint64_t hashes[STORE_BATCH_WINDOW];
+    size_t hits = 0;
+
+    // Per window: hash and prefetch the home control groups, then prefetch
+    // the first tag match of each, then resolve. Misses on the control
+    // byte and the slot line overlap across the window instead of
+    // serializing per lookup.
+    for (size_t base = 0; base < count; base += STORE_BATCH_WINDOW) {
+        size_t n = count - base < STORE_BATCH_WINDOW ? count - base : STORE_BATCH_WINDOW;
+
+        for (size_t i = 0; i < n; i++) {
+            hashes[i] = store_hash(store, account_ids[base + i]);
+            size_t group = (size_t)(hashes[i] >> 7) & group_mask;
+            __builtin_prefetch(table->ctrl + group * RSA_ACCOUNT_STORE_GROUP_SIZE);
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t group = (size_t)(hashes[i] >> 7) & group_mask;
+            uint32_t matches = group_match(table->ctrl + group * RSA_ACCOUNT_STORE_GROUP_SIZE,
+                                           store_tag(hashes[i]));
+            if (matches) {
+                __builtin_prefetch(&table->slots[group * RSA_ACCOUNT_STORE_GROUP_SIZE +
+                                                 (size_t)__builtin_ctz(matches)]);
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            const uint32_t *id = account_ids[base + i];
+            rsa_account_entry_t *entry = table_find(table, id, hashes[i]);
+            if (!entry && store->old.ctrl) {
+                entry = table_find(&store->old, id, hashes[i]);
+            }
+            out[base + i] = entry;
+            hits += (entry != NULL);
+        }
+    }
+    return hits;
+}
+
+rsa_account_entry_t *rsa_account_store_upsert(rsa_account_store_t *store,
+                                              const uint32_t account_id[8], bool *inserted) {
+    if (inserted) *inserted = false;
+    if (!store || !account_id || !store->current.ctrl) return NULL;
+
+    // Migrate first so the returned pointer is not moved by this call
+    store_migrate(store, RSA_ACCOUNT_STORE_MIGRATE_STEP);
+
+    uint64_t hash = store_hash(store, account_id);
+    rsa_account_entry_t *entry = table_find(&store->current, account_id, hash);
+    if (!entry && store->old.ctrl) {
+        entry = table_find(&store->old, account_id, hash);
+    }
+    if (entry) return entry;
+
+    // Room is kept for every entry still waiting in the old table, so a
+    // migration can always run to completion
+    if (store->current.used + store->old.size + 1 > table_max_used(store->current.capacity)) {
+        if (!store_begin_resize(store, rsa_account_store_size(store) + 1)) {
+            return NULL;
+        }
+    }
+
+    entry = table_insert(&store->current, hash);
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->account_id, account_id, sizeof(entry->account_id));
+    entry->index = RSA_ACCOUNT_NO_INDEX;
+    if (inserted) *inserted = true;
+    return entry;
+}
+
+rsa_account_entry_t *rsa_account_store_put(rsa_account_store_t *store,
+                                           const rsa_account_t *account) {
+    if (!account) return NULL;
+    rsa_account_entry_t *entry = rsa_account_store_upsert(store, account->account_id, NULL);
+    if (entry) {
+        entry->balance = account->balance;
+        entry->seq_num = account->seq_num;
+        entry->num_sub_entries = account->num_sub_entries;
+        entry->flags = account->flags;
+    }
+    return entry;
+}
+
+bool rsa_account_store_erase(rsa_account_store_t *store, const uint32_t account_id[8]) {
+    if (!store || !account_id || !store->current.ctrl) return false;
+
+    store_migrate(store, RSA_ACCOUNT_STORE_MIGRATE_STEP);
+
+    uint64_t hash = store_hash(store, account_id);
+    rsa_account_entry_t *entry = table_find(&store->current, account_id, hash);
+    if (entry) {
+        table_erase_slot(&store->current, entry);
+        return true;
+    }
+    if (store->old.ctrl) {
+        entry = table_find(&store->old, account_id, hash);
+        if (entry) {
+            table_erase_slot(&store->old, entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+rsa_account_entry_t *rsa_account_store_next(const rsa_account_store_t *store, size_t *cursor) {
+    if (!store || !cursor) return NULL;
+
+    // Cursor runs over the current table, then the old one
+    size_t current_capacity = store->current.ctrl ? store->current.capacity : 0;
+    size_t old_capacity = store->old.ctrl ? store->old.capacity : 0;
+
+    while (*cursor < current_capacity + old_capacity) {
+        size_t position = (*cursor)++;
+        const rsa_account_table_t *table = &store->current;
+        if (position >= current_capacity) {
+            table = &store->old;
+            position -= current_capacity;
+        }
+        if (table->ctrl[position] & CTRL_FULL_BIT) {
+            return &table->slots[position];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,97 @@
+#ifndef RSA_ACCOUNT_STORE_H
+#define RSA_ACCOUNT_STORE_H
+
+#include "rsa_token.h"
+#include "rsa_hash.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// IN-MEMORY ACCOUNT STORE
+// =======================
+// Open-addressing hash table keyed by the 256-bit account_id. Each slot is
+// one 64-byte cache line holding the key and the fields payments touch
+// (balance, seq_num, num_sub_entries, flags), so a hit costs one control
+// byte group plus one line. Probing compares 16 one-byte tags at a time
+// with SSE2 (Swiss-table style). Growth is incremental: a new table is
+// allocated and every mutation migrates a bounded number of old slots, so
+// no single insert pays for a full rehash.
+//
+// Entry pointers stay valid until the next mutation of the store.
+// Not thread-safe; readers that run concurrently with apply go through a
+// snapshot instead.
+
+#define RSA_ACCOUNT_STORE_GROUP_SIZE 16
+#define RSA_ACCOUNT_STORE_MIN_CAPACITY 16
+#define RSA_ACCOUNT_STORE_MIGRATE_STEP 256  // old slots moved per mutation while resizing
+#define RSA_ACCOUNT_NO_INDEX UINT32_MAX
+
+// One slot (exactly one cache line)
+typedef struct {
+    uint32_t account_id[8];
+    int64_t balance;
+    uint64_t seq_num;
+    uint32_t num_sub_entries;
+    uint32_t flags;
+    uint32_t index;                 // caller-managed dense index, RSA_ACCOUNT_NO_INDEX if unset
+    uint32_t reserved;
+} rsa_account_entry_t;
+
+typedef struct {
+    uint8_t *ctrl;                  // one tag byte per slot
+    rsa_account_entry_t *slots;
+    size_t capacity;                // power of two, >= RSA_ACCOUNT_STORE_MIN_CAPACITY
+    size_t size;                    // live entries
+    size_t used;                    // live entries + tombstones
+    size_t map_bytes;
+} rsa_account_table_t;
+
+typedef struct {
+    rsa_account_table_t current;
+    rsa_account_table_t old;        // drained incrementally while resizing
+    size_t migrate_cursor;
+    rsa_hash_key_t key;
+} rsa_account_store_t;
+
+// Capacity is a hint (entries); 0 starts at the minimum
+bool rsa_account_store_init(rsa_account_store_t *store, size_t capacity);
+void rsa_account_store_free(rsa_account_store_t *store);
+
+// Grow ahead of a bulk load so it never resizes
+bool rsa_account_store_reserve(rsa_account_store_t *store, size_t entries);
+
+size_t rsa_account_store_size(const rsa_account_store_t *store);
+// Bytes of table memory currently mapped (both tables while resizing)
+size_t rsa_account_store_memory(const rsa_account_store_t *store);
+
+rsa_account_entry_t *rsa_account_store_find(const rsa_account_store_t *store,
+                                            const uint32_t account_id[8]);
+
+// Looks up count ids with software prefetching across the batch; out[i]
+// is NULL for misses. Returns the number of hits.
+size_t rsa_account_store_find_batch(const rsa_account_store_t *store,
+                                    const uint32_t (*account_ids)[8], size_t count,
+                                    rsa_account_entry_t **out);
+
+// Returns the entry for account_id, inserting a zeroed one (index set to
+// RSA_ACCOUNT_NO_INDEX) if absent. NULL only on allocation failure.
+rsa_account_entry_t *rsa_account_store_upsert(rsa_account_store_t *store,
+                                              const uint32_t account_id[8], bool *inserted);
+
+// Copies the hot fields of an rsa_account_t in (insert or overwrite)
+rsa_account_entry_t *rsa_account_store_put(rsa_account_store_t *store,
+                                           const rsa_account_t *account);
+
+bool rsa_account_store_erase(rsa_account_store_t *store, const uint32_t account_id[8]);
+
+// Iteration in table order: start with *cursor = 0, NULL at the end.
+// The store must not be mutated while iterating.
+rsa_account_entry_t *rsa_account_store_next(const rsa_account_store_t *store, size_t *cursor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_ACCOUNT_STORE_H
@@ -0,0 +1,121 @@
+#include "rsa_address.h"
+#include <openssl/sha.h>
+#include <string.h>
+
+// BULK ADDRESS CODEC
+// ==================
+
+#define RSA_ADDRESS_PREFIX_LENGTH (sizeof(RSA_ADDRESS_PREFIX) - 1)
+
+static const char base32_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+// value + 1 for every valid base32 character, 0 otherwise
+static const uint8_t base32_decode_table[256] = {
+    ['A'] = 1,  ['B'] = 2,  ['C'] = 3,  ['D'] = 4,  ['E'] = 5,  ['F'] = 6,  ['G'] = 7,  ['H'] = 8,
+    ['I'] = 9,  ['J'] = 10, ['K'] = 11, ['L'] = 12, ['M'] = 13, ['N'] = 14, ['O'] = 15, ['P'] = 16,
+    ['Q'] = 17, ['R'] = 18, ['S'] = 19, ['T'] = 20, ['U'] = 21, ['V'] = 22, ['W'] = 23, ['X'] = 24,
+    ['Y'] = 25, ['Z'] = 26, ['2'] = 27, ['3'] = 28, ['4'] = 29, ['5'] = 30, ['6'] = 31, ['7'] = 32
+};
+
+static inline void address_checksum(const uint8_t *versioned_key, uint8_t *checksum) {
+    // Low-level context API: the one-shot SHA256() goes through an EVP
+    // fetch per call in OpenSSL 3, which dominates a 33-byte digest
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, versioned_key, 1 + RSA_PUBLIC_KEY_LENGTH);
+    SHA256_Final(digest, &ctx);
+    memcpy(checksum, digest, RSA_ADDRESS_CHECKSUM_LENGTH);
+}
+
+bool rsa_address_encode_fast(const uint8_t *public_key, char *address) {
+    if (!public_key || !address) return false;
+
+    uint8_t payload[RSA_ADDRESS_PAYLOAD_LENGTH];
+    payload[0] = RSA_ADDRESS_VERSION_BYTE;
+    memcpy(payload + 1, public_key, RSA_PUBLIC_KEY_LENGTH);
+    address_checksum(payload, payload + 1 + RSA_PUBLIC_KEY_LENGTH);
+
+    memcpy(address, RSA_ADDRESS_PREFIX, RSA_ADDRESS_PREFIX_LENGTH);
+    char *out = address + RSA_ADDRESS_PREFIX_LENGTH;
+
+    // 5 bytes -> 8 characters; 37 bytes = 7 full groups + 2 trailing bytes
+    const uint8_t *in = payload;
+    for (int group = 0; group < 7; group++, in += 5, out += 8) {
+        uint64_t acc = ((uint64_t)in[0] << 32) | ((uint64_t)in[1] << 24) |
+                       ((uint64_t)in[2] << 16) | ((uint64_t)in[3] << 8) | (uint64_t)in[4];
+        for (int k = 0; k < 8; k++) {
+            out[k] = base32_alphabet[(acc >> (35 - 5 * k)) & 31];
+        }
+    }
+    uint32_t tail = ((uint32_t)in[0] << 12) | ((uint32_t)in[1] << 4);   // 16 bits + 4 pad
+    for (int k = 0; k < 4; k++) {
+        out[k] = base32_alphabet[(tail >> (15 - 5 * k)) & 31];
+    }
+    out[4] = '\0';
+    return true;
+}
+
+bool rsa_address_decode_fast(const char *address, size_t len, uint8_t *public_key) {
+    if (!address || !public_key) return false;
+    if (len != RSA_ADDRESS_FULL_LENGTH ||
+        memcmp(address, RSA_ADDRESS_PREFIX, RSA_ADDRESS_PREFIX_LENGTH) != 0) {
+        return false;
+    }
+
+    const unsigned char *in = (const unsigned char *)address + RSA_ADDRESS_PREFIX_LENGTH;
+    uint8_t payload[RSA_ADDRESS_PAYLOAD_LENGTH];
+    uint8_t *out = payload;
+    uint32_t invalid = 0;
+
+    // Invalid characters are folded into one flag instead of branching per byte
+    for (int group = 0; group < 7; group++, in += 8, out += 5) {
+        uint64_t acc = 0;
+        for (int k = 0; k < 8; k++) {
+            uint32_t v = base32_decode_table[in[k]];
+            invalid |= (v == 0);
+            acc = (acc << 5) | ((v - 1) & 31);
+        }
+        out[0] = (uint8_t)(acc >> 32);
+        out[1] = (uint8_t)(acc >> 24);
+        out[2] = (uint8_t)(acc >> 16);
+        out[3] = (uint8_t)(acc >> 8);
+        out[4] = (uint8_t)acc;
+    }
+    uint32_t tail = 0;
+    for (int k = 0; k < 4; k++) {
+        uint32_t v = base32_decode_table[in[k]];
+        invalid |= (v == 0);
+        tail = (tail << 5) | ((v - 1) & 31);
+    }
+    out[0] = (uint8_t)(tail >> 12);
+    out[1] = (uint8_t)(tail >> 4);
+
+    // Non-canonical padding bits would give two spellings of one address
+    if (invalid || (tail & 0xF) != 0 || payload[0] != RSA_ADDRESS_VERSION_BYTE) {
+        return false;
+    }
+
+    uint8_t checksum[RSA_ADDRESS_CHECKSUM_LENGTH];
+    address_checksum(payload, checksum);
+    if (memcmp(checksum, payload + 1 + RSA_PUBLIC_KEY_LENGTH, RSA_ADDRESS_CHECKSUM_LENGTH) != 0) {
+        return false;
+    }
+
+    memcpy(public_key, payload + 1, RSA_PUBLIC_KEY_LENGTH);
+    return true;
+}
+
+size_t rsa_address_decode_batch(const char *const *addresses, const size_t *lens, size_t count,
+                                uint8_t (*public_keys)[RSA_PUBLIC_KEY_LENGTH], bool *ok) {
+    if (!addresses || !lens || !public_keys) return 0;
+
+    size_t decoded = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool success = rsa_address_decode_fast(addresses[i], lens[i], public_keys[i]);
+        if (!success) memset(public_keys[i], 0, RSA_PUBLIC_KEY_LENGTH);
+        if (ok) ok[i] = success;
+        decoded += success;
+    }
+    return decoded;
+}
@@ -0,0 +1,43 @@
+#ifndef RSA_ADDRESS_H
+#define RSA_ADDRESS_H
+
+#include "rsa_token.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// BULK ADDRESS CODEC
+// ==================
+// Table-driven encoder/decoder for the RSA address layout
+//   RSA_ADDRESS_PREFIX + base32(version 0x30 | public key | sha256[0..3])
+// for bulk paths (CSV import/export, reconciliation). Unlike
+// rsa_encode_address()/rsa_decode_address() these skip the global operation
+// limiter and do not raise alerts; callers report bad rows themselves.
+// A 37-byte payload encodes to 60 base32 characters, so the full address is
+// 63 characters rather than RSA_ADDRESS_LENGTH.
+
+#define RSA_ADDRESS_VERSION_BYTE 0x30
+#define RSA_ADDRESS_CHECKSUM_LENGTH 4
+#define RSA_ADDRESS_PAYLOAD_LENGTH (1 + RSA_PUBLIC_KEY_LENGTH + RSA_ADDRESS_CHECKSUM_LENGTH)
+#define RSA_ADDRESS_FULL_LENGTH 63
+#define RSA_ADDRESS_FULL_BUFFER_SIZE (RSA_ADDRESS_FULL_LENGTH + 1)
+
+// Writes RSA_ADDRESS_FULL_LENGTH characters plus NUL to `address`
+bool rsa_address_encode_fast(const uint8_t *public_key, char *address);
+
+// Decodes `len` bytes (no NUL required); checks prefix, alphabet, padding
+// bits, version byte and checksum
+bool rsa_address_decode_fast(const char *address, size_t len, uint8_t *public_key);
+
+// Batch decode; ok[i] records each result (may be NULL). Returns the number
+// of addresses decoded successfully.
+size_t rsa_address_decode_batch(const char *const *addresses, const size_t *lens, size_t count,
+                                uint8_t (*public_keys)[RSA_PUBLIC_KEY_LENGTH], bool *ok);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_ADDRESS_H
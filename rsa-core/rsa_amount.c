@@ -0,0 +1,252 @@
+#include "rsa_amount.h"
+#include <string.h>
+
+// EXACT FIXED-POINT AMOUNT CODEC
+// ==============================
+
+#define RSA_SWAR_ONES     0x0101010101010101ULL
+#define RSA_SWAR_ZEROS    (RSA_SWAR_ONES * '0')
+#define RSA_SWAR_HI_NIBS  0xF0F0F0F0F0F0F0F0ULL
+
+// Largest magnitudes representable in int64 units
+#define RSA_AMOUNT_MAX_POSITIVE 9223372036854775807ULL
+#define RSA_AMOUNT_MAX_NEGATIVE 9223372036854775808ULL
+#define RSA_AMOUNT_MAX_WHOLE_DIGITS 12   // 922337203685
+
+static const uint64_t pow10_table[9] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL,
+    100000ULL, 1000000ULL, 10000000ULL, 100000000ULL
+};
+
+// All SWAR lanes below put the first character in the lowest byte
+static inline uint64_t load_le64(const char *p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+}
+
+static inline void store_le64(char *p, uint64_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    memcpy(p, &x, sizeof(x));
+}
+
+static inline bool is_digit(char c) {
+    return (unsigned char)(c - '0') < 10;
+}
+
+// Nonzero high nibble in every byte that is not an ASCII digit. Carries from
+// the +6 only travel toward later bytes, so the first flagged byte is exact.
+static inline uint64_t swar_non_digit_mask(uint64_t x) {
+    uint64_t hi = (x & RSA_SWAR_HI_NIBS) ^ RSA_SWAR_ZEROS;
+    uint64_t le9 = ((x + RSA_SWAR_ONES * 6) & RSA_SWAR_HI_NIBS) ^ RSA_SWAR_ZEROS;
+    return hi | le9;
+}
+
+// Length of the run of digits starting at p, scanning 8 bytes per step
+static inline size_t scan_digits(const char *p, const char *end) {
+    const char *start = p;
+    while (end - p >= 8) {
+        uint64_t mask = swar_non_digit_mask(load_le64(p));
+        if (mask) {
+            return (size_t)(p - start) + (size_t)(__builtin_ctzll(mask) >> 3);
+        }
+        p += 8;
+    }
+    while (p < end && is_digit(*p)) p++;
+    return (size_t)(p - start);
+}
+
+// Eight ASCII digits to their value
+static inline uint64_t swar_parse8(uint64_t x) {
+    x -= RSA_SWAR_ZEROS;
+    x = (x * 10 + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x * 100 + (x >> 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x * 10000 + (x >> 32)) & 0x00000000FFFFFFFFULL;
+    return x;
+}
+
+// Up to 16 validated digits to their value
+static inline uint64_t parse_digits(const char *p, size_t n) {
+    uint64_t value = 0;
+    if (n >= 8) {
+        value = swar_parse8(load_le64(p));
+        p += 8;
+        n -= 8;
+    }
+    if (n > 0) {
+        char buf[8];
+        memset(buf, '0', sizeof(buf));
+        memcpy(buf + 8 - n, p, n);
+        value = value * pow10_table[n] + swar_parse8(load_le64(buf));
+    }
+    return value;
+}
+
+// Value below 1e8 to eight ASCII digits, most significant first
+static inline uint64_t swar_encode8(uint32_t v) {
+    uint64_t x = (uint64_t)(v / 10000) | ((uint64_t)(v % 10000) << 32);
+    uint64_t q = ((x * 10486) >> 20) & 0x0000007F0000007FULL;    // lanes / 100
+    x = q | ((x - q * 100) << 16);
+    q = ((x * 103) >> 10) & 0x000F000F000F000FULL;               // lanes / 10
+    x = q | ((x - q * 10) << 8);
+    return x + RSA_SWAR_ZEROS;
+}
+
+// Writes v < 1e8 without leading zeros. May scribble up to 8 bytes at p.
+static inline char *write_short(char *p, uint32_t v) {
+    uint64_t digits = swar_encode8(v);
+    uint64_t raw = digits - RSA_SWAR_ZEROS;
+    if (raw == 0) {
+        *p = '0';
+        return p + 1;
+    }
+    unsigned skip = (unsigned)__builtin_ctzll(raw) >> 3;
+    store_le64(p, digits >> (skip * 8));
+    return p + (8 - skip);
+}
+
+static inline rsa_amount_status_t parse_amount(const char *str, size_t len, int64_t *out) {
+    const char *p = str;
+    const char *end = str + len;
+    bool negative = false;
+
+    *out = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    const char *whole = p;
+    size_t whole_len = scan_digits(p, end);
+    p += whole_len;
+
+    const char *frac = p;
+    size_t frac_len = 0;
+    if (p < end && *p == '.') {
+        frac = ++p;
+        frac_len = scan_digits(p, end);
+        p += frac_len;
+    }
+
+    if (p != end || (whole_len == 0 && frac_len == 0)) {
+        return RSA_AMOUNT_ERR_INVALID;
+    }
+
+    while (whole_len > 0 && *whole == '0') {
+        whole++;
+        whole_len--;
+    }
+    if (whole_len > RSA_AMOUNT_MAX_WHOLE_DIGITS) {
+        return RSA_AMOUNT_ERR_OVERFLOW;
+    }
+
+    rsa_amount_status_t status = RSA_AMOUNT_OK;
+    if (frac_len > RSA_AMOUNT_FRACTION_DIGITS) {
+        frac_len = RSA_AMOUNT_FRACTION_DIGITS;
+        status = RSA_AMOUNT_ERR_PRECISION;
+    }
+
+    // "0" followed by the fraction right-padded with zeros to 7 digits
+    char frac_buf[8];
+    memset(frac_buf, '0', sizeof(frac_buf));
+    memcpy(frac_buf + 1, frac, frac_len);
+
+    // 12 whole digits * 1e7 + 7 fraction digits stays below 2^64
+    uint64_t magnitude = parse_digits(whole, whole_len) * (uint64_t)RSA_AMOUNT_SCALE +
+                         swar_parse8(load_le64(frac_buf));
+
+    if (magnitude > (negative ? RSA_AMOUNT_MAX_NEGATIVE : RSA_AMOUNT_MAX_POSITIVE)) {
+        return RSA_AMOUNT_ERR_OVERFLOW;
+    }
+
+    *out = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    return status;
+}
+
+static inline size_t format_amount(int64_t amount, char *out, rsa_amount_format_t mode) {
+    char *p = out;
+    uint64_t magnitude = (uint64_t)amount;
+    if (amount < 0) {
+        magnitude = 0 - magnitude;
+        *p++ = '-';
+    }
+
+    uint64_t whole = magnitude / (uint64_t)RSA_AMOUNT_SCALE;
+    uint32_t frac = (uint32_t)(magnitude % (uint64_t)RSA_AMOUNT_SCALE);
+
+    if (whole < 100000000ULL) {
+        p = write_short(p, (uint32_t)whole);
+    } else {
+        p = write_short(p, (uint32_t)(whole / 100000000ULL));
+        store_le64(p, swar_encode8((uint32_t)(whole % 100000000ULL)));
+        p += 8;
+    }
+
+    if (frac == 0 && mode == RSA_AMOUNT_FORMAT_TRIM) {
+        *p = '\0';
+        return (size_t)(p - out);
+    }
+
+    // Drop the leading '0' of the 8-digit encoding to get 7 fraction digits
+    uint64_t digits = swar_encode8(frac) >> 8;
+    size_t frac_len = RSA_AMOUNT_FRACTION_DIGITS;
+    if (mode == RSA_AMOUNT_FORMAT_TRIM) {
+        uint64_t raw = digits - (RSA_SWAR_ZEROS >> 8);
+        frac_len = 8 - ((size_t)__builtin_clzll(raw) >> 3);
+    }
+
+    *p++ = '.';
+    store_le64(p, digits);
+    p += frac_len;
+    *p = '\0';
+    return (size_t)(p - out);
+}
+
+rsa_amount_status_t rsa_amount_parse(const char *str, size_t len, int64_t *out) {
+    if (!str || !out) return RSA_AMOUNT_ERR_INVALID;
+    return parse_amount(str, len, out);
+}
+
+size_t rsa_amount_format(int64_t amount, char *out, rsa_amount_format_t mode) {
+    if (!out) return 0;
+    return format_amount(amount, out, mode);
+}
+
+size_t rsa_amount_parse_batch(const char *const *strs, const size_t *lens, size_t count,
+                              int64_t *out, rsa_amount_status_t *status) {
+    if (!strs || !lens || !out) return 0;
+
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        rsa_amount_status_t s = strs[i] ? parse_amount(strs[i], lens[i], &out[i])
+                                        : RSA_AMOUNT_ERR_INVALID;
+        if (status) status[i] = s;
+        ok += (s == RSA_AMOUNT_OK);
+    }
+    return ok;
+}
+
+void rsa_amount_format_batch(const int64_t *amounts, size_t count, char *out,
+                             size_t stride, size_t *lens, rsa_amount_format_t mode) {
+    if (!amounts || !out || stride < RSA_AMOUNT_BUFFER_SIZE) return;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t len = format_amount(amounts[i], out + i * stride, mode);
+        if (lens) lens[i] = len;
+    }
+}
+
+const char *rsa_amount_status_str(rsa_amount_status_t status) {
+    switch (status) {
+        case RSA_AMOUNT_OK:            return "OK";
+        case RSA_AMOUNT_ERR_INVALID:   return "INVALID_AMOUNT";
+        case RSA_AMOUNT_ERR_OVERFLOW:  return "AMOUNT_OVERFLOW";
+        case RSA_AMOUNT_ERR_PRECISION: return "AMOUNT_PRECISION_LOST";
+        default:                       return "UNKNOWN";
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef RSA_AMOUNT_H
+#define RSA_AMOUNT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// EXACT FIXED-POINT AMOUNT CODEC
+// ==============================
+// Amounts are int64 counts of 1e-7 RSA units (RSA_TOKEN_DECIMALS). Parsing
+// and formatting are integer-only: no doubles, no locale, no libc float
+// conversion. Eight digits are converted at a time with SWAR arithmetic.
+
+#define RSA_AMOUNT_SCALE 10000000LL        // 10^RSA_TOKEN_DECIMALS
+#define RSA_AMOUNT_FRACTION_DIGITS 7
+#define RSA_AMOUNT_MAX_STRING_LENGTH 21    // "-922337203685.4775808"
+#define RSA_AMOUNT_BUFFER_SIZE (RSA_AMOUNT_MAX_STRING_LENGTH + 1)
+
+typedef enum {
+    RSA_AMOUNT_OK = 0,
+    RSA_AMOUNT_ERR_INVALID = 1,     // empty, stray character, misplaced sign or dot
+    RSA_AMOUNT_ERR_OVERFLOW = 2,    // does not fit in int64 units
+    RSA_AMOUNT_ERR_PRECISION = 3    // more than 7 fractional digits (value truncated)
+} rsa_amount_status_t;
+
+typedef enum {
+    RSA_AMOUNT_FORMAT_FIXED = 0,    // always 7 fractional digits: "100.0000000"
+    RSA_AMOUNT_FORMAT_TRIM = 1      // trailing zeros and dot removed: "100"
+} rsa_amount_format_t;
+
+// Parse `len` bytes of `str` (no NUL required). Accepts an optional leading
+// '+' or '-', integer digits and an optional '.' with up to 7 fraction digits.
+// On RSA_AMOUNT_ERR_PRECISION *out holds the value truncated toward zero.
+rsa_amount_status_t rsa_amount_parse(const char *str, size_t len, int64_t *out);
+
+// Write `amount` to `out` (at least RSA_AMOUNT_BUFFER_SIZE bytes) with a
+// terminating NUL. Returns the number of characters written, excluding NUL.
+size_t rsa_amount_format(int64_t amount, char *out, rsa_amount_format_t mode);
+
+// Batch variants. Parse returns the number of RSA_AMOUNT_OK entries; `status`
+// may be NULL. Format writes entry i at out + i * stride (stride must be at
+// least RSA_AMOUNT_BUFFER_SIZE) and stores its length in lens[i] if non-NULL.
+size_t rsa_amount_parse_batch(const char *const *strs, const size_t *lens, size_t count,
+                              int64_t *out, rsa_amount_status_t *status);
+void rsa_amount_format_batch(const int64_t *amounts, size_t count, char *out,
+                             size_t stride, size_t *lens, rsa_amount_format_t mode);
+
+const char *rsa_amount_status_str(rsa_amount_status_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_AMOUNT_H
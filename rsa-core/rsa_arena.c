@@ -0,0 +1,243 @@
+#include "rsa_arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// TRANSIENT ARENA
+// ===============
+
+#define CHUNK_HEADER 64                 // keeps chunk data cache-line aligned
+#define HUGE_PAGE_SIZE (2u << 20)
+
+struct rsa_arena_chunk {
+    rsa_arena_chunk_t *next;
+    size_t size;                        // usable bytes after the header
+    size_t mapped;                      // mmap length, 0 when from aligned_alloc()
+    bool oversized;                     // one allocation, released at reset
+};
+
+_Static_assert(sizeof(rsa_arena_chunk_t) <= CHUNK_HEADER, "chunk header too large");
+
+// Where this thread bumps in one arena; valid while `epoch` matches
+typedef struct {
+    uint64_t epoch;                     // 0 = unused
+    uintptr_t cur;
+    uintptr_t end;
+} arena_cursor_t;
+
+static _Thread_local arena_cursor_t thread_cursors[RSA_ARENA_THREAD_SLOTS];
+static _Thread_local unsigned thread_next_cursor;
+
+// Unique over the process, so a cursor can never match a later arena that
+// reuses the same address
+static uint64_t arena_epochs;
+
+static uint64_t next_epoch(void) {
+    return __atomic_add_fetch(&arena_epochs, 1, __ATOMIC_RELAXED);
+}
+
+static inline uintptr_t align_up(uintptr_t p, size_t align) {
+    return (p + align - 1) & ~(uintptr_t)(align - 1);
+}
+
+static inline uint8_t *chunk_data(rsa_arena_chunk_t *chunk) {
+    return (uint8_t *)chunk + CHUNK_HEADER;
+}
+
+static inline size_t chunk_bytes(const rsa_arena_chunk_t *chunk) {
+    return chunk->mapped ? chunk->mapped : CHUNK_HEADER + chunk->size;
+}
+
+// CHUNKS
+// ------
+
+static rsa_arena_chunk_t *chunk_create(const rsa_arena_t *arena, size_t bytes, bool oversized) {
+    if (bytes > SIZE_MAX / 2) return NULL;
+    size_t total = CHUNK_HEADER + bytes;
+    void *base = MAP_FAILED;
+    size_t mapped = 0;
+
+    if (arena->config.huge_pages) {
+        total = (total + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+        base = mmap(NULL, total, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (base == MAP_FAILED) {
+            // hugetlb pool empty or not configured
+            base = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+            madvise(base, total, MADV_HUGEPAGE);
+#endif
+        }
+        mapped = total;
+    } else {
+        total = (total + CHUNK_HEADER - 1) & ~(size_t)(CHUNK_HEADER - 1);
+        base = aligned_alloc(CHUNK_HEADER, total);
+        if (!base) return NULL;
+    }
+
+    rsa_arena_chunk_t *chunk = base;
+    chunk->next = NULL;
+    chunk->size = total - CHUNK_HEADER;
+    chunk->mapped = mapped;
+    chunk->oversized = oversized;
+    return chunk;
+}
+
+static void chunk_release(rsa_arena_chunk_t *chunk) {
+    if (chunk->mapped) {
+        munmap(chunk, chunk->mapped);
+    } else {
+        free(chunk);
+    }
+}
+
+static void chunk_list_release(rsa_arena_chunk_t *chunk) {
+    while (chunk) {
+        rsa_arena_chunk_t *next = chunk->next;
+        chunk_release(chunk);
+        chunk = next;
+    }
+}
+
+// LIFECYCLE
+// ---------
+
+bool rsa_arena_init(rsa_arena_t *arena, const rsa_arena_config_t *config) {
+    if (!arena) return false;
+
+    memset(arena, 0, sizeof(*arena));
+    if (config) arena->config = *config;
+    size_t chunk_size = arena->config.chunk_size;
+    if (!chunk_size) chunk_size = RSA_ARENA_CHUNK_SIZE;
+    if (chunk_size < RSA_ARENA_MIN_CHUNK_SIZE) chunk_size = RSA_ARENA_MIN_CHUNK_SIZE;
+    if (chunk_size > SIZE_MAX / 4) return false;
+    if (arena->config.huge_pages) {
+        chunk_size = (chunk_size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    }
+    arena->config.chunk_size = chunk_size;
+
+    if (pthread_mutex_init(&arena->lock, NULL) != 0) return false;
+    arena->epoch = next_epoch();
+    return true;
+}
+
+void rsa_arena_free(rsa_arena_t *arena) {
+    if (!arena || !arena->epoch) return;
+    chunk_list_release(arena->used);
+    chunk_list_release(arena->free);
+    pthread_mutex_destroy(&arena->lock);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void rsa_arena_reset(rsa_arena_t *arena) {
+    if (!arena || !arena->epoch) return;
+
+    pthread_mutex_lock(&arena->lock);
+    rsa_arena_chunk_t *chunk = arena->used;
+    while (chunk) {
+        rsa_arena_chunk_t *next = chunk->next;
+        if (chunk->oversized) {
+            arena->reserved -= chunk_bytes(chunk);
+            chunk_release(chunk);
+        } else {
+            // Last used goes back on top, still warm in cache
+            chunk->next = arena->free;
+            arena->free = chunk;
+        }
+        chunk = next;
+    }
+    arena->used = NULL;
+    arena->chunks_in_use = 0;
+    arena->resets++;
+    __atomic_store_n(&arena->epoch, next_epoch(), __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&arena->lock);
+}
+
+// ALLOCATION
+// ----------
+
+static void *alloc_oversized(rsa_arena_t *arena, size_t size, size_t align) {
+    if (size > SIZE_MAX / 2 - align) return NULL;
+    rsa_arena_chunk_t *chunk = chunk_create(arena, size + align - 1, true);
+    if (!chunk) return NULL;
+
+    pthread_mutex_lock(&arena->lock);
+    chunk->next = arena->used;
+    arena->used = chunk;
+    arena->reserved += chunk_bytes(chunk);
+    arena->oversized++;
+    pthread_mutex_unlock(&arena->lock);
+    return (void *)align_up((uintptr_t)chunk_data(chunk), align);
+}
+
+// Gives this thread's cursor a fresh chunk, reused when one is free
+static void *alloc_refill(rsa_arena_t *arena, uint64_t epoch, arena_cursor_t *cursor,
+                          size_t size, size_t align) {
+    size_t chunk_size = arena->config.chunk_size;
+    if (size > chunk_size / 4 || align > CHUNK_HEADER) return alloc_oversized(arena, size, align);
+
+    pthread_mutex_lock(&arena->lock);
+    rsa_arena_chunk_t *chunk = arena->free;
+    if (chunk) {
+        arena->free = chunk->next;
+    } else {
+        // No mapping under the lock; other threads keep refilling
+        pthread_mutex_unlock(&arena->lock);
+        chunk = chunk_create(arena, chunk_size - CHUNK_HEADER, false);
+        if (!chunk) return NULL;
+        pthread_mutex_lock(&arena->lock);
+        arena->chunks++;
+        arena->reserved += chunk_bytes(chunk);
+    }
+    chunk->next = arena->used;
+    arena->used = chunk;
+    if (++arena->chunks_in_use > arena->peak_chunks_in_use) {
+        arena->peak_chunks_in_use = arena->chunks_in_use;
+    }
+    pthread_mutex_unlock(&arena->lock);
+
+    if (!cursor) {
+        cursor = &thread_cursors[thread_next_cursor];
+        thread_next_cursor = (thread_next_cursor + 1) % RSA_ARENA_THREAD_SLOTS;
+    }
+    // Chunk data is CHUNK_HEADER-aligned, so no padding is needed here
+    uintptr_t p = (uintptr_t)chunk_data(chunk);
+    cursor->epoch = epoch;
+    cursor->cur = p + size;
+    cursor->end = p + chunk->size;
+    return (void *)p;
+}
+
+void *rsa_arena_alloc(rsa_arena_t *arena, size_t size, size_t align) {
+    if (!arena || (align & (align - 1)) != 0) return NULL;
+    if (align < RSA_ARENA_ALIGN) align = RSA_ARENA_ALIGN;
+
+    uint64_t epoch = __atomic_load_n(&arena->epoch, __ATOMIC_RELAXED);
+    if (!epoch) return NULL;
+    arena_cursor_t *cursor = NULL;
+    for (int i = 0; i < RSA_ARENA_THREAD_SLOTS; i++) {
+        if (thread_cursors[i].epoch == epoch) {
+            cursor = &thread_cursors[i];
+            break;
+        }
+    }
+    if (cursor) {
+        uintptr_t p = align_up(cursor->cur, align);
+        if (p <= cursor->end && size <= cursor->end - p) {
+            cursor->cur = p + size;
+            return (void *)p;
+        }
+    }
+    return alloc_refill(arena, epoch, cursor, size, align);
+}
+
+void *rsa_arena_calloc(rsa_arena_t *arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void *p = rsa_arena_alloc(arena, count * size, RSA_ARENA_ALIGN);
+    if (p) memset(p, 0, count * size);
+    return p;
+}
@@ -0,0 +1,121 @@
+#ifndef RSA_ARENA_H
+#define RSA_ARENA_H
+
+#include "rsa_token.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// TRANSIENT ARENA
+// ===============
+// Bump-pointer allocator for objects that live for one ledger close:
+// allocation advances a cursor through a chunk, nothing is freed on its
+// own, and rsa_arena_reset() releases everything at once when the close
+// is done. Chunks are kept across resets, so a steady workload stops
+// calling malloc after its first few ledgers.
+//
+// Every thread allocates from its own chunk through a thread-local cursor
+// (one per arena, up to RSA_ARENA_THREAD_SLOTS arenas per thread), so
+// apply workers never share a cache line or a lock on the fast path; the
+// arena lock is taken only to hand out the next chunk. Allocations larger
+// than a quarter of a chunk get a chunk of their own, released at reset.
+//
+// Each init and reset gives the arena a new epoch; a thread-local cursor
+// is used only while its epoch matches, so cursors left over from an
+// earlier ledger (or a freed arena) are never followed.
+//
+// With `huge_pages`, chunks are rounded up to 2 MB and mapped from the
+// hugetlb pool, falling back to transparent huge pages (madvise) when the
+// pool is empty.
+//
+// Allocation is thread-safe. Reset and free require that no thread is
+// allocating and that nothing allocated since the last reset is used
+// again.
+
+#define RSA_ARENA_CHUNK_SIZE (1u << 20)     // default
+#define RSA_ARENA_MIN_CHUNK_SIZE 4096
+#define RSA_ARENA_ALIGN 16                  // rsa_arena_calloc(), and the minimum
+#define RSA_ARENA_THREAD_SLOTS 4            // arenas a thread allocates from at once
+
+typedef struct {
+    size_t chunk_size;                  // 0 = RSA_ARENA_CHUNK_SIZE
+    bool huge_pages;
+} rsa_arena_config_t;
+
+typedef struct rsa_arena_chunk rsa_arena_chunk_t;
+
+typedef struct {
+    rsa_arena_config_t config;
+    pthread_mutex_t lock;
+    rsa_arena_chunk_t *used;            // handed out since the last reset
+    rsa_arena_chunk_t *free;            // standard chunks kept for reuse
+    uint64_t epoch;
+
+    // Stats, under the lock
+    size_t chunks;                      // standard chunks owned
+    size_t reserved;                    // bytes owned, oversized chunks included
+    size_t chunks_in_use;               // since the last reset
+    size_t peak_chunks_in_use;          // over all ledgers
+    uint64_t oversized;                 // allocations given a chunk of their own
+    uint64_t resets;
+} rsa_arena_t;
+
+// `config` may be NULL for defaults. No memory is reserved until the
+// first allocation.
+bool rsa_arena_init(rsa_arena_t *arena, const rsa_arena_config_t *config);
+void rsa_arena_free(rsa_arena_t *arena);
+
+// `align` is a power of two, raised to RSA_ARENA_ALIGN; NULL when out of
+// memory. Zero-size allocations return a valid pointer.
+void *rsa_arena_alloc(rsa_arena_t *arena, size_t size, size_t align);
+// Zeroed; NULL on overflow as well
+void *rsa_arena_calloc(rsa_arena_t *arena, size_t count, size_t size);
+
+// Releases every allocation; standard chunks are kept for the next ledger
+void rsa_arena_reset(rsa_arena_t *arena);
+
+#ifdef __cplusplus
+}
+
+#include <memory_resource>
+#include <new>
+
+namespace rsa {
+
+// std::pmr adapter, so containers built for one close can use the arena:
+//
+//   rsa::arena_resource resource(&ledger->arena);
+//   std::pmr::vector<uint32_t> ids(&resource);
+//
+// Deallocation does nothing; memory comes back at rsa_arena_reset(), so
+// containers must not outlive it.
+class arena_resource final : public std::pmr::memory_resource {
+public:
+    explicit arena_resource(rsa_arena_t *arena) noexcept : arena_(arena) {}
+
+    rsa_arena_t *arena() const noexcept { return arena_; }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        void *p = rsa_arena_alloc(arena_, bytes, alignment);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    void do_deallocate(void *, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        const arena_resource *resource = dynamic_cast<const arena_resource *>(&other);
+        return resource && resource->arena_ == arena_;
+    }
+
+    rsa_arena_t *arena_;
+};
+
+} // namespace rsa
+#endif
+
+#endif // RSA_ARENA_H
@@ -0,0 +1,261 @@
+#include "rsa_asset_intern.h"
+#include "rsa_op_validation.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ASSET INTERNING
+// ===============
+
+_Static_assert(sizeof(rsa_asset_t) == 48, "canonical asset key is 48 bytes");
+
+#define INDEX_EMPTY UINT64_MAX
+#define INDEX_MIN_CAPACITY 64
+
+// Slots pack the upper hash bits with the id so most mismatches are
+// rejected without touching the asset itself
+struct rsa_asset_index {
+    uint64_t *slots;
+    size_t mask;
+    rsa_asset_index_t *next_retired;
+};
+
+// Fixed key for rsa_asset_hash(), which must agree across tables
+static const rsa_hash_key_t asset_fixed_key = {{0xA0761D6478BD642FULL, 0xE7037ED1A0B428DBULL,
+                                                0x8EBC6AF09C88C6E3ULL, 0x589965CC75374CC3ULL}};
+
+bool rsa_asset_canonicalize(const rsa_asset_t *asset, rsa_asset_t *canonical) {
+    if (!asset || !rsa_asset_is_valid(asset)) return false;
+
+    memset(canonical, 0, sizeof(*canonical));
+    canonical->type = asset->type;
+    switch (asset->type) {
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM4:
+            memcpy(canonical->asset.credit_alphanum4.code, asset->asset.credit_alphanum4.code, 4);
+            memcpy(canonical->asset.credit_alphanum4.issuer,
+                   asset->asset.credit_alphanum4.issuer, 32);
+            break;
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM12:
+            memcpy(canonical->asset.credit_alphanum12.code, asset->asset.credit_alphanum12.code, 12);
+            memcpy(canonical->asset.credit_alphanum12.issuer,
+                   asset->asset.credit_alphanum12.issuer, 32);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+static inline uint64_t asset_canonical_hash(const rsa_asset_t *canonical,
+                                            const rsa_hash_key_t *key) {
+    return rsa_hash_blocks(key, canonical, sizeof(*canonical) / 16);
+}
+
+uint64_t rsa_asset_hash(const rsa_asset_t *asset) {
+    rsa_asset_t canonical;
+    if (!rsa_asset_canonicalize(asset, &canonical)) return 0;
+    return asset_canonical_hash(&canonical, &asset_fixed_key);
+}
+
+static inline const rsa_asset_t *asset_at(const rsa_asset_table_t *table, uint32_t id) {
+    rsa_asset_t *chunk = __atomic_load_n(&table->chunks[id / RSA_ASSET_CHUNK_SIZE], __ATOMIC_ACQUIRE);
+    return &chunk[id % RSA_ASSET_CHUNK_SIZE];
+}
+
+static inline uint64_t index_slot(uint64_t hash, uint32_t id) {
+    return (hash & 0xFFFFFFFF00000000ULL) | id;
+}
+
+static uint32_t index_find(const rsa_asset_table_t *table, const rsa_asset_t *canonical,
+                           uint64_t hash) {
+    const rsa_asset_index_t *index = __atomic_load_n(&table->index, __ATOMIC_ACQUIRE);
+    for (size_t pos = (size_t)hash & index->mask;; pos = (pos + 1) & index->mask) {
+        uint64_t slot = __atomic_load_n(&index->slots[pos], __ATOMIC_ACQUIRE);
+        if (slot == INDEX_EMPTY) return RSA_ASSET_INVALID_ID;
+        if ((slot >> 32) == (hash >> 32)) {
+            uint32_t id = (uint32_t)slot;
+            if (memcmp(asset_at(table, id), canonical, sizeof(*canonical)) == 0) {
+                return id;
+            }
+        }
+    }
+}
+
+static void index_put(rsa_asset_index_t *index, uint64_t hash, uint32_t id) {
+    size_t pos = (size_t)hash & index->mask;
+    while (index->slots[pos] != INDEX_EMPTY) {
+        pos = (pos + 1) & index->mask;
+    }
+    __atomic_store_n(&index->slots[pos], index_slot(hash, id), __ATOMIC_RELEASE);
+}
+
+static rsa_asset_index_t *index_create(size_t capacity) {
+    rsa_asset_index_t *index = malloc(sizeof(*index));
+    if (!index) return NULL;
+    index->slots = malloc(capacity * sizeof(*index->slots));
+    if (!index->slots) {
+        free(index);
+        return NULL;
+    }
+    for (size_t i = 0; i < capacity; i++) index->slots[i] = INDEX_EMPTY;
+    index->mask = capacity - 1;
+    index->next_retired = NULL;
+    return index;
+}
+
+static void index_destroy(rsa_asset_index_t *index) {
+    if (!index) return;
+    free(index->slots);
+    free(index);
+}
+
+// Builds a twice larger index off to the side and publishes it; readers
+// still probing the old one finish there safely
+static bool index_grow(rsa_asset_table_t *table, uint32_t count) {
+    rsa_asset_index_t *old = table->index;
+    rsa_asset_index_t *grown = index_create((old->mask + 1) * 2);
+    if (!grown) return false;
+
+    for (uint32_t id = 1; id < count; id++) {
+        index_put(grown, asset_canonical_hash(asset_at(table, id), &table->key), id);
+    }
+    __atomic_store_n(&table->index, grown, __ATOMIC_RELEASE);
+    old->next_retired = table->retired;
+    table->retired = old;
+    return true;
+}
+
+bool rsa_asset_table_init(rsa_asset_table_t *table) {
+    if (!table) return false;
+    memset(table, 0, sizeof(*table));
+
+    rsa_hash_key_init(&table->key, table);
+    table->chunks[0] = calloc(RSA_ASSET_CHUNK_SIZE, sizeof(rsa_asset_t));
+    table->index = index_create(INDEX_MIN_CAPACITY);
+    if (!table->chunks[0] || !table->index || pthread_mutex_init(&table->mutex, NULL) != 0) {
+        free(table->chunks[0]);
+        index_destroy(table->index);
+        memset(table, 0, sizeof(*table));
+        return false;
+    }
+
+    // Id 0 is the native asset; it is resolved without the index
+    table->chunks[0][RSA_ASSET_NATIVE_ID].type = RSA_ASSET_TYPE_NATIVE;
+    table->count = 1;
+    return true;
+}
+
+void rsa_asset_table_free(rsa_asset_table_t *table) {
+    if (!table || !table->index) return;
+    for (size_t c = 0; c < RSA_ASSET_MAX_CHUNKS && table->chunks[c]; c++) {
+        free(table->chunks[c]);
+    }
+    index_destroy(table->index);
+    while (table->retired) {
+        rsa_asset_index_t *next = table->retired->next_retired;
+        index_destroy(table->retired);
+        table->retired = next;
+    }
+    pthread_mutex_destroy(&table->mutex);
+    memset(table, 0, sizeof(*table));
+}
+
+uint32_t rsa_asset_lookup(const rsa_asset_table_t *table, const rsa_asset_t *asset) {
+    rsa_asset_t canonical;
+    if (!table || !table->index || !rsa_asset_canonicalize(asset, &canonical)) {
+        return RSA_ASSET_INVALID_ID;
+    }
+    if (canonical.type == RSA_ASSET_TYPE_NATIVE) return RSA_ASSET_NATIVE_ID;
+    return index_find(table, &canonical, asset_canonical_hash(&canonical, &table->key));
+}
+
+uint32_t rsa_asset_intern(rsa_asset_table_t *table, const rsa_asset_t *asset) {
+    rsa_asset_t canonical;
+    if (!table || !table->index || !rsa_asset_canonicalize(asset, &canonical)) {
+        return RSA_ASSET_INVALID_ID;
+    }
+    if (canonical.type == RSA_ASSET_TYPE_NATIVE) return RSA_ASSET_NATIVE_ID;
+
+    uint64_t hash = asset_canonical_hash(&canonical, &table->key);
+    uint32_t id = index_find(table, &canonical, hash);
+    if (id != RSA_ASSET_INVALID_ID) return id;
+
+    pthread_mutex_lock(&table->mutex);
+    // Another writer may have interned it since the lock-free probe
+    id = index_find(table, &canonical, hash);
+    if (id != RSA_ASSET_INVALID_ID) {
+        pthread_mutex_unlock(&table->mutex);
+        return id;
+    }
+
+    uint32_t count = table->count;
+    if ((size_t)count >= (size_t)RSA_ASSET_CHUNK_SIZE * RSA_ASSET_MAX_CHUNKS) {
+        pthread_mutex_unlock(&table->mutex);
+        return RSA_ASSET_INVALID_ID;
+    }
+    size_t chunk = count / RSA_ASSET_CHUNK_SIZE;
+    if (!table->chunks[chunk]) {
+        rsa_asset_t *fresh = calloc(RSA_ASSET_CHUNK_SIZE, sizeof(rsa_asset_t));
+        if (!fresh) {
+            pthread_mutex_unlock(&table->mutex);
+            return RSA_ASSET_INVALID_ID;
+        }
+        __atomic_store_n(&table->chunks[chunk], fresh, __ATOMIC_RELEASE);
+    }
+    // Keep the index at most half full
+    if ((size_t)count + 1 > (table->index->mask + 1) / 2 && !index_grow(table, count)) {
+        pthread_mutex_unlock(&table->mutex);
+        return RSA_ASSET_INVALID_ID;
+    }
+
+    id = count;
+    table->chunks[chunk][id % RSA_ASSET_CHUNK_SIZE] = canonical;
+    index_put(table->index, hash, id);
+    __atomic_store_n(&table->count, count + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&table->mutex);
+    return id;
+}
+
+const rsa_asset_t *rsa_asset_from_id(const rsa_asset_table_t *table, uint32_t id) {
+    if (!table || id >= __atomic_load_n(&table->count, __ATOMIC_ACQUIRE)) return NULL;
+    return asset_at(table, id);
+}
+
+size_t rsa_asset_table_size(const rsa_asset_table_t *table) {
+    return table ? __atomic_load_n(&table->count, __ATOMIC_ACQUIRE) : 0;
+}
+
+static const char *asset_code(const rsa_asset_t *asset, size_t *len) {
+    if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+        *len = 4;
+        return asset->asset.credit_alphanum4.code;
+    }
+    *len = 12;
+    return asset->asset.credit_alphanum12.code;
+}
+
+static const uint8_t *asset_issuer(const rsa_asset_t *asset) {
+    return asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4 ? asset->asset.credit_alphanum4.issuer
+                                                          : asset->asset.credit_alphanum12.issuer;
+}
+
+int rsa_asset_id_compare(const rsa_asset_table_t *table, uint32_t a, uint32_t b) {
+    if (a == b) return 0;
+    const rsa_asset_t *left = rsa_asset_from_id(table, a);
+    const rsa_asset_t *right = rsa_asset_from_id(table, b);
+    if (!left || !right) {
+        // Unknown ids sort after every interned asset
+        return left ? -1 : (right ? 1 : (a < b ? -1 : 1));
+    }
+
+    if (left->type != right->type) return left->type < right->type ? -1 : 1;
+    if (left->type == RSA_ASSET_TYPE_NATIVE) return 0;
+
+    size_t left_len, right_len;
+    const char *left_code = asset_code(left, &left_len);
+    const char *right_code = asset_code(right, &right_len);
+    int order = memcmp(left_code, right_code, left_len < right_len ? left_len : right_len);
+    if (order != 0) return order < 0 ? -1 : 1;
+
+    order = memcmp(asset_issuer(left), asset_issuer(right), 32);
+    return order < 0 ? -1 : (order > 0 ? 1 : 0);
+}
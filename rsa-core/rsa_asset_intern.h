@@ -0,0 +1,74 @@
+#ifndef RSA_ASSET_INTERN_H
+#define RSA_ASSET_INTERN_H
+
+#include "rsa_token.h"
+#include "rsa_hash.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ASSET INTERNING
+// ===============
+// Maps each canonical rsa_asset_t to a dense 32-bit id so order books,
+// trustline keys and path-finding graphs compare 4 bytes instead of a
+// 48-byte union. The native asset is always id 0. Ids are never reused.
+//
+// Lookups and id -> asset resolution are lock-free; interning a new asset
+// takes the table mutex. Assets are stored in fixed chunks that never
+// move, and the hash index is replaced wholesale on growth (old indexes
+// are retired and freed with the table), so readers never see freed memory.
+
+#define RSA_ASSET_NATIVE_ID 0u
+#define RSA_ASSET_INVALID_ID UINT32_MAX
+#define RSA_ASSET_CHUNK_SIZE 4096
+#define RSA_ASSET_MAX_CHUNKS 4096       // 16M assets
+
+typedef struct rsa_asset_index rsa_asset_index_t;
+
+typedef struct {
+    rsa_asset_t *chunks[RSA_ASSET_MAX_CHUNKS];
+    uint32_t count;                     // published with release semantics
+    rsa_asset_index_t *index;           // current hash index
+    rsa_asset_index_t *retired;         // replaced indexes, freed with the table
+    rsa_hash_key_t key;
+    pthread_mutex_t mutex;              // serializes interning
+} rsa_asset_table_t;
+
+bool rsa_asset_table_init(rsa_asset_table_t *table);
+void rsa_asset_table_free(rsa_asset_table_t *table);
+
+// Id of an asset, interning it on first sight. RSA_ASSET_INVALID_ID for
+// malformed assets (see rsa_asset_is_valid) or when the table is full.
+uint32_t rsa_asset_intern(rsa_asset_table_t *table, const rsa_asset_t *asset);
+// Id of an already interned asset, RSA_ASSET_INVALID_ID otherwise
+uint32_t rsa_asset_lookup(const rsa_asset_table_t *table, const rsa_asset_t *asset);
+// Canonical asset for an id (code NUL padded, unused bytes zeroed)
+const rsa_asset_t *rsa_asset_from_id(const rsa_asset_table_t *table, uint32_t id);
+size_t rsa_asset_table_size(const rsa_asset_table_t *table);
+
+// Canonical form (code NUL padded, unused bytes zeroed): two assets are
+// equal exactly when their canonical forms are byte-equal. False for
+// malformed assets.
+bool rsa_asset_canonicalize(const rsa_asset_t *asset, rsa_asset_t *canonical);
+
+// Canonical-form hash, independent of any table. Unkeyed, so not for
+// tables indexed by client input.
+uint64_t rsa_asset_hash(const rsa_asset_t *asset);
+
+// Id equality is asset equality
+static inline bool rsa_asset_id_equal(uint32_t a, uint32_t b) {
+    return a == b;
+}
+
+// Canonical order of the underlying assets (native first, then by type,
+// code and issuer); use plain id order where any total order will do
+int rsa_asset_id_compare(const rsa_asset_table_t *table, uint32_t a, uint32_t b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_ASSET_INTERN_H
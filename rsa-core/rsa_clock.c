@@ -0,0 +1,132 @@
+#include "rsa_clock.h"
+#include <pthread.h>
+#include <time.h>
+
+// COARSE CLOCK SERVICE
+// ====================
+
+// Fake time; read only under RSA_CLOCK_FAKE
+static uint64_t g_clock_wall_ms = 0;
+static uint64_t g_clock_monotonic_ms = 0;
+static int g_clock_mode = RSA_CLOCK_REAL;
+
+// Serializes fake clock writers; readers are lock-free
+static pthread_mutex_t g_clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t clock_read_ms(clockid_t id) {
+    struct timespec ts;
+    if (clock_gettime(id, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+// The coarse clocks are served from the vDSO without a syscall; their
+// resolution (one scheduler tick) is well within what the callers need
+static uint64_t clock_read_wall_ms(void) {
+#ifdef CLOCK_REALTIME_COARSE
+    return clock_read_ms(CLOCK_REALTIME_COARSE);
+#else
+    return clock_read_ms(CLOCK_REALTIME);
+#endif
+}
+
+static uint64_t clock_read_monotonic_ms(void) {
+#ifdef CLOCK_MONOTONIC_COARSE
+    return clock_read_ms(CLOCK_MONOTONIC_COARSE);
+#else
+    return clock_read_ms(CLOCK_MONOTONIC);
+#endif
+}
+
+static int clock_mode(void) {
+    return __atomic_load_n(&g_clock_mode, __ATOMIC_ACQUIRE);
+}
+
+uint64_t rsa_clock_wall_ms(void) {
+    if (clock_mode() == RSA_CLOCK_REAL) {
+        return clock_read_wall_ms();
+    }
+    return __atomic_load_n(&g_clock_wall_ms, __ATOMIC_RELAXED);
+}
+
+uint64_t rsa_clock_wall_seconds(void) {
+    return rsa_clock_wall_ms() / 1000u;
+}
+
+uint64_t rsa_clock_monotonic_ms(void) {
+    if (clock_mode() == RSA_CLOCK_REAL) {
+        return clock_read_monotonic_ms();
+    }
+    return __atomic_load_n(&g_clock_monotonic_ms, __ATOMIC_RELAXED);
+}
+
+uint64_t rsa_clock_precise_ns(void) {
+    if (clock_mode() == RSA_CLOCK_FAKE) {
+        return __atomic_load_n(&g_clock_monotonic_ms, __ATOMIC_RELAXED) * 1000000u;
+    }
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+rsa_clock_mode_t rsa_clock_mode(void) {
+    return (rsa_clock_mode_t)clock_mode();
+}
+
+static void clock_store(uint64_t wall_ms, uint64_t monotonic_ms) {
+    __atomic_store_n(&g_clock_wall_ms, wall_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_clock_monotonic_ms, monotonic_ms, __ATOMIC_RELAXED);
+}
+
+void rsa_clock_set_fake(uint64_t wall_ms, uint64_t monotonic_ms) {
+    pthread_mutex_lock(&g_clock_mutex);
+    clock_store(wall_ms, monotonic_ms);
+    __atomic_store_n(&g_clock_mode, RSA_CLOCK_FAKE, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_clock_mutex);
+}
+
+void rsa_clock_advance_ms(uint64_t delta_ms) {
+    pthread_mutex_lock(&g_clock_mutex);
+    if (clock_mode() == RSA_CLOCK_FAKE) {
+        clock_store(g_clock_wall_ms + delta_ms, g_clock_monotonic_ms + delta_ms);
+    }
+    pthread_mutex_unlock(&g_clock_mutex);
+}
+
+void rsa_clock_use_real(void) {
+    pthread_mutex_lock(&g_clock_mutex);
+    __atomic_store_n(&g_clock_mode, RSA_CLOCK_REAL, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_clock_mutex);
+}
+
+rsa_clock_bounds_t rsa_clock_check_bounds(const rsa_time_bounds_t *bounds, uint64_t now) {
+    if (!bounds) return RSA_CLOCK_WITHIN_BOUNDS;
+    if (bounds->min_time > 0 && now < bounds->min_time) {
+        return RSA_CLOCK_TOO_EARLY;
+    }
+    if (bounds->max_time > 0 && now > bounds->max_time) {
+        return RSA_CLOCK_EXPIRED;
+    }
+    return RSA_CLOCK_WITHIN_BOUNDS;
+}
+
+size_t rsa_clock_check_bounds_batch(const rsa_time_bounds_t *bounds, size_t count,
+                                    uint64_t now, uint8_t *out) {
+    if (!bounds || !out) return 0;
+
+    // Branch-free so mixed sets do not pay for mispredictions; TOO_EARLY
+    // wins over EXPIRED as in rsa_clock_check_bounds()
+    size_t outside = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t early = (uint8_t)((bounds[i].min_time > 0) & (now < bounds[i].min_time));
+        uint8_t expired = (uint8_t)((bounds[i].max_time > 0) & (now > bounds[i].max_time));
+        uint8_t verdict = (uint8_t)(early * RSA_CLOCK_TOO_EARLY +
+                                    (expired & (early ^ 1u)) * RSA_CLOCK_EXPIRED);
+        out[i] = verdict;
+        outside += (verdict != RSA_CLOCK_WITHIN_BOUNDS);
+    }
+    return outside;
+}
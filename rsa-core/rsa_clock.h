@@ -0,0 +1,60 @@
+#ifndef RSA_CLOCK_H
+#define RSA_CLOCK_H
+
+#include "rsa_token.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// COARSE CLOCK SERVICE
+// ====================
+// Hot paths read wall-clock and monotonic timestamps (milliseconds) from
+// the coarse kernel clocks instead of calling time(NULL). Those are served
+// from the vDSO without a syscall and advance once per scheduler tick,
+// well within what the callers need, so nothing is cached. A fake clock
+// can be installed for deterministic replay and benchmarks, in which case
+// time only moves through rsa_clock_set_fake() and rsa_clock_advance_ms().
+
+typedef enum {
+    RSA_CLOCK_REAL = 0,                // the coarse kernel clocks
+    RSA_CLOCK_FAKE                     // controlled by the caller
+} rsa_clock_mode_t;
+
+// Result of a time-bound check
+typedef enum {
+    RSA_CLOCK_WITHIN_BOUNDS = 0,
+    RSA_CLOCK_TOO_EARLY,
+    RSA_CLOCK_EXPIRED
+} rsa_clock_bounds_t;
+
+// Wall-clock time since the epoch
+uint64_t rsa_clock_wall_ms(void);
+uint64_t rsa_clock_wall_seconds(void);
+// Monotonic time, for intervals and deadlines
+uint64_t rsa_clock_monotonic_ms(void);
+// Full-resolution monotonic time, for timing phases shorter than a tick;
+// always a kernel read, except under a fake clock, where it follows the
+// fake monotonic time
+uint64_t rsa_clock_precise_ns(void);
+
+// Fake clock: pins both timestamps until rsa_clock_use_real()
+void rsa_clock_set_fake(uint64_t wall_ms, uint64_t monotonic_ms);
+void rsa_clock_advance_ms(uint64_t delta_ms);
+void rsa_clock_use_real(void);
+rsa_clock_mode_t rsa_clock_mode(void);
+
+// Time-bound checks against a single `now` (seconds) read once by the
+// caller; 0 bounds are open
+rsa_clock_bounds_t rsa_clock_check_bounds(const rsa_time_bounds_t *bounds, uint64_t now);
+// Batch form over bounds[0..count): out[i] receives an rsa_clock_bounds_t.
+// Returns the number of entries outside their bounds.
+size_t rsa_clock_check_bounds_batch(const rsa_time_bounds_t *bounds, size_t count,
+                                    uint64_t now, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_CLOCK_H
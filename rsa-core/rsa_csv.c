@@ -0,0 +1,300 @@
+#include "rsa_csv.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// BULK (ADDRESS, AMOUNT) CSV CODEC
+// ================================
+
+#define RSA_CSV_BLOCK 64
+
+// Bit i set when p[i] is ',' or '\n'
+static inline uint64_t structural_mask64(const char *p) {
+#if defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(p + 16 * i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, newline));
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(hit) << (16 * i);
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    for (int i = 0; i < RSA_CSV_BLOCK; i++) {
+        mask |= (uint64_t)(p[i] == ',' || p[i] == '\n') << i;
+    }
+    return mask;
+#endif
+}
+
+static inline uint64_t block_mask(const rsa_csv_reader_t *reader, size_t block) {
+    if (reader->size - block >= RSA_CSV_BLOCK) {
+        return structural_mask64(reader->data + block);
+    }
+    // Final partial block: pad so the vector loads stay inside our buffer
+    char tail[RSA_CSV_BLOCK];
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, reader->data + block, reader->size - block);
+    return structural_mask64(tail);
+}
+
+// Offset of the next ',' or '\n' at or after the scan position, or size
+static inline size_t next_structural(rsa_csv_reader_t *reader) {
+    while (reader->scan_mask == 0) {
+        reader->scan_block += RSA_CSV_BLOCK;
+        if (reader->scan_block >= reader->size) {
+            reader->scan_block = reader->size;
+            return reader->size;
+        }
+        reader->scan_mask = block_mask(reader, reader->scan_block);
+    }
+    size_t offset = reader->scan_block + (size_t)__builtin_ctzll(reader->scan_mask);
+    reader->scan_mask &= reader->scan_mask - 1;
+    return offset;
+}
+
+bool rsa_csv_batch_init(rsa_csv_batch_t *batch, size_t capacity) {
+    if (!batch || capacity == 0) return false;
+
+    memset(batch, 0, sizeof(*batch));
+    batch->capacity = capacity;
+    batch->public_keys = malloc(capacity * sizeof(*batch->public_keys));
+    batch->amounts = malloc(capacity * sizeof(*batch->amounts));
+    batch->status = malloc(capacity * sizeof(*batch->status));
+    batch->fields = malloc(2 * capacity * sizeof(*batch->fields));
+    batch->field_lens = malloc(2 * capacity * sizeof(*batch->field_lens));
+    batch->address_ok = malloc(capacity * sizeof(*batch->address_ok));
+    batch->amount_status = malloc(capacity * sizeof(*batch->amount_status));
+
+    if (!batch->public_keys || !batch->amounts || !batch->status || !batch->fields ||
+        !batch->field_lens || !batch->address_ok || !batch->amount_status) {
+        rsa_csv_batch_free(batch);
+        return false;
+    }
+    return true;
+}
+
+void rsa_csv_batch_free(rsa_csv_batch_t *batch) {
+    if (!batch) return;
+    free(batch->public_keys);
+    free(batch->amounts);
+    free(batch->status);
+    free(batch->fields);
+    free(batch->field_lens);
+    free(batch->address_ok);
+    free(batch->amount_status);
+    memset(batch, 0, sizeof(*batch));
+}
+
+bool rsa_csv_reader_open(rsa_csv_reader_t *reader, const char *path, bool skip_header) {
+    if (!reader || !path) return false;
+
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (reader->fd < 0) return false;
+
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0) {
+        close(reader->fd);
+        reader->fd = -1;
+        return false;
+    }
+
+    reader->size = (size_t)st.st_size;
+    if (reader->size > 0) {
+        void *map = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+        if (map == MAP_FAILED) {
+            close(reader->fd);
+            reader->fd = -1;
+            return false;
+        }
+        madvise(map, reader->size, MADV_SEQUENTIAL);
+        reader->data = map;
+        reader->scan_mask = block_mask(reader, 0);
+    }
+
+    if (skip_header) {
+        size_t s;
+        do {
+            s = next_structural(reader);
+        } while (s < reader->size && reader->data[s] != '\n');
+        reader->cursor = (s < reader->size) ? s + 1 : reader->size;
+    }
+    return true;
+}
+
+size_t rsa_csv_read_batch(rsa_csv_reader_t *reader, rsa_csv_batch_t *batch) {
+    if (!reader || !batch) return 0;
+
+    const char *data = reader->data;
+    const size_t size = reader->size;
+    const size_t cap = batch->capacity;
+    const char **addresses = batch->fields;
+    const char **amounts = batch->fields + cap;
+    size_t *address_lens = batch->field_lens;
+    size_t *amount_lens = batch->field_lens + cap;
+    size_t n = 0;
+
+    batch->first_row = reader->rows_read;
+
+    // Stage 1: split rows at the structural characters
+    while (n < cap && reader->cursor < size) {
+        size_t row_start = reader->cursor;
+        size_t comma = next_structural(reader);
+
+        if (comma >= size || data[comma] == '\n') {
+            size_t row_end = comma;
+            reader->cursor = (comma < size) ? comma + 1 : size;
+            // Blank lines (optionally "\r\n") are skipped silently
+            if (row_end == row_start || (row_end == row_start + 1 && data[row_start] == '\r')) {
+                continue;
+            }
+            addresses[n] = amounts[n] = NULL;
+            address_lens[n] = amount_lens[n] = 0;
+            batch->status[n++] = RSA_CSV_ROW_BAD_FORMAT;
+            continue;
+        }
+
+        size_t row_end = next_structural(reader);
+        if (row_end < size && data[row_end] == ',') {
+            while (row_end < size && data[row_end] != '\n') {
+                row_end = next_structural(reader);
+            }
+            reader->cursor = (row_end < size) ? row_end + 1 : size;
+            addresses[n] = amounts[n] = NULL;
+            address_lens[n] = amount_lens[n] = 0;
+            batch->status[n++] = RSA_CSV_ROW_BAD_FORMAT;
+            continue;
+        }
+
+        reader->cursor = (row_end < size) ? row_end + 1 : size;
+        if (row_end > comma + 1 && data[row_end - 1] == '\r') {
+            row_end--;
+        }
+        addresses[n] = data + row_start;
+        address_lens[n] = comma - row_start;
+        amounts[n] = data + comma + 1;
+        amount_lens[n] = row_end - comma - 1;
+        batch->status[n++] = RSA_CSV_ROW_OK;
+    }
+
+    // Stage 2: decode each column in one pass
+    rsa_address_decode_batch(addresses, address_lens, n, batch->public_keys, batch->address_ok);
+    rsa_amount_parse_batch(amounts, amount_lens, n, batch->amounts, batch->amount_status);
+
+    for (size_t i = 0; i < n; i++) {
+        if (batch->status[i] != RSA_CSV_ROW_OK) {
+            batch->amounts[i] = 0;
+        } else if (!batch->address_ok[i]) {
+            batch->status[i] = RSA_CSV_ROW_BAD_ADDRESS;
+        } else if (batch->amount_status[i] != RSA_AMOUNT_OK) {
+            batch->status[i] = RSA_CSV_ROW_BAD_AMOUNT;
+        }
+    }
+
+    batch->count = n;
+    reader->rows_read += n;
+    return n;
+}
+
+void rsa_csv_reader_close(rsa_csv_reader_t *reader) {
+    if (!reader) return;
+    if (reader->data) {
+        munmap((void *)reader->data, reader->size);
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
+
+static bool write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buf += written;
+        len -= (size_t)written;
+    }
+    return true;
+}
+
+bool rsa_csv_writer_open(rsa_csv_writer_t *writer, const char *path, const char *header,
+                         size_t buffer_rows) {
+    if (!writer || !path) return false;
+
+    memset(writer, 0, sizeof(*writer));
+    writer->buffer_rows = buffer_rows ? buffer_rows : RSA_CSV_DEFAULT_BATCH_ROWS;
+    writer->buffer = malloc(writer->buffer_rows * RSA_CSV_MAX_ROW_LENGTH);
+    if (!writer->buffer) return false;
+
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (writer->fd < 0) {
+        free(writer->buffer);
+        writer->buffer = NULL;
+        return false;
+    }
+
+    if (header) {
+        if (!write_all(writer->fd, header, strlen(header)) || !write_all(writer->fd, "\n", 1)) {
+            rsa_csv_writer_close(writer);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool rsa_csv_write_batch(rsa_csv_writer_t *writer,
+                         const uint8_t (*public_keys)[RSA_PUBLIC_KEY_LENGTH],
+                         const int64_t *amounts, size_t count) {
+    if (!writer || !writer->buffer || (count > 0 && (!public_keys || !amounts))) return false;
+
+    size_t i = 0;
+    while (i < count) {
+        size_t chunk = count - i;
+        if (chunk > writer->buffer_rows) chunk = writer->buffer_rows;
+
+        // Every row fits in RSA_CSV_MAX_ROW_LENGTH, so no bounds checks per field
+        char *p = writer->buffer;
+        for (size_t k = 0; k < chunk; k++) {
+            rsa_address_encode_fast(public_keys[i + k], p);
+            p += RSA_ADDRESS_FULL_LENGTH;
+            *p++ = ',';
+            p += rsa_amount_format(amounts[i + k], p, RSA_AMOUNT_FORMAT_FIXED);
+            *p++ = '\n';
+        }
+
+        if (!write_all(writer->fd, writer->buffer, (size_t)(p - writer->buffer))) {
+            return false;
+        }
+        i += chunk;
+        writer->rows_written += chunk;
+    }
+    return true;
+}
+
+bool rsa_csv_writer_close(rsa_csv_writer_t *writer) {
+    if (!writer) return false;
+
+    bool ok = true;
+    if (writer->fd >= 0) {
+        ok = (close(writer->fd) == 0);
+    }
+    free(writer->buffer);
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+    return ok;
+}
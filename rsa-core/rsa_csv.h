@@ -0,0 +1,84 @@
+#ifndef RSA_CSV_H
+#define RSA_CSV_H
+
+#include "rsa_token.h"
+#include "rsa_amount.h"
+#include "rsa_address.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// BULK (ADDRESS, AMOUNT) CSV CODEC
+// ================================
+// Streaming columnar codec for reconciliation and payout files with rows of
+//   <address>,<amount>\n
+// The reader memory-maps the file, indexes ',' and '\n' with a SIMD scan,
+// then decodes a whole batch of addresses and amounts into typed arrays.
+// The writer formats batches into a pre-sized buffer and issues one write.
+
+#define RSA_CSV_DEFAULT_BATCH_ROWS 65536
+#define RSA_CSV_MAX_ROW_LENGTH (RSA_ADDRESS_FULL_LENGTH + 1 + RSA_AMOUNT_MAX_STRING_LENGTH + 1)
+
+typedef enum {
+    RSA_CSV_ROW_OK = 0,
+    RSA_CSV_ROW_BAD_ADDRESS = 1,
+    RSA_CSV_ROW_BAD_AMOUNT = 2,
+    RSA_CSV_ROW_BAD_FORMAT = 3     // not exactly two columns
+} rsa_csv_row_status_t;
+
+// Column arrays for one batch of rows
+typedef struct {
+    size_t capacity;
+    size_t count;
+    uint64_t first_row;            // data row number of entry 0 (0-based)
+    uint8_t (*public_keys)[RSA_PUBLIC_KEY_LENGTH];
+    int64_t *amounts;
+    uint8_t *status;               // rsa_csv_row_status_t per row
+    // Field slices for the decode stage: addresses, then amounts
+    const char **fields;
+    size_t *field_lens;
+    bool *address_ok;
+    rsa_amount_status_t *amount_status;
+} rsa_csv_batch_t;
+
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t cursor;
+    size_t scan_block;             // offset of the block behind scan_mask
+    uint64_t scan_mask;            // unconsumed ',' / '\n' bits of that block
+    uint64_t rows_read;
+    int fd;
+} rsa_csv_reader_t;
+
+typedef struct {
+    char *buffer;
+    size_t buffer_rows;
+    uint64_t rows_written;
+    int fd;
+} rsa_csv_writer_t;
+
+bool rsa_csv_batch_init(rsa_csv_batch_t *batch, size_t capacity);
+void rsa_csv_batch_free(rsa_csv_batch_t *batch);
+
+// Maps `path` read-only. With skip_header the first line is ignored.
+bool rsa_csv_reader_open(rsa_csv_reader_t *reader, const char *path, bool skip_header);
+// Fills up to batch->capacity rows. Returns the row count; 0 at end of file.
+size_t rsa_csv_read_batch(rsa_csv_reader_t *reader, rsa_csv_batch_t *batch);
+void rsa_csv_reader_close(rsa_csv_reader_t *reader);
+
+// Creates/truncates `path`; writes `header` as the first line when non-NULL
+bool rsa_csv_writer_open(rsa_csv_writer_t *writer, const char *path, const char *header,
+                         size_t buffer_rows);
+bool rsa_csv_write_batch(rsa_csv_writer_t *writer,
+                         const uint8_t (*public_keys)[RSA_PUBLIC_KEY_LENGTH],
+                         const int64_t *amounts, size_t count);
+bool rsa_csv_writer_close(rsa_csv_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_CSV_H
@@ -0,0 +1,703 @@
+#include "rsa_envelope.h"
+#include <openssl/sha.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ENVELOPE WIRE FORMAT
+// ====================
+
+#define TX_OFFSET RSA_ENVELOPE_HEADER_BYTES
+#define MEMO_OFFSET (TX_OFFSET + 60)
+#define MAX_PATH (sizeof(((rsa_operation_t *)0)->operation.path_payment.path) / sizeof(rsa_asset_t))
+#define MAX_HOME_DOMAIN sizeof(((rsa_operation_t *)0)->operation.set_options.home_domain)
+#define MAX_SIGNERS \
+    (sizeof(((rsa_operation_t *)0)->operation.set_options.signers) / sizeof(rsa_signer_t))
+#define MAX_DATA_NAME sizeof(((rsa_operation_t *)0)->operation.manage_data.data_name)
+#define MAX_DATA_VALUE sizeof(((rsa_operation_t *)0)->operation.manage_data.data_value)
+#define MAX_MEMO_TEXT sizeof(((rsa_memo_t *)0)->memo.text)
+
+// Little-endian fields at any alignment
+// -------------------------------------
+
+static inline uint16_t load_le16(const uint8_t *p) {
+    uint16_t x;
+    memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap16(x);
+#endif
+    return x;
+}
+
+static inline uint32_t load_le32(const uint8_t *p) {
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap32(x);
+#endif
+    return x;
+}
+
+static inline uint64_t load_le64(const uint8_t *p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+}
+
+static inline void store_le16(uint8_t *p, uint16_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap16(x);
+#endif
+    memcpy(p, &x, sizeof(x));
+}
+
+static inline void store_le32(uint8_t *p, uint32_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap32(x);
+#endif
+    memcpy(p, &x, sizeof(x));
+}
+
+static inline void store_le64(uint8_t *p, uint64_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    memcpy(p, &x, sizeof(x));
+}
+
+// Writers return the cursor past the field; sizes were checked up front
+// ---------------------------------------------------------------------
+
+static inline uint8_t *put_u8(uint8_t *p, uint32_t v) {
+    *p = (uint8_t)v;
+    return p + 1;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    store_le32(p, v);
+    return p + 4;
+}
+
+static inline uint8_t *put_u64(uint8_t *p, uint64_t v) {
+    store_le64(p, v);
+    return p + 8;
+}
+
+static inline uint8_t *put_bytes(uint8_t *p, const void *src, size_t n) {
+    memcpy(p, src, n);
+    return p + n;
+}
+
+static inline uint8_t *put_account(uint8_t *p, const uint32_t id[8]) {
+    for (int i = 0; i < 8; i++) store_le32(p + 4 * i, id[i]);
+    return p + 32;
+}
+
+static uint8_t *put_asset(uint8_t *p, const rsa_asset_t *asset) {
+    p = put_u8(p, asset->type);
+    if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+        p = put_bytes(p, asset->asset.credit_alphanum4.code, 4);
+        p = put_bytes(p, asset->asset.credit_alphanum4.issuer, 32);
+    } else if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM12) {
+        p = put_bytes(p, asset->asset.credit_alphanum12.code, 12);
+        p = put_bytes(p, asset->asset.credit_alphanum12.issuer, 32);
+    }
+    return p;
+}
+
+// Readers run on parsed views only
+// --------------------------------
+
+static inline const uint8_t *get_account(const uint8_t *p, uint32_t id[8]) {
+    for (int i = 0; i < 8; i++) id[i] = load_le32(p + 4 * i);
+    return p + 32;
+}
+
+static const uint8_t *get_asset(const uint8_t *p, rsa_asset_t *asset) {
+    asset->type = (rsa_asset_type_t)*p++;
+    if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+        memcpy(asset->asset.credit_alphanum4.code, p, 4);
+        memcpy(asset->asset.credit_alphanum4.issuer, p + 4, 32);
+        p += 36;
+    } else if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM12) {
+        memcpy(asset->asset.credit_alphanum12.code, p, 12);
+        memcpy(asset->asset.credit_alphanum12.issuer, p + 12, 32);
+        p += 44;
+    }
+    return p;
+}
+
+// Sizes
+// -----
+
+static size_t asset_size(const rsa_asset_t *asset) {
+    switch (asset->type) {
+        case RSA_ASSET_TYPE_NATIVE: return 1;
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM4: return 1 + 4 + 32;
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM12: return 1 + 12 + 32;
+    }
+    return 0;
+}
+
+// Memo text is NUL-padded, or fills the field
+static size_t memo_text_len(const rsa_memo_t *memo) {
+    const char *nul = memchr(memo->memo.text, 0, MAX_MEMO_TEXT);
+    return nul ? (size_t)(nul - memo->memo.text) : MAX_MEMO_TEXT;
+}
+
+static size_t memo_size(const rsa_memo_t *memo) {
+    switch (memo->type) {
+        case RSA_MEMO_NONE: return 1;
+        case RSA_MEMO_TEXT: return 2 + memo_text_len(memo);
+        case RSA_MEMO_ID: return 1 + 8;
+        case RSA_MEMO_HASH:
+        case RSA_MEMO_RETURN: return 1 + 32;
+    }
+    return 0;
+}
+
+// 0 when the operation cannot be encoded
+static size_t op_size(const rsa_operation_t *op) {
+    size_t a, b, size;
+    switch (op->type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            return 1 + 32 + 8;
+        case RSA_OP_PAYMENT:
+            a = asset_size(&op->operation.payment.asset);
+            return a ? 1 + a + 32 + 32 + 8 : 0;
+        case RSA_OP_PATH_PAYMENT:
+            a = asset_size(&op->operation.path_payment.send_asset);
+            b = asset_size(&op->operation.path_payment.dest_asset);
+            if (!a || !b || op->operation.path_payment.path_len > MAX_PATH) return 0;
+            size = 1 + a + 8 + 32 + b + 8 + 1;
+            for (uint32_t i = 0; i < op->operation.path_payment.path_len; i++) {
+                a = asset_size(&op->operation.path_payment.path[i]);
+                if (!a) return 0;
+                size += a;
+            }
+            return size;
+        case RSA_OP_MANAGE_OFFER:
+        case RSA_OP_CREATE_PASSIVE_OFFER:
+            a = asset_size(&op->operation.manage_offer.selling);
+            b = asset_size(&op->operation.manage_offer.buying);
+            return a && b ? 1 + a + b + 8 + 4 + 4 + 4 : 0;
+        case RSA_OP_SET_OPTIONS:
+            if (op->operation.set_options.home_domain_len > MAX_HOME_DOMAIN ||
+                op->operation.set_options.signer_count > MAX_SIGNERS) {
+                return 0;
+            }
+            return 1 + 4 + 1 + op->operation.set_options.home_domain_len + 1 +
+                   op->operation.set_options.signer_count * (32 + 4);
+        case RSA_OP_CHANGE_TRUST:
+            a = asset_size(&op->operation.change_trust.asset);
+            return a ? 1 + a + 8 : 0;
+        case RSA_OP_ALLOW_TRUST:
+            a = asset_size(&op->operation.allow_trust.asset);
+            return a ? 1 + 32 + a + 4 : 0;
+        case RSA_OP_ACCOUNT_MERGE:
+            return 1 + 32;
+        case RSA_OP_INFLATION:
+            return 1;
+        case RSA_OP_MANAGE_DATA:
+            if (op->operation.manage_data.data_name_len > MAX_DATA_NAME ||
+                op->operation.manage_data.data_value_len > MAX_DATA_VALUE) {
+                return 0;
+            }
+            return 1 + 1 + op->operation.manage_data.data_name_len + 1 +
+                   op->operation.manage_data.data_value_len;
+        case RSA_OP_BUMP_SEQUENCE:
+            return 1 + 8;
+    }
+    return 0;
+}
+
+// Encoding
+// --------
+
+static uint8_t *encode_op(uint8_t *p, const rsa_operation_t *op) {
+    p = put_u8(p, op->type);
+    switch (op->type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            p = put_account(p, op->operation.create_account.destination);
+            p = put_u64(p, (uint64_t)op->operation.create_account.starting_balance);
+            break;
+        case RSA_OP_PAYMENT:
+            p = put_asset(p, &op->operation.payment.asset);
+            p = put_account(p, op->operation.payment.from);
+            p = put_account(p, op->operation.payment.to);
+            p = put_u64(p, (uint64_t)op->operation.payment.amount);
+            break;
+        case RSA_OP_PATH_PAYMENT:
+            p = put_asset(p, &op->operation.path_payment.send_asset);
+            p = put_u64(p, (uint64_t)op->operation.path_payment.send_max);
+            p = put_account(p, op->operation.path_payment.destination);
+            p = put_asset(p, &op->operation.path_payment.dest_asset);
+            p = put_u64(p, (uint64_t)op->operation.path_payment.dest_amount);
+            p = put_u8(p, op->operation.path_payment.path_len);
+            for (uint32_t i = 0; i < op->operation.path_payment.path_len; i++) {
+                p = put_asset(p, &op->operation.path_payment.path[i]);
+            }
+            break;
+        case RSA_OP_MANAGE_OFFER:
+        case RSA_OP_CREATE_PASSIVE_OFFER:
+            p = put_asset(p, &op->operation.manage_offer.selling);
+            p = put_asset(p, &op->operation.manage_offer.buying);
+            p = put_u64(p, (uint64_t)op->operation.manage_offer.amount);
+            p = put_u32(p, (uint32_t)op->operation.manage_offer.price.n);
+            p = put_u32(p, (uint32_t)op->operation.manage_offer.price.d);
+            p = put_u32(p, op->operation.manage_offer.offer_id);
+            break;
+        case RSA_OP_SET_OPTIONS:
+            p = put_u32(p, op->operation.set_options.thresholds);
+            p = put_u8(p, op->operation.set_options.home_domain_len);
+            p = put_bytes(p, op->operation.set_options.home_domain,
+                          op->operation.set_options.home_domain_len);
+            p = put_u8(p, op->operation.set_options.signer_count);
+            for (uint32_t i = 0; i < op->operation.set_options.signer_count; i++) {
+                p = put_bytes(p, op->operation.set_options.signers[i].key, 32);
+                p = put_u32(p, op->operation.set_options.signers[i].weight);
+            }
+            break;
+        case RSA_OP_CHANGE_TRUST:
+            p = put_asset(p, &op->operation.change_trust.asset);
+            p = put_u64(p, (uint64_t)op->operation.change_trust.limit);
+            break;
+        case RSA_OP_ALLOW_TRUST:
+            p = put_account(p, op->operation.allow_trust.trustor);
+            p = put_asset(p, &op->operation.allow_trust.asset);
+            p = put_u32(p, op->operation.allow_trust.authorize);
+            break;
+        case RSA_OP_ACCOUNT_MERGE:
+            p = put_account(p, op->operation.account_merge.destination);
+            break;
+        case RSA_OP_INFLATION:
+            break;
+        case RSA_OP_MANAGE_DATA:
+            p = put_u8(p, op->operation.manage_data.data_name_len);
+            p = put_bytes(p, op->operation.manage_data.data_name,
+                          op->operation.manage_data.data_name_len);
+            p = put_u8(p, op->operation.manage_data.data_value_len);
+            p = put_bytes(p, op->operation.manage_data.data_value,
+                          op->operation.manage_data.data_value_len);
+            break;
+        case RSA_OP_BUMP_SEQUENCE:
+            p = put_u64(p, op->operation.bump_sequence.bump_to);
+            break;
+    }
+    return p;
+}
+
+size_t rsa_envelope_body_size(const rsa_transaction_t *tx, const rsa_operation_t *operations) {
+    if (!tx || tx->operations_count > RSA_MAX_OPERATIONS_PER_TX) return 0;
+    if (tx->operations_count > 0 && !operations) return 0;
+    size_t memo = memo_size(&tx->memo);
+    if (!memo) return 0;
+    size_t size = MEMO_OFFSET + memo + 4 * (size_t)tx->operations_count;
+    for (uint32_t i = 0; i < tx->operations_count; i++) {
+        size_t op = op_size(&operations[i]);
+        if (!op) return 0;
+        size += op;
+    }
+    return size;
+}
+
+size_t rsa_envelope_encode(const rsa_transaction_t *tx, const rsa_operation_t *operations,
+                           uint8_t *out, size_t capacity) {
+    size_t size = rsa_envelope_body_size(tx, operations);
+    if (!size || !out || capacity < size) return 0;
+
+    uint32_t op_count = tx->operations_count;
+    uint32_t ops_offset = (uint32_t)(MEMO_OFFSET + memo_size(&tx->memo));
+    store_le32(out, RSA_ENVELOPE_MAGIC);
+    store_le16(out + 4, RSA_ENVELOPE_VERSION);
+    store_le16(out + 6, (uint16_t)op_count);
+    store_le32(out + 8, ops_offset);
+    store_le32(out + 12, (uint32_t)size);
+
+    uint8_t *p = put_account(out + TX_OFFSET, tx->tx_source_account);
+    p = put_u32(p, tx->fee);
+    p = put_u64(p, tx->seq_num);
+    p = put_u64(p, tx->time_bounds.min_time);
+    p = put_u64(p, tx->time_bounds.max_time);
+    p = put_u8(p, tx->memo.type);
+    switch (tx->memo.type) {
+        case RSA_MEMO_TEXT: {
+            size_t len = memo_text_len(&tx->memo);
+            p = put_u8(p, (uint32_t)len);
+            p = put_bytes(p, tx->memo.memo.text, len);
+            break;
+        }
+        case RSA_MEMO_ID:
+            p = put_u64(p, tx->memo.memo.id);
+            break;
+        case RSA_MEMO_HASH:
+            p = put_bytes(p, tx->memo.memo.hash, 32);
+            break;
+        case RSA_MEMO_RETURN:
+            p = put_bytes(p, tx->memo.memo.ret_hash, 32);
+            break;
+        case RSA_MEMO_NONE:
+            break;
+    }
+
+    uint8_t *table = p;
+    p += 4 * (size_t)op_count;
+    for (uint32_t i = 0; i < op_count; i++) {
+        store_le32(table + 4 * i, (uint32_t)(p - out));
+        p = encode_op(p, &operations[i]);
+    }
+    return size;
+}
+
+bool rsa_envelope_build(rsa_envelope_t *envelope, const rsa_transaction_t *tx,
+                        const rsa_operation_t *operations, uint32_t max_signatures) {
+    if (!envelope) return false;
+    memset(envelope, 0, sizeof(*envelope));
+    if (max_signatures > RSA_ENVELOPE_MAX_SIGNATURES) return false;
+    size_t size = rsa_envelope_body_size(tx, operations);
+    if (!size) return false;
+
+    size_t capacity = size + (size_t)max_signatures * RSA_ENVELOPE_SIGNER_BYTES;
+    uint8_t *data = malloc(capacity);
+    if (!data) return false;
+    rsa_envelope_encode(tx, operations, data, capacity);
+    envelope->data = data;
+    envelope->size = size;
+    envelope->capacity = capacity;
+    return true;
+}
+
+bool rsa_envelope_add_signature(rsa_envelope_t *envelope, const uint8_t *public_key,
+                                const uint8_t *signature) {
+    if (!envelope || !envelope->data || !public_key || !signature) return false;
+    if (envelope->capacity - envelope->size < RSA_ENVELOPE_SIGNER_BYTES) return false;
+    uint8_t *p = envelope->data + envelope->size;
+    memcpy(p, public_key, RSA_ENVELOPE_PUBLIC_KEY_BYTES);
+    memcpy(p + RSA_ENVELOPE_PUBLIC_KEY_BYTES, signature, RSA_ENVELOPE_SIGNATURE_BYTES);
+    envelope->size += RSA_ENVELOPE_SIGNER_BYTES;
+    return true;
+}
+
+void rsa_envelope_free(rsa_envelope_t *envelope) {
+    if (!envelope) return;
+    free(envelope->data);
+    memset(envelope, 0, sizeof(*envelope));
+}
+
+// Parsing
+// -------
+
+// Bounds-checked cursor over one record
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} span_t;
+
+static inline bool span_skip(span_t *s, size_t n) {
+    if ((size_t)(s->end - s->p) < n) return false;
+    s->p += n;
+    return true;
+}
+
+static inline bool span_u8(span_t *s, uint8_t *v) {
+    if (s->p == s->end) return false;
+    *v = *s->p++;
+    return true;
+}
+
+static bool span_asset(span_t *s) {
+    uint8_t type;
+    if (!span_u8(s, &type)) return false;
+    switch (type) {
+        case RSA_ASSET_TYPE_NATIVE: return true;
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM4: return span_skip(s, 4 + 32);
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM12: return span_skip(s, 12 + 32);
+    }
+    return false;
+}
+
+// Counted field: a u8 count of at most `max`, then count * `stride` bytes
+static inline bool span_counted(span_t *s, size_t max, size_t stride) {
+    uint8_t count;
+    return span_u8(s, &count) && count <= max && span_skip(s, count * stride);
+}
+
+// Walks one operation record; true when it is well-formed and ends
+// exactly at s->end
+static bool span_op(span_t *s) {
+    uint8_t type, path_len = 0;
+    if (!span_u8(s, &type)) return false;
+    bool ok;
+    switch (type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            ok = span_skip(s, 32 + 8);
+            break;
+        case RSA_OP_PAYMENT:
+            ok = span_asset(s) && span_skip(s, 32 + 32 + 8);
+            break;
+        case RSA_OP_PATH_PAYMENT:
+            ok = span_asset(s) && span_skip(s, 8 + 32) && span_asset(s) && span_skip(s, 8) &&
+                 span_u8(s, &path_len) && path_len <= MAX_PATH;
+            for (uint8_t i = 0; ok && i < path_len; i++) ok = span_asset(s);
+            break;
+        case RSA_OP_MANAGE_OFFER:
+        case RSA_OP_CREATE_PASSIVE_OFFER:
+            ok = span_asset(s) && span_asset(s) && span_skip(s, 8 + 4 + 4 + 4);
+            break;
+        case RSA_OP_SET_OPTIONS:
+            ok = span_skip(s, 4) && span_counted(s, MAX_HOME_DOMAIN, 1) &&
+                 span_counted(s, MAX_SIGNERS, 32 + 4);
+            break;
+        case RSA_OP_CHANGE_TRUST:
+            ok = span_asset(s) && span_skip(s, 8);
+            break;
+        case RSA_OP_ALLOW_TRUST:
+            ok = span_skip(s, 32) && span_asset(s) && span_skip(s, 4);
+            break;
+        case RSA_OP_ACCOUNT_MERGE:
+            ok = span_skip(s, 32);
+            break;
+        case RSA_OP_INFLATION:
+            ok = true;
+            break;
+        case RSA_OP_MANAGE_DATA:
+            ok = span_counted(s, MAX_DATA_NAME, 1) && span_counted(s, MAX_DATA_VALUE, 1);
+            break;
+        case RSA_OP_BUMP_SEQUENCE:
+            ok = span_skip(s, 8);
+            break;
+        default:
+            return false;
+    }
+    return ok && s->p == s->end;
+}
+
+static bool span_memo(span_t *s) {
+    uint8_t type;
+    if (!span_u8(s, &type)) return false;
+    bool ok;
+    switch (type) {
+        case RSA_MEMO_NONE: ok = true; break;
+        case RSA_MEMO_TEXT: ok = span_counted(s, MAX_MEMO_TEXT, 1); break;
+        case RSA_MEMO_ID: ok = span_skip(s, 8); break;
+        case RSA_MEMO_HASH:
+        case RSA_MEMO_RETURN: ok = span_skip(s, 32); break;
+        default: return false;
+    }
+    return ok && s->p == s->end;
+}
+
+bool rsa_envelope_parse(const uint8_t *data, size_t size, rsa_envelope_view_t *view) {
+    if (!data || !view || size < MEMO_OFFSET + 1) return false;
+    if (load_le32(data) != RSA_ENVELOPE_MAGIC || load_le16(data + 4) != RSA_ENVELOPE_VERSION) {
+        return false;
+    }
+    uint32_t op_count = load_le16(data + 6);
+    uint32_t ops_offset = load_le32(data + 8);
+    uint32_t signatures_offset = load_le32(data + 12);
+    if (op_count > RSA_MAX_OPERATIONS_PER_TX || ops_offset <= MEMO_OFFSET ||
+        signatures_offset > size || ops_offset > signatures_offset ||
+        signatures_offset - ops_offset < 4 * op_count ||
+        (size - signatures_offset) % RSA_ENVELOPE_SIGNER_BYTES != 0) {
+        return false;
+    }
+    size_t signature_count = (size - signatures_offset) / RSA_ENVELOPE_SIGNER_BYTES;
+    if (signature_count > RSA_ENVELOPE_MAX_SIGNATURES) return false;
+
+    span_t memo = {data + MEMO_OFFSET, data + ops_offset};
+    if (!span_memo(&memo)) return false;
+
+    // Records follow the table back to back, in order, up to the signatures
+    uint32_t expected = ops_offset + 4 * op_count;
+    for (uint32_t i = 0; i < op_count; i++) {
+        uint32_t start = load_le32(data + ops_offset + 4 * i);
+        uint32_t end = i + 1 < op_count ? load_le32(data + ops_offset + 4 * (i + 1))
+                                        : signatures_offset;
+        if (start != expected || end <= start || end > signatures_offset) return false;
+        span_t op = {data + start, data + end};
+        if (!span_op(&op)) return false;
+        expected = end;
+    }
+    if (expected != signatures_offset) return false;
+
+    view->data = data;
+    view->size = size;
+    view->op_count = op_count;
+    view->signature_count = (uint32_t)signature_count;
+    view->ops_offset = ops_offset;
+    view->signatures_offset = signatures_offset;
+    return true;
+}
+
+bool rsa_envelope_view(const rsa_envelope_t *envelope, rsa_envelope_view_t *view) {
+    return envelope && rsa_envelope_parse(envelope->data, envelope->size, view);
+}
+
+// Accessors
+// ---------
+
+void rsa_envelope_source(const rsa_envelope_view_t *view, uint32_t account_id[8]) {
+    get_account(view->data + TX_OFFSET, account_id);
+}
+
+uint32_t rsa_envelope_fee(const rsa_envelope_view_t *view) {
+    return load_le32(view->data + TX_OFFSET + 32);
+}
+
+uint64_t rsa_envelope_seq_num(const rsa_envelope_view_t *view) {
+    return load_le64(view->data + TX_OFFSET + 36);
+}
+
+rsa_time_bounds_t rsa_envelope_time_bounds(const rsa_envelope_view_t *view) {
+    rsa_time_bounds_t bounds;
+    bounds.min_time = load_le64(view->data + TX_OFFSET + 44);
+    bounds.max_time = load_le64(view->data + TX_OFFSET + 52);
+    return bounds;
+}
+
+static inline const uint8_t *op_record(const rsa_envelope_view_t *view, uint32_t index) {
+    return view->data + load_le32(view->data + view->ops_offset + 4 * index);
+}
+
+rsa_operation_type_t rsa_envelope_op_type(const rsa_envelope_view_t *view, uint32_t index) {
+    return (rsa_operation_type_t)*op_record(view, index);
+}
+
+void rsa_envelope_hash(const rsa_envelope_view_t *view, uint8_t hash[32]) {
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, view->data, view->signatures_offset);
+    SHA256_Final(hash, &ctx);
+}
+
+void rsa_envelope_signature(const rsa_envelope_view_t *view, uint32_t index,
+                            const uint8_t **public_key, const uint8_t **signature) {
+    if (index >= view->signature_count) {
+        *public_key = NULL;
+        *signature = NULL;
+        return;
+    }
+    const uint8_t *p =
+        view->data + view->signatures_offset + (size_t)index * RSA_ENVELOPE_SIGNER_BYTES;
+    *public_key = p;
+    *signature = p + RSA_ENVELOPE_PUBLIC_KEY_BYTES;
+}
+
+// Decoding
+// --------
+
+void rsa_envelope_tx(const rsa_envelope_view_t *view, rsa_transaction_t *tx) {
+    memset(tx, 0, sizeof(*tx));
+    const uint8_t *p = get_account(view->data + TX_OFFSET, tx->tx_source_account);
+    tx->fee = load_le32(p);
+    tx->seq_num = load_le64(p + 4);
+    tx->time_bounds.min_time = load_le64(p + 12);
+    tx->time_bounds.max_time = load_le64(p + 20);
+    p += 28;
+    tx->memo.type = (rsa_memo_type_t)*p++;
+    switch (tx->memo.type) {
+        case RSA_MEMO_TEXT:
+            memcpy(tx->memo.memo.text, p + 1, *p);
+            break;
+        case RSA_MEMO_ID:
+            tx->memo.memo.id = load_le64(p);
+            break;
+        case RSA_MEMO_HASH:
+            memcpy(tx->memo.memo.hash, p, 32);
+            break;
+        case RSA_MEMO_RETURN:
+            memcpy(tx->memo.memo.ret_hash, p, 32);
+            break;
+        case RSA_MEMO_NONE:
+            break;
+    }
+    tx->operations_count = view->op_count;
+}
+
+void rsa_envelope_op(const rsa_envelope_view_t *view, uint32_t index, rsa_operation_t *op) {
+    memset(op, 0, sizeof(*op));
+    const uint8_t *p = op_record(view, index);
+    op->type = (rsa_operation_type_t)*p++;
+    switch (op->type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            p = get_account(p, op->operation.create_account.destination);
+            op->operation.create_account.starting_balance = (int64_t)load_le64(p);
+            break;
+        case RSA_OP_PAYMENT:
+            p = get_asset(p, &op->operation.payment.asset);
+            p = get_account(p, op->operation.payment.from);
+            p = get_account(p, op->operation.payment.to);
+            op->operation.payment.amount = (int64_t)load_le64(p);
+            break;
+        case RSA_OP_PATH_PAYMENT:
+            p = get_asset(p, &op->operation.path_payment.send_asset);
+            op->operation.path_payment.send_max = (int64_t)load_le64(p);
+            p = get_account(p + 8, op->operation.path_payment.destination);
+            p = get_asset(p, &op->operation.path_payment.dest_asset);
+            op->operation.path_payment.dest_amount = (int64_t)load_le64(p);
+            op->operation.path_payment.path_len = p[8];
+            p += 9;
+            for (uint32_t i = 0; i < op->operation.path_payment.path_len; i++) {
+                p = get_asset(p, &op->operation.path_payment.path[i]);
+            }
+            break;
+        case RSA_OP_MANAGE_OFFER:
+        case RSA_OP_CREATE_PASSIVE_OFFER:
+            p = get_asset(p, &op->operation.manage_offer.selling);
+            p = get_asset(p, &op->operation.manage_offer.buying);
+            op->operation.manage_offer.amount = (int64_t)load_le64(p);
+            op->operation.manage_offer.price.n = (int32_t)load_le32(p + 8);
+            op->operation.manage_offer.price.d = (int32_t)load_le32(p + 12);
+            op->operation.manage_offer.offer_id = load_le32(p + 16);
+            break;
+        case RSA_OP_SET_OPTIONS:
+            op->operation.set_options.thresholds = load_le32(p);
+            op->operation.set_options.home_domain_len = p[4];
+            memcpy(op->operation.set_options.home_domain, p + 5,
+                   op->operation.set_options.home_domain_len);
+            p += 5 + op->operation.set_options.home_domain_len;
+            op->operation.set_options.signer_count = *p++;
+            for (uint32_t i = 0; i < op->operation.set_options.signer_count; i++, p += 36) {
+                memcpy(op->operation.set_options.signers[i].key, p, 32);
+                op->operation.set_options.signers[i].weight = load_le32(p + 32);
+            }
+            break;
+        case RSA_OP_CHANGE_TRUST:
+            p = get_asset(p, &op->operation.change_trust.asset);
+            op->operation.change_trust.limit = (int64_t)load_le64(p);
+            break;
+        case RSA_OP_ALLOW_TRUST:
+            p = get_account(p, op->operation.allow_trust.trustor);
+            p = get_asset(p, &op->operation.allow_trust.asset);
+            op->operation.allow_trust.authorize = load_le32(p);
+            break;
+        case RSA_OP_ACCOUNT_MERGE:
+            get_account(p, op->operation.account_merge.destination);
+            break;
+        case RSA_OP_INFLATION:
+            break;
+        case RSA_OP_MANAGE_DATA:
+            op->operation.manage_data.data_name_len = *p++;
+            memcpy(op->operation.manage_data.data_name, p, op->operation.manage_data.data_name_len);
+            p += op->operation.manage_data.data_name_len;
+            op->operation.manage_data.data_value_len = *p++;
+            memcpy(op->operation.manage_data.data_value, p, op->operation.manage_data.data_value_len);
+            break;
+        case RSA_OP_BUMP_SEQUENCE:
+            op->operation.bump_sequence.bump_to = load_le64(p);
+            break;
+    }
+}
+
+rsa_tx_envelope_ref_t rsa_envelope_decode(const rsa_envelope_view_t *view, rsa_transaction_t *tx,
+                                          rsa_operation_t *operations) {
+    rsa_envelope_tx(view, tx);
+    for (uint32_t i = 0; i < view->op_count; i++) rsa_envelope_op(view, i, &operations[i]);
+    rsa_tx_envelope_ref_t ref;
+    ref.tx = tx;
+    ref.operations = operations;
+    rsa_envelope_signature(view, 0, &ref.public_key, &ref.signature);
+    return ref;
+}
@@ -0,0 +1,117 @@
+#ifndef RSA_ENVELOPE_H
+#define RSA_ENVELOPE_H
+
+#include "rsa_token.h"
+#include "rsa_txset.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// TRANSACTION ENVELOPE WIRE FORMAT
+// ================================
+// A transaction, its operations and its signatures in one contiguous
+// buffer. Integers are little-endian and nothing is aligned: every field
+// is read byte-wise, so a view works directly on a network buffer at any
+// address.
+//
+//   0    u32  magic "RSE1"
+//   4    u16  version
+//   6    u16  operation count
+//   8    u32  operation table offset
+//   12   u32  signatures offset (end of the body)
+//   16        source account (8 x u32), fee u32, seq_num u64,
+//             min_time u64, max_time u64
+//   76        memo: u8 type, then text (u8 length + bytes), id (u64) or
+//             hash (32 bytes)
+//   table     u32 offset per operation
+//   ...       operations: u8 type, then the fields of that type, with
+//             u8 counts before paths, signers, home domain and data
+//   sigs      signatures: public key and signature, fixed size each
+//
+// Everything before the signatures is the body; rsa_envelope_hash()
+// covers it, and signatures are appended without changing it (their
+// count follows from the buffer size). Operations take as many bytes as
+// their fields need: a native payment is 74 bytes, not sizeof(rsa_operation_t).
+//
+// Parsing checks the whole structure once and allocates nothing; after
+// that, accessors read fields from the buffer unchecked, and the
+// transaction and operations decode on demand into caller structs
+// (zero-filled, so rsa_ledger_tx_hash() of a decoded envelope matches the
+// original's). The builder sizes the body first and allocates once.
+
+#define RSA_ENVELOPE_MAGIC 0x31455352u     // "RSE1"
+#define RSA_ENVELOPE_VERSION 1
+#define RSA_ENVELOPE_HEADER_BYTES 16
+#define RSA_ENVELOPE_PUBLIC_KEY_BYTES 260  // as rsa_verify_signature() reads it
+#define RSA_ENVELOPE_SIGNATURE_BYTES 256
+#define RSA_ENVELOPE_SIGNER_BYTES (RSA_ENVELOPE_PUBLIC_KEY_BYTES + RSA_ENVELOPE_SIGNATURE_BYTES)
+#define RSA_ENVELOPE_MAX_SIGNATURES 20
+
+// Read-only view over a parsed envelope; valid while the buffer is
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint32_t op_count;
+    uint32_t signature_count;
+    uint32_t ops_offset;
+    uint32_t signatures_offset;
+} rsa_envelope_view_t;
+
+// An envelope built in one allocation
+typedef struct {
+    uint8_t *data;
+    size_t size;                        // body and the signatures added so far
+    size_t capacity;
+} rsa_envelope_t;
+
+// Builder
+// -------
+
+// Body size; 0 when a count or type is out of range for the format
+size_t rsa_envelope_body_size(const rsa_transaction_t *tx, const rsa_operation_t *operations);
+// Writes the body into `out`; returns its size, 0 if invalid or too small
+size_t rsa_envelope_encode(const rsa_transaction_t *tx, const rsa_operation_t *operations,
+                           uint8_t *out, size_t capacity);
+// Body plus room for `max_signatures` in one allocation
+bool rsa_envelope_build(rsa_envelope_t *envelope, const rsa_transaction_t *tx,
+                        const rsa_operation_t *operations, uint32_t max_signatures);
+// False once the reserved room is used up
+bool rsa_envelope_add_signature(rsa_envelope_t *envelope, const uint8_t *public_key,
+                                const uint8_t *signature);
+void rsa_envelope_free(rsa_envelope_t *envelope);
+
+// Views
+// -----
+
+// Checks magic, version, offsets and every operation's extent and counts
+bool rsa_envelope_parse(const uint8_t *data, size_t size, rsa_envelope_view_t *view);
+bool rsa_envelope_view(const rsa_envelope_t *envelope, rsa_envelope_view_t *view);
+
+void rsa_envelope_source(const rsa_envelope_view_t *view, uint32_t account_id[8]);
+uint32_t rsa_envelope_fee(const rsa_envelope_view_t *view);
+uint64_t rsa_envelope_seq_num(const rsa_envelope_view_t *view);
+rsa_time_bounds_t rsa_envelope_time_bounds(const rsa_envelope_view_t *view);
+rsa_operation_type_t rsa_envelope_op_type(const rsa_envelope_view_t *view, uint32_t index);
+
+// SHA-256 of the body, straight from the buffer
+void rsa_envelope_hash(const rsa_envelope_view_t *view, uint8_t hash[32]);
+// Pointers into the buffer
+void rsa_envelope_signature(const rsa_envelope_view_t *view, uint32_t index,
+                            const uint8_t **public_key, const uint8_t **signature);
+
+// Decoding into zero-filled structs
+void rsa_envelope_tx(const rsa_envelope_view_t *view, rsa_transaction_t *tx);
+void rsa_envelope_op(const rsa_envelope_view_t *view, uint32_t index, rsa_operation_t *op);
+// The transaction and all operations (`operations` holds op_count), as
+// the ledger and mempool take them; the first signature, if any, is
+// referenced in place
+rsa_tx_envelope_ref_t rsa_envelope_decode(const rsa_envelope_view_t *view, rsa_transaction_t *tx,
+                                          rsa_operation_t *operations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_ENVELOPE_H
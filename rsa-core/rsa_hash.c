@@ -0,0 +1,17 @@
+#include "rsa_hash.h"
+#include <openssl/rand.h>
+
+// KEYED TABLE HASH
+// ================
+
+void rsa_hash_key_init(rsa_hash_key_t *key, const void *salt) {
+    if (RAND_bytes((unsigned char *)key->k, sizeof(key->k)) == 1) return;
+    // splitmix64 over the address: distinct per table, if not secret
+    uint64_t x = (uint64_t)(uintptr_t)salt;
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        key->k[i] = z ^ (z >> 31);
+    }
+}
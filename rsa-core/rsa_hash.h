@@ -0,0 +1,91 @@
+#ifndef RSA_HASH_H
+#define RSA_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// KEYED TABLE HASH
+// ================
+// The hash of every in-memory table indexed by keys a client chooses
+// (account ids, transaction hashes, assets). Each table draws a random
+// key of four words. Every 64-bit lane of the input is XORed with its own
+// key word before it is multiplied, and 16-byte blocks are chained through
+// the running hash rather than XORed together, so without the key no lane
+// can be chosen to zero a product, swap with its partner, or cancel
+// another block: collisions, and keys crowding one shard, cannot be
+// crafted. Both halves of the result are usable.
+//
+// Not a cryptographic hash; it only has to be unpredictable.
+
+typedef struct {
+    uint64_t k[4];
+} rsa_hash_key_t;
+
+// Random key; falls back to one derived from `salt` (the table's address)
+// when the system RNG fails
+void rsa_hash_key_init(rsa_hash_key_t *key, const void *salt);
+
+__extension__ typedef unsigned __int128 rsa_hash_uint128_t;
+
+// 64x64 -> 128-bit multiply, halves folded
+static inline uint64_t rsa_hash_mix(uint64_t a, uint64_t b) {
+    rsa_hash_uint128_t product = (rsa_hash_uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+// Chains block `i` (16 bytes at `p`) into the running hash
+static inline uint64_t rsa_hash_block(const rsa_hash_key_t *key, uint64_t h, size_t i,
+                                      const uint8_t *p) {
+    uint64_t a, b;
+    memcpy(&a, p, 8);
+    memcpy(&b, p + 8, 8);
+    return rsa_hash_mix(a ^ key->k[(2 * i) & 3] ^ h, b ^ key->k[(2 * i + 1) & 3]);
+}
+
+// Keyed hash of `blocks` 16-byte blocks of `data`
+static inline uint64_t rsa_hash_blocks(const rsa_hash_key_t *key, const void *data,
+                                       size_t blocks) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h = 0;
+    for (size_t i = 0; i < blocks; i++, p += 16) h = rsa_hash_block(key, h, i, p);
+    return h;
+}
+
+// Account ids and transaction hashes
+static inline uint64_t rsa_hash_32(const rsa_hash_key_t *key, const void *data) {
+    return rsa_hash_blocks(key, data, 2);
+}
+
+// Packed 64-bit keys (trustline account row and asset id)
+static inline uint64_t rsa_hash_64(const rsa_hash_key_t *key, uint64_t word) {
+    return rsa_hash_mix(word ^ key->k[0], key->k[1]);
+}
+
+// Folds one more word (an asset id, say) into a keyed hash
+static inline uint64_t rsa_hash_extend(const rsa_hash_key_t *key, uint64_t hash, uint64_t word) {
+    return rsa_hash_64(key, hash ^ word);
+}
+
+// Keys of any length: a partial last block is zero-padded, and the length
+// folded in so padding cannot collide with zero bytes
+static inline uint64_t rsa_hash_bytes(const rsa_hash_key_t *key, const void *data, size_t size) {
+    size_t blocks = size / 16;
+    uint64_t h = rsa_hash_blocks(key, data, blocks);
+    if (size % 16) {
+        uint8_t tail[16] = {0};
+        memcpy(tail, (const uint8_t *)data + blocks * 16, size % 16);
+        h = rsa_hash_block(key, h, blocks, tail);
+    }
+    return rsa_hash_extend(key, h, size);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_HASH_H
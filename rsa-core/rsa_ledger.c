@@ -0,0 +1,1715 @@
+#include "rsa_ledger.h"
+#include "rsa_clock.h"
+#include "rsa_hash.h"
+#include "rsa_snapshot.h"
+#include "rsa_validation.h"
+#include "rsa_worker_pool.h"
+#include <dirent.h>
+#include <inttypes.h>
+#include <openssl/sha.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// LEDGER CLOSE
+// ============
+
+#define DIRTY_MIN_SLOTS 1024
+#define NO_BEFORE UINT32_MAX
+#define NO_ASSET RSA_ASSET_INVALID_ID   // dirty / undo entry of an account
+#define TX_MAX_FOOTPRINT (1 + RSA_MAX_OPERATIONS_PER_TX)
+
+typedef union {
+    rsa_account_t account;
+    rsa_trustline_t trustline;
+} ledger_image_t;
+
+// Entry changed in the ledger being closed, keyed by id so row moves on
+// merge do not matter
+typedef struct {
+    uint32_t account_id[8];
+    uint32_t asset_id;                  // NO_ASSET for the account itself
+    uint32_t before;                    // image at first touch (WAL only), or NO_BEFORE
+    uint32_t tx;                        // set position of the first touch
+} ledger_dirty_t;
+
+// Changed entries in first-touch order, with an open-addressing index
+typedef struct {
+    ledger_dirty_t *dirty;
+    size_t count;
+    size_t capacity;
+    uint32_t *slots;                    // dirty index + 1, 0 = empty
+    size_t mask;
+
+    ledger_image_t *before;
+    size_t before_count;
+    size_t before_capacity;
+} ledger_touch_set_t;
+
+// State of an entry before an operation touched it, for rolling back a
+// failed multi-operation transaction
+typedef struct {
+    uint32_t account_id[8];
+    uint32_t asset_id;
+    bool existed;
+    ledger_image_t image;
+} ledger_undo_t;
+
+typedef struct ledger_segment ledger_segment_t;
+
+// Applies transactions: inline, or as one worker of a parallel segment.
+// Padded so workers do not share lines.
+typedef struct {
+    rsa_ledger_t *ledger;
+    ledger_segment_t *segment;          // NULL when applying inline
+    ledger_touch_set_t local;           // parallel: entries new to the ledger
+    uint32_t tx;                        // set position being applied
+    int64_t fees;                       // charged this close
+
+    ledger_undo_t *undo;
+    size_t undo_count;
+    size_t undo_capacity;
+    bool undo_active;                   // recording for the current transaction
+} __attribute__((aligned(64))) ledger_worker_t;
+
+typedef struct {
+    uint32_t start;                     // in group_txs
+    uint32_t count;
+} ledger_group_t;
+
+// Footprint index slot: account -> a segment position naming it
+typedef struct {
+    const uint32_t *account_id;         // NULL = empty
+    uint32_t position;
+} ledger_owner_t;
+
+// Worker entry awaiting the merge into the ledger's touch set
+typedef struct {
+    uint32_t tx;
+    uint32_t worker;
+    uint32_t index;
+} ledger_touch_ref_t;
+
+// Transactions collected between two structural ones. Arrays are sized
+// for a full set when parallel apply is configured.
+struct ledger_segment {
+    const rsa_tx_envelope_ref_t *envelopes;
+    rsa_tx_result_t *results;
+    uint32_t *txs;                      // set positions
+    uint32_t *footprint_ends;           // per position, end in `footprint`
+    size_t count;
+    const uint32_t **footprint;         // accounts named, TX_MAX_FOOTPRINT per tx at most
+    size_t footprint_count;
+
+    ledger_owner_t *owners;
+    size_t owner_slots;
+    uint32_t *parents;                  // union-find over positions, root = first position
+    uint32_t *offsets;                  // per root, fill cursor into group_txs
+    uint32_t *group_txs;                // set positions grouped, set order within a group
+    ledger_group_t *groups;
+    size_t group_count;
+
+    size_t next;                        // next group to claim
+    bool failed;
+};
+
+struct rsa_ledger_scratch {
+    ledger_touch_set_t dirty;
+    rsa_hash_key_t key;
+
+    ledger_worker_t workers[RSA_LEDGER_MAX_APPLY_THREADS];  // [0] also applies inline
+    unsigned worker_count;
+    rsa_worker_pool_t pool;             // threads for apply segments and the state tree
+    ledger_segment_t segment;
+    ledger_touch_ref_t *refs;           // sized by touches, so kept off the arena
+    size_t ref_capacity;
+
+    rsa_ledger_t *shadow;               // check_determinism: serial copy
+    bool record;                        // report phases to the monitor
+
+    rsa_merkle_batch_t state_batch;
+    rsa_wal_batch_t wal_batch;
+    uint32_t ledger_seq;                // being closed
+    uint32_t base_fee;                  // per operation, this close
+};
+
+static inline uint64_t dirty_hash(const rsa_hash_key_t *key, const uint32_t account_id[8],
+                                  uint32_t asset_id) {
+    return rsa_hash_extend(key, rsa_hash_32(key, account_id), asset_id);
+}
+
+static const uint32_t zero_account[8];
+
+static inline bool same_account(const uint32_t a[8], const uint32_t b[8]) {
+    return memcmp(a, b, 32) == 0;
+}
+
+// Issuers are account ids
+static inline const uint8_t *asset_issuer(const rsa_asset_t *asset) {
+    return asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4 ? asset->asset.credit_alphanum4.issuer
+                                                          : asset->asset.credit_alphanum12.issuer;
+}
+
+static inline bool is_issuer(const rsa_asset_t *asset, const uint32_t account_id[8]) {
+    return memcmp(asset_issuer(asset), account_id, 32) == 0;
+}
+
+// STATE ACCESS
+// ------------
+
+static uint32_t account_row(const rsa_ledger_t *ledger, const uint32_t account_id[8]) {
+    const rsa_account_entry_t *entry = rsa_account_store_find(&ledger->account_index, account_id);
+    return entry ? entry->index : RSA_ACCOUNT_NO_INDEX;
+}
+
+static int64_t min_balance(const rsa_ledger_t *ledger, uint32_t row, int32_t extra_sub_entries) {
+    int64_t sub_entries = (int64_t)ledger->accounts.num_sub_entries[row] + extra_sub_entries;
+    return (2 + sub_entries) * (int64_t)ledger->config.base_reserve;
+}
+
+static void trustline_image(const rsa_ledger_t *ledger, const uint32_t account_id[8],
+                            uint32_t asset_id, uint32_t entry, rsa_trustline_t *trustline) {
+    memset(trustline, 0, sizeof(*trustline));
+    memcpy(trustline->account_id, account_id, sizeof(trustline->account_id));
+    trustline->asset = *rsa_asset_from_id(&ledger->assets, asset_id);
+    if (entry != RSA_TRUSTLINE_NONE) {
+        trustline->balance = ledger->trustlines.balances[entry];
+        trustline->limit = ledger->trustlines.limits[entry];
+        trustline->flags = ledger->trustlines.flags[entry];
+    }
+}
+
+// Current image of an entry; false if it does not exist
+static bool entry_image(const rsa_ledger_t *ledger, const uint32_t account_id[8],
+                        uint32_t asset_id, ledger_image_t *image) {
+    uint32_t row = account_row(ledger, account_id);
+    if (row == RSA_ACCOUNT_NO_INDEX) return false;
+    if (asset_id == NO_ASSET) return rsa_account_soa_get(&ledger->accounts, row, &image->account);
+
+    uint32_t entry = rsa_trustline_store_find(&ledger->trustlines, row, asset_id);
+    if (entry == RSA_TRUSTLINE_NONE) return false;
+    trustline_image(ledger, account_id, asset_id, entry, &image->trustline);
+    return true;
+}
+
+// Removes an account row; the account must have no trustlines
+static bool remove_account_row(rsa_ledger_t *ledger, uint32_t row) {
+    uint32_t last = (uint32_t)ledger->accounts.count - 1;
+    if (!rsa_account_soa_remove(&ledger->accounts, row, &ledger->account_index)) return false;
+    return row == last || rsa_trustline_store_first(&ledger->trustlines, last) == RSA_TRUSTLINE_NONE ||
+           rsa_trustline_store_move_account(&ledger->trustlines, last, row);
+}
+
+// CHANGE TRACKING
+// ---------------
+
+// Array with room for `needed` elements (possibly moved), NULL on failure
+static void *grow_array(void *array, size_t *capacity, size_t element, size_t needed) {
+    if (needed <= *capacity) return array;
+    size_t grown = *capacity ? *capacity * 2 : 256;
+    while (grown < needed) grown *= 2;
+    void *resized = realloc(array, grown * element);
+    if (resized) *capacity = grown;
+    return resized;
+}
+
+// Slot holding the entry, or the empty slot that ends its probe
+static size_t touch_set_probe(const ledger_touch_set_t *set, const rsa_hash_key_t *key,
+                              const uint32_t account_id[8], uint32_t asset_id) {
+    size_t pos = dirty_hash(key, account_id, asset_id) & set->mask;
+    for (; set->slots[pos]; pos = (pos + 1) & set->mask) {
+        const ledger_dirty_t *dirty = &set->dirty[set->slots[pos] - 1];
+        if (dirty->asset_id == asset_id && same_account(dirty->account_id, account_id)) break;
+    }
+    return pos;
+}
+
+static bool touch_set_rehash(ledger_touch_set_t *set, const rsa_hash_key_t *key, size_t slots) {
+    uint32_t *table = calloc(slots, sizeof(*table));
+    if (!table) return false;
+    for (size_t i = 0; i < set->count; i++) {
+        const ledger_dirty_t *dirty = &set->dirty[i];
+        size_t pos = dirty_hash(key, dirty->account_id, dirty->asset_id) & (slots - 1);
+        while (table[pos]) pos = (pos + 1) & (slots - 1);
+        table[pos] = (uint32_t)i + 1;
+    }
+    free(set->slots);
+    set->slots = table;
+    set->mask = slots - 1;
+    return true;
+}
+
+// Adds an absent entry at its probe slot `pos`. `before` is its image at
+// first touch, kept only when there is a log; NULL if it did not exist.
+static bool touch_set_add(ledger_touch_set_t *set, size_t pos, const rsa_hash_key_t *key,
+                          const uint32_t account_id[8], uint32_t asset_id, uint32_t tx,
+                          const ledger_image_t *before) {
+    ledger_dirty_t *dirties = grow_array(set->dirty, &set->capacity, sizeof(*dirties),
+                                         set->count + 1);
+    if (!dirties) return false;
+    set->dirty = dirties;
+    ledger_dirty_t *dirty = &set->dirty[set->count];
+    memcpy(dirty->account_id, account_id, sizeof(dirty->account_id));
+    dirty->asset_id = asset_id;
+    dirty->before = NO_BEFORE;
+    dirty->tx = tx;
+    if (before) {
+        ledger_image_t *images = grow_array(set->before, &set->before_capacity, sizeof(*images),
+                                            set->before_count + 1);
+        if (!images) return false;
+        set->before = images;
+        set->before[set->before_count] = *before;
+        dirty->before = (uint32_t)set->before_count++;
+    }
+    set->slots[pos] = (uint32_t)++set->count;
+
+    // Keep the load at or under 1/2
+    if (set->count * 2 > set->mask + 1) return touch_set_rehash(set, key, (set->mask + 1) * 2);
+    return true;
+}
+
+static void touch_set_reset(ledger_touch_set_t *set) {
+    if (set->count) memset(set->slots, 0, (set->mask + 1) * sizeof(*set->slots));
+    set->count = 0;
+    set->before_count = 0;
+}
+
+static void touch_set_free(ledger_touch_set_t *set) {
+    free(set->dirty);
+    free(set->slots);
+    free(set->before);
+}
+
+// Records the entry as changed by this ledger, and for rollback when the
+// current transaction has several operations. Call before every mutation.
+static bool touch(ledger_worker_t *worker, const uint32_t account_id[8], uint32_t asset_id) {
+    rsa_ledger_t *ledger = worker->ledger;
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+
+    if (worker->undo_active) {
+        ledger_undo_t *undos = grow_array(worker->undo, &worker->undo_capacity,
+                                          sizeof(*undos), worker->undo_count + 1);
+        if (!undos) return false;
+        worker->undo = undos;
+        ledger_undo_t *undo = &worker->undo[worker->undo_count++];
+        memcpy(undo->account_id, account_id, sizeof(undo->account_id));
+        undo->asset_id = asset_id;
+        undo->existed = entry_image(ledger, account_id, asset_id, &undo->image);
+    }
+
+    // Parallel workers only read the ledger's set; what they add is merged
+    // in set order once the segment is done
+    ledger_touch_set_t *set = &scratch->dirty;
+    size_t pos = touch_set_probe(set, &scratch->key, account_id, asset_id);
+    if (set->slots[pos]) return true;
+    if (worker->segment) {
+        set = &worker->local;
+        pos = touch_set_probe(set, &scratch->key, account_id, asset_id);
+        if (set->slots[pos]) return true;
+    }
+
+    ledger_image_t image;
+    const ledger_image_t *before = NULL;
+    if (ledger->config.wal && entry_image(ledger, account_id, asset_id, &image)) before = &image;
+    return touch_set_add(set, pos, &scratch->key, account_id, asset_id, worker->tx, before);
+}
+
+static bool undo_restore(rsa_ledger_t *ledger, const ledger_undo_t *undo) {
+    uint32_t row = account_row(ledger, undo->account_id);
+
+    if (undo->asset_id == NO_ASSET) {
+        if (!undo->existed) return row == RSA_ACCOUNT_NO_INDEX || remove_account_row(ledger, row);
+        if (row != RSA_ACCOUNT_NO_INDEX) {
+            return rsa_account_soa_set(&ledger->accounts, row, &undo->image.account,
+                                       &ledger->account_index);
+        }
+        return rsa_account_soa_append(&ledger->accounts, &undo->image.account,
+                                      &ledger->account_index) != RSA_ACCOUNT_NO_INDEX;
+    }
+
+    // The owning account is restored first whenever it existed at the time
+    if (row == RSA_ACCOUNT_NO_INDEX) return !undo->existed;
+    rsa_trustline_store_t *lines = &ledger->trustlines;
+    if (!undo->existed) {
+        rsa_trustline_store_remove(lines, row, undo->asset_id);
+        return true;
+    }
+    const rsa_trustline_t *image = &undo->image.trustline;
+    uint32_t entry = rsa_trustline_store_add(lines, row, undo->asset_id, image->limit,
+                                             image->flags, NULL);
+    if (entry == RSA_TRUSTLINE_NONE) return false;
+    lines->balances[entry] = image->balance;
+    lines->limits[entry] = image->limit;
+    lines->flags[entry] = image->flags;
+    return true;
+}
+
+static bool undo_rollback(ledger_worker_t *worker) {
+    bool ok = true;
+    while (worker->undo_count > 0) {
+        ok &= undo_restore(worker->ledger, &worker->undo[--worker->undo_count]);
+    }
+    return ok;
+}
+
+// OPERATIONS
+// ----------
+// Each operation checks everything before its first mutation, so a failing
+// single-operation transaction needs no rollback.
+
+#define TOUCH(worker, id, asset_id)                                         \
+    do {                                                                    \
+        if (!touch((worker), (id), (asset_id))) return RSA_OP_RESULT_INTERNAL_ERROR; \
+    } while (0)
+
+static rsa_op_result_code_t op_create_account(ledger_worker_t *worker, const uint32_t source[8],
+                                              uint32_t row, const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    const uint32_t *destination = op->operation.create_account.destination;
+    int64_t starting = op->operation.create_account.starting_balance;
+    rsa_account_soa_t *accounts = &ledger->accounts;
+
+    if (account_row(ledger, destination) != RSA_ACCOUNT_NO_INDEX) return RSA_OP_RESULT_ALREADY_EXISTS;
+    if (starting < 2 * (int64_t)ledger->config.base_reserve) return RSA_OP_RESULT_LOW_RESERVE;
+    if (accounts->balances[row] - starting < min_balance(ledger, row, 0)) {
+        return RSA_OP_RESULT_UNDERFUNDED;
+    }
+
+    rsa_account_t account;
+    memset(&account, 0, sizeof(account));
+    memcpy(account.account_id, destination, sizeof(account.account_id));
+    account.balance = starting;
+    account.seq_num = (uint64_t)ledger->scratch->ledger_seq << 32;
+    account.thresholds.master_weight = 1;
+
+    TOUCH(worker, source, NO_ASSET);
+    TOUCH(worker, destination, NO_ASSET);
+    if (rsa_account_soa_append(accounts, &account, &ledger->account_index) == RSA_ACCOUNT_NO_INDEX) {
+        return RSA_OP_RESULT_INTERNAL_ERROR;
+    }
+    accounts->balances[row] -= starting;
+    return RSA_OP_RESULT_SUCCESS;
+}
+
+static rsa_op_result_code_t op_native_payment(ledger_worker_t *worker, const uint32_t source[8],
+                                              uint32_t row, const uint32_t destination[8],
+                                              uint32_t destination_row, int64_t amount) {
+    rsa_ledger_t *ledger = worker->ledger;
+    int64_t *balances = ledger->accounts.balances;
+    if (balances[row] - amount < min_balance(ledger, row, 0)) return RSA_OP_RESULT_UNDERFUNDED;
+    if (balances[destination_row] > INT64_MAX - amount) return RSA_OP_RESULT_LINE_FULL;
+
+    TOUCH(worker, source, NO_ASSET);
+    TOUCH(worker, destination, NO_ASSET);
+    balances[row] -= amount;
+    balances[destination_row] += amount;
+    return RSA_OP_RESULT_SUCCESS;
+}
+
+// Issuers send and receive their own asset without a trustline
+static rsa_op_result_code_t op_credit_payment(ledger_worker_t *worker, const uint32_t source[8],
+                                              uint32_t row, const uint32_t destination[8],
+                                              uint32_t destination_row, const rsa_asset_t *asset,
+                                              int64_t amount) {
+    rsa_ledger_t *ledger = worker->ledger;
+    rsa_trustline_store_t *lines = &ledger->trustlines;
+    uint32_t asset_id = rsa_asset_lookup(&ledger->assets, asset);
+    if (asset_id == RSA_ASSET_INVALID_ID) return RSA_OP_RESULT_NO_TRUST;
+
+    uint32_t from = RSA_TRUSTLINE_NONE, to = RSA_TRUSTLINE_NONE;
+    if (!is_issuer(asset, source)) {
+        from = rsa_trustline_store_find(lines, row, asset_id);
+        if (from == RSA_TRUSTLINE_NONE) return RSA_OP_RESULT_NO_TRUST;
+        if (!(lines->flags[from] & RSA_TRUSTLINE_AUTHORIZED_FLAG)) return RSA_OP_RESULT_NOT_AUTHORIZED;
+        if (lines->balances[from] < amount) return RSA_OP_RESULT_UNDERFUNDED;
+    }
+    if (!is_issuer(asset, destination)) {
+        to = rsa_trustline_store_find(lines, destination_row, asset_id);
+        if (to == RSA_TRUSTLINE_NONE) return RSA_OP_RESULT_NO_TRUST;
+        if (!(lines->flags[to] & RSA_TRUSTLINE_AUTHORIZED_FLAG)) return RSA_OP_RESULT_NOT_AUTHORIZED;
+        if (lines->balances[to] > lines->limits[to] - amount) return RSA_OP_RESULT_LINE_FULL;
+    }
+
+    if (from != RSA_TRUSTLINE_NONE) {
+        TOUCH(worker, source, asset_id);
+        lines->balances[from] -= amount;
+    }
+    if (to != RSA_TRUSTLINE_NONE) {
+        TOUCH(worker, destination, asset_id);
+        lines->balances[to] += amount;
+    }
+    return RSA_OP_RESULT_SUCCESS;
+}
+
+static rsa_op_result_code_t op_payment(ledger_worker_t *worker, const uint32_t source[8],
+                                       uint32_t row, const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    const uint32_t *destination = op->operation.payment.to;
+    uint32_t destination_row = account_row(ledger, destination);
+    if (destination_row == RSA_ACCOUNT_NO_INDEX) return RSA_OP_RESULT_NO_DESTINATION;
+    if (destination_row == row) return RSA_OP_RESULT_SUCCESS;
+
+    const rsa_asset_t *asset = &op->operation.payment.asset;
+    int64_t amount = op->operation.payment.amount;
+    if (asset->type == RSA_ASSET_TYPE_NATIVE) {
+        return op_native_payment(worker, source, row, destination, destination_row, amount);
+    }
+    return op_credit_payment(worker, source, row, destination, destination_row, asset, amount);
+}
+
+static rsa_op_result_code_t op_change_trust(ledger_worker_t *worker, const uint32_t source[8],
+                                            uint32_t row, const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    const rsa_asset_t *asset = &op->operation.change_trust.asset;
+    int64_t limit = op->operation.change_trust.limit;
+    rsa_trustline_store_t *lines = &ledger->trustlines;
+    if (is_issuer(asset, source)) return RSA_OP_RESULT_MALFORMED;
+
+    uint32_t asset_id = rsa_asset_lookup(&ledger->assets, asset);
+    uint32_t entry = asset_id == RSA_ASSET_INVALID_ID
+                         ? RSA_TRUSTLINE_NONE
+                         : rsa_trustline_store_find(lines, row, asset_id);
+
+    if (entry != RSA_TRUSTLINE_NONE) {
+        if (limit < lines->balances[entry]) return RSA_OP_RESULT_INVALID_LIMIT;
+        TOUCH(worker, source, asset_id);
+        if (limit > 0) {
+            lines->limits[entry] = limit;
+            return RSA_OP_RESULT_SUCCESS;
+        }
+        TOUCH(worker, source, NO_ASSET);
+        rsa_trustline_store_remove(lines, row, asset_id);
+        ledger->accounts.num_sub_entries[row]--;
+        return RSA_OP_RESULT_SUCCESS;
+    }
+
+    if (limit == 0) return RSA_OP_RESULT_NO_TRUST;
+    uint32_t issuer[8];
+    memcpy(issuer, asset_issuer(asset), sizeof(issuer));
+    uint32_t issuer_row = account_row(ledger, issuer);
+    if (issuer_row == RSA_ACCOUNT_NO_INDEX) return RSA_OP_RESULT_NO_ISSUER;
+    if (ledger->accounts.balances[row] < min_balance(ledger, row, 1)) return RSA_OP_RESULT_LOW_RESERVE;
+
+    asset_id = rsa_asset_intern(&ledger->assets, asset);
+    if (asset_id == RSA_ASSET_INVALID_ID) return RSA_OP_RESULT_INTERNAL_ERROR;
+    uint32_t flags = (ledger->accounts.flags[issuer_row] & RSA_AUTH_REQUIRED_FLAG)
+                         ? 0 : RSA_TRUSTLINE_AUTHORIZED_FLAG;
+    TOUCH(worker, source, NO_ASSET);
+    TOUCH(worker, source, asset_id);
+    if (rsa_trustline_store_add(lines, row, asset_id, limit, flags, NULL) == RSA_TRUSTLINE_NONE) {
+        return RSA_OP_RESULT_INTERNAL_ERROR;
+    }
+    ledger->accounts.num_sub_entries[row]++;
+    return RSA_OP_RESULT_SUCCESS;
+}
+
+static rsa_op_result_code_t op_allow_trust(ledger_worker_t *worker, const uint32_t source[8],
+                                           uint32_t row, const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    const rsa_asset_t *asset = &op->operation.allow_trust.asset;
+    const uint32_t *trustor = op->operation.allow_trust.trustor;
+    uint32_t authorize = op->operation.allow_trust.authorize;
+    if (!is_issuer(asset, source)) return RSA_OP_RESULT_MALFORMED;
+    if (authorize == 0 && !(ledger->accounts.flags[row] & RSA_AUTH_REVOCABLE_FLAG)) {
+        return RSA_OP_RESULT_NOT_AUTHORIZED;
+    }
+
+    uint32_t trustor_row = account_row(ledger, trustor);
+    if (trustor_row == RSA_ACCOUNT_NO_INDEX) return RSA_OP_RESULT_NO_DESTINATION;
+    uint32_t asset_id = rsa_asset_lookup(&ledger->assets, asset);
+    uint32_t entry = asset_id == RSA_ASSET_INVALID_ID
+                         ? RSA_TRUSTLINE_NONE
+                         : rsa_trustline_store_find(&ledger->trustlines, trustor_row, asset_id);
+    if (entry == RSA_TRUSTLINE_NONE) return RSA_OP_RESULT_NO_TRUST;
+
+    TOUCH(worker, trustor, asset_id);
+    ledger->trustlines.flags[entry] = authorize;
+    return RSA_OP_RESULT_SUCCESS;
+}
+
+// Replaces thresholds, home domain and signers; each signer is a sub-entry
+static rsa_op_result_code_t op_set_options(ledger_worker_t *worker, const uint32_t source[8],
+                                           uint32_t row, const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    rsa_account_t account;
+    if (!rsa_account_soa_get(&ledger->accounts, row, &account)) return RSA_OP_RESULT_INTERNAL_ERROR;
+
+    uint32_t signer_count = op->operation.set_options.signer_count;
+    int32_t delta = (int32_t)signer_count - (int32_t)account.signer_count;
+    if (delta > 0 && account.balance < min_balance(ledger, row, delta)) {
+        return RSA_OP_RESULT_LOW_RESERVE;
+    }
+
+    memcpy(&account.thresholds, &op->operation.set_options.thresholds, sizeof(account.thresholds));
+    account.home_domain_len = op->operation.set_options.home_domain_len;
+    memset(account.home_domain, 0, sizeof(account.home_domain));
+    memcpy(account.home_domain, op->operation.set_options.home_domain, account.home_domain_len);
+    memset(account.signers, 0, sizeof(account.signers));
+    memcpy(account.signers, op->operation.set_options.signers, signer_count * sizeof(account.signers[0]));
+    account.signer_count = signer_count;
+    account.num_sub_entries = (uint32_t)((int32_t)account.num_sub_entries + delta);
+
+    TOUCH(worker, source, NO_ASSET);
+    return rsa_account_soa_set(&ledger->accounts, row, &account, &ledger->account_index)
+               ? RSA_OP_RESULT_SUCCESS
+               : RSA_OP_RESULT_INTERNAL_ERROR;
+}
+
+static rsa_op_result_code_t op_account_merge(ledger_worker_t *worker, const uint32_t source[8],
+                                             uint32_t row, const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    const uint32_t *destination = op->operation.account_merge.destination;
+    uint32_t destination_row = account_row(ledger, destination);
+    if (destination_row == RSA_ACCOUNT_NO_INDEX) return RSA_OP_RESULT_NO_DESTINATION;
+    if (destination_row == row) return RSA_OP_RESULT_MALFORMED;
+    if (ledger->accounts.num_sub_entries[row] != 0) return RSA_OP_RESULT_HAS_SUB_ENTRIES;
+
+    int64_t *balances = ledger->accounts.balances;
+    if (balances[destination_row] > INT64_MAX - balances[row]) return RSA_OP_RESULT_LINE_FULL;
+
+    TOUCH(worker, source, NO_ASSET);
+    TOUCH(worker, destination, NO_ASSET);
+    balances[destination_row] += balances[row];
+    return remove_account_row(ledger, row) ? RSA_OP_RESULT_SUCCESS : RSA_OP_RESULT_INTERNAL_ERROR;
+}
+
+static rsa_op_result_code_t op_bump_sequence(ledger_worker_t *worker, const uint32_t source[8],
+                                             uint32_t row, const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    uint64_t bump_to = op->operation.bump_sequence.bump_to;
+    if (bump_to > ledger->accounts.seq_nums[row]) {
+        TOUCH(worker, source, NO_ASSET);
+        ledger->accounts.seq_nums[row] = bump_to;
+    }
+    return RSA_OP_RESULT_SUCCESS;
+}
+
+static rsa_op_result_code_t apply_operation(ledger_worker_t *worker, const uint32_t tx_source[8],
+                                            const rsa_operation_t *op) {
+    rsa_ledger_t *ledger = worker->ledger;
+    // Only the transaction source is authorized by the envelope; until
+    // signers and thresholds are checked, a payment may not debit another
+    // account
+    const uint32_t *source = tx_source;
+    if (op->type == RSA_OP_PAYMENT && !same_account(op->operation.payment.from, zero_account) &&
+        !same_account(op->operation.payment.from, tx_source)) {
+        return RSA_OP_RESULT_BAD_AUTH;
+    }
+    uint32_t row = account_row(ledger, source);
+    if (row == RSA_ACCOUNT_NO_INDEX) return RSA_OP_RESULT_NO_ACCOUNT;
+
+    switch (op->type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            return op_create_account(worker, source, row, op);
+        case RSA_OP_PAYMENT:
+            return op_payment(worker, source, row, op);
+        case RSA_OP_CHANGE_TRUST:
+            return op_change_trust(worker, source, row, op);
+        case RSA_OP_ALLOW_TRUST:
+            return op_allow_trust(worker, source, row, op);
+        case RSA_OP_SET_OPTIONS:
+            return op_set_options(worker, source, row, op);
+        case RSA_OP_ACCOUNT_MERGE:
+            return op_account_merge(worker, source, row, op);
+        case RSA_OP_BUMP_SEQUENCE:
+            return op_bump_sequence(worker, source, row, op);
+        default:
+            return RSA_OP_RESULT_NOT_SUPPORTED;
+    }
+}
+
+// Fee and sequence number, then the operations. False only on internal
+// failure.
+static bool apply_transaction(ledger_worker_t *worker, const rsa_tx_envelope_ref_t *envelope,
+                              rsa_tx_result_t *result) {
+    const rsa_transaction_t *tx = envelope->tx;
+    rsa_ledger_t *ledger = worker->ledger;
+    rsa_account_soa_t *accounts = &ledger->accounts;
+
+    uint32_t row = account_row(ledger, tx->tx_source_account);
+    if (row == RSA_ACCOUNT_NO_INDEX) {
+        result->code = RSA_TX_RESULT_NO_ACCOUNT;
+        return true;
+    }
+    if (!rsa_check_sequence_number(accounts->seq_nums[row], tx->seq_num)) {
+        result->code = RSA_TX_RESULT_BAD_SEQ;
+        return true;
+    }
+    int64_t fee = (int64_t)ledger->scratch->base_fee * tx->operations_count;
+    if (fee > tx->fee) fee = tx->fee;
+    if (accounts->balances[row] < fee) {
+        result->code = RSA_TX_RESULT_INSUFFICIENT_BALANCE;
+        return true;
+    }
+
+    if (!touch(worker, tx->tx_source_account, NO_ASSET)) return false;
+    accounts->balances[row] -= fee;
+    accounts->seq_nums[row] = tx->seq_num;
+    worker->fees += fee;
+    result->fee_charged = fee;
+
+    worker->undo_active = tx->operations_count > 1;
+    worker->undo_count = 0;
+    result->code = RSA_TX_RESULT_SUCCESS;
+    for (uint32_t i = 0; i < tx->operations_count; i++) {
+        rsa_op_result_code_t code = apply_operation(worker, tx->tx_source_account,
+                                                    &envelope->operations[i]);
+        result->op_results[i] = (uint8_t)code;
+        if (code == RSA_OP_RESULT_SUCCESS) continue;
+        if (code == RSA_OP_RESULT_INTERNAL_ERROR) return false;
+
+        for (uint32_t j = i + 1; j < tx->operations_count; j++) {
+            result->op_results[j] = RSA_OP_RESULT_NOT_APPLIED;
+        }
+        result->code = RSA_TX_RESULT_FAILED;
+        if (worker->undo_active && !undo_rollback(worker)) return false;
+        break;
+    }
+    worker->undo_active = false;
+    return true;
+}
+
+// PARALLEL APPLY
+// --------------
+
+// Accounts the transaction names, into `accounts` (TX_MAX_FOOTPRINT at
+// most). False when an operation changes shared structure - rows, the
+// trustline index, the cold table or the asset table - so the transaction
+// has to run alone.
+static bool tx_footprint(const rsa_tx_envelope_ref_t *envelope, const uint32_t **accounts,
+                         size_t *count) {
+    const rsa_transaction_t *tx = envelope->tx;
+    size_t n = 0;
+    accounts[n++] = tx->tx_source_account;
+    for (uint32_t i = 0; i < tx->operations_count; i++) {
+        const rsa_operation_t *op = &envelope->operations[i];
+        switch (op->type) {
+            case RSA_OP_PAYMENT:
+                accounts[n++] = op->operation.payment.to;
+                break;
+            case RSA_OP_ALLOW_TRUST:
+                accounts[n++] = op->operation.allow_trust.trustor;
+                break;
+            case RSA_OP_CREATE_ACCOUNT:
+            case RSA_OP_CHANGE_TRUST:
+            case RSA_OP_SET_OPTIONS:
+            case RSA_OP_ACCOUNT_MERGE:
+                return false;
+            default:
+                break;                  // the transaction source only
+        }
+    }
+    *count = n;
+    return true;
+}
+
+static bool segment_init(ledger_segment_t *segment, size_t max_txs) {
+    size_t accounts = max_txs * TX_MAX_FOOTPRINT;
+    segment->owner_slots = 64;
+    while (segment->owner_slots < accounts * 2) segment->owner_slots *= 2;
+    segment->txs = malloc(max_txs * sizeof(*segment->txs));
+    segment->footprint_ends = malloc(max_txs * sizeof(*segment->footprint_ends));
+    segment->footprint = malloc(accounts * sizeof(*segment->footprint));
+    segment->owners = malloc(segment->owner_slots * sizeof(*segment->owners));
+    segment->parents = malloc(max_txs * sizeof(*segment->parents));
+    segment->offsets = malloc(max_txs * sizeof(*segment->offsets));
+    segment->group_txs = malloc(max_txs * sizeof(*segment->group_txs));
+    segment->groups = malloc(max_txs * sizeof(*segment->groups));
+    return segment->txs && segment->footprint_ends && segment->footprint && segment->owners &&
+           segment->parents && segment->offsets && segment->group_txs && segment->groups;
+}
+
+static void segment_free(ledger_segment_t *segment) {
+    free(segment->txs);
+    free(segment->footprint_ends);
+    free(segment->footprint);
+    free(segment->owners);
+    free(segment->parents);
+    free(segment->offsets);
+    free(segment->group_txs);
+    free(segment->groups);
+}
+
+static uint32_t group_root(uint32_t *parents, uint32_t position) {
+    while (parents[position] != position) {
+        parents[position] = parents[parents[position]];
+        position = parents[position];
+    }
+    return position;
+}
+
+// The earlier position becomes the root, so roots are first transactions
+static void group_join(uint32_t *parents, uint32_t a, uint32_t b) {
+    a = group_root(parents, a);
+    b = group_root(parents, b);
+    if (a < b) parents[b] = a;
+    else if (b < a) parents[a] = b;
+}
+
+// Largest first, then set order
+static int compare_groups(const void *a, const void *b) {
+    const ledger_group_t *x = a, *y = b;
+    if (x->count != y->count) return x->count > y->count ? -1 : 1;
+    return x->start < y->start ? -1 : x->start > y->start;
+}
+
+// Joins positions naming a common account; returns the number of groups
+static size_t segment_group(ledger_segment_t *segment, const rsa_hash_key_t *key) {
+    size_t slots = 64;
+    while (slots < segment->footprint_count * 2) slots *= 2;
+    size_t mask = slots - 1;
+    memset(segment->owners, 0, slots * sizeof(*segment->owners));
+
+    size_t begin = 0;
+    for (uint32_t p = 0; p < segment->count; p++) {
+        segment->parents[p] = p;
+        for (size_t a = begin; a < segment->footprint_ends[p]; a++) {
+            const uint32_t *account_id = segment->footprint[a];
+            size_t pos = dirty_hash(key, account_id, NO_ASSET) & mask;
+            for (;; pos = (pos + 1) & mask) {
+                ledger_owner_t *owner = &segment->owners[pos];
+                if (!owner->account_id) {
+                    owner->account_id = account_id;
+                    owner->position = p;
+                    break;
+                }
+                if (same_account(owner->account_id, account_id)) {
+                    group_join(segment->parents, owner->position, p);
+                    break;
+                }
+            }
+        }
+        begin = segment->footprint_ends[p];
+    }
+
+    // Lay groups out contiguously, each in set order
+    size_t groups = 0;
+    for (uint32_t p = 0; p < segment->count; p++) {
+        uint32_t root = group_root(segment->parents, p);
+        if (root == p) {
+            segment->offsets[p] = (uint32_t)groups;
+            segment->groups[groups++] = (ledger_group_t){0, 0};
+        }
+        segment->groups[segment->offsets[root]].count++;
+    }
+    uint32_t start = 0;
+    for (size_t g = 0; g < groups; g++) {
+        segment->groups[g].start = start;
+        start += segment->groups[g].count;
+    }
+    for (uint32_t p = 0; p < segment->count; p++) {
+        if (segment->parents[p] == p) {
+            segment->offsets[p] = segment->groups[segment->offsets[p]].start;
+        }
+    }
+    for (uint32_t p = 0; p < segment->count; p++) {
+        uint32_t root = group_root(segment->parents, p);
+        segment->group_txs[segment->offsets[root]++] = segment->txs[p];
+    }
+    segment->group_count = groups;
+    return groups;
+}
+
+static void segment_worker(void *arg, unsigned w) {
+    ledger_worker_t *worker = &((rsa_ledger_scratch_t *)arg)->workers[w];
+    ledger_segment_t *segment = worker->segment;
+    for (;;) {
+        size_t g = __atomic_fetch_add(&segment->next, 1, __ATOMIC_RELAXED);
+        if (g >= segment->group_count) break;
+        const ledger_group_t *group = &segment->groups[g];
+        for (uint32_t i = 0; i < group->count; i++) {
+            uint32_t tx = segment->group_txs[group->start + i];
+            worker->tx = tx;
+            if (!apply_transaction(worker, &segment->envelopes[tx], &segment->results[tx])) {
+                __atomic_store_n(&segment->failed, true, __ATOMIC_RELAXED);
+                return;
+            }
+        }
+    }
+}
+
+static int compare_touch_refs(const void *a, const void *b) {
+    const ledger_touch_ref_t *x = a, *y = b;
+    if (x->tx != y->tx) return x->tx < y->tx ? -1 : 1;
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+// Worker entries into the ledger's set, in serial first-touch order: by
+// transaction, then touch order. A transaction ran on one worker only.
+static bool merge_touch_sets(rsa_ledger_t *ledger, unsigned workers) {
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    size_t total = 0;
+    for (unsigned w = 0; w < workers; w++) total += scratch->workers[w].local.count;
+    if (total == 0) return true;
+
+    ledger_touch_ref_t *refs = grow_array(scratch->refs, &scratch->ref_capacity, sizeof(*refs),
+                                          total);
+    if (!refs) return false;
+    scratch->refs = refs;
+    size_t n = 0;
+    for (unsigned w = 0; w < workers; w++) {
+        const ledger_touch_set_t *local = &scratch->workers[w].local;
+        for (size_t i = 0; i < local->count; i++) {
+            refs[n++] = (ledger_touch_ref_t){local->dirty[i].tx, w, (uint32_t)i};
+        }
+    }
+    qsort(refs, n, sizeof(*refs), compare_touch_refs);
+
+    ledger_touch_set_t *set = &scratch->dirty;
+    for (size_t i = 0; i < n; i++) {
+        const ledger_touch_set_t *local = &scratch->workers[refs[i].worker].local;
+        const ledger_dirty_t *dirty = &local->dirty[refs[i].index];
+        const ledger_image_t *before =
+            dirty->before == NO_BEFORE ? NULL : &local->before[dirty->before];
+        size_t pos = touch_set_probe(set, &scratch->key, dirty->account_id, dirty->asset_id);
+        if (!touch_set_add(set, pos, &scratch->key, dirty->account_id, dirty->asset_id, dirty->tx,
+                           before)) {
+            return false;
+        }
+    }
+    for (unsigned w = 0; w < workers; w++) touch_set_reset(&scratch->workers[w].local);
+    return true;
+}
+
+// Applies the collected segment: conflict groups on the workers when it is
+// long enough to pay for them, inline otherwise
+static bool segment_apply(rsa_ledger_t *ledger) {
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    ledger_segment_t *segment = &scratch->segment;
+    if (segment->count == 0) return true;
+
+    size_t groups = segment->count >= RSA_LEDGER_MIN_PARALLEL_TXS
+                        ? segment_group(segment, &scratch->key) : 1;
+    unsigned threads = scratch->worker_count;
+    if (threads > groups) threads = (unsigned)groups;
+    if (threads < 2) {
+        ledger_worker_t *worker = &scratch->workers[0];
+        for (size_t p = 0; p < segment->count; p++) {
+            worker->tx = segment->txs[p];
+            if (!apply_transaction(worker, &segment->envelopes[worker->tx],
+                                   &segment->results[worker->tx])) {
+                return false;
+            }
+        }
+        segment->count = 0;
+        segment->footprint_count = 0;
+        return true;
+    }
+
+    qsort(segment->groups, groups, sizeof(*segment->groups), compare_groups);
+    segment->next = 0;
+    segment->failed = false;
+    for (unsigned w = 0; w < threads; w++) scratch->workers[w].segment = segment;
+
+    rsa_worker_pool_run(&scratch->pool, threads, segment_worker, scratch);
+
+    for (unsigned w = 0; w < threads; w++) scratch->workers[w].segment = NULL;
+    ledger->apply_groups += groups;
+    segment->count = 0;
+    segment->footprint_count = 0;
+    return !segment->failed && merge_touch_sets(ledger, threads);
+}
+
+// Set order, with transactions that change shared structure applied inline
+// between parallel segments
+static bool apply_set(rsa_ledger_t *ledger, const rsa_tx_envelope_ref_t *envelopes, size_t count,
+                      rsa_tx_result_t *results) {
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    ledger_worker_t *inline_worker = &scratch->workers[0];
+    ledger_segment_t *segment = &scratch->segment;
+    segment->envelopes = envelopes;
+    segment->results = results;
+
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].code == RSA_TX_RESULT_INVALID) continue;
+        size_t named;
+        if (scratch->worker_count > 1 &&
+            tx_footprint(&envelopes[i], segment->footprint + segment->footprint_count, &named)) {
+            segment->footprint_count += named;
+            segment->footprint_ends[segment->count] = (uint32_t)segment->footprint_count;
+            segment->txs[segment->count++] = (uint32_t)i;
+            continue;
+        }
+        if (!segment_apply(ledger)) return false;
+        inline_worker->tx = (uint32_t)i;
+        if (!apply_transaction(inline_worker, &envelopes[i], &results[i])) return false;
+    }
+    return segment_apply(ledger);
+}
+
+// HASHING
+// -------
+
+void rsa_ledger_tx_hash(const rsa_tx_envelope_ref_t *envelope, uint8_t hash[32]) {
+    if (!envelope->tx) {
+        memset(hash, 0, 32);
+        return;
+    }
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, envelope->tx, sizeof(*envelope->tx));
+    uint32_t op_count = envelope->tx->operations_count;
+    if (envelope->operations && op_count <= RSA_MAX_OPERATIONS_PER_TX) {
+        SHA256_Update(&ctx, envelope->operations, op_count * sizeof(rsa_operation_t));
+    }
+    SHA256_Final(hash, &ctx);
+}
+
+#define HEADER_PUT(cursor, field)                          \
+    do {                                                   \
+        memcpy((cursor), &(field), sizeof(field));         \
+        (cursor) += sizeof(field);                         \
+    } while (0)
+
+void rsa_ledger_header_hash(const rsa_ledger_header_t *header, uint8_t hash[32]) {
+    uint8_t buffer[sizeof(rsa_ledger_header_t)];
+    uint8_t *cursor = buffer;
+    HEADER_PUT(cursor, header->ledger_version);
+    HEADER_PUT(cursor, header->ledger_seq);
+    HEADER_PUT(cursor, header->previous_ledger_hash);
+    HEADER_PUT(cursor, header->state_hash);
+    HEADER_PUT(cursor, header->tx_set_hash);
+    HEADER_PUT(cursor, header->tx_set_result_hash);
+    HEADER_PUT(cursor, header->scp_value);
+    HEADER_PUT(cursor, header->close_time);
+    HEADER_PUT(cursor, header->fee_pool);
+    HEADER_PUT(cursor, header->close_time_res);
+    HEADER_PUT(cursor, header->base_fee);
+    HEADER_PUT(cursor, header->base_reserve);
+    HEADER_PUT(cursor, header->max_tx_set_size);
+    HEADER_PUT(cursor, header->skip_list);
+    HEADER_PUT(cursor, header->ext);
+    SHA256(buffer, (size_t)(cursor - buffer), hash);
+}
+
+// stellar-core's skip list: hashes of ledgers 50, 5000, 50000 and 500000
+// back, refreshed on those boundaries
+static void update_skip_list(rsa_ledger_header_t *header) {
+    int64_t seq = header->ledger_seq;
+    if (seq % RSA_LEDGER_SKIP_1 != 0) return;
+
+    int64_t v = seq - RSA_LEDGER_SKIP_1;
+    if (v > 0 && v % RSA_LEDGER_SKIP_2 == 0) {
+        v = seq - RSA_LEDGER_SKIP_2 - RSA_LEDGER_SKIP_1;
+        if (v > 0 && v % RSA_LEDGER_SKIP_3 == 0) {
+            v = seq - RSA_LEDGER_SKIP_3 - RSA_LEDGER_SKIP_2 - RSA_LEDGER_SKIP_1;
+            if (v > 0 && v % RSA_LEDGER_SKIP_4 == 0) {
+                memcpy(header->skip_list[3], header->skip_list[2], sizeof(header->skip_list[3]));
+            }
+            memcpy(header->skip_list[2], header->skip_list[1], sizeof(header->skip_list[2]));
+        }
+        memcpy(header->skip_list[1], header->skip_list[0], sizeof(header->skip_list[1]));
+    }
+    memcpy(header->skip_list[0], header->state_hash, sizeof(header->skip_list[0]));
+}
+
+static inline rsa_mvcc_store_t *mvcc_store(const rsa_ledger_t *ledger, rsa_wal_entry_type_t type) {
+    return type == RSA_WAL_ACCOUNT ? ledger->config.mvcc_accounts : ledger->config.mvcc_trustlines;
+}
+
+static inline rsa_mvcc_domain_t *mvcc_domain(const rsa_ledger_t *ledger) {
+    if (ledger->config.mvcc_accounts) return ledger->config.mvcc_accounts->domain;
+    return ledger->config.mvcc_trustlines ? ledger->config.mvcc_trustlines->domain : NULL;
+}
+
+// Dirtied entry into its reader store, if there is one. An entry readers
+// never saw (created and removed within the ledger) has nothing to erase.
+static bool publish_entry(rsa_mvcc_store_t *store, rsa_wal_entry_type_t type,
+                          const ledger_image_t *image, bool present) {
+    if (!store) return true;
+    if (present) return rsa_mvcc_put(store, image);
+
+    ledger_image_t normalized;
+    if (!rsa_wal_entry_normalize(type, image, &normalized)) return false;
+    if (!rsa_mvcc_latest(store, (const uint8_t *)&normalized + store->key_offset)) return true;
+    return rsa_mvcc_erase(store, image);
+}
+
+// Dirtied entries into the state tree and the reader stores, and the log
+// batch when there is a log
+static bool hash_state(rsa_ledger_t *ledger) {
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    const ledger_touch_set_t *set = &scratch->dirty;
+    rsa_wal_t *wal = ledger->config.wal;
+    ledger_image_t after;
+
+    for (size_t i = 0; i < set->count; i++) {
+        const ledger_dirty_t *dirty = &set->dirty[i];
+        rsa_wal_entry_type_t type = dirty->asset_id == NO_ASSET ? RSA_WAL_ACCOUNT : RSA_WAL_TRUSTLINE;
+        const ledger_image_t *before =
+            dirty->before == NO_BEFORE ? NULL : &set->before[dirty->before];
+        bool ok;
+
+        if (entry_image(ledger, dirty->account_id, dirty->asset_id, &after)) {
+            ok = rsa_merkle_batch_put_entry(&scratch->state_batch, type, &after) &&
+                 publish_entry(mvcc_store(ledger, type), type, &after, true);
+            if (ok && wal) {
+                ok = before ? rsa_wal_batch_update(&scratch->wal_batch, type, before, &after)
+                            : rsa_wal_batch_create(&scratch->wal_batch, type, &after);
+            }
+        } else {
+            if (type == RSA_WAL_ACCOUNT) {
+                memset(&after.account, 0, sizeof(after.account));
+                memcpy(after.account.account_id, dirty->account_id, 32);
+            } else {
+                trustline_image(ledger, dirty->account_id, dirty->asset_id, RSA_TRUSTLINE_NONE,
+                                &after.trustline);
+            }
+            if (!wal) {
+                ok = rsa_merkle_batch_erase_entry(&scratch->state_batch, type, &after);
+            } else if (before) {
+                ok = rsa_merkle_batch_erase_entry(&scratch->state_batch, type, &after) &&
+                     rsa_wal_batch_delete(&scratch->wal_batch, type, before);
+            } else {
+                ok = true;              // created and removed within the ledger
+            }
+            ok = ok && publish_entry(mvcc_store(ledger, type), type, &after, false);
+        }
+        if (!ok) return false;
+    }
+    return rsa_merkle_apply(&ledger->state_tree, &scratch->state_batch, &scratch->pool,
+                            ledger->config.hash_threads);
+}
+
+// SNAPSHOTS
+// ---------
+
+static void snapshot_path(const char *dir, uint64_t ledger_seq, char *out, size_t size) {
+    snprintf(out, size, "%s/%016" PRIx64 ".snap", dir, ledger_seq);
+}
+
+// Newest snapshot in dir (0 if none), removing those before remove_before
+static uint64_t snapshot_scan(const char *dir, uint64_t remove_before) {
+    DIR *handle = opendir(dir);
+    if (!handle) return 0;
+
+    uint64_t newest = 0;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        const char *name = entry->d_name;
+        if (strlen(name) != 21 || strcmp(name + 16, ".snap") != 0) continue;
+        if (strspn(name, "0123456789abcdef") != 16) continue;
+
+        uint64_t ledger_seq = strtoull(name, NULL, 16);
+        if (ledger_seq < remove_before) {
+            char path[600];
+            snapshot_path(dir, ledger_seq, path, sizeof(path));
+            unlink(path);
+        } else if (ledger_seq > newest) {
+            newest = ledger_seq;
+        }
+    }
+    closedir(handle);
+    return newest;
+}
+
+// The last closed ledger into snapshot_dir; accounts in row order,
+// trustlines in entry order
+static bool write_snapshot(const rsa_ledger_t *ledger) {
+    char path[600];
+    uint64_t ledger_seq = ledger->header.ledger_seq;
+    snapshot_path(ledger->config.snapshot_dir, ledger_seq, path, sizeof(path));
+
+    rsa_snapshot_writer_t writer;
+    if (!rsa_snapshot_writer_open(&writer, path, ledger_seq, ledger->header_hash)) return false;
+    rsa_snapshot_writer_set_ledger_header(&writer, &ledger->header);
+
+    const rsa_account_soa_t *accounts = &ledger->accounts;
+    bool ok = rsa_snapshot_writer_begin(&writer, RSA_SNAPSHOT_ACCOUNTS);
+    rsa_account_t account;
+    for (uint32_t row = 0; ok && row < accounts->count; row++) {
+        ok = rsa_account_soa_get(accounts, row, &account) &&
+             rsa_snapshot_write_account(&writer, &account);
+    }
+    ok = ok && rsa_snapshot_writer_end(&writer) &&
+         rsa_snapshot_writer_begin(&writer, RSA_SNAPSHOT_TRUSTLINES);
+
+    const rsa_trustline_store_t *lines = &ledger->trustlines;
+    rsa_trustline_t trustline;
+    for (size_t entry = 0; ok && entry < lines->count; entry++) {
+        trustline_image(ledger, accounts->account_ids[lines->account_rows[entry]],
+                        lines->asset_ids[entry], (uint32_t)entry, &trustline);
+        ok = rsa_snapshot_write_trustline(&writer, &trustline);
+    }
+    ok = ok && rsa_snapshot_writer_end(&writer) && rsa_snapshot_writer_commit(&writer);
+    if (!ok) {
+        rsa_snapshot_writer_abort(&writer);
+        return false;
+    }
+    snapshot_scan(ledger->config.snapshot_dir, ledger_seq);
+    return true;
+}
+
+// Creates or overwrites an entry from a stored image. A trustline's
+// account must already be there.
+static bool restore_entry(rsa_ledger_t *ledger, rsa_wal_entry_type_t type, const void *record) {
+    if (type == RSA_WAL_ACCOUNT) {
+        return rsa_account_soa_append(&ledger->accounts, record, &ledger->account_index) !=
+               RSA_ACCOUNT_NO_INDEX;
+    }
+
+    const rsa_trustline_t *image = record;
+    uint32_t row = account_row(ledger, image->account_id);
+    uint32_t asset_id = rsa_asset_intern(&ledger->assets, &image->asset);
+    if (row == RSA_ACCOUNT_NO_INDEX || asset_id == RSA_ASSET_INVALID_ID) return false;
+    rsa_trustline_store_t *lines = &ledger->trustlines;
+    uint32_t entry = rsa_trustline_store_add(lines, row, asset_id, image->limit, image->flags, NULL);
+    if (entry == RSA_TRUSTLINE_NONE) return false;
+    lines->balances[entry] = image->balance;
+    lines->limits[entry] = image->limit;
+    lines->flags[entry] = image->flags;
+    return true;
+}
+
+// Current stored image of the entry keyed by the image's key bytes
+static bool stored_image(const rsa_ledger_t *ledger, rsa_wal_entry_type_t type,
+                         ledger_image_t *image) {
+    uint32_t account_id[8];             // entry_image() clears the image first
+    memcpy(account_id, image->account.account_id, sizeof(account_id));
+    if (type == RSA_WAL_ACCOUNT) return entry_image(ledger, account_id, NO_ASSET, image);
+    uint32_t asset_id = rsa_asset_lookup(&ledger->assets, &image->trustline.asset);
+    return asset_id != RSA_ASSET_INVALID_ID && entry_image(ledger, account_id, asset_id, image);
+}
+
+static bool erase_entry(rsa_ledger_t *ledger, rsa_wal_entry_type_t type,
+                        const ledger_image_t *image) {
+    uint32_t row = account_row(ledger, image->account.account_id);
+    if (row == RSA_ACCOUNT_NO_INDEX) return false;
+    if (type == RSA_WAL_ACCOUNT) return remove_account_row(ledger, row);
+    uint32_t asset_id = rsa_asset_lookup(&ledger->assets, &image->trustline.asset);
+    return asset_id != RSA_ASSET_INVALID_ID &&
+           rsa_trustline_store_remove(&ledger->trustlines, row, asset_id);
+}
+
+// rsa_wal_replay() callback: one logged change onto the restored state
+static bool replay_change(void *ctx, uint64_t ledger_seq, const rsa_wal_change_t *change) {
+    rsa_ledger_t *ledger = ctx;
+    (void)ledger_seq;
+    if (change->type != RSA_WAL_ACCOUNT && change->type != RSA_WAL_TRUSTLINE) return false;
+
+    ledger_image_t image;
+    memset(&image, 0, sizeof(image));
+    memcpy(&image, change->key, rsa_wal_key_size[change->type]);
+    if (change->kind == RSA_WAL_DELETE) return erase_entry(ledger, change->type, &image);
+    if (change->kind == RSA_WAL_UPDATE && !stored_image(ledger, change->type, &image)) return false;
+    return rsa_wal_change_apply(change, &image) && restore_entry(ledger, change->type, &image);
+}
+
+// Every entry into the (empty) state tree and reader stores, then the
+// reader domain restarted at and committed as the restored ledger
+static bool restore_index(rsa_ledger_t *ledger, uint64_t ledger_seq) {
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    rsa_mvcc_domain_t *domain = mvcc_domain(ledger);
+    if (domain) {
+        uint64_t retain = domain->retain;
+        rsa_mvcc_domain_free(domain);
+        if (!rsa_mvcc_domain_init(domain, ledger_seq - 1, retain)) return false;
+    }
+
+    rsa_merkle_batch_reset(&scratch->state_batch);
+    ledger_image_t image;
+    bool ok = true;
+    for (uint32_t row = 0; ok && row < ledger->accounts.count; row++) {
+        ok = rsa_account_soa_get(&ledger->accounts, row, &image.account) &&
+             rsa_merkle_batch_put_entry(&scratch->state_batch, RSA_WAL_ACCOUNT, &image) &&
+             publish_entry(ledger->config.mvcc_accounts, RSA_WAL_ACCOUNT, &image, true);
+    }
+    const rsa_trustline_store_t *lines = &ledger->trustlines;
+    for (size_t entry = 0; ok && entry < lines->count; entry++) {
+        trustline_image(ledger, ledger->accounts.account_ids[lines->account_rows[entry]],
+                        lines->asset_ids[entry], (uint32_t)entry, &image.trustline);
+        ok = rsa_merkle_batch_put_entry(&scratch->state_batch, RSA_WAL_TRUSTLINE, &image) &&
+             publish_entry(ledger->config.mvcc_trustlines, RSA_WAL_TRUSTLINE, &image, true);
+    }
+    ok = ok && rsa_merkle_apply(&ledger->state_tree, &scratch->state_batch, &scratch->pool,
+                                ledger->config.hash_threads);
+    rsa_merkle_batch_reset(&scratch->state_batch);
+    if (ok && domain) rsa_mvcc_commit(domain);
+    return ok;
+}
+
+// Loads the newest snapshot in dir into an initialized, empty ledger
+static bool restore_snapshot(rsa_ledger_t *ledger, const char *dir) {
+    uint64_t ledger_seq = dir ? snapshot_scan(dir, 0) : 0;
+    if (ledger_seq == 0) return true;
+    char path[600];
+    snapshot_path(dir, ledger_seq, path, sizeof(path));
+    rsa_snapshot_t snapshot;
+    if (!rsa_snapshot_open(&snapshot, path)) return false;
+
+    // Checksums are checked once here rather than as pages fault in
+    const rsa_ledger_header_t *header = &snapshot.header->ledger_header;
+    uint8_t hash[32];
+    rsa_ledger_header_hash(header, hash);
+    bool ok = rsa_snapshot_verify(&snapshot) && header->ledger_seq == ledger_seq &&
+              memcmp(hash, snapshot.header->ledger_hash, sizeof(hash)) == 0;
+
+    uint64_t count;
+    const rsa_account_t *accounts = rsa_snapshot_records(&snapshot, RSA_SNAPSHOT_ACCOUNTS, &count);
+    ok = ok && rsa_account_soa_reserve(&ledger->accounts, count);
+    for (uint64_t i = 0; ok && i < count; i++) {
+        ok = restore_entry(ledger, RSA_WAL_ACCOUNT, &accounts[i]);
+    }
+    const rsa_trustline_t *lines = rsa_snapshot_records(&snapshot, RSA_SNAPSHOT_TRUSTLINES, &count);
+    for (uint64_t i = 0; ok && i < count; i++) {
+        ok = restore_entry(ledger, RSA_WAL_TRUSTLINE, &lines[i]);
+    }
+    if (ok) {
+        ledger->header = *header;
+        memcpy(ledger->header_hash, hash, sizeof(hash));
+    }
+    rsa_snapshot_close(&snapshot);
+    return ok;
+}
+
+// Newest snapshot, then every ledger the log closed after it, into an
+// initialized, empty ledger, its serial shadow included. The rebuilt
+// state must hash to the last header.
+static bool restore_state(rsa_ledger_t *ledger, const char *snapshot_dir, const char *wal_dir) {
+    rsa_ledger_t *shadow = ledger->scratch->shadow;
+    if (shadow && !restore_state(shadow, snapshot_dir, wal_dir)) return false;
+    if (!restore_snapshot(ledger, snapshot_dir)) return false;
+
+    rsa_wal_recovery_t info;
+    if (wal_dir) {
+        if (!rsa_wal_replay(wal_dir, ledger->header.ledger_seq, replay_change, ledger, &info)) {
+            return false;
+        }
+        if (info.closed_ledger_seq > ledger->header.ledger_seq) {
+            const rsa_ledger_header_t *header = &info.closed_ledger_header;
+            uint8_t hash[32];
+            rsa_ledger_header_hash(header, hash);
+            if (!info.has_header || header->ledger_seq != info.closed_ledger_seq ||
+                memcmp(hash, info.closed_ledger_hash, sizeof(hash)) != 0) {
+                return false;
+            }
+            ledger->header = *header;
+            memcpy(ledger->header_hash, hash, sizeof(hash));
+        }
+    }
+    if (ledger->header.ledger_seq == 0) return true;
+
+    uint8_t root[32];
+    if (!restore_index(ledger, ledger->header.ledger_seq)) return false;
+    rsa_merkle_root(&ledger->state_tree, root);
+    return memcmp(root, ledger->header.state_hash, sizeof(root)) == 0;
+}
+
+static void record_phases(const uint64_t *phase_ns) {
+    __atomic_fetch_add(&g_rsa_monitor.ledgers_closed, 1, __ATOMIC_RELAXED);
+    for (int p = 0; p < RSA_LEDGER_PHASE_COUNT; p++) {
+        __atomic_fetch_add(&g_rsa_monitor.ledger_phase_ns[p], phase_ns[p], __ATOMIC_RELAXED);
+        __atomic_store_n(&g_rsa_monitor.ledger_phase_last_ns[p], phase_ns[p], __ATOMIC_RELAXED);
+    }
+}
+
+static void scratch_reset(rsa_ledger_t *ledger, uint32_t ledger_seq) {
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    touch_set_reset(&scratch->dirty);
+    for (unsigned w = 0; w < scratch->worker_count; w++) {
+        scratch->workers[w].ledger = ledger;
+        scratch->workers[w].fees = 0;
+        scratch->workers[w].undo_count = 0;
+        scratch->workers[w].undo_active = false;
+    }
+    rsa_merkle_batch_reset(&scratch->state_batch);
+    rsa_wal_batch_reset(&scratch->wal_batch);
+    scratch->ledger_seq = ledger_seq;
+}
+
+// Hash and commit phases, shared with genesis. `header` has the ledger
+// sequence, close time, fee pool and tx set hash filled in.
+static bool ledger_finish(rsa_ledger_t *ledger, rsa_ledger_header_t *header,
+                          const rsa_tx_result_t *results, size_t count, uint64_t *phase_ns) {
+    uint64_t start = rsa_clock_precise_ns();
+    rsa_mvcc_domain_t *domain = mvcc_domain(ledger);
+    if (domain && domain->published + 1 != header->ledger_seq) return false;
+    if (!hash_state(ledger)) return false;
+
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    for (size_t i = 0; i < count; i++) {
+        const rsa_tx_result_t *result = &results[i];
+        SHA256_Update(&ctx, result->tx_hash, sizeof(result->tx_hash));
+        SHA256_Update(&ctx, &result->fee_charged, sizeof(result->fee_charged));
+        SHA256_Update(&ctx, &result->code, sizeof(result->code));
+        SHA256_Update(&ctx, &result->validation, sizeof(result->validation));
+        SHA256_Update(&ctx, &result->op_count, sizeof(result->op_count));
+        SHA256_Update(&ctx, result->op_results, result->op_count);
+    }
+    SHA256_Final((uint8_t *)header->tx_set_result_hash, &ctx);
+
+    header->ledger_version = RSA_LEDGER_VERSION;
+    memcpy(header->previous_ledger_hash, ledger->header_hash, sizeof(header->previous_ledger_hash));
+    rsa_merkle_root(&ledger->state_tree, (uint8_t *)header->state_hash);
+    header->base_reserve = ledger->config.base_reserve;
+    header->max_tx_set_size = ledger->config.max_tx_set_size;
+    update_skip_list(header);
+    uint8_t hash[32];
+    rsa_ledger_header_hash(header, hash);
+    phase_ns[RSA_LEDGER_PHASE_HASH] = rsa_clock_precise_ns() - start;
+
+    // The serial shadow closed the same set first; compare before commit
+    rsa_ledger_t *shadow = ledger->scratch->shadow;
+    if (shadow && memcmp(hash, shadow->header_hash, sizeof(hash)) != 0) {
+        __atomic_fetch_add(&g_rsa_monitor.ledger_apply_mismatches, 1, __ATOMIC_RELAXED);
+        rsa_trigger_alert_throttled("LEDGER_APPLY_MISMATCH",
+                                    "Parallel apply diverged from serial apply");
+        return false;
+    }
+
+    start = rsa_clock_precise_ns();
+    if (ledger->config.wal &&
+        !rsa_wal_commit_ledger(ledger->config.wal, header->ledger_seq, hash, header,
+                               &ledger->scratch->wal_batch)) {
+        return false;
+    }
+    ledger->header = *header;
+    memcpy(ledger->header_hash, hash, sizeof(hash));
+    if (domain) rsa_mvcc_commit(domain);
+    if (ledger->config.snapshot_dir && header->ledger_seq % ledger->config.snapshot_interval == 0) {
+        if (!write_snapshot(ledger)) {
+            rsa_trigger_alert_throttled("LEDGER_SNAPSHOT_FAILED",
+                                        "Ledger snapshot could not be written");
+        } else if (ledger->config.wal) {
+            rsa_wal_remove_through(ledger->config.wal, header->ledger_seq);
+        }
+    }
+    phase_ns[RSA_LEDGER_PHASE_COMMIT] = rsa_clock_precise_ns() - start;
+
+    memcpy(ledger->phase_ns, phase_ns, sizeof(ledger->phase_ns));
+    if (ledger->scratch->record) record_phases(phase_ns);
+    return true;
+}
+
+// LIFECYCLE
+// ---------
+
+bool rsa_ledger_init(rsa_ledger_t *ledger, const rsa_ledger_config_t *config) {
+    if (!ledger) return false;
+
+    memset(ledger, 0, sizeof(*ledger));
+    if (config) ledger->config = *config;
+    if (!ledger->config.base_fee) ledger->config.base_fee = RSA_BASE_FEE;
+    if (!ledger->config.base_reserve) ledger->config.base_reserve = RSA_BASE_RESERVE;
+    if (!ledger->config.max_tx_set_size) ledger->config.max_tx_set_size = RSA_MAX_TX_SET_SIZE;
+    if (!ledger->config.snapshot_interval) {
+        ledger->config.snapshot_interval = RSA_LEDGER_SNAPSHOT_INTERVAL;
+    }
+
+    rsa_mvcc_store_t *mvcc_accounts = ledger->config.mvcc_accounts;
+    rsa_mvcc_store_t *mvcc_trustlines = ledger->config.mvcc_trustlines;
+    if ((mvcc_accounts && mvcc_accounts->type != RSA_WAL_ACCOUNT) ||
+        (mvcc_trustlines && mvcc_trustlines->type != RSA_WAL_TRUSTLINE) ||
+        (mvcc_accounts && mvcc_trustlines && mvcc_accounts->domain != mvcc_trustlines->domain)) {
+        return false;
+    }
+
+    // Chunks hold a full set's shadow results without the oversized path
+    rsa_arena_config_t arena = {0, ledger->config.arena_huge_pages};
+    size_t results = (size_t)ledger->config.max_tx_set_size * sizeof(rsa_tx_result_t);
+    if (results > RSA_ARENA_CHUNK_SIZE / 4) arena.chunk_size = 4 * results;
+    rsa_ledger_scratch_t *scratch = calloc(1, sizeof(*scratch));
+    ledger->scratch = scratch;
+    if (!scratch || !rsa_asset_table_init(&ledger->assets)) {
+        free(scratch);
+        ledger->scratch = NULL;
+        return false;
+    }
+    if (!rsa_arena_init(&ledger->arena, &arena)) {
+        rsa_asset_table_free(&ledger->assets);
+        free(scratch);
+        ledger->scratch = NULL;
+        return false;
+    }
+    rsa_merkle_batch_init(&scratch->state_batch);
+    rsa_wal_batch_init(&scratch->wal_batch);
+    rsa_hash_key_init(&scratch->key, scratch);
+
+    scratch->record = true;
+    unsigned threads = ledger->config.apply_threads;
+    scratch->worker_count = threads < 1 ? 1 : threads > RSA_LEDGER_MAX_APPLY_THREADS
+                                                  ? RSA_LEDGER_MAX_APPLY_THREADS : threads;
+
+    // One set of threads serves both parallel phases; they never overlap
+    unsigned pool_threads = ledger->config.hash_threads > scratch->worker_count
+                                ? ledger->config.hash_threads : scratch->worker_count;
+    bool ok = rsa_worker_pool_init(&scratch->pool, pool_threads) &&
+              touch_set_rehash(&scratch->dirty, &scratch->key, DIRTY_MIN_SLOTS) &&
+              rsa_account_soa_init(&ledger->accounts, ledger->config.account_capacity) &&
+              rsa_account_store_init(&ledger->account_index, ledger->config.account_capacity) &&
+              rsa_trustline_store_init(&ledger->trustlines, ledger->config.trustline_capacity) &&
+              rsa_merkle_tree_init(&ledger->state_tree);
+    if (ok && scratch->worker_count > 1) {
+        ok = segment_init(&scratch->segment, ledger->config.max_tx_set_size);
+        for (unsigned w = 0; ok && w < scratch->worker_count; w++) {
+            ok = touch_set_rehash(&scratch->workers[w].local, &scratch->key, DIRTY_MIN_SLOTS);
+        }
+    }
+    if (ok && ledger->config.check_determinism) {
+        rsa_ledger_config_t serial = ledger->config;
+        serial.apply_threads = 0;
+        serial.check_determinism = false;
+        serial.wal = NULL;
+        serial.snapshot_dir = NULL;
+        serial.mvcc_accounts = NULL;
+        serial.mvcc_trustlines = NULL;
+        scratch->shadow = malloc(sizeof(*scratch->shadow));
+        ok = scratch->shadow && rsa_ledger_init(scratch->shadow, &serial);
+        if (ok) {
+            scratch->shadow->scratch->record = false;
+        } else {
+            free(scratch->shadow);
+            scratch->shadow = NULL;
+        }
+    }
+    if (!ok) {
+        rsa_ledger_free(ledger);
+        return false;
+    }
+    return true;
+}
+
+void rsa_ledger_free(rsa_ledger_t *ledger) {
+    if (!ledger) return;
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    if (scratch) {
+        touch_set_free(&scratch->dirty);
+        for (unsigned w = 0; w < RSA_LEDGER_MAX_APPLY_THREADS; w++) {
+            touch_set_free(&scratch->workers[w].local);
+            free(scratch->workers[w].undo);
+        }
+        segment_free(&scratch->segment);
+        rsa_worker_pool_free(&scratch->pool);
+        free(scratch->refs);
+        if (scratch->shadow) {
+            rsa_ledger_free(scratch->shadow);
+            free(scratch->shadow);
+        }
+        rsa_merkle_batch_free(&scratch->state_batch);
+        rsa_wal_batch_free(&scratch->wal_batch);
+        free(scratch);
+        rsa_account_soa_free(&ledger->accounts);
+        rsa_account_store_free(&ledger->account_index);
+        rsa_trustline_store_free(&ledger->trustlines);
+        rsa_merkle_tree_free(&ledger->state_tree);
+        rsa_asset_table_free(&ledger->assets);
+        rsa_arena_free(&ledger->arena);
+    }
+    memset(ledger, 0, sizeof(*ledger));
+}
+
+bool rsa_ledger_open(rsa_ledger_t *ledger, const rsa_ledger_config_t *config,
+                     const char *wal_dir) {
+    if (!config || (!config->snapshot_dir && !wal_dir) || !rsa_ledger_init(ledger, config)) {
+        return false;
+    }
+
+    rsa_mvcc_domain_t *domain = mvcc_domain(ledger);
+    bool ok = !domain || domain->published == 0;
+    if (ok && ledger->config.mvcc_accounts) ok = ledger->config.mvcc_accounts->used == 0;
+    if (ok && ledger->config.mvcc_trustlines) ok = ledger->config.mvcc_trustlines->used == 0;
+    if (!ok || !restore_state(ledger, config->snapshot_dir, wal_dir)) {
+        rsa_ledger_free(ledger);
+        return false;
+    }
+    return true;
+}
+
+bool rsa_ledger_genesis(rsa_ledger_t *ledger, const uint32_t root_account[8], uint64_t close_time) {
+    if (!ledger || !ledger->scratch || !root_account || ledger->header.ledger_seq != 0) return false;
+
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    if (scratch->shadow && !rsa_ledger_genesis(scratch->shadow, root_account, close_time)) {
+        return false;
+    }
+
+    uint64_t phase_ns[RSA_LEDGER_PHASE_COUNT] = {0};
+    uint64_t start = rsa_clock_precise_ns();
+    scratch_reset(ledger, RSA_LEDGER_GENESIS_SEQ);
+
+    rsa_account_t root;
+    memset(&root, 0, sizeof(root));
+    memcpy(root.account_id, root_account, sizeof(root.account_id));
+    root.balance = RSA_LEDGER_TOTAL_COINS;
+    root.thresholds.master_weight = 1;
+    if (!touch(&scratch->workers[0], root_account, NO_ASSET) ||
+        rsa_account_soa_append(&ledger->accounts, &root, &ledger->account_index) ==
+            RSA_ACCOUNT_NO_INDEX) {
+        return false;
+    }
+    phase_ns[RSA_LEDGER_PHASE_APPLY] = rsa_clock_precise_ns() - start;
+
+    rsa_ledger_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.ledger_seq = RSA_LEDGER_GENESIS_SEQ;
+    header.close_time = close_time;
+    header.base_fee = ledger->config.base_fee;
+    SHA256(NULL, 0, (uint8_t *)header.tx_set_hash);
+    return ledger_finish(ledger, &header, NULL, 0, phase_ns);
+}
+
+bool rsa_ledger_prepare(const rsa_ledger_t *ledger, const rsa_tx_envelope_ref_t *envelopes,
+                        size_t count, uint64_t close_time, rsa_tx_result_t *results,
+                        rsa_ledger_candidate_t *candidate) {
+    if (!ledger || !candidate || (count > 0 && (!envelopes || !results)) ||
+        count > ledger->config.max_tx_set_size) {
+        return false;
+    }
+
+    // The set was already agreed on, so it does not go through the
+    // submission rate limiter
+    uint64_t start = rsa_clock_precise_ns();
+    uint32_t counts[RSA_VALIDATION_RESULT_COUNT] = {0};
+    SHA256_CTX set_ctx;
+    SHA256_Init(&set_ctx);
+    for (size_t i = 0; i < count; i++) {
+        rsa_tx_result_t *result = &results[i];
+        memset(result, 0, sizeof(*result));
+        rsa_validation_result_t validation = rsa_validate_tx_envelope(
+            &envelopes[i], close_time, ledger->config.verify_signatures);
+        counts[validation]++;
+        result->validation = validation;
+        if (validation != RSA_VALIDATION_OK) result->code = RSA_TX_RESULT_INVALID;
+        else result->op_count = envelopes[i].tx->operations_count;
+        rsa_ledger_tx_hash(&envelopes[i], result->tx_hash);
+        SHA256_Update(&set_ctx, result->tx_hash, sizeof(result->tx_hash));
+    }
+    SHA256_Final(candidate->tx_set_hash, &set_ctx);
+    rsa_record_validation_counts(counts);
+
+    candidate->envelopes = envelopes;
+    candidate->count = count;
+    candidate->close_time = close_time;
+    candidate->results = results;
+    candidate->base_fee = ledger->config.base_fee;
+    candidate->validate_ns = rsa_clock_precise_ns() - start;
+    return true;
+}
+
+bool rsa_ledger_apply(rsa_ledger_t *ledger, const rsa_ledger_candidate_t *candidate) {
+    if (!ledger || !ledger->scratch || !candidate || ledger->header.ledger_seq == 0 ||
+        ledger->header.ledger_seq == UINT32_MAX || candidate->close_time < ledger->header.close_time ||
+        candidate->base_fee < ledger->config.base_fee) {
+        return false;
+    }
+
+    // The previous close's objects go; chunks stay for this one
+    rsa_arena_reset(&ledger->arena);
+
+    // The shadow starts from the validation results, before apply fills
+    // in the rest
+    rsa_ledger_scratch_t *scratch = ledger->scratch;
+    size_t count = candidate->count;
+    if (scratch->shadow) {
+        rsa_tx_result_t *shadow_results = rsa_arena_alloc(&ledger->arena,
+                                                          count * sizeof(*shadow_results),
+                                                          _Alignof(rsa_tx_result_t));
+        if (!shadow_results) return false;
+        if (count > 0) memcpy(shadow_results, candidate->results, count * sizeof(*shadow_results));
+        rsa_ledger_candidate_t serial = *candidate;
+        serial.results = shadow_results;
+        if (!rsa_ledger_apply(scratch->shadow, &serial)) return false;
+    }
+
+    uint64_t phase_ns[RSA_LEDGER_PHASE_COUNT] = {0};
+    phase_ns[RSA_LEDGER_PHASE_VALIDATE] = candidate->validate_ns;
+    rsa_ledger_header_t header = ledger->header;
+    header.ledger_seq++;
+    header.close_time = candidate->close_time;
+    header.base_fee = candidate->base_fee;
+    memcpy(header.tx_set_hash, candidate->tx_set_hash, sizeof(header.tx_set_hash));
+
+    // State-dependent checks (account, sequence, fee balance) happen here
+    uint64_t start = rsa_clock_precise_ns();
+    scratch_reset(ledger, header.ledger_seq);
+    scratch->base_fee = candidate->base_fee;
+    ledger->apply_groups = 0;
+    if (!apply_set(ledger, candidate->envelopes, count, candidate->results)) return false;
+    for (unsigned w = 0; w < scratch->worker_count; w++) {
+        header.fee_pool += scratch->workers[w].fees;
+    }
+    phase_ns[RSA_LEDGER_PHASE_APPLY] = rsa_clock_precise_ns() - start;
+
+    return ledger_finish(ledger, &header, candidate->results, count, phase_ns);
+}
+
+bool rsa_ledger_close(rsa_ledger_t *ledger, const rsa_tx_envelope_ref_t *envelopes, size_t count,
+                      uint64_t close_time, rsa_tx_result_t *results) {
+    rsa_ledger_candidate_t candidate;
+    if (!ledger || ledger->header.ledger_seq == 0 || close_time < ledger->header.close_time) {
+        return false;
+    }
+    return rsa_ledger_prepare(ledger, envelopes, count, close_time, results, &candidate) &&
+           rsa_ledger_apply(ledger, &candidate);
+}
+
+// READS
+// -----
+
+bool rsa_ledger_get_account(const rsa_ledger_t *ledger, const uint32_t account_id[8],
+                            rsa_account_t *account) {
+    if (!ledger || !account_id || !account) return false;
+    uint32_t row = account_row(ledger, account_id);
+    return row != RSA_ACCOUNT_NO_INDEX && rsa_account_soa_get(&ledger->accounts, row, account);
+}
+
+bool rsa_ledger_get_trustline(const rsa_ledger_t *ledger, const uint32_t account_id[8],
+                              const rsa_asset_t *asset, rsa_trustline_t *trustline) {
+    if (!ledger || !account_id || !asset || !trustline) return false;
+    uint32_t asset_id = rsa_asset_lookup(&ledger->assets, asset);
+    if (asset_id == RSA_ASSET_INVALID_ID) return false;
+    ledger_image_t image;
+    if (!entry_image(ledger, account_id, asset_id, &image)) return false;
+    *trustline = image.trustline;
+    return true;
+}
+
+// NAMES
+// -----
+
+const char *rsa_ledger_phase_str(rsa_ledger_phase_t phase) {
+    switch (phase) {
+        case RSA_LEDGER_PHASE_VALIDATE: return "validate";
+        case RSA_LEDGER_PHASE_APPLY:    return "apply";
+        case RSA_LEDGER_PHASE_HASH:     return "hash";
+        case RSA_LEDGER_PHASE_COMMIT:   return "commit";
+        default:                        return "unknown";
+    }
+}
+
+const char *rsa_tx_result_str(rsa_tx_result_code_t code) {
+    switch (code) {
+        case RSA_TX_RESULT_SUCCESS:              return "SUCCESS";
+        case RSA_TX_RESULT_FAILED:               return "FAILED";
+        case RSA_TX_RESULT_INVALID:              return "INVALID";
+        case RSA_TX_RESULT_NO_ACCOUNT:           return "NO_ACCOUNT";
+        case RSA_TX_RESULT_BAD_SEQ:              return "BAD_SEQ";
+        case RSA_TX_RESULT_INSUFFICIENT_BALANCE: return "INSUFFICIENT_BALANCE";
+        default:                                 return "UNKNOWN";
+    }
+}
+
+const char *rsa_op_result_str(rsa_op_result_code_t code) {
+    switch (code) {
+        case RSA_OP_RESULT_SUCCESS:          return "SUCCESS";
+        case RSA_OP_RESULT_NOT_APPLIED:      return "NOT_APPLIED";
+        case RSA_OP_RESULT_NO_ACCOUNT:       return "NO_ACCOUNT";
+        case RSA_OP_RESULT_UNDERFUNDED:      return "UNDERFUNDED";
+        case RSA_OP_RESULT_LOW_RESERVE:      return "LOW_RESERVE";
+        case RSA_OP_RESULT_NO_DESTINATION:   return "NO_DESTINATION";
+        case RSA_OP_RESULT_ALREADY_EXISTS:   return "ALREADY_EXISTS";
+        case RSA_OP_RESULT_NO_TRUST:         return "NO_TRUST";
+        case RSA_OP_RESULT_NOT_AUTHORIZED:   return "NOT_AUTHORIZED";
+        case RSA_OP_RESULT_LINE_FULL:        return "LINE_FULL";
+        case RSA_OP_RESULT_NO_ISSUER:        return "NO_ISSUER";
+        case RSA_OP_RESULT_INVALID_LIMIT:    return "INVALID_LIMIT";
+        case RSA_OP_RESULT_HAS_SUB_ENTRIES:  return "HAS_SUB_ENTRIES";
+        case RSA_OP_RESULT_MALFORMED:        return "MALFORMED";
+        case RSA_OP_RESULT_NOT_SUPPORTED:    return "NOT_SUPPORTED";
+        case RSA_OP_RESULT_INTERNAL_ERROR:   return "INTERNAL_ERROR";
+        case RSA_OP_RESULT_BAD_AUTH:         return "BAD_AUTH";
+        default:                             return "UNKNOWN";
+    }
+}
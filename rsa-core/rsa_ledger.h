@@ -0,0 +1,270 @@
+#ifndef RSA_LEDGER_H
+#define RSA_LEDGER_H
+
+#include "rsa_token.h"
+#include "rsa_account_soa.h"
+#include "rsa_account_store.h"
+#include "rsa_arena.h"
+#include "rsa_asset_intern.h"
+#include "rsa_merkle.h"
+#include "rsa_mvcc.h"
+#include "rsa_trustline_store.h"
+#include "rsa_txset.h"
+#include "rsa_wal.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LEDGER CLOSE
+// ============
+// Applies an agreed transaction set to the ledger state and produces the
+// next rsa_ledger_header_t, chained to the last closed one by hash:
+//
+//   validate  stateless checks of every envelope (rsa_validate_tx_envelope)
+//   apply     per transaction: source, sequence and fee, then operations;
+//             a failing operation rolls the whole transaction back, the
+//             fee and sequence number stay consumed
+//   hash      dirtied entries into the state tree, result set, header
+//   commit    optional write-ahead log records (changes, then the header),
+//             then the header is installed
+//
+// Phase times are kept per close and added to the monitor.
+//
+// Close reuses its scratch buffers (touch sets, undo logs, segment plans,
+// merge refs, log batches) from one ledger to the next, sized by the
+// largest close so far, so apply allocates nothing per transaction. The
+// only per-close objects are the determinism shadow's copy of the results,
+// taken from `arena` (rsa_arena.h); it is reset when the next close starts
+// applying, so they stay readable until then.
+//
+// State: account rows live in rsa_account_soa_t (authoritative) with the
+// account store as the id -> row index; credit balances live in the
+// trustline store under interned asset ids. Offers, data entries, path
+// payments and inflation have no store yet, so those operations fail with
+// RSA_OP_RESULT_NOT_SUPPORTED.
+//
+// Authorization: the envelope signature stands for the transaction source
+// only, and signers and thresholds are not checked yet, so every operation
+// acts for the transaction source. A payment whose `from` names another
+// account fails with RSA_OP_RESULT_BAD_AUTH; a zero `from` means the
+// source.
+//
+// Parallel apply: each transaction's footprint is the set of accounts its
+// fee and operations name (source, destinations, trustors; trustlines belong to their account). Transactions sharing an
+// account are joined into one conflict group, applied in set order by a
+// single worker; groups run concurrently, claimed largest first. Operations
+// that change shared structure (create_account, account_merge,
+// change_trust, set_options) cannot be footprinted that way and run alone,
+// splitting the set into parallel segments around them. Touched entries
+// are merged back in set order, so state, results, hashes and the log
+// record are identical to serial apply. `check_determinism` proves it on
+// every close by also applying the set serially to a shadow copy of the
+// state and comparing header hashes before commit.
+//
+// Readers: with mvcc stores configured (rsa_mvcc.h, both on one domain),
+// the hash phase stages every dirtied account and trustline there, or its
+// erasure, and commit publishes the domain once the header is installed, so
+// views follow closed ledgers without touching apply state. The domain
+// starts at the last closed ledger (0 before genesis); a close whose
+// sequence does not follow its published ledger fails.
+//
+// Persistence: with a log, every close is durable once it returns; the
+// log's close record carries the header. With a snapshot_dir, every
+// snapshot_interval-th ledger is also written there once committed
+// (rsa_snapshot.h, header included), then older snapshots and the log
+// segments it covers are removed. The write is synchronous and counts as
+// commit time; a failed one raises an alert but the close stands.
+// rsa_ledger_open() restarts from the newest snapshot plus every ledger
+// the log closed after it, checking the state tree it rebuilds against
+// the last header's state hash.
+//
+// Transaction hashes cover the transaction and operation structs as laid
+// out in memory, like rsa_hash_transaction(): envelopes must be
+// zero-initialized so padding is deterministic.
+//
+// Not thread-safe; rsa_ledger_close() manages its own workers, one pool of
+// threads (rsa_worker_pool.h) started at init and shared by apply segments
+// and the state tree update.
+
+#define RSA_LEDGER_VERSION 1
+#define RSA_LEDGER_GENESIS_SEQ 1
+#define RSA_LEDGER_STROOPS_PER_UNIT 10000000LL              // RSA_TOKEN_DECIMALS
+#define RSA_LEDGER_TOTAL_COINS (RSA_TOKEN_TOTAL_SUPPLY * RSA_LEDGER_STROOPS_PER_UNIT)
+
+#define RSA_LEDGER_MAX_APPLY_THREADS 16
+#define RSA_LEDGER_MIN_PARALLEL_TXS 64     // shorter segments are applied inline
+#define RSA_LEDGER_SNAPSHOT_INTERVAL 64    // ledgers, stellar-core's checkpoint frequency
+
+// Skip list refresh periods (ledgers), as in stellar-core
+#define RSA_LEDGER_SKIP_1 50
+#define RSA_LEDGER_SKIP_2 5000
+#define RSA_LEDGER_SKIP_3 50000
+#define RSA_LEDGER_SKIP_4 500000
+
+typedef enum {
+    RSA_LEDGER_PHASE_VALIDATE = 0,
+    RSA_LEDGER_PHASE_APPLY,
+    RSA_LEDGER_PHASE_HASH,
+    RSA_LEDGER_PHASE_COMMIT,
+    RSA_LEDGER_PHASE_COUNT
+} rsa_ledger_phase_t;
+
+_Static_assert(RSA_LEDGER_PHASE_COUNT <= RSA_MONITOR_LEDGER_PHASES,
+               "rsa_ops_monitor_t.ledger_phase_ns is too small");
+
+typedef enum {
+    RSA_TX_RESULT_SUCCESS = 0,
+    RSA_TX_RESULT_FAILED,               // an operation failed; fee charged, effects undone
+    RSA_TX_RESULT_INVALID,              // rejected by validation; see `validation`
+    RSA_TX_RESULT_NO_ACCOUNT,
+    RSA_TX_RESULT_BAD_SEQ,
+    RSA_TX_RESULT_INSUFFICIENT_BALANCE, // cannot pay the fee
+    RSA_TX_RESULT_COUNT
+} rsa_tx_result_code_t;
+
+typedef enum {
+    RSA_OP_RESULT_SUCCESS = 0,
+    RSA_OP_RESULT_NOT_APPLIED,          // an earlier operation of the transaction failed
+    RSA_OP_RESULT_NO_ACCOUNT,           // operation source is gone (merged)
+    RSA_OP_RESULT_UNDERFUNDED,
+    RSA_OP_RESULT_LOW_RESERVE,
+    RSA_OP_RESULT_NO_DESTINATION,
+    RSA_OP_RESULT_ALREADY_EXISTS,
+    RSA_OP_RESULT_NO_TRUST,
+    RSA_OP_RESULT_NOT_AUTHORIZED,
+    RSA_OP_RESULT_LINE_FULL,
+    RSA_OP_RESULT_NO_ISSUER,
+    RSA_OP_RESULT_INVALID_LIMIT,
+    RSA_OP_RESULT_HAS_SUB_ENTRIES,
+    RSA_OP_RESULT_MALFORMED,
+    RSA_OP_RESULT_NOT_SUPPORTED,
+    RSA_OP_RESULT_INTERNAL_ERROR,       // allocation failure; the close fails
+    RSA_OP_RESULT_BAD_AUTH,             // payment.from is not the transaction source
+    RSA_OP_RESULT_COUNT
+} rsa_op_result_code_t;
+
+typedef struct {
+    uint8_t tx_hash[32];
+    int64_t fee_charged;
+    uint32_t code;                      // rsa_tx_result_code_t
+    uint32_t validation;                // rsa_validation_result_t, for INVALID
+    uint32_t op_count;
+    uint8_t op_results[RSA_MAX_OPERATIONS_PER_TX];  // rsa_op_result_code_t
+} rsa_tx_result_t;
+
+typedef struct {
+    uint32_t base_fee;                  // 0 = RSA_BASE_FEE (per operation)
+    uint32_t base_reserve;              // 0 = RSA_BASE_RESERVE
+    uint32_t max_tx_set_size;           // 0 = RSA_MAX_TX_SET_SIZE
+    size_t account_capacity;            // initial sizing hints
+    size_t trustline_capacity;
+    unsigned hash_threads;              // state tree workers, 0/1 = inline
+    unsigned apply_threads;             // transaction apply workers, 0/1 = serial
+    bool check_determinism;             // also apply serially on a shadow state and compare
+    bool verify_signatures;             // re-verify envelopes while validating
+    bool arena_huge_pages;              // back `arena` with 2 MB pages
+    rsa_wal_t *wal;                     // optional, opened by the caller
+    const char *snapshot_dir;           // optional, must exist (see above)
+    uint32_t snapshot_interval;         // 0 = RSA_LEDGER_SNAPSHOT_INTERVAL
+    rsa_mvcc_store_t *mvcc_accounts;    // optional reader copies, one domain (see above)
+    rsa_mvcc_store_t *mvcc_trustlines;
+} rsa_ledger_config_t;
+
+typedef struct rsa_ledger_scratch rsa_ledger_scratch_t;
+
+typedef struct {
+    rsa_ledger_config_t config;
+
+    // State
+    rsa_account_soa_t accounts;
+    rsa_account_store_t account_index;  // id -> row; hot fields are not maintained
+    rsa_trustline_store_t trustlines;
+    rsa_asset_table_t assets;
+    rsa_merkle_tree_t state_tree;
+
+    // Last closed ledger
+    rsa_ledger_header_t header;
+    uint8_t header_hash[32];
+
+    rsa_ledger_scratch_t *scratch;      // per-close buffers
+    rsa_arena_t arena;                  // shadow results, reset as the next close applies
+    uint64_t phase_ns[RSA_LEDGER_PHASE_COUNT];  // last close
+    size_t apply_groups;                // conflict groups applied in parallel, last close
+} rsa_ledger_t;
+
+// `config` may be NULL for defaults. The state is empty until genesis.
+bool rsa_ledger_init(rsa_ledger_t *ledger, const rsa_ledger_config_t *config);
+void rsa_ledger_free(rsa_ledger_t *ledger);
+
+// Init, then the state and last closed header of the newest snapshot in
+// config->snapshot_dir (optional), replaying the changes of every later
+// ledger with a durable close record in the log at wal_dir (optional,
+// not open yet: open config->wal there afterwards, before closing). With
+// neither holding a ledger the state is empty, as after init. Reader
+// stores must be empty, on a domain at ledger 0: it is restarted at the
+// restored ledger. False (ledger freed) on an unreadable snapshot or log,
+// or a state that does not hash to the last header.
+bool rsa_ledger_open(rsa_ledger_t *ledger, const rsa_ledger_config_t *config,
+                     const char *wal_dir);
+
+// Closes ledger RSA_LEDGER_GENESIS_SEQ: the root account holds every coin
+bool rsa_ledger_genesis(rsa_ledger_t *ledger, const uint32_t root_account[8], uint64_t close_time);
+
+// Closes the next ledger with envelopes[0..count) applied in order.
+// results[i] (count entries) receives each transaction's outcome. False
+// on a malformed set (too large, close time going backwards) with the
+// state untouched, or on allocation / log failure, after which the ledger
+// must be reopened from disk (rsa_ledger_open).
+bool rsa_ledger_close(rsa_ledger_t *ledger, const rsa_tx_envelope_ref_t *envelopes, size_t count,
+                      uint64_t close_time, rsa_tx_result_t *results);
+
+// Split close
+// -----------
+// rsa_ledger_close() is prepare then apply. Prepare is the validate phase
+// (hashing, signatures, stateless checks) and reads only the ledger's
+// configuration, so it may run on another thread while earlier candidates
+// are applied (rsa_ledger_pipeline.h). Apply redoes nothing stateless.
+// Prepare sets base_fee to the configured one; the set builder's surge
+// price (rsa_mempool.h) may raise it, never lower it. The header records
+// the base fee each ledger charged.
+
+// A set through the validate phase; envelopes and results stay the caller's
+typedef struct {
+    const rsa_tx_envelope_ref_t *envelopes;
+    size_t count;
+    uint64_t close_time;
+    rsa_tx_result_t *results;           // validation and tx hashes filled in
+    uint32_t base_fee;                  // charged per operation; a surge-priced set raises it
+    uint8_t tx_set_hash[32];
+    uint64_t validate_ns;
+} rsa_ledger_candidate_t;
+
+// False only when the set is larger than max_tx_set_size
+bool rsa_ledger_prepare(const rsa_ledger_t *ledger, const rsa_tx_envelope_ref_t *envelopes,
+                        size_t count, uint64_t close_time, rsa_tx_result_t *results,
+                        rsa_ledger_candidate_t *candidate);
+// Apply, hash and commit phases of the next ledger; failures as for close
+bool rsa_ledger_apply(rsa_ledger_t *ledger, const rsa_ledger_candidate_t *candidate);
+
+// Canonical header hash (fields in order, no padding)
+void rsa_ledger_header_hash(const rsa_ledger_header_t *header, uint8_t hash[32]);
+// rsa_tx_result_t.tx_hash: the transaction and its operations
+void rsa_ledger_tx_hash(const rsa_tx_envelope_ref_t *envelope, uint8_t hash[32]);
+
+// Reads of the current state
+bool rsa_ledger_get_account(const rsa_ledger_t *ledger, const uint32_t account_id[8],
+                            rsa_account_t *account);
+bool rsa_ledger_get_trustline(const rsa_ledger_t *ledger, const uint32_t account_id[8],
+                              const rsa_asset_t *asset, rsa_trustline_t *trustline);
+
+const char *rsa_ledger_phase_str(rsa_ledger_phase_t phase);
+const char *rsa_tx_result_str(rsa_tx_result_code_t code);
+const char *rsa_op_result_str(rsa_op_result_code_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_LEDGER_H
@@ -0,0 +1,157 @@
+#include "rsa_ledger_pipeline.h"
+#include <stdlib.h>
+#include <string.h>
+
+// PIPELINED LEDGER CLOSE
+// ======================
+
+static void *prepare_stage(void *arg) {
+    rsa_ledger_pipeline_t *pipeline = arg;
+    pthread_mutex_lock(&pipeline->mutex);
+    for (;;) {
+        while (!pipeline->stopping && pipeline->prepared == pipeline->submitted) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->mutex);
+        }
+        if (pipeline->prepared == pipeline->submitted) break;
+        rsa_ledger_pipeline_slot_t *slot = &pipeline->slots[pipeline->prepared % pipeline->depth];
+        pthread_mutex_unlock(&pipeline->mutex);
+
+        // Reads only the ledger's configuration, so apply may be running
+        bool ok = rsa_ledger_prepare(pipeline->ledger, slot->envelopes, slot->count,
+                                     slot->close_time, slot->results, &slot->candidate);
+        if (ok && slot->base_fee) slot->candidate.base_fee = slot->base_fee;
+
+        pthread_mutex_lock(&pipeline->mutex);
+        slot->ok = ok;
+        pipeline->prepared++;
+        pthread_cond_broadcast(&pipeline->changed);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+    return NULL;
+}
+
+static void *apply_stage(void *arg) {
+    rsa_ledger_pipeline_t *pipeline = arg;
+    rsa_ledger_t *ledger = pipeline->ledger;
+    pthread_mutex_lock(&pipeline->mutex);
+    for (;;) {
+        while (pipeline->applied == pipeline->prepared &&
+               !(pipeline->stopping && pipeline->prepared == pipeline->submitted)) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->mutex);
+        }
+        if (pipeline->applied == pipeline->prepared) break;
+        rsa_ledger_pipeline_slot_t *slot = &pipeline->slots[pipeline->applied % pipeline->depth];
+        bool apply = slot->ok && !pipeline->failed;
+        pthread_mutex_unlock(&pipeline->mutex);
+
+        bool ok = apply && rsa_ledger_apply(ledger, &slot->candidate);
+        if (ok) {
+            slot->ledger_seq = ledger->header.ledger_seq;
+            memcpy(slot->phase_ns, ledger->phase_ns, sizeof(slot->phase_ns));
+        }
+
+        pthread_mutex_lock(&pipeline->mutex);
+        slot->ok = ok;
+        if (!ok) pipeline->failed = true;
+        pipeline->applied++;
+        pthread_cond_broadcast(&pipeline->changed);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+    return NULL;
+}
+
+bool rsa_ledger_pipeline_start(rsa_ledger_pipeline_t *pipeline, rsa_ledger_t *ledger, size_t depth) {
+    if (!pipeline || !ledger) return false;
+
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->ledger = ledger;
+    pipeline->depth = depth ? depth : RSA_LEDGER_PIPELINE_DEPTH;
+    pipeline->slots = calloc(pipeline->depth, sizeof(*pipeline->slots));
+    if (!pipeline->slots) return false;
+
+    pthread_mutex_init(&pipeline->mutex, NULL);
+    pthread_cond_init(&pipeline->changed, NULL);
+    if (pthread_create(&pipeline->prepare_thread, NULL, prepare_stage, pipeline) != 0) {
+        goto fail;
+    }
+    if (pthread_create(&pipeline->apply_thread, NULL, apply_stage, pipeline) != 0) {
+        pthread_mutex_lock(&pipeline->mutex);
+        pipeline->stopping = true;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->mutex);
+        pthread_join(pipeline->prepare_thread, NULL);
+        goto fail;
+    }
+    return true;
+
+fail:
+    pthread_cond_destroy(&pipeline->changed);
+    pthread_mutex_destroy(&pipeline->mutex);
+    free(pipeline->slots);
+    memset(pipeline, 0, sizeof(*pipeline));
+    return false;
+}
+
+void rsa_ledger_pipeline_stop(rsa_ledger_pipeline_t *pipeline) {
+    if (!pipeline || !pipeline->slots) return;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->stopping = true;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->mutex);
+    pthread_join(pipeline->prepare_thread, NULL);
+    pthread_join(pipeline->apply_thread, NULL);
+
+    pthread_cond_destroy(&pipeline->changed);
+    pthread_mutex_destroy(&pipeline->mutex);
+    free(pipeline->slots);
+    memset(pipeline, 0, sizeof(*pipeline));
+}
+
+bool rsa_ledger_pipeline_submit(rsa_ledger_pipeline_t *pipeline,
+                                const rsa_tx_envelope_ref_t *envelopes, size_t count,
+                                uint64_t close_time, uint32_t base_fee,
+                                rsa_tx_result_t *results, void *user) {
+    if (!pipeline || !pipeline->slots || (count > 0 && (!envelopes || !results))) return false;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    while (pipeline->submitted - pipeline->retired == pipeline->depth) {
+        pthread_cond_wait(&pipeline->changed, &pipeline->mutex);
+    }
+    rsa_ledger_pipeline_slot_t *slot = &pipeline->slots[pipeline->submitted % pipeline->depth];
+    memset(slot, 0, sizeof(*slot));
+    slot->envelopes = envelopes;
+    slot->count = count;
+    slot->close_time = close_time;
+    slot->base_fee = base_fee;
+    slot->results = results;
+    slot->user = user;
+    pipeline->submitted++;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->mutex);
+    return true;
+}
+
+bool rsa_ledger_pipeline_wait(rsa_ledger_pipeline_t *pipeline, rsa_ledger_completion_t *completion) {
+    if (!pipeline || !pipeline->slots || !completion) return false;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    if (pipeline->retired == pipeline->submitted) {
+        pthread_mutex_unlock(&pipeline->mutex);
+        return false;
+    }
+    while (pipeline->retired == pipeline->applied) {
+        pthread_cond_wait(&pipeline->changed, &pipeline->mutex);
+    }
+    const rsa_ledger_pipeline_slot_t *slot = &pipeline->slots[pipeline->retired % pipeline->depth];
+    completion->user = slot->user;
+    completion->results = slot->results;
+    completion->count = slot->count;
+    completion->closed = slot->ok;
+    completion->ledger_seq = slot->ok ? slot->ledger_seq : 0;
+    memcpy(completion->phase_ns, slot->phase_ns, sizeof(completion->phase_ns));
+    pipeline->retired++;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->mutex);
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef RSA_LEDGER_PIPELINE_H
+#define RSA_LEDGER_PIPELINE_H
+
+#include "rsa_token.h"
+#include "rsa_ledger.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PIPELINED LEDGER CLOSE
+// ======================
+// Overlaps the validate phase of upcoming transaction sets (hashing,
+// signature verification, stateless checks) with apply, hash and commit of
+// the current one:
+//
+//   submit -> prepare thread -> apply thread -> wait
+//
+// Sets move through a ring of `depth` slots with one cursor per stage, so
+// each hand-off is a bounded queue: submit blocks while `depth` sets are
+// in flight, and the prepare stage runs at most that far ahead of apply.
+// State-dependent checks (source account, sequence number, fee balance)
+// are made by apply against the state the set actually lands on.
+//
+// Sets close exactly as rsa_ledger_close() would close them, in
+// submission order. The close time of a set is fixed at submission since
+// validation checks time bounds against it. After a failed prepare or
+// apply the remaining sets complete without closing: the state needs the
+// same recovery as after a failed rsa_ledger_close().
+//
+// One submitting and one waiting thread (they may be the same). The
+// ledger must not be used directly while the pipeline runs.
+
+#define RSA_LEDGER_PIPELINE_DEPTH 2
+
+typedef struct {
+    // Submitted; envelopes and results stay the caller's until completion
+    const rsa_tx_envelope_ref_t *envelopes;
+    size_t count;
+    uint64_t close_time;
+    uint32_t base_fee;
+    rsa_tx_result_t *results;
+    void *user;
+
+    rsa_ledger_candidate_t candidate;
+    bool ok;
+    uint32_t ledger_seq;
+    uint64_t phase_ns[RSA_LEDGER_PHASE_COUNT];
+} rsa_ledger_pipeline_slot_t;
+
+typedef struct {
+    void *user;
+    rsa_tx_result_t *results;
+    size_t count;
+    bool closed;
+    uint32_t ledger_seq;                // when closed
+    uint64_t phase_ns[RSA_LEDGER_PHASE_COUNT];
+} rsa_ledger_completion_t;
+
+typedef struct {
+    rsa_ledger_t *ledger;
+    rsa_ledger_pipeline_slot_t *slots;
+    size_t depth;
+
+    // Stage cursors, monotonic; slot = cursor % depth
+    uint64_t submitted;
+    uint64_t prepared;
+    uint64_t applied;
+    uint64_t retired;
+    bool stopping;
+    bool failed;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    pthread_t prepare_thread;
+    pthread_t apply_thread;
+} rsa_ledger_pipeline_t;
+
+// `depth` 0 = RSA_LEDGER_PIPELINE_DEPTH; 2 already overlaps neighbours
+bool rsa_ledger_pipeline_start(rsa_ledger_pipeline_t *pipeline, rsa_ledger_t *ledger, size_t depth);
+// Finishes the sets in flight, then joins the stages. Completions not
+// waited for are dropped.
+void rsa_ledger_pipeline_stop(rsa_ledger_pipeline_t *pipeline);
+
+// Queues the next set; blocks while the pipeline is full. `base_fee` is
+// the set's surge price, 0 for the ledger's base fee.
+bool rsa_ledger_pipeline_submit(rsa_ledger_pipeline_t *pipeline,
+                                const rsa_tx_envelope_ref_t *envelopes, size_t count,
+                                uint64_t close_time, uint32_t base_fee,
+                                rsa_tx_result_t *results, void *user);
+// Oldest submitted set, once applied. False when nothing is in flight.
+bool rsa_ledger_pipeline_wait(rsa_ledger_pipeline_t *pipeline, rsa_ledger_completion_t *completion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_LEDGER_PIPELINE_H
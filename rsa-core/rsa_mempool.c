@@ -0,0 +1,914 @@
+#include "rsa_mempool.h"
+#include "rsa_clock.h"
+#include <stdlib.h>
+#include <string.h>
+
+// PENDING TRANSACTION POOL
+// ========================
+
+#define MEMPOOL_MIN_ENTRIES 64
+#define MEMPOOL_MIN_SLOTS 64
+#define MEMPOOL_FULL ((rsa_mempool_result_t)RSA_MEMPOOL_RESULT_COUNT)  // internal: evict, then retry
+
+// Keyed hash of a 32-byte key (account id or tx hash); the high half picks
+// the shard, the low half keys the shard's maps
+static inline uint64_t mempool_hash(const rsa_mempool_t *pool, const void *key) {
+    return rsa_hash_32(&pool->key, key);
+}
+
+static inline rsa_mempool_shard_t *mempool_shard(rsa_mempool_t *pool, uint64_t account_hash) {
+    return &pool->shards[(account_hash >> 32) % RSA_MEMPOOL_SHARDS];
+}
+
+// RANKING
+// -------
+
+typedef struct {
+    uint64_t fee;
+    uint64_t ops;
+    uint64_t arrival;
+} mempool_rank_t;
+
+static inline mempool_rank_t item_rank(const rsa_mempool_heap_item_t *item) {
+    return (mempool_rank_t){item->fee, item->ops, item->arrival};
+}
+
+// Higher fee per operation first, then earlier arrival
+static inline bool rank_better(mempool_rank_t a, mempool_rank_t b) {
+    uint64_t left = a.fee * b.ops;
+    uint64_t right = b.fee * a.ops;
+    if (left != right) return left > right;
+    return a.arrival < b.arrival;
+}
+
+// MAPS
+// ----
+
+static bool map_reserve(rsa_mempool_map_t *map, size_t count) {
+    size_t capacity = MEMPOOL_MIN_SLOTS;
+    while (capacity < count * 2) capacity <<= 1;
+    if (map->slots && capacity <= map->mask + 1) return true;
+
+    rsa_mempool_map_slot_t *slots = calloc(capacity, sizeof(*slots));
+    if (!slots) return false;
+    size_t mask = capacity - 1;
+    for (size_t i = 0; map->slots && i <= map->mask; i++) {
+        if (!map->slots[i].index) continue;
+        size_t pos = map->slots[i].hash & mask;
+        while (slots[pos].index) pos = (pos + 1) & mask;
+        slots[pos] = map->slots[i];
+    }
+    free(map->slots);
+    map->slots = slots;
+    map->mask = mask;
+    return true;
+}
+
+static void map_insert(rsa_mempool_map_t *map, uint32_t hash, uint32_t index) {
+    size_t pos = hash & map->mask;
+    while (map->slots[pos].index) pos = (pos + 1) & map->mask;
+    map->slots[pos] = (rsa_mempool_map_slot_t){hash, index + 1};
+    map->count++;
+}
+
+static void map_erase(rsa_mempool_map_t *map, uint32_t hash, uint32_t index) {
+    size_t mask = map->mask;
+    size_t hole = hash & mask;
+    while (map->slots[hole].index != index + 1) hole = (hole + 1) & mask;
+
+    // Backward shift: pull later members of the run into the hole unless
+    // that would move them before their home slot
+    for (size_t pos = (hole + 1) & mask; map->slots[pos].index; pos = (pos + 1) & mask) {
+        size_t home = map->slots[pos].hash & mask;
+        if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+            map->slots[hole] = map->slots[pos];
+            hole = pos;
+        }
+    }
+    map->slots[hole] = (rsa_mempool_map_slot_t){0, 0};
+    map->count--;
+}
+
+static uint32_t find_tx(const rsa_mempool_shard_t *shard, uint32_t hash, const uint8_t tx_hash[32]) {
+    const rsa_mempool_map_t *map = &shard->by_hash;
+    if (!map->slots) return RSA_MEMPOOL_NONE;
+    for (size_t pos = hash & map->mask; map->slots[pos].index; pos = (pos + 1) & map->mask) {
+        uint32_t index = map->slots[pos].index - 1;
+        if (map->slots[pos].hash == hash && memcmp(shard->entries[index].hash, tx_hash, 32) == 0) {
+            return index;
+        }
+    }
+    return RSA_MEMPOOL_NONE;
+}
+
+static uint32_t find_account(const rsa_mempool_shard_t *shard, uint32_t hash,
+                             const uint32_t account_id[8]) {
+    const rsa_mempool_map_t *map = &shard->by_account;
+    if (!map->slots) return RSA_MEMPOOL_NONE;
+    for (size_t pos = hash & map->mask; map->slots[pos].index; pos = (pos + 1) & map->mask) {
+        uint32_t index = map->slots[pos].index - 1;
+        if (map->slots[pos].hash == hash &&
+            memcmp(shard->accounts[index].account_id, account_id, 32) == 0) {
+            return index;
+        }
+    }
+    return RSA_MEMPOOL_NONE;
+}
+
+// HEAPS
+// -----
+// Binary heaps over entries; every entry records its position so any
+// entry can be removed or re-ranked in O(log n)
+
+static inline bool heap_above(int id, const rsa_mempool_heap_item_t *a,
+                              const rsa_mempool_heap_item_t *b) {
+    return id == RSA_MEMPOOL_HEAP_HEADS ? rank_better(item_rank(a), item_rank(b))
+                                        : rank_better(item_rank(b), item_rank(a));
+}
+
+static inline void heap_set(rsa_mempool_shard_t *shard, int id, size_t pos,
+                            const rsa_mempool_heap_item_t *item) {
+    shard->heaps[id].items[pos] = *item;
+    shard->entries[item->entry].heap_pos[id] = (uint32_t)pos;
+}
+
+static void heap_sift_up(rsa_mempool_shard_t *shard, int id, size_t pos) {
+    rsa_mempool_heap_item_t *items = shard->heaps[id].items;
+    rsa_mempool_heap_item_t item = items[pos];
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (!heap_above(id, &item, &items[parent])) break;
+        heap_set(shard, id, pos, &items[parent]);
+        pos = parent;
+    }
+    heap_set(shard, id, pos, &item);
+}
+
+static void heap_sift_down(rsa_mempool_shard_t *shard, int id, size_t pos) {
+    rsa_mempool_heap_t *heap = &shard->heaps[id];
+    rsa_mempool_heap_item_t item = heap->items[pos];
+    for (;;) {
+        size_t child = 2 * pos + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap_above(id, &heap->items[child + 1], &heap->items[child])) {
+            child++;
+        }
+        if (!heap_above(id, &heap->items[child], &item)) break;
+        heap_set(shard, id, pos, &heap->items[child]);
+        pos = child;
+    }
+    heap_set(shard, id, pos, &item);
+}
+
+static inline rsa_mempool_heap_item_t heap_item(const rsa_mempool_shard_t *shard, uint32_t index) {
+    const rsa_mempool_entry_t *entry = &shard->entries[index];
+    return (rsa_mempool_heap_item_t){entry->tx.fee, entry->arrival, entry->tx.operations_count,
+                                     index};
+}
+
+// Capacity is reserved by shard_reserve()
+static void heap_insert(rsa_mempool_shard_t *shard, int id, uint32_t index) {
+    size_t pos = shard->heaps[id].count++;
+    rsa_mempool_heap_item_t item = heap_item(shard, index);
+    heap_set(shard, id, pos, &item);
+    heap_sift_up(shard, id, pos);
+}
+
+static void heap_remove(rsa_mempool_shard_t *shard, int id, uint32_t index) {
+    rsa_mempool_heap_t *heap = &shard->heaps[id];
+    size_t pos = shard->entries[index].heap_pos[id];
+    shard->entries[index].heap_pos[id] = RSA_MEMPOOL_NONE;
+    rsa_mempool_heap_item_t last = heap->items[--heap->count];
+    if (pos < heap->count) {
+        heap_set(shard, id, pos, &last);
+        heap_sift_up(shard, id, pos);
+        heap_sift_down(shard, id, shard->entries[last.entry].heap_pos[id]);
+    }
+}
+
+// After the entry's bid changed
+static void heap_update(rsa_mempool_shard_t *shard, int id, uint32_t index) {
+    size_t pos = shard->entries[index].heap_pos[id];
+    shard->heaps[id].items[pos] = heap_item(shard, index);
+    heap_sift_up(shard, id, pos);
+    heap_sift_down(shard, id, shard->entries[index].heap_pos[id]);
+}
+
+static inline uint32_t heap_top(const rsa_mempool_shard_t *shard, int id) {
+    return shard->heaps[id].count ? shard->heaps[id].items[0].entry : RSA_MEMPOOL_NONE;
+}
+
+// SHARDS
+// ------
+
+// Room for one more entry and queue, so the insert that follows cannot fail
+static bool shard_reserve(rsa_mempool_shard_t *shard) {
+    if (shard->entry_free == RSA_MEMPOOL_NONE) {
+        uint32_t capacity = shard->entry_capacity ? shard->entry_capacity * 2 : MEMPOOL_MIN_ENTRIES;
+        rsa_mempool_entry_t *entries = realloc(shard->entries, capacity * sizeof(*entries));
+        if (!entries) return false;
+        for (uint32_t i = capacity; i-- > shard->entry_capacity;) {
+            entries[i].operations = NULL;
+            entries[i].next = shard->entry_free;
+            shard->entry_free = i;
+        }
+        shard->entries = entries;
+        shard->entry_capacity = capacity;
+    }
+    if (shard->account_free == RSA_MEMPOOL_NONE) {
+        uint32_t capacity = shard->account_capacity ? shard->account_capacity * 2 : MEMPOOL_MIN_ENTRIES;
+        rsa_mempool_account_t *accounts = realloc(shard->accounts, capacity * sizeof(*accounts));
+        if (!accounts) return false;
+        for (uint32_t i = capacity; i-- > shard->account_capacity;) {
+            accounts[i].head = shard->account_free;
+            shard->account_free = i;
+        }
+        shard->accounts = accounts;
+        shard->account_capacity = capacity;
+    }
+    // Heaps and wheels cover every entry slot, so a queue head released
+    // from parking always has room in the head heap
+    for (int id = 0; id < RSA_MEMPOOL_HEAP_COUNT; id++) {
+        rsa_mempool_heap_t *heap = &shard->heaps[id];
+        if (heap->capacity >= shard->entry_capacity) continue;
+        rsa_mempool_heap_item_t *items = realloc(heap->items, shard->entry_capacity * sizeof(*items));
+        if (!items) return false;
+        heap->items = items;
+        heap->capacity = shard->entry_capacity;
+    }
+    return rsa_timer_wheel_reserve(&shard->expiry, shard->entry_capacity) &&
+           rsa_timer_wheel_reserve(&shard->parked, shard->entry_capacity) &&
+           map_reserve(&shard->by_hash, shard->by_hash.count + 1) &&
+           map_reserve(&shard->by_account, shard->by_account.count + 1);
+}
+
+static void entry_fill(rsa_mempool_entry_t *entry, const rsa_tx_envelope_ref_t *envelope,
+                       const uint8_t hash[32], void *blob, uint64_t arrival) {
+    uint32_t op_count = envelope->tx->operations_count;
+    memcpy(entry->hash, hash, 32);
+    entry->tx = *envelope->tx;
+    entry->operations = blob;
+    memcpy(entry->operations, envelope->operations, op_count * sizeof(rsa_operation_t));
+    entry->has_signature = envelope->public_key && envelope->signature;
+    if (entry->has_signature) {
+        uint8_t *signer = (uint8_t *)(entry->operations + op_count);
+        memcpy(signer, envelope->public_key, RSA_MEMPOOL_PUBLIC_KEY_BYTES);
+        memcpy(signer + RSA_MEMPOOL_PUBLIC_KEY_BYTES, envelope->signature,
+               RSA_MEMPOOL_SIGNATURE_BYTES);
+    }
+    entry->arrival = arrival;
+}
+
+// Queue heads are offered through the head heap unless parked
+static void head_insert(rsa_mempool_shard_t *shard, uint32_t index) {
+    if (!shard->entries[index].parked) heap_insert(shard, RSA_MEMPOOL_HEAP_HEADS, index);
+}
+
+// Arms the entry's timers from its time bounds against the shard's time
+static void entry_schedule(rsa_mempool_shard_t *shard, uint32_t index) {
+    rsa_mempool_entry_t *entry = &shard->entries[index];
+    const rsa_time_bounds_t *bounds = &entry->tx.time_bounds;
+    entry->parked = bounds->min_time > shard->parked.now;
+    if (entry->parked) {
+        rsa_timer_wheel_set(&shard->parked, index, bounds->min_time);
+    } else {
+        rsa_timer_wheel_cancel(&shard->parked, index);
+    }
+    if (bounds->max_time > 0 && bounds->max_time < UINT64_MAX) {
+        rsa_timer_wheel_set(&shard->expiry, index, bounds->max_time + 1);
+    } else {
+        rsa_timer_wheel_cancel(&shard->expiry, index);
+    }
+}
+
+// Removes one entry from the maps, the heaps, the wheels and its queue
+static void shard_unlink(rsa_mempool_t *pool, rsa_mempool_shard_t *shard, uint32_t index) {
+    rsa_mempool_entry_t *entry = &shard->entries[index];
+    rsa_mempool_account_t *account = &shard->accounts[entry->account];
+
+    map_erase(&shard->by_hash, (uint32_t)mempool_hash(pool, entry->hash), index);
+    heap_remove(shard, RSA_MEMPOOL_HEAP_EVICT, index);
+    if (entry->heap_pos[RSA_MEMPOOL_HEAP_HEADS] != RSA_MEMPOOL_NONE) {
+        heap_remove(shard, RSA_MEMPOOL_HEAP_HEADS, index);
+    }
+    rsa_timer_wheel_cancel(&shard->expiry, index);
+    rsa_timer_wheel_cancel(&shard->parked, index);
+
+    if (entry->prev != RSA_MEMPOOL_NONE) {
+        shard->entries[entry->prev].next = entry->next;
+    } else {
+        account->head = entry->next;
+    }
+    if (entry->next != RSA_MEMPOOL_NONE) {
+        shard->entries[entry->next].prev = entry->prev;
+        if (entry->prev == RSA_MEMPOOL_NONE) head_insert(shard, entry->next);
+    } else {
+        account->tail = entry->prev;
+    }
+    if (--account->count == 0) {
+        map_erase(&shard->by_account, (uint32_t)mempool_hash(pool, account->account_id),
+                  entry->account);
+        account->head = shard->account_free;
+        shard->account_free = entry->account;
+    }
+
+    free(entry->operations);
+    entry->operations = NULL;
+    entry->next = shard->entry_free;
+    shard->entry_free = index;
+    shard->count--;
+    __atomic_fetch_sub(&pool->count, 1, __ATOMIC_RELAXED);
+}
+
+// Removes the entry and every later one of its queue, tail first
+static size_t shard_drop_from(rsa_mempool_t *pool, rsa_mempool_shard_t *shard, uint32_t index) {
+    uint32_t account = shard->entries[index].account;
+    size_t dropped = 0;
+    for (;;) {
+        uint32_t tail = shard->accounts[account].tail;
+        shard_unlink(pool, shard, tail);
+        dropped++;
+        if (tail == index) return dropped;
+    }
+}
+
+static rsa_mempool_result_t shard_submit(rsa_mempool_t *pool, rsa_mempool_shard_t *shard,
+                                         const rsa_tx_envelope_ref_t *envelope,
+                                         const uint8_t hash[32], uint64_t account_hash,
+                                         uint64_t account_seq, uint64_t arrival, void **blob) {
+    const rsa_transaction_t *tx = envelope->tx;
+    if (tx->time_bounds.max_time > 0 && shard->expiry.now > tx->time_bounds.max_time) {
+        return RSA_MEMPOOL_EXPIRED;
+    }
+    uint32_t tx_key = (uint32_t)mempool_hash(pool, hash);
+    if (find_tx(shard, tx_key, hash) != RSA_MEMPOOL_NONE) return RSA_MEMPOOL_DUPLICATE;
+
+    uint32_t account = find_account(shard, (uint32_t)account_hash, tx->tx_source_account);
+    uint32_t replace = RSA_MEMPOOL_NONE;
+    if (account != RSA_MEMPOOL_NONE) {
+        const rsa_mempool_account_t *queue = &shard->accounts[account];
+        uint64_t first = shard->entries[queue->head].tx.seq_num;
+        uint64_t last = shard->entries[queue->tail].tx.seq_num;
+        if (!rsa_check_sequence_number(last, tx->seq_num)) {
+            if (tx->seq_num < first || tx->seq_num > last) return RSA_MEMPOOL_BAD_SEQ;
+            replace = queue->head;
+            while (shard->entries[replace].tx.seq_num != tx->seq_num) {
+                replace = shard->entries[replace].next;
+            }
+        } else if (queue->count >= pool->config.max_per_account) {
+            return RSA_MEMPOOL_ACCOUNT_LIMIT;
+        }
+    } else if (!rsa_check_sequence_number(account_seq, tx->seq_num)) {
+        return RSA_MEMPOOL_BAD_SEQ;
+    }
+
+    if (replace != RSA_MEMPOOL_NONE) {
+        rsa_mempool_entry_t *entry = &shard->entries[replace];
+        uint64_t bid = (uint64_t)tx->fee * entry->tx.operations_count * 100;
+        uint64_t needed = (uint64_t)entry->tx.fee * tx->operations_count *
+                          (100 + pool->config.replace_bump_percent);
+        if (bid < needed) return RSA_MEMPOOL_FEE_TOO_LOW;
+
+        bool offered = entry->heap_pos[RSA_MEMPOOL_HEAP_HEADS] != RSA_MEMPOOL_NONE;
+        map_erase(&shard->by_hash, (uint32_t)mempool_hash(pool, entry->hash), replace);
+        free(entry->operations);
+        entry_fill(entry, envelope, hash, *blob, arrival);
+        *blob = NULL;
+        map_insert(&shard->by_hash, tx_key, replace);
+        entry_schedule(shard, replace);
+        heap_update(shard, RSA_MEMPOOL_HEAP_EVICT, replace);
+
+        // The replacement may park a head or release one
+        if (offered && entry->parked) {
+            heap_remove(shard, RSA_MEMPOOL_HEAP_HEADS, replace);
+        } else if (offered) {
+            heap_update(shard, RSA_MEMPOOL_HEAP_HEADS, replace);
+        } else if (shard->accounts[account].head == replace) {
+            head_insert(shard, replace);
+        }
+        __atomic_fetch_add(&pool->replaced, 1, __ATOMIC_RELAXED);
+        return RSA_MEMPOOL_REPLACED;
+    }
+
+    if (__atomic_add_fetch(&pool->count, 1, __ATOMIC_RELAXED) > pool->config.capacity) {
+        __atomic_fetch_sub(&pool->count, 1, __ATOMIC_RELAXED);
+        return MEMPOOL_FULL;
+    }
+    if (!shard_reserve(shard)) {
+        __atomic_fetch_sub(&pool->count, 1, __ATOMIC_RELAXED);
+        return RSA_MEMPOOL_NO_MEMORY;
+    }
+
+    if (account == RSA_MEMPOOL_NONE) {
+        account = shard->account_free;
+        rsa_mempool_account_t *queue = &shard->accounts[account];
+        shard->account_free = queue->head;
+        memcpy(queue->account_id, tx->tx_source_account, 32);
+        queue->head = queue->tail = RSA_MEMPOOL_NONE;
+        queue->count = 0;
+        map_insert(&shard->by_account, (uint32_t)account_hash, account);
+    }
+    rsa_mempool_account_t *queue = &shard->accounts[account];
+
+    uint32_t index = shard->entry_free;
+    rsa_mempool_entry_t *entry = &shard->entries[index];
+    shard->entry_free = entry->next;
+    entry_fill(entry, envelope, hash, *blob, arrival);
+    *blob = NULL;
+    entry->account = account;
+    entry->prev = queue->tail;
+    entry->next = RSA_MEMPOOL_NONE;
+    for (int id = 0; id < RSA_MEMPOOL_HEAP_COUNT; id++) entry->heap_pos[id] = RSA_MEMPOOL_NONE;
+    if (queue->tail != RSA_MEMPOOL_NONE) {
+        shard->entries[queue->tail].next = index;
+    } else {
+        queue->head = index;
+    }
+    queue->tail = index;
+    queue->count++;
+    shard->count++;
+
+    map_insert(&shard->by_hash, tx_key, index);
+    entry_schedule(shard, index);
+    heap_insert(shard, RSA_MEMPOOL_HEAP_EVICT, index);
+    if (queue->head == index) head_insert(shard, index);
+    return RSA_MEMPOOL_ADDED;
+}
+
+// Finds the shard whose heap `id` has the most extreme top, one lock at a
+// time; -1 when every heap is empty
+static int mempool_scan(rsa_mempool_t *pool, int id, mempool_rank_t *top) {
+    int found = -1;
+    for (int s = 0; s < RSA_MEMPOOL_SHARDS; s++) {
+        rsa_mempool_shard_t *shard = &pool->shards[s];
+        pthread_mutex_lock(&shard->mutex);
+        if (shard->heaps[id].count) {
+            mempool_rank_t rank = item_rank(&shard->heaps[id].items[0]);
+            bool above = id == RSA_MEMPOOL_HEAP_HEADS ? rank_better(rank, *top)
+                                                      : rank_better(*top, rank);
+            if (found < 0 || above) {
+                found = s;
+                *top = rank;
+            }
+        }
+        pthread_mutex_unlock(&shard->mutex);
+    }
+    return found;
+}
+
+// Evicts the lowest-rate entry of the pool (with the rest of its queue)
+// if `rank` outbids it
+static bool mempool_evict_below(rsa_mempool_t *pool, mempool_rank_t rank) {
+    for (;;) {
+        mempool_rank_t worst = {0, 0, 0};
+        int found = mempool_scan(pool, RSA_MEMPOOL_HEAP_EVICT, &worst);
+        if (found < 0 || !rank_better(rank, worst)) return false;
+
+        // Arrivals are unique, so an unchanged top is the same entry
+        rsa_mempool_shard_t *shard = &pool->shards[found];
+        pthread_mutex_lock(&shard->mutex);
+        uint32_t index = heap_top(shard, RSA_MEMPOOL_HEAP_EVICT);
+        bool same = index != RSA_MEMPOOL_NONE && shard->entries[index].arrival == worst.arrival;
+        if (same) {
+            size_t dropped = shard_drop_from(pool, shard, index);
+            __atomic_fetch_add(&pool->evicted, dropped, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&shard->mutex);
+        if (same) return true;
+    }
+}
+
+// TIME BOUNDS
+// -----------
+
+typedef struct {
+    rsa_mempool_t *pool;
+    rsa_mempool_shard_t *shard;
+    size_t dropped;
+} mempool_timer_ctx_t;
+
+static void entry_expired(uint32_t index, void *user) {
+    mempool_timer_ctx_t *ctx = user;
+    ctx->dropped += shard_drop_from(ctx->pool, ctx->shard, index);
+}
+
+static void entry_unparked(uint32_t index, void *user) {
+    mempool_timer_ctx_t *ctx = user;
+    rsa_mempool_entry_t *entry = &ctx->shard->entries[index];
+    entry->parked = false;
+    if (ctx->shard->accounts[entry->account].head == index) head_insert(ctx->shard, index);
+}
+
+// API
+// ---
+
+bool rsa_mempool_init(rsa_mempool_t *pool, const rsa_mempool_config_t *config) {
+    if (!pool) return false;
+    memset(pool, 0, sizeof(*pool));
+    if (config) pool->config = *config;
+    if (!pool->config.capacity) pool->config.capacity = RSA_MEMPOOL_CAPACITY;
+    if (!pool->config.max_per_account) pool->config.max_per_account = RSA_MEMPOOL_MAX_PER_ACCOUNT;
+    if (!pool->config.replace_bump_percent) {
+        pool->config.replace_bump_percent = RSA_MEMPOOL_REPLACE_BUMP;
+    }
+    // Bounds are enforced from the start, not once the first close sets
+    // the time
+    if (!pool->config.start_time) pool->config.start_time = rsa_clock_wall_seconds();
+
+    rsa_hash_key_init(&pool->key, pool);
+    for (int s = 0; s < RSA_MEMPOOL_SHARDS; s++) {
+        rsa_mempool_shard_t *shard = &pool->shards[s];
+        pthread_mutex_init(&shard->mutex, NULL);
+        shard->entry_free = RSA_MEMPOOL_NONE;
+        shard->account_free = RSA_MEMPOOL_NONE;
+        rsa_timer_wheel_init(&shard->expiry, pool->config.start_time);
+        rsa_timer_wheel_init(&shard->parked, pool->config.start_time);
+    }
+    return true;
+}
+
+void rsa_mempool_free(rsa_mempool_t *pool) {
+    if (!pool) return;
+    for (int s = 0; s < RSA_MEMPOOL_SHARDS; s++) {
+        rsa_mempool_shard_t *shard = &pool->shards[s];
+        for (uint32_t i = 0; i < shard->entry_capacity; i++) free(shard->entries[i].operations);
+        free(shard->entries);
+        free(shard->accounts);
+        free(shard->by_hash.slots);
+        free(shard->by_account.slots);
+        for (int id = 0; id < RSA_MEMPOOL_HEAP_COUNT; id++) free(shard->heaps[id].items);
+        rsa_timer_wheel_free(&shard->expiry);
+        rsa_timer_wheel_free(&shard->parked);
+        pthread_mutex_destroy(&shard->mutex);
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+rsa_mempool_result_t rsa_mempool_submit(rsa_mempool_t *pool, const rsa_tx_envelope_ref_t *envelope,
+                                        uint64_t account_seq) {
+    if (!pool || !envelope || !envelope->tx || !envelope->operations) return RSA_MEMPOOL_MALFORMED;
+    const rsa_transaction_t *tx = envelope->tx;
+    if (tx->operations_count == 0 || tx->operations_count > RSA_MAX_OPERATIONS_PER_TX) {
+        return RSA_MEMPOOL_MALFORMED;
+    }
+
+    // Hashing and the copy happen outside the shard lock
+    uint8_t hash[32];
+    rsa_ledger_tx_hash(envelope, hash);
+    size_t size = tx->operations_count * sizeof(rsa_operation_t);
+    if (envelope->public_key && envelope->signature) {
+        size += RSA_MEMPOOL_PUBLIC_KEY_BYTES + RSA_MEMPOOL_SIGNATURE_BYTES;
+    }
+    void *blob = malloc(size);
+    if (!blob) return RSA_MEMPOOL_NO_MEMORY;
+
+    uint64_t account_hash = mempool_hash(pool, tx->tx_source_account);
+    rsa_mempool_shard_t *shard = mempool_shard(pool, account_hash);
+    uint64_t arrival = __atomic_add_fetch(&pool->arrivals, 1, __ATOMIC_RELAXED);
+    mempool_rank_t rank = {tx->fee, tx->operations_count, arrival};
+
+    rsa_mempool_result_t result;
+    for (;;) {
+        pthread_mutex_lock(&shard->mutex);
+        result = shard_submit(pool, shard, envelope, hash, account_hash, account_seq, arrival, &blob);
+        pthread_mutex_unlock(&shard->mutex);
+        if (result != MEMPOOL_FULL) break;
+        if (!mempool_evict_below(pool, rank)) {
+            result = RSA_MEMPOOL_FEE_TOO_LOW;
+            break;
+        }
+    }
+    free(blob);                         // NULL once taken by the entry
+    return result;
+}
+
+bool rsa_mempool_pop(rsa_mempool_t *pool, rsa_mempool_tx_t *out) {
+    if (!pool || !out) return false;
+    for (;;) {
+        mempool_rank_t best = {0, 0, 0};
+        int found = mempool_scan(pool, RSA_MEMPOOL_HEAP_HEADS, &best);
+        if (found < 0) return false;
+
+        rsa_mempool_shard_t *shard = &pool->shards[found];
+        pthread_mutex_lock(&shard->mutex);
+        uint32_t index = heap_top(shard, RSA_MEMPOOL_HEAP_HEADS);
+        bool same = index != RSA_MEMPOOL_NONE && shard->entries[index].arrival == best.arrival;
+        if (same) {
+            const rsa_mempool_entry_t *entry = &shard->entries[index];
+            uint32_t op_count = entry->tx.operations_count;
+            memcpy(out->hash, entry->hash, 32);
+            out->tx = entry->tx;
+            memcpy(out->operations, entry->operations, op_count * sizeof(rsa_operation_t));
+            out->has_signature = entry->has_signature;
+            if (entry->has_signature) {
+                const uint8_t *signer = (const uint8_t *)(entry->operations + op_count);
+                memcpy(out->public_key, signer, RSA_MEMPOOL_PUBLIC_KEY_BYTES);
+                memcpy(out->signature, signer + RSA_MEMPOOL_PUBLIC_KEY_BYTES,
+                       RSA_MEMPOOL_SIGNATURE_BYTES);
+            }
+            shard_unlink(pool, shard, index);
+        }
+        pthread_mutex_unlock(&shard->mutex);
+        if (same) return true;
+    }
+}
+
+size_t rsa_mempool_remove(rsa_mempool_t *pool, const uint8_t hash[32]) {
+    if (!pool || !hash) return 0;
+
+    // The hash does not name the account, so every shard is probed
+    uint32_t tx_key = (uint32_t)mempool_hash(pool, hash);
+    for (int s = 0; s < RSA_MEMPOOL_SHARDS; s++) {
+        rsa_mempool_shard_t *shard = &pool->shards[s];
+        pthread_mutex_lock(&shard->mutex);
+        uint32_t index = find_tx(shard, tx_key, hash);
+        size_t removed = index != RSA_MEMPOOL_NONE ? shard_drop_from(pool, shard, index) : 0;
+        pthread_mutex_unlock(&shard->mutex);
+        if (removed) return removed;
+    }
+    return 0;
+}
+
+size_t rsa_mempool_advance(rsa_mempool_t *pool, const uint32_t account_id[8], uint64_t seq_num) {
+    if (!pool || !account_id) return 0;
+
+    uint64_t account_hash = mempool_hash(pool, account_id);
+    rsa_mempool_shard_t *shard = mempool_shard(pool, account_hash);
+    size_t dropped = 0;
+    pthread_mutex_lock(&shard->mutex);
+    uint32_t account = find_account(shard, (uint32_t)account_hash, account_id);
+    while (account != RSA_MEMPOOL_NONE) {
+        const rsa_mempool_account_t *queue = &shard->accounts[account];
+        uint32_t head = queue->head;
+        bool last = head == queue->tail;
+        uint64_t head_seq = shard->entries[head].tx.seq_num;
+        if (head_seq > seq_num) {
+            if (!rsa_check_sequence_number(seq_num, head_seq)) {
+                dropped += shard_drop_from(pool, shard, head);
+            }
+            break;
+        }
+        shard_unlink(pool, shard, head);
+        dropped++;
+        if (last) break;
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    return dropped;
+}
+
+size_t rsa_mempool_ledger_closed(rsa_mempool_t *pool, const rsa_ledger_t *ledger,
+                                 const rsa_tx_envelope_ref_t *envelopes, size_t count) {
+    if (!pool || !ledger || !envelopes) return 0;
+
+    size_t dropped = 0;
+    for (size_t i = 0; i < count; i++) {
+        const rsa_transaction_t *tx = envelopes[i].tx;
+        if (!tx) continue;
+        rsa_account_t account;
+        uint64_t seq_num = rsa_ledger_get_account(ledger, tx->tx_source_account, &account)
+                               ? account.seq_num
+                               : UINT64_MAX;
+        dropped += rsa_mempool_advance(pool, tx->tx_source_account, seq_num);
+    }
+    return dropped + rsa_mempool_set_time(pool, ledger->header.close_time);
+}
+
+size_t rsa_mempool_set_time(rsa_mempool_t *pool, uint64_t now) {
+    if (!pool) return 0;
+
+    // Expiry first: a transaction whose whole window has passed is dropped,
+    // not released
+    size_t dropped = 0;
+    for (int s = 0; s < RSA_MEMPOOL_SHARDS; s++) {
+        mempool_timer_ctx_t ctx = {pool, &pool->shards[s], 0};
+        pthread_mutex_lock(&ctx.shard->mutex);
+        rsa_timer_wheel_advance(&ctx.shard->expiry, now, entry_expired, &ctx);
+        rsa_timer_wheel_advance(&ctx.shard->parked, now, entry_unparked, &ctx);
+        pthread_mutex_unlock(&ctx.shard->mutex);
+        dropped += ctx.dropped;
+    }
+    __atomic_fetch_add(&pool->expired, dropped, __ATOMIC_RELAXED);
+    return dropped;
+}
+
+bool rsa_mempool_contains(rsa_mempool_t *pool, const uint8_t hash[32]) {
+    if (!pool || !hash) return false;
+
+    uint32_t tx_key = (uint32_t)mempool_hash(pool, hash);
+    for (int s = 0; s < RSA_MEMPOOL_SHARDS; s++) {
+        rsa_mempool_shard_t *shard = &pool->shards[s];
+        pthread_mutex_lock(&shard->mutex);
+        bool found = find_tx(shard, tx_key, hash) != RSA_MEMPOOL_NONE;
+        pthread_mutex_unlock(&shard->mutex);
+        if (found) return true;
+    }
+    return false;
+}
+
+size_t rsa_mempool_size(const rsa_mempool_t *pool) {
+    return pool ? __atomic_load_n(&pool->count, __ATOMIC_RELAXED) : 0;
+}
+
+rsa_tx_envelope_ref_t rsa_mempool_tx_envelope(const rsa_mempool_tx_t *tx) {
+    rsa_tx_envelope_ref_t envelope = {&tx->tx, tx->operations, NULL, NULL};
+    if (tx->has_signature) {
+        envelope.public_key = tx->public_key;
+        envelope.signature = tx->signature;
+    }
+    return envelope;
+}
+
+// TX SET BUILDING
+// ---------------
+
+static inline mempool_rank_t candidate_rank(const rsa_mempool_candidate_t *candidate) {
+    return (mempool_rank_t){candidate->fee, candidate->ops, candidate->arrival};
+}
+
+// Capacity is reserved by tx_set_reserve()
+static void candidate_push(rsa_mempool_tx_set_t *set, size_t *count,
+                           const rsa_mempool_candidate_t *candidate) {
+    size_t pos = (*count)++;
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (!rank_better(candidate_rank(candidate), candidate_rank(&set->heap[parent]))) break;
+        set->heap[pos] = set->heap[parent];
+        pos = parent;
+    }
+    set->heap[pos] = *candidate;
+}
+
+static rsa_mempool_candidate_t candidate_pop(rsa_mempool_tx_set_t *set, size_t *count) {
+    rsa_mempool_candidate_t top = set->heap[0];
+    rsa_mempool_candidate_t last = set->heap[--(*count)];
+    size_t pos = 0;
+    for (;;) {
+        size_t child = 2 * pos + 1;
+        if (child >= *count) break;
+        if (child + 1 < *count &&
+            rank_better(candidate_rank(&set->heap[child + 1]), candidate_rank(&set->heap[child]))) {
+            child++;
+        }
+        if (!rank_better(candidate_rank(&set->heap[child]), candidate_rank(&last))) break;
+        set->heap[pos] = set->heap[child];
+        pos = child;
+    }
+    if (*count > 0) set->heap[pos] = last;
+    return top;
+}
+
+// Queue head at `pos` of the shard's head heap, if there is one
+static void candidate_add_head(rsa_mempool_t *pool, rsa_mempool_tx_set_t *set, size_t *count,
+                               uint32_t shard, size_t pos) {
+    const rsa_mempool_heap_t *heads = &pool->shards[shard].heaps[RSA_MEMPOOL_HEAP_HEADS];
+    if (pos >= heads->count) return;
+    const rsa_mempool_heap_item_t *item = &heads->items[pos];
+    rsa_mempool_candidate_t candidate = {item->fee, item->ops, item->arrival,
+                                         shard, item->entry, (uint32_t)pos};
+    candidate_push(set, count, &candidate);
+    __builtin_prefetch(&pool->shards[shard].entries[item->entry]);
+}
+
+// Successor in a queue; a parked one holds back the rest
+static void candidate_add_next(rsa_mempool_t *pool, rsa_mempool_tx_set_t *set, size_t *count,
+                               uint32_t shard, uint32_t index) {
+    const rsa_mempool_entry_t *entry = &pool->shards[shard].entries[index];
+    if (entry->parked) return;
+    rsa_mempool_candidate_t candidate = {entry->tx.fee, entry->tx.operations_count, entry->arrival,
+                                         shard, index, RSA_MEMPOOL_NONE};
+    candidate_push(set, count, &candidate);
+}
+
+static bool tx_set_reserve(rsa_mempool_tx_set_t *set, size_t max_txs) {
+    if (set->capacity < max_txs) {
+        rsa_tx_envelope_ref_t *envelopes = realloc(set->envelopes, max_txs * sizeof(*envelopes));
+        if (envelopes) set->envelopes = envelopes;
+        rsa_transaction_t *txs = realloc(set->txs, max_txs * sizeof(*txs));
+        if (txs) set->txs = txs;
+        uint8_t *signers = realloc(set->signers, max_txs * (RSA_MEMPOOL_PUBLIC_KEY_BYTES +
+                                                            RSA_MEMPOOL_SIGNATURE_BYTES));
+        if (signers) set->signers = signers;
+        uint8_t(*hashes)[32] = realloc(set->hashes, max_txs * sizeof(*hashes));
+        if (hashes) set->hashes = hashes;
+        if (!envelopes || !txs || !signers || !hashes) return false;
+        set->capacity = max_txs;
+    }
+
+    // Every pick adds at most its two heap children and its successor
+    size_t heap_needed = RSA_MEMPOOL_SHARDS + 3 * max_txs;
+    if (set->heap_capacity < heap_needed) {
+        rsa_mempool_candidate_t *heap = realloc(set->heap, heap_needed * sizeof(*heap));
+        if (!heap) return false;
+        set->heap = heap;
+        set->heap_capacity = heap_needed;
+    }
+    return true;
+}
+
+bool rsa_mempool_build_tx_set(rsa_mempool_t *pool, size_t max_txs, uint32_t base_fee,
+                              rsa_mempool_tx_set_t *set) {
+    if (!pool || !set) return false;
+    if (!max_txs) max_txs = RSA_MAX_TX_SET_SIZE;
+    set->count = 0;
+    set->op_count = 0;
+    set->base_fee = base_fee;
+    set->surged = false;
+    if (!tx_set_reserve(set, max_txs)) return false;
+
+    for (int s = 0; s < RSA_MEMPOOL_SHARDS; s++) pthread_mutex_lock(&pool->shards[s].mutex);
+
+    size_t candidates = 0;
+    for (uint32_t s = 0; s < RSA_MEMPOOL_SHARDS; s++) candidate_add_head(pool, set, &candidates, s, 0);
+
+    // Operations are copied once the total is known; until then the
+    // envelopes point into the pool
+    uint64_t lowest_fee = 0, lowest_ops = 1;
+    size_t signer_bytes = RSA_MEMPOOL_PUBLIC_KEY_BYTES + RSA_MEMPOOL_SIGNATURE_BYTES;
+    while (candidates > 0 && set->count < max_txs) {
+        // Nothing left in the heap bids more per operation than the top, so
+        // the first one under base_fee ends the set
+        if (set->heap[0].fee < (uint64_t)base_fee * set->heap[0].ops) break;
+        rsa_mempool_candidate_t picked = candidate_pop(set, &candidates);
+        if (picked.heap_pos != RSA_MEMPOOL_NONE) {
+            candidate_add_head(pool, set, &candidates, picked.shard, 2 * (size_t)picked.heap_pos + 1);
+            candidate_add_head(pool, set, &candidates, picked.shard, 2 * (size_t)picked.heap_pos + 2);
+        }
+        const rsa_mempool_entry_t *entry = &pool->shards[picked.shard].entries[picked.entry];
+        if (entry->next != RSA_MEMPOOL_NONE) {
+            candidate_add_next(pool, set, &candidates, picked.shard, entry->next);
+        }
+
+        size_t i = set->count++;
+        uint8_t *signer = set->signers + i * signer_bytes;
+        set->txs[i] = entry->tx;
+        memcpy(set->hashes[i], entry->hash, 32);
+        set->envelopes[i] = (rsa_tx_envelope_ref_t){&set->txs[i], entry->operations, NULL, NULL};
+        if (entry->has_signature) {
+            memcpy(signer, entry->operations + entry->tx.operations_count, signer_bytes);
+            set->envelopes[i].public_key = signer;
+            set->envelopes[i].signature = signer + RSA_MEMPOOL_PUBLIC_KEY_BYTES;
+        }
+        set->op_count += entry->tx.operations_count;
+        if (i == 0 || picked.fee * lowest_ops < lowest_fee * picked.ops) {
+            lowest_fee = picked.fee;
+            lowest_ops = picked.ops;
+        }
+    }
+    set->surged = set->count == max_txs && candidates > 0 &&
+                  set->heap[0].fee >= (uint64_t)base_fee * set->heap[0].ops;
+
+    bool ok = true;
+    if (set->op_capacity < set->op_count) {
+        rsa_operation_t *operations = realloc(set->operations,
+                                              set->op_count * sizeof(*operations));
+        ok = operations != NULL;
+        if (ok) {
+            set->operations = operations;
+            set->op_capacity = set->op_count;
+        }
+    }
+    for (size_t i = 0, op = 0; ok && i < set->count; i++) {
+        uint32_t op_count = set->txs[i].operations_count;
+        memcpy(&set->operations[op], set->envelopes[i].operations, op_count * sizeof(rsa_operation_t));
+        set->envelopes[i].operations = &set->operations[op];
+        op += op_count;
+    }
+
+    for (int s = RSA_MEMPOOL_SHARDS; s-- > 0;) pthread_mutex_unlock(&pool->shards[s].mutex);
+    if (!ok) {
+        set->count = 0;
+        set->op_count = 0;
+        return false;
+    }
+
+    if (set->surged && lowest_fee / lowest_ops > base_fee) {
+        set->base_fee = (uint32_t)(lowest_fee / lowest_ops);
+    }
+    return true;
+}
+
+void rsa_mempool_tx_set_free(rsa_mempool_tx_set_t *set) {
+    if (!set) return;
+    free(set->envelopes);
+    free(set->txs);
+    free(set->operations);
+    free(set->signers);
+    free(set->hashes);
+    free(set->heap);
+    memset(set, 0, sizeof(*set));
+}
+
+const char *rsa_mempool_result_str(rsa_mempool_result_t result) {
+    switch (result) {
+        case RSA_MEMPOOL_ADDED: return "added";
+        case RSA_MEMPOOL_REPLACED: return "replaced";
+        case RSA_MEMPOOL_DUPLICATE: return "duplicate";
+        case RSA_MEMPOOL_BAD_SEQ: return "bad_seq";
+        case RSA_MEMPOOL_FEE_TOO_LOW: return "fee_too_low";
+        case RSA_MEMPOOL_ACCOUNT_LIMIT: return "account_limit";
+        case RSA_MEMPOOL_EXPIRED: return "expired";
+        case RSA_MEMPOOL_MALFORMED: return "malformed";
+        case RSA_MEMPOOL_NO_MEMORY: return "no_memory";
+        default: return "unknown";
+    }
+}
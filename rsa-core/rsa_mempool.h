@@ -0,0 +1,271 @@
+#ifndef RSA_MEMPOOL_H
+#define RSA_MEMPOOL_H
+
+#include "rsa_token.h"
+#include "rsa_hash.h"
+#include "rsa_ledger.h"
+#include "rsa_txset.h"
+#include "rsa_timer_wheel.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PENDING TRANSACTION POOL
+// ========================
+// Transactions received but not yet applied, held as private copies:
+//
+//   account queues   per source account, ordered by seq_num; a new
+//                    transaction must extend its queue by exactly one
+//                    (rsa_check_sequence_number() against the tail, or
+//                    against the ledger's seq_num for an empty queue)
+//   dedupe           tx hash -> entry (rsa_ledger_tx_hash())
+//   eviction heap    every entry, lowest fee rate on top
+//   head heap        the first entry of every queue, best fee rate on top
+//
+// Fee rate is fee per operation (rsa_calculate_fee() charges per
+// operation); ties go to the earlier arrival. Every update is O(log n) in
+// the size of one shard.
+//
+// A pending transaction with the same source and seq_num is replaced when
+// it bids at least `replace_bump_percent` more per operation. When the
+// pool is full a new transaction evicts the lowest-rate entry of the whole
+// pool, or is refused if it bids no more than that. Removing an entry that
+// is not the last of its queue removes the entries behind it as well,
+// since their sequence numbers can no longer be reached.
+//
+// Time bounds are kept against the pool's time, the close time the next
+// set is built for (rsa_mempool_set_time()), which starts at the config's
+// `start_time` or else the wall clock (rsa_clock). A transaction past its
+// max_time is refused, and one that expires while pending is dropped with
+// the rest of its queue when the time passes max_time. One before its
+// min_time is accepted but parked: it holds its place in the queue and
+// counts against capacity, but neither it nor anything behind it is
+// offered until min_time. Both deadlines sit in per-shard timer wheels
+// (rsa_timer_wheel.h), so dead transactions cost O(1) each to drop
+// instead of failing validation every time a set is built.
+//
+// Accounts are spread over RSA_MEMPOOL_SHARDS shards by keyed hash, each
+// with its own lock; operations hold one shard lock at a time. Envelopes
+// should be validated (rsa_validate_tx_envelope) before submission.
+
+#define RSA_MEMPOOL_SHARDS 16
+#define RSA_MEMPOOL_CAPACITY 1000000        // default, transactions
+#define RSA_MEMPOOL_MAX_PER_ACCOUNT 64      // default queue length
+#define RSA_MEMPOOL_REPLACE_BUMP 10         // default, percent of the fee rate
+#define RSA_MEMPOOL_PUBLIC_KEY_BYTES 260    // modulus and exponent, as rsa_verify_signature() reads them
+#define RSA_MEMPOOL_SIGNATURE_BYTES 256
+#define RSA_MEMPOOL_NONE UINT32_MAX
+
+typedef enum {
+    RSA_MEMPOOL_ADDED = 0,
+    RSA_MEMPOOL_REPLACED,
+    RSA_MEMPOOL_DUPLICATE,
+    RSA_MEMPOOL_BAD_SEQ,                // does not extend the account's queue
+    RSA_MEMPOOL_FEE_TOO_LOW,            // replacement bump or full pool
+    RSA_MEMPOOL_ACCOUNT_LIMIT,
+    RSA_MEMPOOL_EXPIRED,                // past max_time at the pool's time
+    RSA_MEMPOOL_MALFORMED,
+    RSA_MEMPOOL_NO_MEMORY,
+    RSA_MEMPOOL_RESULT_COUNT
+} rsa_mempool_result_t;
+
+typedef enum {
+    RSA_MEMPOOL_HEAP_EVICT = 0,         // all entries, lowest fee rate on top
+    RSA_MEMPOOL_HEAP_HEADS,             // queue heads, best fee rate on top
+    RSA_MEMPOOL_HEAP_COUNT
+} rsa_mempool_heap_id_t;
+
+typedef struct {
+    uint8_t hash[32];
+    rsa_transaction_t tx;
+    rsa_operation_t *operations;        // owned; public key and signature follow when signed
+    bool has_signature;
+    bool parked;                        // before min_time: kept out of the head heap
+    uint32_t account;                   // queue index in the shard
+    uint32_t prev;                      // queue neighbours; `next` links the free list
+    uint32_t next;
+    uint32_t heap_pos[RSA_MEMPOOL_HEAP_COUNT];  // RSA_MEMPOOL_NONE when not in the heap
+    uint64_t arrival;
+} rsa_mempool_entry_t;
+
+typedef struct {
+    uint32_t account_id[8];
+    uint32_t head;                      // entries; `head` links the free list
+    uint32_t tail;
+    uint32_t count;
+} rsa_mempool_account_t;
+
+// Open addressing, linear probing with backward-shift deletion
+typedef struct {
+    uint32_t hash;
+    uint32_t index;                     // + 1; 0 is empty
+} rsa_mempool_map_slot_t;
+
+typedef struct {
+    rsa_mempool_map_slot_t *slots;
+    size_t mask;
+    size_t count;
+} rsa_mempool_map_t;
+
+// Heap items carry the entry's rank, so sifting and the set builder's
+// walk compare without touching entries
+typedef struct {
+    uint64_t fee;
+    uint64_t arrival;
+    uint32_t ops;
+    uint32_t entry;
+} rsa_mempool_heap_item_t;
+
+typedef struct {
+    rsa_mempool_heap_item_t *items;
+    size_t count;
+    size_t capacity;
+} rsa_mempool_heap_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    rsa_mempool_entry_t *entries;
+    uint32_t entry_capacity;
+    uint32_t entry_free;
+    size_t count;
+    rsa_mempool_account_t *accounts;
+    uint32_t account_capacity;
+    uint32_t account_free;
+    rsa_mempool_map_t by_hash;
+    rsa_mempool_map_t by_account;
+    rsa_mempool_heap_t heaps[RSA_MEMPOOL_HEAP_COUNT];
+    rsa_timer_wheel_t expiry;           // by entry, at max_time + 1
+    rsa_timer_wheel_t parked;           // by entry, at min_time
+} __attribute__((aligned(64))) rsa_mempool_shard_t;
+
+typedef struct {
+    size_t capacity;                    // 0 = RSA_MEMPOOL_CAPACITY
+    uint32_t max_per_account;           // 0 = RSA_MEMPOOL_MAX_PER_ACCOUNT
+    uint32_t replace_bump_percent;      // 0 = RSA_MEMPOOL_REPLACE_BUMP
+    uint64_t start_time;                // pool time at init, seconds; 0 = wall clock
+} rsa_mempool_config_t;
+
+typedef struct {
+    rsa_mempool_config_t config;
+    rsa_mempool_shard_t shards[RSA_MEMPOOL_SHARDS];
+    rsa_hash_key_t key;
+
+    // Atomic
+    size_t count;
+    uint64_t arrivals;
+    uint64_t evicted;                   // entries dropped to make room
+    uint64_t replaced;
+    uint64_t expired;                   // entries dropped past max_time
+} rsa_mempool_t;
+
+// A transaction taken out of the pool, with its own storage
+typedef struct {
+    uint8_t hash[32];
+    rsa_transaction_t tx;
+    rsa_operation_t operations[RSA_MAX_OPERATIONS_PER_TX];
+    uint8_t public_key[RSA_MEMPOOL_PUBLIC_KEY_BYTES];
+    uint8_t signature[RSA_MEMPOOL_SIGNATURE_BYTES];
+    bool has_signature;
+} rsa_mempool_tx_t;
+
+// `config` may be NULL for defaults
+bool rsa_mempool_init(rsa_mempool_t *pool, const rsa_mempool_config_t *config);
+void rsa_mempool_free(rsa_mempool_t *pool);
+
+// Copies the envelope in. `account_seq` is the source account's seq_num
+// in the last closed ledger; it only matters while its queue is empty.
+// The signer key and signature are kept when both are set.
+rsa_mempool_result_t rsa_mempool_submit(rsa_mempool_t *pool, const rsa_tx_envelope_ref_t *envelope,
+                                        uint64_t account_seq);
+
+// Takes out the best queue head; its successor becomes the new head.
+// False when the pool is empty.
+bool rsa_mempool_pop(rsa_mempool_t *pool, rsa_mempool_tx_t *out);
+
+// Removes the transaction and the rest of its queue; returns the number
+// of entries removed
+size_t rsa_mempool_remove(rsa_mempool_t *pool, const uint8_t hash[32]);
+// The account's seq_num reached `seq_num`: drops the entries it consumed,
+// and the whole queue if the next one no longer follows on
+size_t rsa_mempool_advance(rsa_mempool_t *pool, const uint32_t account_id[8], uint64_t seq_num);
+// rsa_mempool_advance() for the source of every envelope of a closed set,
+// with seq_nums read from the ledger (merged accounts lose their queue);
+// then rsa_mempool_set_time() to the ledger's close time
+size_t rsa_mempool_ledger_closed(rsa_mempool_t *pool, const rsa_ledger_t *ledger,
+                                 const rsa_tx_envelope_ref_t *envelopes, size_t count);
+
+// Moves the pool's time forward to `now` (seconds; it never goes back):
+// drops transactions past their max_time, with the rest of their queues,
+// and releases parked ones whose min_time has come. Returns the number
+// dropped.
+size_t rsa_mempool_set_time(rsa_mempool_t *pool, uint64_t now);
+
+bool rsa_mempool_contains(rsa_mempool_t *pool, const uint8_t hash[32]);
+size_t rsa_mempool_size(const rsa_mempool_t *pool);
+
+// Tx set building
+// ---------------
+// Picks the next ledger's transactions by fee per operation without
+// taking them out of the pool. Candidates sit in one heap: each shard's
+// best queue head to start with, then as a transaction is picked, its
+// children in its shard's head heap (never better than it) and its
+// successor in its queue unless parked. The cost is O(max_txs log max_txs) however many
+// transactions wait, and the pick order, which is the set order, keeps
+// every account's transactions in seq_num order. Shards are locked in
+// index order for the duration.
+//
+// `base_fee` is the ledger's configured fee per operation
+// (rsa_ledger_config_t.base_fee); a transaction bidding less per operation
+// is left out, and so is the rest of its queue. Surge pricing: when
+// candidates that do meet it are left out, every included transaction is
+// charged the lowest included bid per operation (rounded down, never below
+// `base_fee`) instead of `base_fee`. Pass the set's base_fee on as
+// rsa_ledger_candidate_t.base_fee or to rsa_ledger_pipeline_submit().
+
+// Candidate in the builder's heap
+typedef struct {
+    uint64_t fee;
+    uint64_t ops;
+    uint64_t arrival;
+    uint32_t shard;
+    uint32_t entry;
+    uint32_t heap_pos;                  // in the shard's head heap, RSA_MEMPOOL_NONE for a successor
+} rsa_mempool_candidate_t;
+
+// Copies of the picked transactions; zero-initialize, reuse across builds
+typedef struct {
+    rsa_tx_envelope_ref_t *envelopes;   // `count`, in apply order
+    size_t count;
+    size_t op_count;
+    uint32_t base_fee;                  // per operation
+    bool surged;                        // candidates meeting base_fee were left out
+
+    rsa_transaction_t *txs;
+    rsa_operation_t *operations;
+    uint8_t *signers;                   // public key and signature per transaction
+    uint8_t (*hashes)[32];
+    size_t capacity;
+    size_t op_capacity;
+    rsa_mempool_candidate_t *heap;
+    size_t heap_capacity;
+} rsa_mempool_tx_set_t;
+
+// Up to `max_txs` (0 = RSA_MAX_TX_SET_SIZE) transactions bidding at least
+// `base_fee` per operation. False on allocation failure.
+bool rsa_mempool_build_tx_set(rsa_mempool_t *pool, size_t max_txs, uint32_t base_fee,
+                              rsa_mempool_tx_set_t *set);
+void rsa_mempool_tx_set_free(rsa_mempool_tx_set_t *set);
+
+// Envelope over a popped transaction (valid while `tx` is)
+rsa_tx_envelope_ref_t rsa_mempool_tx_envelope(const rsa_mempool_tx_t *tx);
+
+const char *rsa_mempool_result_str(rsa_mempool_result_t result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_MEMPOOL_H
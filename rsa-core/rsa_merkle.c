@@ -0,0 +1,486 @@
+#include "rsa_merkle.h"
+#include <openssl/sha.h>
+#include <stdlib.h>
+#include <string.h>
+
+// LEDGER STATE MERKLE TREE
+// ========================
+
+#define REF_LEAF 0x80000000u
+#define MERKLE_MAX_DEPTH 64             // nibbles in a 256-bit key
+
+static inline bool ref_is_leaf(uint32_t ref) {
+    return (ref & REF_LEAF) != 0;
+}
+
+static inline unsigned key_nibble(const uint8_t key[32], unsigned depth) {
+    return (depth & 1) ? key[depth / 2] & 0x0F : key[depth / 2] >> 4;
+}
+
+// NODE POOLS
+// ----------
+
+static inline rsa_merkle_node_t *pool_node(const rsa_merkle_pool_t *pool, uint32_t ref) {
+    uint32_t index = ref - 1;
+    return &pool->node_chunks[index / RSA_MERKLE_CHUNK_SIZE][index % RSA_MERKLE_CHUNK_SIZE];
+}
+
+static inline rsa_merkle_leaf_t *pool_leaf(const rsa_merkle_pool_t *pool, uint32_t ref) {
+    uint32_t index = (ref & ~REF_LEAF) - 1;
+    return &pool->leaf_chunks[index / RSA_MERKLE_CHUNK_SIZE][index % RSA_MERKLE_CHUNK_SIZE];
+}
+
+static inline const uint8_t *ref_hash(const rsa_merkle_pool_t *pool, uint32_t ref) {
+    return ref_is_leaf(ref) ? pool_leaf(pool, ref)->hash : pool_node(pool, ref)->hash;
+}
+
+// Chunks are added when the high-water mark reaches the end of the last one
+static bool node_chunk_add(rsa_merkle_pool_t *pool) {
+    if (pool->node_count >= REF_LEAF - 1 - RSA_MERKLE_CHUNK_SIZE) return false;
+    rsa_merkle_node_t **grown =
+        realloc(pool->node_chunks, (pool->node_chunk_count + 1) * sizeof(*grown));
+    if (!grown) return false;
+    pool->node_chunks = grown;
+    grown[pool->node_chunk_count] = malloc(RSA_MERKLE_CHUNK_SIZE * sizeof(rsa_merkle_node_t));
+    if (!grown[pool->node_chunk_count]) return false;
+    pool->node_chunk_count++;
+    return true;
+}
+
+static bool leaf_chunk_add(rsa_merkle_pool_t *pool) {
+    if (pool->leaf_count >= REF_LEAF - 1 - RSA_MERKLE_CHUNK_SIZE) return false;
+    rsa_merkle_leaf_t **grown =
+        realloc(pool->leaf_chunks, (pool->leaf_chunk_count + 1) * sizeof(*grown));
+    if (!grown) return false;
+    pool->leaf_chunks = grown;
+    grown[pool->leaf_chunk_count] = malloc(RSA_MERKLE_CHUNK_SIZE * sizeof(rsa_merkle_leaf_t));
+    if (!grown[pool->leaf_chunk_count]) return false;
+    pool->leaf_chunk_count++;
+    return true;
+}
+
+static uint32_t node_alloc(rsa_merkle_pool_t *pool) {
+    uint32_t ref = pool->node_free;
+    if (ref) {
+        pool->node_free = pool_node(pool, ref)->children[0];
+    } else {
+        if (pool->node_count == pool->node_chunk_count * RSA_MERKLE_CHUNK_SIZE &&
+            !node_chunk_add(pool)) {
+            return 0;
+        }
+        ref = ++pool->node_count;
+    }
+    memset(pool_node(pool, ref), 0, sizeof(rsa_merkle_node_t));
+    pool->node_live++;
+    return ref;
+}
+
+static void node_release(rsa_merkle_pool_t *pool, uint32_t ref) {
+    pool_node(pool, ref)->children[0] = pool->node_free;
+    pool->node_free = ref;
+    pool->node_live--;
+}
+
+static uint32_t leaf_alloc(rsa_merkle_pool_t *pool) {
+    uint32_t ref = pool->leaf_free;
+    if (ref) {
+        memcpy(&pool->leaf_free, pool_leaf(pool, ref)->key, sizeof(uint32_t));
+    } else {
+        if (pool->leaf_count == pool->leaf_chunk_count * RSA_MERKLE_CHUNK_SIZE &&
+            !leaf_chunk_add(pool)) {
+            return 0;
+        }
+        ref = ++pool->leaf_count | REF_LEAF;
+    }
+    pool->leaf_live++;
+    return ref;
+}
+
+static void leaf_release(rsa_merkle_pool_t *pool, uint32_t ref) {
+    memcpy(pool_leaf(pool, ref)->key, &pool->leaf_free, sizeof(uint32_t));
+    pool->leaf_free = ref;
+    pool->leaf_live--;
+}
+
+static void pool_free(rsa_merkle_pool_t *pool) {
+    for (size_t c = 0; c < pool->node_chunk_count; c++) free(pool->node_chunks[c]);
+    for (size_t c = 0; c < pool->leaf_chunk_count; c++) free(pool->leaf_chunks[c]);
+    free(pool->node_chunks);
+    free(pool->leaf_chunks);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// HASHING
+// -------
+
+static void hash_leaf(const uint8_t key[32], const uint8_t value[32], uint8_t out[32]) {
+    uint8_t buffer[65];
+    buffer[0] = 0x00;
+    memcpy(buffer + 1, key, 32);
+    memcpy(buffer + 33, value, 32);
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, buffer, sizeof(buffer));
+    SHA256_Final(out, &ctx);
+}
+
+// Interior hash over the present children only, so sparse nodes near the
+// leaves cost one or two compression blocks
+static void hash_children(const rsa_merkle_pool_t *pool, const uint32_t children[RSA_MERKLE_FANOUT],
+                          uint8_t out[32]) {
+    // Children are scattered across the pool: start every miss up front
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) {
+        if (children[i]) __builtin_prefetch(ref_hash(pool, children[i]));
+    }
+
+    uint8_t buffer[3 + RSA_MERKLE_FANOUT * 32];
+    size_t length = 3;
+    uint16_t bitmap = 0;
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) {
+        if (!children[i]) continue;
+        bitmap |= (uint16_t)(1u << i);
+        memcpy(buffer + length, ref_hash(pool, children[i]), 32);
+        length += 32;
+    }
+    buffer[0] = 0x01;
+    buffer[1] = (uint8_t)(bitmap & 0xFF);
+    buffer[2] = (uint8_t)(bitmap >> 8);
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, buffer, length);
+    SHA256_Final(out, &ctx);
+}
+
+// SUBTREE UPDATE
+// --------------
+// `updates` are sorted by key, one per key, and all share the prefix of
+// the subtree at *ref. A subtree with several entries is an interior node
+// at its depth, with one entry a leaf, with none empty.
+
+static bool subtree_update(rsa_merkle_pool_t *pool, uint32_t *ref, unsigned depth,
+                           const rsa_merkle_update_t *updates, size_t count);
+
+static bool interior_update(rsa_merkle_pool_t *pool, uint32_t *ref, unsigned depth,
+                            const rsa_merkle_update_t *updates, size_t count) {
+    uint32_t node_ref = *ref;
+    for (size_t i = 0; i < count;) {
+        unsigned nibble = key_nibble(updates[i].key, depth);
+        size_t j = i + 1;
+        while (j < count && key_nibble(updates[j].key, depth) == nibble) j++;
+
+        uint32_t child = pool_node(pool, node_ref)->children[nibble];
+        if (!subtree_update(pool, &child, depth + 1, updates + i, j - i)) return false;
+        pool_node(pool, node_ref)->children[nibble] = child;
+        i = j;
+    }
+
+    // Collapse to nothing or to a lone leaf so the shape stays canonical
+    rsa_merkle_node_t *node = pool_node(pool, node_ref);
+    uint32_t only = 0;
+    unsigned present = 0;
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) {
+        if (node->children[i]) {
+            only = node->children[i];
+            present++;
+        }
+    }
+    if (present == 0 || (present == 1 && ref_is_leaf(only))) {
+        node_release(pool, node_ref);
+        *ref = only;
+        return true;
+    }
+    hash_children(pool, node->children, node->hash);
+    return true;
+}
+
+static bool subtree_update(rsa_merkle_pool_t *pool, uint32_t *ref, unsigned depth,
+                           const rsa_merkle_update_t *updates, size_t count) {
+    if (*ref && ref_is_leaf(*ref)) {
+        rsa_merkle_leaf_t *leaf = pool_leaf(pool, *ref);
+        if (count == 1 && memcmp(updates[0].key, leaf->key, 32) == 0) {
+            if (updates[0].erase) {
+                leaf_release(pool, *ref);
+                *ref = 0;
+            } else {
+                hash_leaf(leaf->key, updates[0].value, leaf->hash);
+            }
+            return true;
+        }
+        bool touched = false;
+        for (size_t i = 0; i < count && !touched; i++) {
+            touched = !updates[i].erase || memcmp(updates[i].key, leaf->key, 32) == 0;
+        }
+        if (!touched) return true;      // only erases of absent keys
+
+        // Push the leaf one level down and merge the updates around it; a
+        // put to the leaf's own key is re-applied harmlessly on the way
+        if (depth >= MERKLE_MAX_DEPTH) return false;
+        uint32_t node_ref = node_alloc(pool);
+        if (!node_ref) return false;
+        pool_node(pool, node_ref)->children[key_nibble(pool_leaf(pool, *ref)->key, depth)] = *ref;
+        *ref = node_ref;
+        return interior_update(pool, ref, depth, updates, count);
+    }
+
+    if (*ref) return interior_update(pool, ref, depth, updates, count);
+
+    // Empty subtree: only puts matter
+    size_t puts = 0, last_put = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!updates[i].erase) {
+            puts++;
+            last_put = i;
+        }
+    }
+    if (puts == 0) return true;
+    if (puts == 1) {
+        uint32_t leaf_ref = leaf_alloc(pool);
+        if (!leaf_ref) return false;
+        rsa_merkle_leaf_t *leaf = pool_leaf(pool, leaf_ref);
+        memcpy(leaf->key, updates[last_put].key, 32);
+        hash_leaf(leaf->key, updates[last_put].value, leaf->hash);
+        *ref = leaf_ref;
+        return true;
+    }
+    if (depth >= MERKLE_MAX_DEPTH) return false;
+    uint32_t node_ref = node_alloc(pool);
+    if (!node_ref) return false;
+    *ref = node_ref;
+    return interior_update(pool, ref, depth, updates, count);
+}
+
+// TREE
+// ----
+
+bool rsa_merkle_tree_init(rsa_merkle_tree_t *tree) {
+    if (!tree) return false;
+    memset(tree, 0, sizeof(*tree));
+    return true;
+}
+
+void rsa_merkle_tree_free(rsa_merkle_tree_t *tree) {
+    if (!tree) return;
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) pool_free(&tree->pools[i]);
+    memset(tree, 0, sizeof(*tree));
+}
+
+void rsa_merkle_batch_init(rsa_merkle_batch_t *batch) {
+    if (batch) memset(batch, 0, sizeof(*batch));
+}
+
+void rsa_merkle_batch_free(rsa_merkle_batch_t *batch) {
+    if (!batch) return;
+    free(batch->updates);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void rsa_merkle_batch_reset(rsa_merkle_batch_t *batch) {
+    if (batch) batch->count = 0;
+}
+
+static rsa_merkle_update_t *batch_push(rsa_merkle_batch_t *batch, const uint8_t key[32]) {
+    if (!batch || !key || batch->count >= UINT32_MAX) return NULL;
+    if (batch->count == batch->capacity) {
+        size_t capacity = batch->capacity ? batch->capacity * 2 : 1024;
+        rsa_merkle_update_t *grown = realloc(batch->updates, capacity * sizeof(*grown));
+        if (!grown) return NULL;
+        batch->updates = grown;
+        batch->capacity = capacity;
+    }
+    rsa_merkle_update_t *update = &batch->updates[batch->count];
+    memcpy(update->key, key, 32);
+    update->sequence = (uint32_t)batch->count++;
+    return update;
+}
+
+bool rsa_merkle_batch_put(rsa_merkle_batch_t *batch, const uint8_t key[32], const uint8_t value[32]) {
+    if (!value) return false;
+    rsa_merkle_update_t *update = batch_push(batch, key);
+    if (!update) return false;
+    memcpy(update->value, value, 32);
+    update->erase = false;
+    return true;
+}
+
+bool rsa_merkle_batch_erase(rsa_merkle_batch_t *batch, const uint8_t key[32]) {
+    rsa_merkle_update_t *update = batch_push(batch, key);
+    if (!update) return false;
+    memset(update->value, 0, 32);
+    update->erase = true;
+    return true;
+}
+
+bool rsa_merkle_entry_hashes(rsa_wal_entry_type_t type, const void *record,
+                             uint8_t key[32], uint8_t value[32]) {
+    union {
+        rsa_account_t account;
+        rsa_trustline_t trustline;
+        rsa_offer_t offer;
+        rsa_data_t data;
+    } image;
+    if (!rsa_wal_entry_normalize(type, record, &image)) return false;
+
+    uint8_t tag = (uint8_t)type;
+    SHA256_CTX ctx;
+    if (key) {
+        SHA256_Init(&ctx);
+        SHA256_Update(&ctx, &tag, 1);
+        SHA256_Update(&ctx, &image, rsa_wal_key_size[type]);
+        SHA256_Final(key, &ctx);
+    }
+    if (value) {
+        SHA256_Init(&ctx);
+        SHA256_Update(&ctx, &tag, 1);
+        SHA256_Update(&ctx, &image, rsa_wal_entry_used[type]);
+        SHA256_Final(value, &ctx);
+    }
+    return true;
+}
+
+bool rsa_merkle_batch_put_entry(rsa_merkle_batch_t *batch, rsa_wal_entry_type_t type,
+                                const void *record) {
+    uint8_t key[32], value[32];
+    return rsa_merkle_entry_hashes(type, record, key, value) &&
+           rsa_merkle_batch_put(batch, key, value);
+}
+
+bool rsa_merkle_batch_erase_entry(rsa_merkle_batch_t *batch, rsa_wal_entry_type_t type,
+                                  const void *record) {
+    uint8_t key[32];
+    return rsa_merkle_entry_hashes(type, record, key, NULL) && rsa_merkle_batch_erase(batch, key);
+}
+
+static int compare_updates(const void *a, const void *b) {
+    const rsa_merkle_update_t *x = a, *y = b;
+    int order = memcmp(x->key, y->key, 32);
+    if (order) return order;
+    return x->sequence < y->sequence ? -1 : (x->sequence > y->sequence ? 1 : 0);
+}
+
+// Sorts and keeps the last change to each key
+static size_t batch_normalize(rsa_merkle_batch_t *batch) {
+    qsort(batch->updates, batch->count, sizeof(rsa_merkle_update_t), compare_updates);
+    size_t kept = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (i + 1 < batch->count && memcmp(batch->updates[i].key, batch->updates[i + 1].key, 32) == 0) {
+            continue;
+        }
+        batch->updates[kept++] = batch->updates[i];
+    }
+    return kept;
+}
+
+// PARALLEL APPLY
+// --------------
+
+typedef struct {
+    rsa_merkle_tree_t *tree;
+    const rsa_merkle_update_t *updates;
+    size_t starts[RSA_MERKLE_FANOUT + 1];
+    unsigned next;                      // next root subtree to claim
+    bool failed;
+} merkle_apply_t;
+
+static void apply_worker(void *arg, unsigned worker) {
+    (void)worker;
+    merkle_apply_t *apply = arg;
+    for (;;) {
+        unsigned group = __atomic_fetch_add(&apply->next, 1, __ATOMIC_RELAXED);
+        if (group >= RSA_MERKLE_FANOUT) break;
+        size_t start = apply->starts[group], end = apply->starts[group + 1];
+        if (start == end) continue;
+        if (!subtree_update(&apply->tree->pools[group], &apply->tree->roots[group], 1,
+                            apply->updates + start, end - start)) {
+            __atomic_store_n(&apply->failed, true, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void merkle_rehash_root(rsa_merkle_tree_t *tree) {
+    unsigned present = 0, only = 0;
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) {
+        if (tree->roots[i]) {
+            present++;
+            only = i;
+        }
+    }
+    if (present == 0) {
+        memset(tree->root, 0, sizeof(tree->root));
+        return;
+    }
+    if (present == 1 && ref_is_leaf(tree->roots[only])) {
+        memcpy(tree->root, pool_leaf(&tree->pools[only], tree->roots[only])->hash, 32);
+        return;
+    }
+
+    // Same encoding as hash_children, with each child read from its own pool
+    uint8_t buffer[3 + RSA_MERKLE_FANOUT * 32];
+    size_t length = 3;
+    uint16_t bitmap = 0;
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) {
+        if (!tree->roots[i]) continue;
+        bitmap |= (uint16_t)(1u << i);
+        memcpy(buffer + length, ref_hash(&tree->pools[i], tree->roots[i]), 32);
+        length += 32;
+    }
+    buffer[0] = 0x01;
+    buffer[1] = (uint8_t)(bitmap & 0xFF);
+    buffer[2] = (uint8_t)(bitmap >> 8);
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, buffer, length);
+    SHA256_Final(tree->root, &ctx);
+}
+
+bool rsa_merkle_apply(rsa_merkle_tree_t *tree, rsa_merkle_batch_t *batch,
+                      rsa_worker_pool_t *workers, unsigned threads) {
+    if (!tree || !batch) return false;
+    size_t count = batch_normalize(batch);
+
+    merkle_apply_t apply = {.tree = tree, .updates = batch->updates};
+    size_t pos = 0;
+    unsigned groups = 0;
+    for (unsigned g = 0; g < RSA_MERKLE_FANOUT; g++) {
+        apply.starts[g] = pos;
+        size_t start = pos;
+        while (pos < count && key_nibble(batch->updates[pos].key, 0) == g) pos++;
+        groups += pos > start;
+    }
+    apply.starts[RSA_MERKLE_FANOUT] = pos;
+
+    if (threads > RSA_MERKLE_MAX_THREADS) threads = RSA_MERKLE_MAX_THREADS;
+    if (threads > groups) threads = groups;
+    if (!workers || threads < 1) threads = 1;
+    rsa_worker_pool_run(workers, threads, apply_worker, &apply);
+
+    batch->count = 0;
+    merkle_rehash_root(tree);
+    return !apply.failed;
+}
+
+void rsa_merkle_root(const rsa_merkle_tree_t *tree, uint8_t root[32]) {
+    if (!root) return;
+    if (!tree) {
+        memset(root, 0, 32);
+        return;
+    }
+    memcpy(root, tree->root, 32);
+}
+
+size_t rsa_merkle_size(const rsa_merkle_tree_t *tree) {
+    if (!tree) return 0;
+    size_t size = 0;
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) size += tree->pools[i].leaf_live;
+    return size;
+}
+
+size_t rsa_merkle_memory(const rsa_merkle_tree_t *tree) {
+    if (!tree) return 0;
+    size_t bytes = 0;
+    for (unsigned i = 0; i < RSA_MERKLE_FANOUT; i++) {
+        const rsa_merkle_pool_t *pool = &tree->pools[i];
+        bytes += pool->node_chunk_count * (RSA_MERKLE_CHUNK_SIZE * sizeof(rsa_merkle_node_t) + sizeof(void *));
+        bytes += pool->leaf_chunk_count * (RSA_MERKLE_CHUNK_SIZE * sizeof(rsa_merkle_leaf_t) + sizeof(void *));
+    }
+    return bytes;
+}
@@ -0,0 +1,118 @@
+#ifndef RSA_MERKLE_H
+#define RSA_MERKLE_H
+
+#include "rsa_token.h"
+#include "rsa_wal.h"
+#include "rsa_worker_pool.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LEDGER STATE MERKLE TREE
+// ========================
+// Sparse 16-ary Merkle trie over SHA-256(entry key), committing to every
+// ledger entry. The root is the ledger header's state_hash.
+//
+//   leaf      SHA-256(0x00 || key hash || value hash)
+//   interior  SHA-256(0x01 || 16-bit child bitmap || present child hashes)
+//
+// A subtree holding one entry is that entry's leaf and an empty tree
+// hashes to 32 zero bytes, so the root depends only on the set of entries,
+// never on insertion order or on how the tree is stored.
+//
+// Updates are applied per ledger as a batch: only the paths to dirtied
+// entries are rehashed, each shared interior node once. The 16 subtrees
+// under the root live in separate node pools and are updated by parallel
+// workers, so close time follows the number of changed entries rather
+// than the size of the state.
+//
+// Not thread-safe; rsa_merkle_apply() runs its workers on the caller's
+// pool (rsa_worker_pool.h).
+
+#define RSA_MERKLE_FANOUT 16
+#define RSA_MERKLE_MAX_THREADS RSA_MERKLE_FANOUT
+#define RSA_MERKLE_CHUNK_SIZE 4096
+
+// Interior node; children are pool refs (0 = empty)
+typedef struct {
+    uint8_t hash[32];
+    uint32_t children[RSA_MERKLE_FANOUT];
+} rsa_merkle_node_t;
+
+typedef struct {
+    uint8_t key[32];
+    uint8_t hash[32];
+} rsa_merkle_leaf_t;
+
+// Nodes and leaves of one root subtree, in chunks that never move
+typedef struct {
+    rsa_merkle_node_t **node_chunks;
+    size_t node_chunk_count;
+    uint32_t node_count;            // high-water mark
+    uint32_t node_free;             // free list through children[0]
+    uint32_t node_live;
+    rsa_merkle_leaf_t **leaf_chunks;
+    size_t leaf_chunk_count;
+    uint32_t leaf_count;
+    uint32_t leaf_free;
+    uint32_t leaf_live;
+} rsa_merkle_pool_t;
+
+typedef struct {
+    uint32_t roots[RSA_MERKLE_FANOUT];          // child refs of the root, one per pool
+    rsa_merkle_pool_t pools[RSA_MERKLE_FANOUT];
+    uint8_t root[32];
+} rsa_merkle_tree_t;
+
+// One pending change: value hash, or erase
+typedef struct {
+    uint8_t key[32];
+    uint8_t value[32];
+    uint32_t sequence;              // batch order; the last change to a key wins
+    bool erase;
+} rsa_merkle_update_t;
+
+typedef struct {
+    rsa_merkle_update_t *updates;
+    size_t count;
+    size_t capacity;
+} rsa_merkle_batch_t;
+
+bool rsa_merkle_tree_init(rsa_merkle_tree_t *tree);
+void rsa_merkle_tree_free(rsa_merkle_tree_t *tree);
+
+void rsa_merkle_batch_init(rsa_merkle_batch_t *batch);
+void rsa_merkle_batch_free(rsa_merkle_batch_t *batch);
+void rsa_merkle_batch_reset(rsa_merkle_batch_t *batch);
+
+// Raw key / value hashes
+bool rsa_merkle_batch_put(rsa_merkle_batch_t *batch, const uint8_t key[32], const uint8_t value[32]);
+bool rsa_merkle_batch_erase(rsa_merkle_batch_t *batch, const uint8_t key[32]);
+
+// Ledger entries (rsa_account_t, rsa_trustline_t, ...), hashed in their
+// canonical form (rsa_wal_entry_normalize)
+bool rsa_merkle_batch_put_entry(rsa_merkle_batch_t *batch, rsa_wal_entry_type_t type,
+                                const void *record);
+bool rsa_merkle_batch_erase_entry(rsa_merkle_batch_t *batch, rsa_wal_entry_type_t type,
+                                  const void *record);
+bool rsa_merkle_entry_hashes(rsa_wal_entry_type_t type, const void *record,
+                             uint8_t key[32], uint8_t value[32]);
+
+// Applies and clears the batch, then recomputes the root, on up to
+// `threads` of `workers` (capped at RSA_MERKLE_MAX_THREADS and the pool's
+// size); a NULL pool, 0 or 1 runs inline. On allocation failure the tree is
+// left partially updated and must be rebuilt.
+bool rsa_merkle_apply(rsa_merkle_tree_t *tree, rsa_merkle_batch_t *batch,
+                      rsa_worker_pool_t *workers, unsigned threads);
+
+void rsa_merkle_root(const rsa_merkle_tree_t *tree, uint8_t root[32]);
+size_t rsa_merkle_size(const rsa_merkle_tree_t *tree);
+size_t rsa_merkle_memory(const rsa_merkle_tree_t *tree);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_MERKLE_H
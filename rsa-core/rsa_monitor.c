@@ -1,4 +1,7 @@
 #include "rsa_token.h"
+#include "rsa_validation.h"
+#include "rsa_ledger.h"
+#include "rsa_wal.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,6 +26,26 @@ static pthread_t g_monitor_thread;
 static FILE *g_monitor_log = NULL;
 static FILE *g_alert_log = NULL;
 
+// Alert throttling state, one slot per alert type; the least recently
+// raised type gives up its slot when all are taken
+#define RSA_ALERT_THROTTLE_SLOTS 32
+
+typedef struct {
+    const char *alert_type;
+    uint64_t last_emit_time;
+    uint64_t last_seen;             // g_alert_throttle_clock when last raised
+    uint64_t suppressed;
+} rsa_alert_throttle_t;
+
+static rsa_alert_throttle_t g_alert_throttle[RSA_ALERT_THROTTLE_SLOTS];
+static pthread_mutex_t g_alert_throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t g_alert_throttle_clock;     // orders raises; seconds are too coarse
+
+// Slab pool occupancy keys, by rsa_wal_entry_type_t
+static const char *const slab_type_names[RSA_WAL_ENTRY_TYPE_COUNT] = {
+    "accounts", "trustlines", "offers", "data"
+};
+
 // Emergency shutdown handler
 void rsa_emergency_shutdown(int sig) {
     (void)sig; // Suppress unused parameter warning
@@ -87,6 +110,38 @@ void rsa_write_stats(void) {
     fprintf(stats_file, "  \"total_operations\": %lu,\n", g_rsa_monitor.total_operations);
     fprintf(stats_file, "  \"memory_usage\": %lu,\n", g_rsa_monitor.memory_usage);
     fprintf(stats_file, "  \"corruption_detections\": %lu,\n", g_rsa_monitor.corruption_detections);
+    fprintf(stats_file, "  \"alerts_suppressed\": %lu,\n", g_rsa_monitor.alerts_suppressed);
+    fprintf(stats_file, "  \"validation_rejections\": {");
+    bool first = true;
+    for (int i = 1; i < RSA_VALIDATION_RESULT_COUNT; i++) {
+        uint64_t count = __atomic_load_n(&g_rsa_monitor.validation_rejections[i], __ATOMIC_RELAXED);
+        if (count == 0) continue;
+        fprintf(stats_file, "%s\n    \"%s\": %lu", first ? "" : ",",
+                rsa_validation_result_str((rsa_validation_result_t)i), count);
+        first = false;
+    }
+    fprintf(stats_file, "%s},\n", first ? "" : "\n  ");
+    fprintf(stats_file, "  \"ledger_close\": {\n");
+    fprintf(stats_file, "    \"ledgers_closed\": %lu,\n",
+            __atomic_load_n(&g_rsa_monitor.ledgers_closed, __ATOMIC_RELAXED));
+    fprintf(stats_file, "    \"apply_mismatches\": %lu",
+            __atomic_load_n(&g_rsa_monitor.ledger_apply_mismatches, __ATOMIC_RELAXED));
+    for (int i = 0; i < RSA_LEDGER_PHASE_COUNT; i++) {
+        fprintf(stats_file, ",\n    \"%s\": { \"total_ns\": %lu, \"last_ns\": %lu }",
+                rsa_ledger_phase_str((rsa_ledger_phase_t)i),
+                __atomic_load_n(&g_rsa_monitor.ledger_phase_ns[i], __ATOMIC_RELAXED),
+                __atomic_load_n(&g_rsa_monitor.ledger_phase_last_ns[i], __ATOMIC_RELAXED));
+    }
+    fprintf(stats_file, "\n  },\n");
+    fprintf(stats_file, "  \"slab_pools\": {");
+    for (int i = 0; i < RSA_WAL_ENTRY_TYPE_COUNT; i++) {
+        fprintf(stats_file, "%s\n    \"%s\": { \"live\": %lu, \"slots\": %lu, \"moved\": %lu }",
+                i ? "," : "", slab_type_names[i],
+                __atomic_load_n(&g_rsa_monitor.slab_live[i], __ATOMIC_RELAXED),
+                __atomic_load_n(&g_rsa_monitor.slab_slots[i], __ATOMIC_RELAXED),
+                __atomic_load_n(&g_rsa_monitor.slab_moved[i], __ATOMIC_RELAXED));
+    }
+    fprintf(stats_file, "\n  },\n");
     fprintf(stats_file, "  \"max_concurrent_limit\": %d,\n", RSA_MAX_CONCURRENT_OPS);
     fprintf(stats_file, "  \"memory_threshold\": %d,\n", RSA_MEMORY_CORRUPTION_THRESHOLD);
     fprintf(stats_file, "  \"status\": \"%s\"\n", 
@@ -138,6 +193,9 @@ void* rsa_monitor_thread_func(void* arg) {
         // Write statistics
         rsa_write_stats();
         
+        // Emit aggregated summaries for throttled alerts
+        rsa_flush_throttled_alerts();
+        
         // Log monitoring data
         if (g_monitor_log) {
             time_t now = time(NULL);
@@ -212,6 +270,104 @@ void rsa_get_monitor_stats(rsa_ops_monitor_t *stats) {
     pthread_mutex_unlock(&g_monitor_mutex);
 }
 
+// Throttled alerts: the first alert of a type is emitted immediately, later
+// ones within RSA_ALERT_THROTTLE_SECONDS are only counted and reported in
+// aggregate by the next emitted alert or by rsa_flush_throttled_alerts().
+// A type evicted with suppressed alerts pending hands them back through
+// *evicted_type / *evicted_suppressed for the caller to report.
+static rsa_alert_throttle_t *rsa_find_throttle_slot(const char *alert_type,
+                                                    const char **evicted_type,
+                                                    uint64_t *evicted_suppressed) {
+    rsa_alert_throttle_t *oldest = &g_alert_throttle[0];
+    for (int i = 0; i < RSA_ALERT_THROTTLE_SLOTS; i++) {
+        rsa_alert_throttle_t *slot = &g_alert_throttle[i];
+        if (!slot->alert_type) {
+            slot->alert_type = alert_type;
+            return slot;
+        }
+        if (slot->alert_type == alert_type || strcmp(slot->alert_type, alert_type) == 0) {
+            return slot;
+        }
+        if (slot->last_seen < oldest->last_seen) oldest = slot;
+    }
+
+    if (oldest->suppressed > 0) {
+        *evicted_type = oldest->alert_type;
+        *evicted_suppressed = oldest->suppressed;
+    }
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->alert_type = alert_type;
+    return oldest;
+}
+
+bool rsa_trigger_alert_throttled(const char *alert_type, const char *message) {
+    if (!alert_type || !message) return false;
+    
+    uint64_t now = rsa_get_current_time();
+    uint64_t suppressed = 0;
+    const char *evicted_type = NULL;
+    uint64_t evicted_suppressed = 0;
+    
+    pthread_mutex_lock(&g_alert_throttle_mutex);
+    rsa_alert_throttle_t *slot = rsa_find_throttle_slot(alert_type, &evicted_type,
+                                                        &evicted_suppressed);
+    slot->last_seen = ++g_alert_throttle_clock;
+    if (slot->last_emit_time != 0 && now < slot->last_emit_time + RSA_ALERT_THROTTLE_SECONDS) {
+        slot->suppressed++;
+        pthread_mutex_unlock(&g_alert_throttle_mutex);
+        __atomic_fetch_add(&g_rsa_monitor.alerts_suppressed, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    suppressed = slot->suppressed;
+    slot->suppressed = 0;
+    slot->last_emit_time = now;
+    pthread_mutex_unlock(&g_alert_throttle_mutex);
+    
+    if (evicted_type) {
+        char aggregated[256];
+        snprintf(aggregated, sizeof(aggregated), "%lu occurrences before its throttle slot was reused",
+                 evicted_suppressed);
+        rsa_trigger_alert(evicted_type, aggregated);
+    }
+    
+    if (suppressed > 0) {
+        char aggregated[512];
+        snprintf(aggregated, sizeof(aggregated), "%s (%lu similar alerts suppressed)",
+                 message, suppressed);
+        rsa_trigger_alert(alert_type, aggregated);
+    } else {
+        rsa_trigger_alert(alert_type, message);
+    }
+    return true;
+}
+
+void rsa_flush_throttled_alerts(void) {
+    uint64_t now = rsa_get_current_time();
+    
+    for (int i = 0; i < RSA_ALERT_THROTTLE_SLOTS; i++) {
+        const char *alert_type = NULL;
+        uint64_t suppressed = 0;
+        
+        pthread_mutex_lock(&g_alert_throttle_mutex);
+        rsa_alert_throttle_t *slot = &g_alert_throttle[i];
+        if (slot->alert_type && slot->suppressed > 0 &&
+            now >= slot->last_emit_time + RSA_ALERT_THROTTLE_SECONDS) {
+            alert_type = slot->alert_type;
+            suppressed = slot->suppressed;
+            slot->suppressed = 0;
+            slot->last_emit_time = now;
+        }
+        pthread_mutex_unlock(&g_alert_throttle_mutex);
+        
+        if (alert_type) {
+            char aggregated[256];
+            snprintf(aggregated, sizeof(aggregated), "%lu occurrences in the last %d seconds",
+                     suppressed, RSA_ALERT_THROTTLE_SECONDS);
+            rsa_trigger_alert(alert_type, aggregated);
+        }
+    }
+}
+
 // Enhanced alert system with escalation
 void rsa_trigger_critical_alert(const char *alert_type, const char *message) {
     // Log to syslog with high priority
@@ -0,0 +1,545 @@
+#include "rsa_mvcc.h"
+#include "rsa_asset_intern.h"
+#include <stdlib.h>
+#include <string.h>
+
+// VERSIONED LEDGER STATE
+// ======================
+//
+// Reclamation: an object retired while ledger N is staged is tagged N. A
+// reader pinned at N or later never reaches it: superseded versions are
+// skipped because their successor is already visible, and a retired index
+// was unpublished before N was. So the object is freed once every pin and
+// the pinnable floor have reached N. Readers store their pin and then
+// re-check the floor, while commit stores the floor and then scans the
+// pins (both seq_cst), so one of the two always sees the other.
+
+#define INDEX_MIN_CAPACITY 64
+
+#define VERSION_DELETED (1ULL << 63)
+
+// Versions are immutable once their ledger is committed; the staged
+// version of the ledger being built is rewritten in place, key bytes
+// excepted, since no reader can pin its ledger yet. The 16-byte header
+// puts every entry type within 8 bytes of whole cache-line slots.
+struct rsa_mvcc_version {
+    uint64_t stamp;                     // ledger that wrote it | VERSION_DELETED
+    rsa_mvcc_version_t *older;          // previous version, cut when it is freed
+    uint8_t record[];                   // a tombstone keeps the key
+};
+
+_Static_assert(sizeof(rsa_mvcc_version_t) == 16, "version header grew");
+
+// Readers load the stamp of the staged version while the writer may
+// flip its tombstone flag
+static inline uint64_t version_seq(const rsa_mvcc_version_t *version) {
+    return __atomic_load_n(&version->stamp, __ATOMIC_RELAXED) & ~VERSION_DELETED;
+}
+
+static inline bool version_deleted(const rsa_mvcc_version_t *version) {
+    return (__atomic_load_n(&version->stamp, __ATOMIC_RELAXED) & VERSION_DELETED) != 0;
+}
+
+static inline void version_set_deleted(rsa_mvcc_version_t *version, bool deleted) {
+    __atomic_store_n(&version->stamp, version_seq(version) | (deleted ? VERSION_DELETED : 0),
+                     __ATOMIC_RELAXED);
+}
+
+// A slot is taken when newest is non-NULL; hash is written first and never
+// changes while the index is published
+typedef struct {
+    uint64_t hash;
+    rsa_mvcc_version_t *newest;
+} mvcc_slot_t;
+
+struct rsa_mvcc_index {
+    size_t mask;
+    mvcc_slot_t slots[];
+};
+
+typedef union {
+    rsa_account_t account;
+    rsa_trustline_t trustline;
+    rsa_offer_t offer;
+    rsa_data_t data;
+} mvcc_record_t;
+
+// Keyed per store so crafted keys cannot pile into one probe run
+static inline uint64_t mvcc_hash(const rsa_mvcc_store_t *store, const void *key) {
+    if (store->key_size == 32) return rsa_hash_32(&store->key, key);
+    return rsa_hash_bytes(&store->key, key, store->key_size);
+}
+
+static inline const uint8_t *version_key(const rsa_mvcc_store_t *store,
+                                         const rsa_mvcc_version_t *version) {
+    return version->record + store->key_offset;
+}
+
+static inline uint64_t staged_seq(const rsa_mvcc_domain_t *domain) {
+    return __atomic_load_n(&domain->published, __ATOMIC_RELAXED) + 1;
+}
+
+// RECLAMATION
+// -----------
+
+static bool retired_reserve(rsa_mvcc_domain_t *domain, size_t extra) {
+    if (domain->retired_count + extra <= domain->retired_capacity) return true;
+
+    size_t capacity = domain->retired_capacity ? domain->retired_capacity : 256;
+    while (capacity < domain->retired_count + extra) capacity *= 2;
+    rsa_mvcc_retired_t *grown = malloc(capacity * sizeof(*grown));
+    if (!grown) return false;
+    for (size_t i = 0; i < domain->retired_count; i++) {
+        grown[i] = domain->retired[(domain->retired_head + i) % domain->retired_capacity];
+    }
+    free(domain->retired);
+    domain->retired = grown;
+    domain->retired_head = 0;
+    domain->retired_capacity = capacity;
+    return true;
+}
+
+// Space must have been reserved. `pool` is the version's, NULL for an index.
+static void retire(rsa_mvcc_domain_t *domain, void *ptr, rsa_slab_pool_t *pool,
+                   rsa_mvcc_version_t *successor) {
+    size_t tail = (domain->retired_head + domain->retired_count) % domain->retired_capacity;
+    domain->retired[tail].ptr = ptr;
+    domain->retired[tail].pool = pool;
+    domain->retired[tail].successor = successor;
+    domain->retired[tail].seq = staged_seq(domain);
+    domain->retired_count++;
+}
+
+static size_t free_through(rsa_mvcc_domain_t *domain, uint64_t horizon) {
+    size_t freed = 0;
+    while (domain->retired_count > 0) {
+        rsa_mvcc_retired_t *entry = &domain->retired[domain->retired_head];
+        if (entry->seq > horizon) break;
+        if (entry->successor) {
+            __atomic_store_n(&entry->successor->older, NULL, __ATOMIC_RELAXED);
+        }
+        if (entry->pool) {
+            rsa_slab_free(entry->pool, entry->ptr);
+        } else {
+            free(entry->ptr);
+        }
+        domain->retired_head = (domain->retired_head + 1) % domain->retired_capacity;
+        domain->retired_count--;
+        freed++;
+    }
+    return freed;
+}
+
+size_t rsa_mvcc_reclaim(rsa_mvcc_domain_t *domain) {
+    if (!domain) return 0;
+
+    uint64_t horizon = __atomic_load_n(&domain->floor, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < RSA_MVCC_MAX_READERS; i++) {
+        uint64_t pin = __atomic_load_n(&domain->readers[i].pin, __ATOMIC_SEQ_CST);
+        if (pin < horizon) horizon = pin;
+    }
+    domain->horizon = horizon;
+    return free_through(domain, horizon);
+}
+
+uint64_t rsa_mvcc_commit(rsa_mvcc_domain_t *domain) {
+    if (!domain) return 0;
+
+    uint64_t seq = staged_seq(domain);
+    __atomic_store_n(&domain->published, seq, __ATOMIC_SEQ_CST);
+    uint64_t floor = seq > domain->retain ? seq - domain->retain : 0;
+    if (floor > __atomic_load_n(&domain->floor, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&domain->floor, floor, __ATOMIC_SEQ_CST);
+    }
+    rsa_mvcc_reclaim(domain);
+    return seq;
+}
+
+bool rsa_mvcc_domain_init(rsa_mvcc_domain_t *domain, uint64_t ledger_seq, uint64_t retain) {
+    if (!domain || ledger_seq == RSA_MVCC_IDLE) return false;
+
+    memset(domain, 0, sizeof(*domain));
+    domain->published = ledger_seq;
+    domain->floor = ledger_seq;
+    domain->horizon = ledger_seq;
+    domain->retain = retain;
+    for (size_t i = 0; i < RSA_MVCC_MAX_READERS; i++) {
+        domain->readers[i].pin = RSA_MVCC_IDLE;
+    }
+    return true;
+}
+
+void rsa_mvcc_domain_free(rsa_mvcc_domain_t *domain) {
+    if (!domain) return;
+    free_through(domain, RSA_MVCC_IDLE);
+    free(domain->retired);
+    memset(domain, 0, sizeof(*domain));
+}
+
+// INDEX
+// -----
+
+static rsa_mvcc_index_t *index_create(size_t capacity) {
+    rsa_mvcc_index_t *index = calloc(1, sizeof(*index) + capacity * sizeof(mvcc_slot_t));
+    if (!index) return NULL;
+    index->mask = capacity - 1;
+    return index;
+}
+
+static size_t index_capacity_for(size_t entries) {
+    size_t capacity = INDEX_MIN_CAPACITY;
+    while (capacity * 3 / 4 < entries) capacity *= 2;
+    return capacity;
+}
+
+// Writer-side lookup; the slot holding key, or the empty slot ending its run
+static mvcc_slot_t *index_slot(const rsa_mvcc_store_t *store, const void *key, uint64_t hash) {
+    rsa_mvcc_index_t *index = store->index;
+    for (size_t pos = hash & index->mask;; pos = (pos + 1) & index->mask) {
+        mvcc_slot_t *slot = &index->slots[pos];
+        if (!slot->newest) return slot;
+        if (slot->hash == hash &&
+            memcmp(version_key(store, slot->newest), key, store->key_size) == 0) {
+            return slot;
+        }
+    }
+}
+
+// Tombstones no view can see past are dropped; their key is absent for
+// every pinnable ledger either way
+static bool droppable(const rsa_mvcc_domain_t *domain, const rsa_mvcc_version_t *version) {
+    return version_deleted(version) && version_seq(version) <= domain->horizon &&
+           !__atomic_load_n(&version->older, __ATOMIC_RELAXED);
+}
+
+// Rebuilds the index off to the side and publishes it; readers still
+// probing the old one finish there safely before it is freed
+static bool index_rebuild(rsa_mvcc_store_t *store) {
+    rsa_mvcc_domain_t *domain = store->domain;
+    rsa_mvcc_index_t *old = store->index;
+
+    size_t kept = 0, dropped = 0;
+    for (size_t i = 0; i <= old->mask; i++) {
+        rsa_mvcc_version_t *newest = old->slots[i].newest;
+        if (!newest) continue;
+        if (droppable(domain, newest)) dropped++;
+        else kept++;
+    }
+    if (!retired_reserve(domain, dropped + 1)) return false;
+    rsa_mvcc_index_t *rebuilt = index_create(index_capacity_for((kept + 1) * 2));
+    if (!rebuilt) return false;
+
+    for (size_t i = 0; i <= old->mask; i++) {
+        mvcc_slot_t *slot = &old->slots[i];
+        if (!slot->newest || droppable(domain, slot->newest)) continue;
+        size_t pos = slot->hash & rebuilt->mask;
+        while (rebuilt->slots[pos].newest) pos = (pos + 1) & rebuilt->mask;
+        rebuilt->slots[pos] = *slot;
+    }
+    __atomic_store_n(&store->index, rebuilt, __ATOMIC_RELEASE);
+
+    for (size_t i = 0; i <= old->mask; i++) {
+        rsa_mvcc_version_t *newest = old->slots[i].newest;
+        if (newest && droppable(domain, newest)) retire(domain, newest, &store->versions, NULL);
+    }
+    retire(domain, old, NULL, NULL);
+    store->used = kept;
+    return true;
+}
+
+// STORE
+// -----
+
+bool rsa_mvcc_store_init(rsa_mvcc_store_t *store, rsa_mvcc_domain_t *domain,
+                         rsa_wal_entry_type_t type, size_t capacity) {
+    if (!store || !domain) return false;
+
+    memset(store, 0, sizeof(*store));
+    switch (type) {
+        case RSA_WAL_ACCOUNT:
+            store->key_size = sizeof(((rsa_account_t *)0)->account_id);
+            break;
+        case RSA_WAL_TRUSTLINE:
+            store->key_size = rsa_wal_key_size[type];
+            break;
+        case RSA_WAL_OFFER:
+            store->key_offset = offsetof(rsa_offer_t, offer_id);
+            store->key_size = sizeof(uint64_t);
+            break;
+        case RSA_WAL_DATA:
+            store->key_size = rsa_wal_key_size[type];
+            break;
+        default:
+            return false;
+    }
+    store->domain = domain;
+    store->type = type;
+    store->record_size = rsa_wal_entry_size[type];
+    rsa_hash_key_init(&store->key, store);
+    rsa_slab_config_t versions = {
+        .object_size = sizeof(rsa_mvcc_version_t) + store->record_size,
+        .monitor_type = (int)type,
+    };
+    if (!rsa_slab_pool_init(&store->versions, &versions)) return false;
+    store->index = index_create(index_capacity_for(capacity));
+    if (!store->index) {
+        rsa_slab_pool_free(&store->versions);
+        return false;
+    }
+    return true;
+}
+
+void rsa_mvcc_store_free(rsa_mvcc_store_t *store) {
+    if (!store || !store->index) return;
+
+    // Drains the retired list, which may hold this store's versions; the
+    // newest versions go with the pool
+    free_through(store->domain, RSA_MVCC_IDLE);
+    free(store->index);
+    rsa_slab_pool_free(&store->versions);
+    memset(store, 0, sizeof(*store));
+}
+
+static rsa_mvcc_version_t *version_create(rsa_mvcc_store_t *store, const void *image,
+                                          rsa_mvcc_version_t *older, bool deleted) {
+    rsa_mvcc_version_t *version = rsa_slab_alloc(&store->versions);
+    if (!version) return NULL;
+    version->stamp = staged_seq(store->domain) | (deleted ? VERSION_DELETED : 0);
+    version->older = older;
+    memcpy(version->record, image, store->record_size);
+    return version;
+}
+
+// Rewrites a staged version around its key
+static void version_overwrite(const rsa_mvcc_store_t *store, rsa_mvcc_version_t *version,
+                              const uint8_t *image) {
+    size_t key_end = store->key_offset + store->key_size;
+    memcpy(version->record, image, store->key_offset);
+    memcpy(version->record + key_end, image + key_end, store->record_size - key_end);
+}
+
+bool rsa_mvcc_put(rsa_mvcc_store_t *store, const void *record) {
+    mvcc_record_t image;
+    if (!store || !rsa_wal_entry_normalize(store->type, record, &image)) return false;
+
+    rsa_mvcc_domain_t *domain = store->domain;
+    const uint8_t *bytes = (const uint8_t *)&image;
+    const uint8_t *key = bytes + store->key_offset;
+    uint64_t hash = mvcc_hash(store, key);
+    mvcc_slot_t *slot = index_slot(store, key, hash);
+    rsa_mvcc_version_t *newest = slot->newest;
+
+    if (newest && version_seq(newest) == staged_seq(domain)) {
+        version_overwrite(store, newest, bytes);
+        if (version_deleted(newest)) {
+            version_set_deleted(newest, false);
+            store->live++;
+        }
+        return true;
+    }
+
+    if (newest) {
+        if (!retired_reserve(domain, 1)) return false;
+        rsa_mvcc_version_t *version = version_create(store, bytes, newest, false);
+        if (!version) return false;
+        __atomic_store_n(&slot->newest, version, __ATOMIC_RELEASE);
+        retire(domain, newest, &store->versions, version);
+        if (version_deleted(newest)) store->live++;
+        return true;
+    }
+
+    if (store->used + 1 > (store->index->mask + 1) * 3 / 4) {
+        if (!index_rebuild(store)) return false;
+        slot = index_slot(store, key, hash);
+    }
+    rsa_mvcc_version_t *version = version_create(store, bytes, NULL, false);
+    if (!version) return false;
+    slot->hash = hash;
+    __atomic_store_n(&slot->newest, version, __ATOMIC_RELEASE);
+    store->used++;
+    store->live++;
+    return true;
+}
+
+bool rsa_mvcc_erase(rsa_mvcc_store_t *store, const void *record) {
+    mvcc_record_t image;
+    if (!store || !rsa_wal_entry_normalize(store->type, record, &image)) return false;
+
+    rsa_mvcc_domain_t *domain = store->domain;
+    const uint8_t *key = (const uint8_t *)&image + store->key_offset;
+    mvcc_slot_t *slot = index_slot(store, key, mvcc_hash(store, key));
+    rsa_mvcc_version_t *newest = slot->newest;
+    if (!newest || version_deleted(newest)) return false;
+
+    if (version_seq(newest) == staged_seq(domain)) {
+        version_set_deleted(newest, true);
+    } else {
+        if (!retired_reserve(domain, 1)) return false;
+        rsa_mvcc_version_t *tombstone = version_create(store, newest->record, newest, true);
+        if (!tombstone) return false;
+        __atomic_store_n(&slot->newest, tombstone, __ATOMIC_RELEASE);
+        retire(domain, newest, &store->versions, tombstone);
+    }
+    store->live--;
+    return true;
+}
+
+const void *rsa_mvcc_latest(const rsa_mvcc_store_t *store, const void *key) {
+    if (!store || !key) return NULL;
+    const rsa_mvcc_version_t *newest = index_slot(store, key, mvcc_hash(store, key))->newest;
+    return newest && !version_deleted(newest) ? newest->record : NULL;
+}
+
+// Every link to a moved version is rewritten: index slots, older links
+// down each chain, and the retired list. Retired indexes still point at
+// versions, but are only ever freed.
+bool rsa_mvcc_compact(rsa_mvcc_store_t *store, size_t *moved) {
+    if (moved) *moved = 0;
+    if (!store || !store->index) return false;
+
+    // Raise the gate, then look for claims: a view claiming its slot
+    // meanwhile either is seen here or sees the gate (both sequentially
+    // consistent) and backs out
+    rsa_mvcc_domain_t *domain = store->domain;
+    __atomic_store_n(&domain->compacting, 1, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < RSA_MVCC_MAX_READERS; i++) {
+        if (__atomic_load_n(&domain->readers[i].claimed, __ATOMIC_SEQ_CST)) {
+            __atomic_store_n(&domain->compacting, 0, __ATOMIC_RELEASE);
+            return false;
+        }
+    }
+    rsa_slab_pool_t *pool = &store->versions;
+    size_t count = rsa_slab_compact(pool);
+    if (count == 0) {
+        __atomic_store_n(&domain->compacting, 0, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    rsa_mvcc_index_t *index = store->index;
+    for (size_t i = 0; i <= index->mask; i++) {
+        rsa_mvcc_version_t *version = rsa_slab_forward(pool, index->slots[i].newest);
+        index->slots[i].newest = version;
+        for (; version; version = version->older) {
+            version->older = rsa_slab_forward(pool, version->older);
+        }
+    }
+    for (size_t i = 0; i < domain->retired_count; i++) {
+        rsa_mvcc_retired_t *entry =
+            &domain->retired[(domain->retired_head + i) % domain->retired_capacity];
+        if (entry->pool != pool) continue;
+        entry->ptr = rsa_slab_forward(pool, entry->ptr);
+        entry->successor = rsa_slab_forward(pool, entry->successor);
+    }
+    rsa_slab_compact_finish(pool);
+    __atomic_store_n(&domain->compacting, 0, __ATOMIC_RELEASE);
+    if (moved) *moved = count;
+    return true;
+}
+
+// VIEWS
+// -----
+
+// Claims a slot, then backs out if compaction is under way (see
+// rsa_mvcc_compact for the ordering)
+static bool view_claim(rsa_mvcc_domain_t *domain, rsa_mvcc_view_t *view) {
+    if (__atomic_load_n(&domain->compacting, __ATOMIC_RELAXED)) return false;
+    for (uint32_t i = 0; i < RSA_MVCC_MAX_READERS; i++) {
+        uint32_t expected = 0;
+        if (__atomic_load_n(&domain->readers[i].claimed, __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&domain->readers[i].claimed, &expected, 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            if (__atomic_load_n(&domain->compacting, __ATOMIC_SEQ_CST)) {
+                __atomic_store_n(&domain->readers[i].claimed, 0, __ATOMIC_RELEASE);
+                return false;
+            }
+            view->domain = domain;
+            view->slot = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool rsa_mvcc_view_open(rsa_mvcc_domain_t *domain, rsa_mvcc_view_t *view) {
+    if (!domain || !view || !view_claim(domain, view)) return false;
+
+    uint64_t *pin = &domain->readers[view->slot].pin;
+    uint64_t seq;
+    do {
+        seq = __atomic_load_n(&domain->published, __ATOMIC_SEQ_CST);
+        __atomic_store_n(pin, seq, __ATOMIC_SEQ_CST);
+    } while (seq < __atomic_load_n(&domain->floor, __ATOMIC_SEQ_CST));
+    view->seq = seq;
+    return true;
+}
+
+bool rsa_mvcc_view_open_at(rsa_mvcc_domain_t *domain, rsa_mvcc_view_t *view, uint64_t ledger_seq) {
+    if (!domain || !view || ledger_seq > __atomic_load_n(&domain->published, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    if (!view_claim(domain, view)) return false;
+
+    __atomic_store_n(&domain->readers[view->slot].pin, ledger_seq, __ATOMIC_SEQ_CST);
+    if (ledger_seq < __atomic_load_n(&domain->floor, __ATOMIC_SEQ_CST)) {
+        rsa_mvcc_view_close(view);
+        return false;
+    }
+    view->seq = ledger_seq;
+    return true;
+}
+
+void rsa_mvcc_view_close(rsa_mvcc_view_t *view) {
+    if (!view || !view->domain) return;
+    rsa_mvcc_reader_slot_t *slot = &view->domain->readers[view->slot];
+    __atomic_store_n(&slot->pin, RSA_MVCC_IDLE, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot->claimed, 0, __ATOMIC_RELEASE);
+    view->domain = NULL;
+}
+
+const void *rsa_mvcc_view_get(const rsa_mvcc_view_t *view, const rsa_mvcc_store_t *store,
+                              const void *key) {
+    if (!view || !store || !key || view->domain != store->domain) return NULL;
+
+    const rsa_mvcc_index_t *index = __atomic_load_n(&store->index, __ATOMIC_ACQUIRE);
+    uint64_t hash = mvcc_hash(store, key);
+    for (size_t pos = hash & index->mask, probes = 0; probes <= index->mask;
+         pos = (pos + 1) & index->mask, probes++) {
+        const mvcc_slot_t *slot = &index->slots[pos];
+        const rsa_mvcc_version_t *version = __atomic_load_n(&slot->newest, __ATOMIC_ACQUIRE);
+        if (!version) return NULL;
+        if (slot->hash != hash ||
+            memcmp(version_key(store, version), key, store->key_size) != 0) {
+            continue;
+        }
+        while (version && version_seq(version) > view->seq) {
+            version = __atomic_load_n(&version->older, __ATOMIC_ACQUIRE);
+        }
+        return version && !version_deleted(version) ? version->record : NULL;
+    }
+    return NULL;
+}
+
+const rsa_account_t *rsa_mvcc_get_account(const rsa_mvcc_view_t *view,
+                                          const rsa_mvcc_store_t *accounts,
+                                          const uint32_t account_id[8]) {
+    if (!accounts || accounts->type != RSA_WAL_ACCOUNT) return NULL;
+    return rsa_mvcc_view_get(view, accounts, account_id);
+}
+
+const rsa_trustline_t *rsa_mvcc_get_trustline(const rsa_mvcc_view_t *view,
+                                              const rsa_mvcc_store_t *trustlines,
+                                              const uint32_t account_id[8],
+                                              const rsa_asset_t *asset) {
+    if (!trustlines || trustlines->type != RSA_WAL_TRUSTLINE || !account_id) return NULL;
+
+    rsa_trustline_t key;
+    memcpy(key.account_id, account_id, sizeof(key.account_id));
+    if (!rsa_asset_canonicalize(asset, &key.asset)) return NULL;
+    return rsa_mvcc_view_get(view, trustlines, &key);
+}
+
+const rsa_offer_t *rsa_mvcc_get_offer(const rsa_mvcc_view_t *view,
+                                      const rsa_mvcc_store_t *offers, uint64_t offer_id) {
+    if (!offers || offers->type != RSA_WAL_OFFER) return NULL;
+    return rsa_mvcc_view_get(view, offers, &offer_id);
+}
@@ -0,0 +1,154 @@
+#ifndef RSA_MVCC_H
+#define RSA_MVCC_H
+
+#include "rsa_token.h"
+#include "rsa_hash.h"
+#include "rsa_slab.h"
+#include "rsa_wal.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// VERSIONED LEDGER STATE
+// ======================
+// Multi-version copy of the account / trustline / offer state for query
+// readers (horizon, explorer) running alongside ledger apply.
+//
+// The apply thread stages entry versions for the next ledger with
+// rsa_mvcc_put / rsa_mvcc_erase and publishes them all at once with
+// rsa_mvcc_commit. Each key keeps a newest-first chain of immutable
+// versions tagged with the ledger that created them. A reader opens a
+// view pinned to a committed ledger and sees exactly the state as of that
+// ledger, however far apply has moved on.
+//
+// Readers never lock: they claim a slot in a fixed array, publish their
+// pinned ledger there and probe the hash index with acquire loads. The
+// index is rebuilt off to the side when it fills and the old one retired.
+// Superseded versions and retired indexes are freed by epoch-based
+// reclamation on commit, once no pinned reader (nor the retained history
+// window) can still reach them.
+//
+// Versions are slots of a per-store slab pool (rsa_slab.h), reported to
+// the monitor under the store's entry type. rsa_mvcc_compact() packs a
+// store's live versions into as few slabs as hold them and unmaps the rest.
+//
+// One writer thread per domain; any number of reader threads up to
+// RSA_MVCC_MAX_READERS concurrent views.
+
+#define RSA_MVCC_MAX_READERS 128
+#define RSA_MVCC_IDLE UINT64_MAX
+
+typedef struct rsa_mvcc_version rsa_mvcc_version_t;
+typedef struct rsa_mvcc_index rsa_mvcc_index_t;
+
+// One per concurrent view; padded so readers do not share lines
+typedef struct {
+    uint64_t pin;                   // pinned ledger, RSA_MVCC_IDLE when free
+    uint32_t claimed;
+} __attribute__((aligned(64))) rsa_mvcc_reader_slot_t;
+
+typedef struct {
+    void *ptr;
+    rsa_slab_pool_t *pool;          // a version's pool; NULL for a retired index
+    rsa_mvcc_version_t *successor;  // its link to ptr is cut before freeing
+    uint64_t seq;                   // freeable once the horizon reaches it
+} rsa_mvcc_retired_t;
+
+typedef struct {
+    uint64_t published;             // last committed ledger
+    uint64_t floor;                 // oldest ledger a new view may pin
+    uint64_t horizon;               // versions superseded at or before it are freed
+    uint64_t retain;                // committed ledgers kept pinnable
+    uint32_t compacting;            // set while a store compacts; no view opens
+    rsa_mvcc_reader_slot_t readers[RSA_MVCC_MAX_READERS];
+
+    // Writer only
+    rsa_mvcc_retired_t *retired;    // FIFO, seq non-decreasing
+    size_t retired_head;
+    size_t retired_count;
+    size_t retired_capacity;
+} rsa_mvcc_domain_t;
+
+typedef struct {
+    rsa_mvcc_domain_t *domain;
+    rsa_wal_entry_type_t type;
+    uint32_t record_size;
+    uint32_t key_offset;            // key bytes within the record
+    uint32_t key_size;
+    rsa_mvcc_index_t *index;        // published with release semantics
+    rsa_slab_pool_t versions;
+    size_t used;                    // occupied index slots
+    size_t live;                    // keys whose newest version is not deleted
+    rsa_hash_key_t key;
+} rsa_mvcc_store_t;
+
+typedef struct {
+    rsa_mvcc_domain_t *domain;
+    uint32_t slot;
+    uint64_t seq;                   // pinned ledger
+} rsa_mvcc_view_t;
+
+// `ledger_seq` is the ledger the initial state belongs to; `retain` extra
+// committed ledgers stay pinnable even with no reader holding them
+bool rsa_mvcc_domain_init(rsa_mvcc_domain_t *domain, uint64_t ledger_seq, uint64_t retain);
+// After every store of the domain is freed
+void rsa_mvcc_domain_free(rsa_mvcc_domain_t *domain);
+
+// Keys: account_id; account_id + canonical asset; offer_id;
+// account_id + data_name_len + data_name
+bool rsa_mvcc_store_init(rsa_mvcc_store_t *store, rsa_mvcc_domain_t *domain,
+                         rsa_wal_entry_type_t type, size_t capacity);
+// No views may be open on the domain
+void rsa_mvcc_store_free(rsa_mvcc_store_t *store);
+
+// Writer
+// ------
+// Stage an entry (normalized as in rsa_wal_entry_normalize) for ledger
+// published + 1. Repeated puts within a ledger overwrite the staged version.
+bool rsa_mvcc_put(rsa_mvcc_store_t *store, const void *record);
+// Key taken from `record`; false if the key is absent
+bool rsa_mvcc_erase(rsa_mvcc_store_t *store, const void *record);
+// Newest version including staged changes, NULL if absent or deleted
+const void *rsa_mvcc_latest(const rsa_mvcc_store_t *store, const void *key);
+
+// Publishes the staged ledger to new views, then reclaims. Returns the
+// committed ledger sequence.
+uint64_t rsa_mvcc_commit(rsa_mvcc_domain_t *domain);
+// Frees whatever no view can reach any more; returns the objects freed
+size_t rsa_mvcc_reclaim(rsa_mvcc_domain_t *domain);
+// Moves versions out of the emptiest slabs and rewrites every link to
+// them; returns the versions moved. It needs the domain quiet: false when
+// a view is open, and views refuse to open until it returns.
+bool rsa_mvcc_compact(rsa_mvcc_store_t *store, size_t *moved);
+
+// Readers
+// -------
+// Pins the latest committed ledger. False when every reader slot is taken
+// or a store of the domain is compacting; retry later.
+bool rsa_mvcc_view_open(rsa_mvcc_domain_t *domain, rsa_mvcc_view_t *view);
+// Pins an older ledger; false if it is no longer retained or not committed,
+// or as above
+bool rsa_mvcc_view_open_at(rsa_mvcc_domain_t *domain, rsa_mvcc_view_t *view, uint64_t ledger_seq);
+void rsa_mvcc_view_close(rsa_mvcc_view_t *view);
+
+// Entry as of the view's ledger, NULL if absent. `key` is the store's key
+// bytes. Pointers stay valid until the view is closed.
+const void *rsa_mvcc_view_get(const rsa_mvcc_view_t *view, const rsa_mvcc_store_t *store,
+                              const void *key);
+const rsa_account_t *rsa_mvcc_get_account(const rsa_mvcc_view_t *view,
+                                          const rsa_mvcc_store_t *accounts,
+                                          const uint32_t account_id[8]);
+const rsa_trustline_t *rsa_mvcc_get_trustline(const rsa_mvcc_view_t *view,
+                                              const rsa_mvcc_store_t *trustlines,
+                                              const uint32_t account_id[8],
+                                              const rsa_asset_t *asset);
+const rsa_offer_t *rsa_mvcc_get_offer(const rsa_mvcc_view_t *view,
+                                      const rsa_mvcc_store_t *offers, uint64_t offer_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_MVCC_H
@@ -0,0 +1,310 @@
+#include "rsa_op_validation.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// PER-TYPE OPERATION VALIDATORS
+// =============================
+
+namespace {
+
+constexpr size_t kOperationTypeCount = RSA_OPERATION_TYPE_COUNT;
+static_assert(RSA_OP_BUMP_SEQUENCE + 1 == kOperationTypeCount,
+              "operation validators must cover every rsa_operation_type_t");
+
+constexpr uint32_t kMaxTrustlineAuthorize =
+    RSA_TRUSTLINE_AUTHORIZED_FLAG | RSA_TRUSTLINE_AUTHORIZED_TO_MAINTAIN_LIABILITIES_FLAG;
+
+inline bool is_alnum(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+}
+
+// Codes are alphanumeric, left aligned and NUL padded, with a length in
+// [min_len, N]
+template <size_t N>
+bool is_valid_asset_code(const char (&code)[N], size_t min_len) {
+    size_t len = 0;
+    while (len < N && code[len] != '\0') {
+        if (!is_alnum(code[len])) return false;
+        len++;
+    }
+    for (size_t i = len; i < N; i++) {
+        if (code[i] != '\0') return false;
+    }
+    return len >= min_len;
+}
+
+inline bool is_zero_account(const uint32_t (&id)[8]) {
+    uint32_t bits = 0;
+    for (uint32_t word : id) bits |= word;
+    return bits == 0;
+}
+
+inline bool is_valid_price(const rsa_price_t &price) {
+    return price.n > 0 && price.d > 0;
+}
+
+inline bool is_valid_asset(const rsa_asset_t &asset) {
+    switch (asset.type) {
+        case RSA_ASSET_TYPE_NATIVE:
+            return true;
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM4:
+            return is_valid_asset_code(asset.asset.credit_alphanum4.code, 1);
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM12:
+            return is_valid_asset_code(asset.asset.credit_alphanum12.code, 5);
+        default:
+            return false;
+    }
+}
+
+inline bool is_valid_credit_asset(const rsa_asset_t &asset) {
+    return asset.type != RSA_ASSET_TYPE_NATIVE && is_valid_asset(asset);
+}
+
+inline bool is_printable_ascii(const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] < 0x20 || s[i] > 0x7E) return false;
+    }
+    return true;
+}
+
+// Primary template is deliberately undefined: adding an operation type
+// without a validator fails to compile
+template <rsa_operation_type_t T>
+struct OpValidator;
+
+template <>
+struct OpValidator<RSA_OP_CREATE_ACCOUNT> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.create_account;
+        return body.starting_balance >= RSA_BASE_RESERVE && !is_zero_account(body.destination);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_PAYMENT> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.payment;
+        return body.amount > 0 && is_valid_asset(body.asset) && !is_zero_account(body.to);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_PATH_PAYMENT> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.path_payment;
+        if (body.send_max <= 0 || body.dest_amount <= 0 || body.path_len > RSA_MAX_PATH_LENGTH) {
+            return false;
+        }
+        if (!is_valid_asset(body.send_asset) || !is_valid_asset(body.dest_asset) ||
+            is_zero_account(body.destination)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < body.path_len; i++) {
+            if (!is_valid_asset(body.path[i])) return false;
+        }
+        return true;
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_MANAGE_OFFER> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.manage_offer;
+        // Amount 0 deletes an existing offer, so it needs an offer id
+        if (body.amount < 0 || (body.amount == 0 && body.offer_id == 0)) {
+            return false;
+        }
+        return is_valid_price(body.price) && is_valid_asset(body.selling) &&
+               is_valid_asset(body.buying) && !rsa_asset_equal(&body.selling, &body.buying);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_CREATE_PASSIVE_OFFER> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.manage_offer;
+        return body.amount > 0 && is_valid_price(body.price) && is_valid_asset(body.selling) &&
+               is_valid_asset(body.buying) && !rsa_asset_equal(&body.selling, &body.buying);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_SET_OPTIONS> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.set_options;
+        if (body.home_domain_len > RSA_MAX_HOME_DOMAIN_LENGTH ||
+            !is_printable_ascii(body.home_domain, body.home_domain_len) ||
+            body.signer_count > RSA_MAX_SIGNERS) {
+            return false;
+        }
+        for (uint32_t i = 0; i < body.signer_count; i++) {
+            if (body.signers[i].weight > 255) return false;
+            for (uint32_t j = 0; j < i; j++) {
+                if (std::memcmp(body.signers[i].key, body.signers[j].key,
+                                sizeof(body.signers[i].key)) == 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_CHANGE_TRUST> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.change_trust;
+        return body.limit >= 0 && is_valid_credit_asset(body.asset);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_ALLOW_TRUST> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.allow_trust;
+        return body.authorize <= kMaxTrustlineAuthorize && is_valid_credit_asset(body.asset) &&
+               !is_zero_account(body.trustor);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_ACCOUNT_MERGE> {
+    static bool check(const rsa_operation_t &op) {
+        return !is_zero_account(op.operation.account_merge.destination);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_INFLATION> {
+    static bool check(const rsa_operation_t &) {
+        return true;
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_MANAGE_DATA> {
+    static bool check(const rsa_operation_t &op) {
+        const auto &body = op.operation.manage_data;
+        return body.data_name_len > 0 && body.data_name_len <= RSA_MAX_DATA_NAME_LENGTH &&
+               body.data_value_len <= RSA_MAX_DATA_VALUE_LENGTH &&
+               is_printable_ascii(body.data_name, body.data_name_len);
+    }
+};
+
+template <>
+struct OpValidator<RSA_OP_BUMP_SEQUENCE> {
+    static bool check(const rsa_operation_t &op) {
+        // Sequence numbers are signed 64-bit on the wire
+        return op.operation.bump_sequence.bump_to <= static_cast<uint64_t>(INT64_MAX);
+    }
+};
+
+// Jump tables, built at compile time from the specializations above
+using SingleFn = bool (*)(const rsa_operation_t &);
+using RunFn = size_t (*)(const rsa_operation_t *const *, size_t, bool *);
+
+template <rsa_operation_type_t T>
+bool validate_single(const rsa_operation_t &op) {
+    return OpValidator<T>::check(op);
+}
+
+template <rsa_operation_type_t T>
+size_t validate_run(const rsa_operation_t *const *ops, size_t count, bool *results) {
+    size_t invalid = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool ok = ops[i]->type == T && OpValidator<T>::check(*ops[i]);
+        results[i] = ok;
+        invalid += !ok;
+    }
+    return invalid;
+}
+
+template <size_t... I>
+constexpr std::array<SingleFn, sizeof...(I)> make_single_table(std::index_sequence<I...>) {
+    return {{&validate_single<static_cast<rsa_operation_type_t>(I)>...}};
+}
+
+template <size_t... I>
+constexpr std::array<RunFn, sizeof...(I)> make_run_table(std::index_sequence<I...>) {
+    return {{&validate_run<static_cast<rsa_operation_type_t>(I)>...}};
+}
+
+constexpr auto kSingleValidators = make_single_table(std::make_index_sequence<kOperationTypeCount>{});
+constexpr auto kRunValidators = make_run_table(std::make_index_sequence<kOperationTypeCount>{});
+
+inline bool is_known_type(rsa_operation_type_t type) {
+    return static_cast<uint32_t>(type) < kOperationTypeCount;
+}
+
+} // namespace
+
+bool rsa_asset_is_valid(const rsa_asset_t *asset) {
+    return asset && is_valid_asset(*asset);
+}
+
+bool rsa_op_validate(const rsa_operation_t *op) {
+    if (!op || !is_known_type(op->type)) return false;
+    return kSingleValidators[op->type](*op);
+}
+
+size_t rsa_op_validate_run(rsa_operation_type_t type, const rsa_operation_t *const *ops,
+                           size_t count, bool *results) {
+    if (!ops || !results) return count;
+    if (!is_known_type(type)) {
+        for (size_t i = 0; i < count; i++) results[i] = false;
+        return count;
+    }
+    return kRunValidators[type](ops, count, results);
+}
+
+size_t rsa_op_validate_batch(const rsa_operation_t *ops, size_t count, bool *results) {
+    if (!ops || !results) return count;
+
+    // Counting sort of operation pointers by type; unknown types go last in
+    // an extra bucket. Counts are shifted by two so offsets[b] ends up as the
+    // start of bucket b after the scatter.
+    std::array<size_t, kOperationTypeCount + 3> offsets{};
+    for (size_t i = 0; i < count; i++) {
+        size_t bucket = is_known_type(ops[i].type) ? static_cast<size_t>(ops[i].type)
+                                                   : kOperationTypeCount;
+        offsets[bucket + 2]++;
+    }
+    for (size_t b = 2; b < offsets.size(); b++) {
+        offsets[b] += offsets[b - 1];
+    }
+
+    std::vector<const rsa_operation_t *> sorted(count);
+    std::vector<size_t> origin(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t bucket = is_known_type(ops[i].type) ? static_cast<size_t>(ops[i].type)
+                                                   : kOperationTypeCount;
+        size_t slot = offsets[bucket + 1]++;
+        sorted[slot] = &ops[i];
+        origin[slot] = i;
+    }
+
+    // offsets[b] is now the start of bucket b
+    std::unique_ptr<bool[]> verdicts(new bool[count]);
+    bool *sorted_results = verdicts.get();
+    size_t invalid = 0;
+    for (size_t b = 0; b < kOperationTypeCount; b++) {
+        size_t begin = offsets[b];
+        size_t end = offsets[b + 1];
+        if (end > begin) {
+            invalid += kRunValidators[b](sorted.data() + begin, end - begin, sorted_results + begin);
+        }
+    }
+    for (size_t slot = offsets[kOperationTypeCount]; slot < count; slot++) {
+        sorted_results[slot] = false;
+        invalid++;
+    }
+
+    for (size_t slot = 0; slot < count; slot++) {
+        results[origin[slot]] = sorted_results[slot];
+    }
+    return invalid;
+}
@@ -0,0 +1,43 @@
+#ifndef RSA_OP_VALIDATION_H
+#define RSA_OP_VALIDATION_H
+
+#include "rsa_token.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PER-TYPE OPERATION VALIDATORS
+// =============================
+// One specialized validator per rsa_operation_type_t (rsa_op_validation.cpp),
+// selected through a constexpr jump table. Batches are bucketed by type and
+// each bucket is checked in a tight, type-homogeneous loop.
+
+#define RSA_OPERATION_TYPE_COUNT 12
+#define RSA_MAX_PATH_LENGTH 5
+#define RSA_MAX_SIGNERS 20
+#define RSA_MAX_HOME_DOMAIN_LENGTH 32
+#define RSA_MAX_DATA_NAME_LENGTH 64
+#define RSA_MAX_DATA_VALUE_LENGTH 64
+
+// Full check of a single operation of any type
+bool rsa_op_validate(const rsa_operation_t *op);
+
+// Validates ops[0..count) grouped by type; results[i] receives the verdict
+// for ops[i]. Returns the number of invalid operations.
+size_t rsa_op_validate_batch(const rsa_operation_t *ops, size_t count, bool *results);
+
+// Type-homogeneous run: every ops[i] is expected to have `type` (others are
+// reported invalid). Returns the number of invalid operations.
+size_t rsa_op_validate_run(rsa_operation_type_t type, const rsa_operation_t *const *ops,
+                           size_t count, bool *results);
+
+// Asset and price rules shared by the validators
+bool rsa_asset_is_valid(const rsa_asset_t *asset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_OP_VALIDATION_H
@@ -0,0 +1,178 @@
+#include "rsa_price.h"
+
+// EXACT PRICE AND AMOUNT ARITHMETIC
+// =================================
+
+__extension__ typedef __int128 rsa_int128_t;
+
+#define RSA_INT64_MAX ((int64_t)0x7FFFFFFFFFFFFFFFLL)
+#define RSA_INT64_MIN (-RSA_INT64_MAX - 1)
+
+// Round num / den (den > 0) according to mode
+static inline rsa_int128_t div_round128(rsa_int128_t num, rsa_int128_t den, rsa_rounding_t mode) {
+    rsa_int128_t q = num / den;   // truncates toward zero
+    rsa_int128_t r = num % den;   // same sign as num
+    if (r == 0) return q;
+
+    switch (mode) {
+        case RSA_ROUND_FLOOR:
+            return num < 0 ? q - 1 : q;
+        case RSA_ROUND_CEIL:
+            return num > 0 ? q + 1 : q;
+        case RSA_ROUND_HALF_EVEN: {
+            rsa_int128_t twice = (r < 0 ? -r : r) * 2;
+            if (twice > den || (twice == den && (q & 1) != 0)) {
+                return num < 0 ? q - 1 : q + 1;
+            }
+            return q;
+        }
+        default:
+            return q;
+    }
+}
+
+// Same rounding on 64-bit operands; used when the product fits in int64
+static inline int64_t div_round64(int64_t num, int64_t den, rsa_rounding_t mode) {
+    int64_t q = num / den;
+    int64_t r = num % den;
+    if (r == 0) return q;
+
+    switch (mode) {
+        case RSA_ROUND_FLOOR:
+            return num < 0 ? q - 1 : q;
+        case RSA_ROUND_CEIL:
+            return num > 0 ? q + 1 : q;
+        case RSA_ROUND_HALF_EVEN: {
+            int64_t twice = (r < 0 ? -r : r) * 2;
+            if (twice > den || (twice == den && (q & 1) != 0)) {
+                return num < 0 ? q - 1 : q + 1;
+            }
+            return q;
+        }
+        default:
+            return q;
+    }
+}
+
+// a * m / den with m, den in (0, 2^31). Most amounts stay below 2^32, in which
+// case the product fits in int64 and the costly 128-bit division is skipped.
+static inline rsa_price_status_t scale_amount(int64_t a, int32_t m, int32_t den,
+                                              rsa_rounding_t mode, int64_t *out) {
+    if (a > -(1LL << 32) && a < (1LL << 32)) {
+        *out = div_round64(a * (int64_t)m, (int64_t)den, mode);
+        return RSA_PRICE_OK;
+    }
+
+    rsa_int128_t q = div_round128((rsa_int128_t)a * m, (rsa_int128_t)den, mode);
+    if (q > RSA_INT64_MAX || q < RSA_INT64_MIN) {
+        *out = 0;
+        return RSA_PRICE_ERR_OVERFLOW;
+    }
+    *out = (int64_t)q;
+    return RSA_PRICE_OK;
+}
+
+bool rsa_price_is_valid(const rsa_price_t *price) {
+    return price && price->n > 0 && price->d > 0;
+}
+
+int rsa_price_compare(const rsa_price_t *a, const rsa_price_t *b) {
+    // n, d < 2^31, so each cross product fits in int64
+    int64_t lhs = (int64_t)a->n * b->d;
+    int64_t rhs = (int64_t)b->n * a->d;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+bool rsa_price_equal(const rsa_price_t *a, const rsa_price_t *b) {
+    return (int64_t)a->n * b->d == (int64_t)b->n * a->d;
+}
+
+rsa_price_status_t rsa_amount_mul_div(int64_t a, int64_t b, int64_t c,
+                                      rsa_rounding_t mode, int64_t *out) {
+    if (!out) return RSA_PRICE_ERR_INVALID;
+    *out = 0;
+    if (c == 0) return RSA_PRICE_ERR_INVALID;
+
+    rsa_int128_t num = (rsa_int128_t)a * b;
+    rsa_int128_t den = c;
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+
+    rsa_int128_t q = div_round128(num, den, mode);
+    if (q > RSA_INT64_MAX || q < RSA_INT64_MIN) {
+        return RSA_PRICE_ERR_OVERFLOW;
+    }
+    *out = (int64_t)q;
+    return RSA_PRICE_OK;
+}
+
+rsa_price_status_t rsa_amount_mul_price(int64_t amount, const rsa_price_t *price,
+                                        rsa_rounding_t mode, int64_t *out) {
+    if (!out) return RSA_PRICE_ERR_INVALID;
+    if (!rsa_price_is_valid(price)) {
+        *out = 0;
+        return RSA_PRICE_ERR_INVALID;
+    }
+    return scale_amount(amount, price->n, price->d, mode, out);
+}
+
+rsa_price_status_t rsa_amount_div_price(int64_t amount, const rsa_price_t *price,
+                                        rsa_rounding_t mode, int64_t *out) {
+    if (!out) return RSA_PRICE_ERR_INVALID;
+    if (!rsa_price_is_valid(price)) {
+        *out = 0;
+        return RSA_PRICE_ERR_INVALID;
+    }
+    return scale_amount(amount, price->d, price->n, mode, out);
+}
+
+size_t rsa_amount_mul_price_batch(const int64_t *amounts, const rsa_price_t *prices,
+                                  size_t count, rsa_rounding_t mode,
+                                  int64_t *out, uint8_t *status) {
+    if (!amounts || !prices || !out) return count;
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        rsa_price_status_t s = RSA_PRICE_ERR_INVALID;
+        out[i] = 0;
+        if (prices[i].n > 0 && prices[i].d > 0) {
+            s = scale_amount(amounts[i], prices[i].n, prices[i].d, mode, &out[i]);
+        }
+        if (status) status[i] = (uint8_t)s;
+        failed += (s != RSA_PRICE_OK);
+    }
+    return failed;
+}
+
+size_t rsa_amount_div_price_batch(const int64_t *amounts, const rsa_price_t *prices,
+                                  size_t count, rsa_rounding_t mode,
+                                  int64_t *out, uint8_t *status) {
+    if (!amounts || !prices || !out) return count;
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        rsa_price_status_t s = RSA_PRICE_ERR_INVALID;
+        out[i] = 0;
+        if (prices[i].n > 0 && prices[i].d > 0) {
+            s = scale_amount(amounts[i], prices[i].d, prices[i].n, mode, &out[i]);
+        }
+        if (status) status[i] = (uint8_t)s;
+        failed += (s != RSA_PRICE_OK);
+    }
+    return failed;
+}
+
+void rsa_price_compare_batch(const rsa_price_t *prices, size_t count,
+                             const rsa_price_t *reference, int8_t *out) {
+    if (!prices || !reference || !out) return;
+
+    const int64_t ref_n = reference->n;
+    const int64_t ref_d = reference->d;
+    for (size_t i = 0; i < count; i++) {
+        int64_t lhs = (int64_t)prices[i].n * ref_d;
+        int64_t rhs = ref_n * (int64_t)prices[i].d;
+        out[i] = (int8_t)((lhs > rhs) - (lhs < rhs));
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef RSA_PRICE_H
+#define RSA_PRICE_H
+
+#include "rsa_token.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// EXACT PRICE AND AMOUNT ARITHMETIC
+// =================================
+// amount x price and amount / price on int64 amounts and n/d rsa_price_t
+// values, carried out in 128-bit integers with explicit rounding and overflow
+// reporting. Nothing here touches floating point.
+
+typedef enum {
+    RSA_ROUND_FLOOR = 0,      // toward negative infinity
+    RSA_ROUND_CEIL = 1,       // toward positive infinity
+    RSA_ROUND_HALF_EVEN = 2   // nearest, ties to even (banker's rounding)
+} rsa_rounding_t;
+
+typedef enum {
+    RSA_PRICE_OK = 0,
+    RSA_PRICE_ERR_INVALID = 1,    // n <= 0, d <= 0 or zero divisor
+    RSA_PRICE_ERR_OVERFLOW = 2    // result does not fit in int64
+} rsa_price_status_t;
+
+// A price is valid when both numerator and denominator are positive
+bool rsa_price_is_valid(const rsa_price_t *price);
+
+// -1, 0 or 1 as a is below, equal to or above b. Exact cross-multiplication;
+// both prices must be valid.
+int rsa_price_compare(const rsa_price_t *a, const rsa_price_t *b);
+bool rsa_price_equal(const rsa_price_t *a, const rsa_price_t *b);
+
+// a * b / c with a 128-bit intermediate
+rsa_price_status_t rsa_amount_mul_div(int64_t a, int64_t b, int64_t c,
+                                      rsa_rounding_t mode, int64_t *out);
+
+// amount * n / d  (e.g. selling amount -> buying amount of an offer)
+rsa_price_status_t rsa_amount_mul_price(int64_t amount, const rsa_price_t *price,
+                                        rsa_rounding_t mode, int64_t *out);
+
+// amount * d / n  (e.g. buying amount -> selling amount of an offer)
+rsa_price_status_t rsa_amount_div_price(int64_t amount, const rsa_price_t *price,
+                                        rsa_rounding_t mode, int64_t *out);
+
+// Batch forms over parallel arrays, for computing fills across many offers.
+// Entries that are invalid or overflow produce 0 and a nonzero status[i]
+// (status may be NULL). Return the number of failed entries.
+size_t rsa_amount_mul_price_batch(const int64_t *amounts, const rsa_price_t *prices,
+                                  size_t count, rsa_rounding_t mode,
+                                  int64_t *out, uint8_t *status);
+size_t rsa_amount_div_price_batch(const int64_t *amounts, const rsa_price_t *prices,
+                                  size_t count, rsa_rounding_t mode,
+                                  int64_t *out, uint8_t *status);
+
+// out[i] = rsa_price_compare(&prices[i], reference). Branch-free, vectorizable.
+void rsa_price_compare_batch(const rsa_price_t *prices, size_t count,
+                             const rsa_price_t *reference, int8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_PRICE_H
@@ -0,0 +1,311 @@
+#include "rsa_slab.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// SLAB POOLS
+// ==========
+
+#define SLAB_EVACUATED SIZE_MAX
+#define SLAB_MPOL_LOCAL 4               // MPOL_LOCAL of <numaif.h>, Linux 3.8+
+#define SLAB_PAGE 4096                  // smallest page, for faulting in
+
+// Header at the start of every slab; slots follow at pool->data_offset
+struct rsa_slab {
+    rsa_slab_pool_t *pool;
+    size_t index;                       // in pool->slabs, SLAB_EVACUATED once evacuated
+    uint32_t live;
+    uint32_t free_head;                 // slot + 1, 0 = none; chained through the free slots
+    uint32_t untouched;                 // slots from here on were never handed out
+    uint64_t bits[];                    // live slots
+};
+
+static inline rsa_slab_t *slab_of(const void *ptr) {
+    return (rsa_slab_t *)((uintptr_t)ptr & ~(uintptr_t)(RSA_SLAB_BYTES - 1));
+}
+
+static inline uint8_t *slot_ptr(const rsa_slab_pool_t *pool, rsa_slab_t *slab, uint32_t slot) {
+    return (uint8_t *)slab + pool->data_offset + (size_t)slot * pool->stride;
+}
+
+static inline size_t align_up(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+static size_t header_size(uint32_t slots) {
+    return offsetof(rsa_slab_t, bits) + ((size_t)slots + 63) / 64 * sizeof(uint64_t);
+}
+
+// Occupancy counters are deltas, so pools of one type add up
+static inline void report(const rsa_slab_pool_t *pool, uint64_t *counters, int64_t delta) {
+    int type = pool->config.monitor_type;
+    if (type == RSA_SLAB_UNMONITORED || delta == 0) return;
+    __atomic_fetch_add(&counters[type], (uint64_t)delta, __ATOMIC_RELAXED);
+}
+
+// SLABS
+// -----
+
+// Binds to the calling thread's node and faults the slab in from here, so
+// first touch lands there even under an interleaving policy
+static void slab_bind_local(void *slab) {
+#ifdef SYS_mbind
+    syscall(SYS_mbind, slab, (unsigned long)RSA_SLAB_BYTES, SLAB_MPOL_LOCAL, NULL, 0UL, 0U);
+#endif
+    for (size_t offset = 0; offset < RSA_SLAB_BYTES; offset += SLAB_PAGE) {
+        ((volatile uint8_t *)slab)[offset] = 0;
+    }
+}
+
+// Anonymous mapping aligned to its size; zero-filled, so the header and
+// bitmap start out empty
+static rsa_slab_t *slab_map(rsa_slab_pool_t *pool) {
+    uint8_t *map = mmap(NULL, 2 * (size_t)RSA_SLAB_BYTES, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) return NULL;
+    uint8_t *base = (uint8_t *)align_up((uintptr_t)map, RSA_SLAB_BYTES);
+    size_t head = (size_t)(base - map);
+    if (head) munmap(map, head);
+    munmap(base + RSA_SLAB_BYTES, RSA_SLAB_BYTES - head);
+
+#ifdef MADV_HUGEPAGE
+    if (pool->config.huge_pages) madvise(base, RSA_SLAB_BYTES, MADV_HUGEPAGE);
+#endif
+    if (pool->config.numa_local) slab_bind_local(base);
+
+    rsa_slab_t *slab = (rsa_slab_t *)base;
+    slab->pool = pool;
+    return slab;
+}
+
+static void slab_unmap(rsa_slab_t *slab) {
+    munmap(slab, RSA_SLAB_BYTES);
+}
+
+static bool pool_grow(rsa_slab_pool_t *pool) {
+    if (pool->slab_count == pool->slab_capacity) {
+        size_t capacity = pool->slab_capacity ? pool->slab_capacity * 2 : 16;
+        rsa_slab_t **slabs = realloc(pool->slabs, capacity * sizeof(*slabs));
+        if (!slabs) return false;
+        pool->slabs = slabs;
+        pool->slab_capacity = capacity;
+    }
+    rsa_slab_t *slab = slab_map(pool);
+    if (!slab) return false;
+    slab->index = pool->slab_count;
+    pool->slabs[pool->slab_count++] = slab;
+    report(pool, g_rsa_monitor.slab_slots, pool->slots_per_slab);
+    return true;
+}
+
+// Keeps one empty slab at the end, against map/unmap churn at the boundary
+static void pool_release_trailing(rsa_slab_pool_t *pool) {
+    while (pool->slab_count >= 2 && pool->slabs[pool->slab_count - 1]->live == 0 &&
+           pool->slabs[pool->slab_count - 2]->live == 0) {
+        slab_unmap(pool->slabs[--pool->slab_count]);
+        report(pool, g_rsa_monitor.slab_slots, -(int64_t)pool->slots_per_slab);
+    }
+    if (pool->first_free > pool->slab_count) pool->first_free = pool->slab_count;
+}
+
+static void *slot_take(const rsa_slab_pool_t *pool, rsa_slab_t *slab) {
+    uint32_t slot;
+    if (slab->free_head) {
+        slot = slab->free_head - 1;
+        memcpy(&slab->free_head, slot_ptr(pool, slab, slot), sizeof(slab->free_head));
+    } else {
+        slot = slab->untouched++;
+    }
+    slab->bits[slot / 64] |= 1ULL << (slot % 64);
+    slab->live++;
+    return slot_ptr(pool, slab, slot);
+}
+
+// First slab with room, mapping one when all are full
+static void *pool_take(rsa_slab_pool_t *pool) {
+    while (pool->first_free < pool->slab_count &&
+           pool->slabs[pool->first_free]->live == pool->slots_per_slab) {
+        pool->first_free++;
+    }
+    if (pool->first_free == pool->slab_count && !pool_grow(pool)) return NULL;
+    return slot_take(pool, pool->slabs[pool->first_free]);
+}
+
+// LIFECYCLE
+// ---------
+
+bool rsa_slab_pool_init(rsa_slab_pool_t *pool, const rsa_slab_config_t *config) {
+    if (!pool || !config) return false;
+
+    memset(pool, 0, sizeof(*pool));
+    pool->config = *config;
+    size_t align = config->align ? config->align : RSA_SLAB_ALIGN;
+    if ((align & (align - 1)) != 0 || align > RSA_SLAB_BYTES / 4) return false;
+    if (config->object_size == 0 || config->object_size > RSA_SLAB_BYTES / 4) return false;
+    if (config->monitor_type != RSA_SLAB_UNMONITORED &&
+        (config->monitor_type < 0 || config->monitor_type >= RSA_MONITOR_SLAB_TYPES)) {
+        return false;
+    }
+    pool->config.align = align;
+
+    // Free slots hold a link, and moved objects their new address
+    size_t size = config->object_size < sizeof(void *) ? sizeof(void *) : config->object_size;
+    pool->stride = align_up(size, align);
+    uint32_t slots = (uint32_t)(RSA_SLAB_BYTES / pool->stride);
+    while (align_up(header_size(slots), align) + (size_t)slots * pool->stride > RSA_SLAB_BYTES) {
+        slots--;
+    }
+    pool->slots_per_slab = slots;
+    pool->data_offset = align_up(header_size(slots), align);
+    return true;
+}
+
+void rsa_slab_pool_free(rsa_slab_pool_t *pool) {
+    if (!pool || !pool->stride) return;
+    for (size_t i = 0; i < pool->slab_count; i++) slab_unmap(pool->slabs[i]);
+    for (size_t i = 0; i < pool->evacuated_count; i++) slab_unmap(pool->evacuated[i]);
+    report(pool, g_rsa_monitor.slab_live, -(int64_t)pool->live);
+    report(pool, g_rsa_monitor.slab_slots,
+           -(int64_t)((pool->slab_count + pool->evacuated_count) * pool->slots_per_slab));
+    free(pool->slabs);
+    free(pool->evacuated);
+    memset(pool, 0, sizeof(*pool));
+}
+
+size_t rsa_slab_capacity(const rsa_slab_pool_t *pool) {
+    return pool ? pool->slab_count * pool->slots_per_slab : 0;
+}
+
+// ALLOCATION
+// ----------
+
+void *rsa_slab_alloc(rsa_slab_pool_t *pool) {
+    if (!pool || !pool->stride) return NULL;
+    void *ptr = pool_take(pool);
+    if (!ptr) return NULL;
+    pool->live++;
+    report(pool, g_rsa_monitor.slab_live, 1);
+    return ptr;
+}
+
+bool rsa_slab_free(rsa_slab_pool_t *pool, void *ptr) {
+    if (!pool || !ptr) return false;
+
+    rsa_slab_t *slab = slab_of(ptr);
+    size_t offset = (size_t)((uint8_t *)ptr - (uint8_t *)slab);
+    size_t slot = (offset - pool->data_offset) / pool->stride;
+    if (slab->pool != pool || slab->index == SLAB_EVACUATED || offset < pool->data_offset ||
+        (offset - pool->data_offset) % pool->stride != 0 || slot >= slab->untouched ||
+        !(slab->bits[slot / 64] & (1ULL << (slot % 64)))) {
+        __atomic_fetch_add(&g_rsa_monitor.corruption_detections, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    slab->bits[slot / 64] &= ~(1ULL << (slot % 64));
+    memcpy(ptr, &slab->free_head, sizeof(slab->free_head));
+    slab->free_head = (uint32_t)slot + 1;
+    slab->live--;
+    pool->live--;
+    report(pool, g_rsa_monitor.slab_live, -1);
+    if (slab->index < pool->first_free) pool->first_free = slab->index;
+    if (slab->live == 0) pool_release_trailing(pool);
+    return true;
+}
+
+void *rsa_slab_iter_next(const rsa_slab_pool_t *pool, rsa_slab_iter_t *iter) {
+    if (!pool || !iter) return NULL;
+
+    for (; iter->slab < pool->slab_count; iter->slab++, iter->slot = 0) {
+        rsa_slab_t *slab = pool->slabs[iter->slab];
+        uint32_t slot = iter->slot;
+        while (slot < slab->untouched) {
+            uint64_t word = slab->bits[slot / 64] >> (slot % 64);
+            if (word) {
+                slot += (uint32_t)__builtin_ctzll(word);
+                iter->slot = slot + 1;
+                return slot_ptr(pool, slab, slot);
+            }
+            slot = (slot / 64 + 1) * 64;
+        }
+    }
+    return NULL;
+}
+
+// COMPACTION
+// ----------
+
+// Emptiest first; among equals the later slab, which is likelier cold
+static int compare_sparsest(const void *a, const void *b) {
+    const rsa_slab_t *x = *(rsa_slab_t *const *)a;
+    const rsa_slab_t *y = *(rsa_slab_t *const *)b;
+    if (x->live != y->live) return x->live < y->live ? -1 : 1;
+    return x->index > y->index ? -1 : x->index < y->index;
+}
+
+size_t rsa_slab_compact(rsa_slab_pool_t *pool) {
+    if (!pool || pool->evacuated_count || pool->slab_count == 0) return 0;
+
+    size_t keep = (pool->live + pool->slots_per_slab - 1) / pool->slots_per_slab;
+    if (keep == 0) keep = 1;
+    if (keep >= pool->slab_count) return 0;
+
+    rsa_slab_t **order = malloc(pool->slab_count * sizeof(*order));
+    if (!order) return 0;
+    memcpy(order, pool->slabs, pool->slab_count * sizeof(*order));
+    qsort(order, pool->slab_count, sizeof(*order), compare_sparsest);
+    size_t victims = pool->slab_count - keep;
+    for (size_t v = 0; v < victims; v++) order[v]->index = SLAB_EVACUATED;
+
+    // The kept slabs stay in allocation order and have room for every
+    // evacuated object
+    size_t kept = 0;
+    for (size_t i = 0; i < pool->slab_count; i++) {
+        rsa_slab_t *slab = pool->slabs[i];
+        if (slab->index == SLAB_EVACUATED) continue;
+        slab->index = kept;
+        pool->slabs[kept++] = slab;
+    }
+    pool->slab_count = kept;
+    pool->first_free = 0;
+    pool->evacuated = order;
+    pool->evacuated_count = victims;
+
+    size_t moved = 0;
+    for (size_t v = 0; v < victims; v++) {
+        rsa_slab_t *slab = order[v];
+        for (uint32_t w = 0; w * 64 < slab->untouched; w++) {
+            for (uint64_t bits = slab->bits[w]; bits; bits &= bits - 1) {
+                uint8_t *from = slot_ptr(pool, slab, w * 64 + (uint32_t)__builtin_ctzll(bits));
+                void *to = pool_take(pool);
+                memcpy(to, from, pool->config.object_size);
+                memcpy(from, &to, sizeof(to));
+                moved++;
+            }
+        }
+    }
+    pool->moved += moved;
+    report(pool, g_rsa_monitor.slab_moved, (int64_t)moved);
+    return moved;
+}
+
+void *rsa_slab_forward(const rsa_slab_pool_t *pool, void *ptr) {
+    if (!pool || !ptr || !pool->evacuated_count) return ptr;
+    if (slab_of(ptr)->index != SLAB_EVACUATED) return ptr;
+    void *moved;
+    memcpy(&moved, ptr, sizeof(moved));
+    return moved;
+}
+
+void rsa_slab_compact_finish(rsa_slab_pool_t *pool) {
+    if (!pool || !pool->evacuated_count) return;
+    for (size_t i = 0; i < pool->evacuated_count; i++) slab_unmap(pool->evacuated[i]);
+    report(pool, g_rsa_monitor.slab_slots,
+           -(int64_t)(pool->evacuated_count * pool->slots_per_slab));
+    free(pool->evacuated);
+    pool->evacuated = NULL;
+    pool->evacuated_count = 0;
+}
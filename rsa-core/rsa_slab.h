@@ -0,0 +1,110 @@
+#ifndef RSA_SLAB_H
+#define RSA_SLAB_H
+
+#include "rsa_token.h"
+#include "rsa_wal.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SLAB POOLS
+// ==========
+// Fixed-size objects (ledger entries and the records wrapping them) in
+// RSA_SLAB_BYTES slabs mapped at addresses aligned to their size. There
+// is no per-object header, every slot starts on a cache line (or the
+// configured alignment), and an object's slab is found by masking its
+// address.
+//
+// Free slots are chained per slab. Allocation takes from the first slab
+// with room, so live objects pack toward the front; when the last two
+// slabs are both empty the last one is unmapped, one empty slab being
+// kept against map/unmap churn at the boundary.
+//
+// Churn still leaves partly used slabs behind. rsa_slab_compact() moves
+// the live objects of the emptiest slabs into holes in the fullest, down
+// to the fewest slabs that hold them, so iteration touches as few pages
+// as possible. Moved objects leave their new address in the vacated slot:
+// the owner rewrites its references with rsa_slab_forward(), then
+// rsa_slab_compact_finish() unmaps the evacuated slabs.
+//
+// With `numa_local`, slabs are bound to the node of the thread that maps
+// them and faulted in there, overriding an interleaving process policy;
+// with `huge_pages` they are advised for transparent huge pages.
+//
+// Occupancy is reported to rsa_ops_monitor_t under `monitor_type`.
+//
+// Not thread-safe; one owner per pool.
+
+#define RSA_SLAB_BYTES (2u << 20)          // one huge page
+#define RSA_SLAB_ALIGN 64                   // default slot alignment, a cache line
+#define RSA_SLAB_UNMONITORED (-1)
+
+_Static_assert(RSA_WAL_ENTRY_TYPE_COUNT <= RSA_MONITOR_SLAB_TYPES,
+               "rsa_ops_monitor_t.slab_* is too small");
+
+typedef struct {
+    size_t object_size;
+    size_t align;                       // power of two; 0 = RSA_SLAB_ALIGN
+    bool huge_pages;
+    bool numa_local;
+    int monitor_type;                   // rsa_wal_entry_type_t, or RSA_SLAB_UNMONITORED
+} rsa_slab_config_t;
+
+typedef struct rsa_slab rsa_slab_t;
+
+typedef struct {
+    rsa_slab_config_t config;
+    size_t stride;                      // object size rounded up to the alignment
+    size_t data_offset;                 // slab header, rounded up to the alignment
+    uint32_t slots_per_slab;
+
+    rsa_slab_t **slabs;                 // allocation order
+    size_t slab_count;
+    size_t slab_capacity;
+    size_t first_free;                  // no slab before it has a free slot
+    rsa_slab_t **evacuated;             // between compact and finish
+    size_t evacuated_count;
+
+    size_t live;
+    uint64_t moved;                     // by compaction, over the pool's life
+} rsa_slab_pool_t;
+
+// Position of an iteration, zero-initialized to start
+typedef struct {
+    size_t slab;
+    uint32_t slot;
+} rsa_slab_iter_t;
+
+bool rsa_slab_pool_init(rsa_slab_pool_t *pool, const rsa_slab_config_t *config);
+// Releases every object at once
+void rsa_slab_pool_free(rsa_slab_pool_t *pool);
+
+// Uninitialized, NULL when out of memory
+void *rsa_slab_alloc(rsa_slab_pool_t *pool);
+// False (and a corruption detection) for a slot that is not allocated
+bool rsa_slab_free(rsa_slab_pool_t *pool, void *ptr);
+
+// Live objects in slab order, then NULL; the pool must not change while
+// iterating
+void *rsa_slab_iter_next(const rsa_slab_pool_t *pool, rsa_slab_iter_t *iter);
+
+// Compaction
+// ----------
+// Returns the objects moved; 0 when no slab can be released. Until
+// rsa_slab_compact_finish(), the owner may allocate, but must free only
+// through forwarded addresses.
+size_t rsa_slab_compact(rsa_slab_pool_t *pool);
+// New address of an object of the pool if compaction moved it, else `ptr`
+void *rsa_slab_forward(const rsa_slab_pool_t *pool, void *ptr);
+void rsa_slab_compact_finish(rsa_slab_pool_t *pool);
+
+// Slots in mapped slabs, for occupancy (live / capacity)
+size_t rsa_slab_capacity(const rsa_slab_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_SLAB_H
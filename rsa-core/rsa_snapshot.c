@@ -0,0 +1,590 @@
+#include "rsa_snapshot.h"
+#include "rsa_asset_intern.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// LEDGER SNAPSHOT FILES
+// =====================
+
+#define SNAPSHOT_BUFFER_SIZE (1u << 20)
+#define SNAPSHOT_DATA_KEY_SIZE 104      // account_id, name_len, name, zero pad
+
+_Static_assert(sizeof(rsa_snapshot_header_t) <= RSA_SNAPSHOT_PAGE_SIZE,
+               "snapshot header must fit in page 0");
+_Static_assert(sizeof(rsa_snapshot_slot_t) == 8, "index slots are 8 bytes");
+
+static const uint32_t snapshot_record_sizes[RSA_SNAPSHOT_SECTION_COUNT] = {
+    [RSA_SNAPSHOT_ACCOUNTS]   = sizeof(rsa_account_t),
+    [RSA_SNAPSHOT_TRUSTLINES] = sizeof(rsa_trustline_t),
+    [RSA_SNAPSHOT_OFFERS]     = sizeof(rsa_offer_t),
+    [RSA_SNAPSHOT_DATA]       = sizeof(rsa_data_t)
+};
+
+// Bytes of each record up to and including its last field; the rest is
+// struct padding, zeroed so files (and checksums) are reproducible
+static const size_t snapshot_record_used[RSA_SNAPSHOT_SECTION_COUNT] = {
+    [RSA_SNAPSHOT_ACCOUNTS]   = offsetof(rsa_account_t, reserved) + 4 * sizeof(uint32_t),
+    [RSA_SNAPSHOT_TRUSTLINES] = offsetof(rsa_trustline_t, reserved) + 2 * sizeof(uint32_t),
+    [RSA_SNAPSHOT_OFFERS]     = offsetof(rsa_offer_t, reserved) + 2 * sizeof(uint32_t),
+    [RSA_SNAPSHOT_DATA]       = offsetof(rsa_data_t, reserved) + 2 * sizeof(uint32_t)
+};
+
+static inline uint64_t align_page(uint64_t value) {
+    return (value + RSA_SNAPSHOT_PAGE_SIZE - 1) & ~(uint64_t)(RSA_SNAPSHOT_PAGE_SIZE - 1);
+}
+
+// KEY HASHING
+// -----------
+// Unseeded so the on-disk index is a pure function of the records
+
+__extension__ typedef unsigned __int128 snapshot_uint128_t;
+
+static inline uint64_t snapshot_mix(uint64_t a, uint64_t b) {
+    snapshot_uint128_t product = (snapshot_uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+// `len` is a multiple of 8
+static uint64_t snapshot_hash(const void *key, size_t len) {
+    const uint8_t *bytes = key;
+    uint64_t hash = 0x243F6A8885A308D3ULL ^ len;
+    for (size_t i = 0; i < len; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = snapshot_mix(hash ^ word, 0x9E3779B97F4A7C15ULL);
+    }
+    return snapshot_mix(hash, 0xBF58476D1CE4E5B9ULL);
+}
+
+static uint64_t account_key_hash(const uint32_t account_id[8]) {
+    return snapshot_hash(account_id, 32);
+}
+
+// Asset must be canonical
+static uint64_t trustline_key_hash(const uint32_t account_id[8], const rsa_asset_t *asset) {
+    uint8_t key[32 + sizeof(rsa_asset_t)];
+    memcpy(key, account_id, 32);
+    memcpy(key + 32, asset, sizeof(rsa_asset_t));
+    return snapshot_hash(key, sizeof(key));
+}
+
+static uint64_t offer_key_hash(uint64_t offer_id) {
+    return snapshot_hash(&offer_id, sizeof(offer_id));
+}
+
+static uint64_t data_key_hash(const uint32_t account_id[8], const char *name, uint32_t name_len) {
+    uint8_t key[SNAPSHOT_DATA_KEY_SIZE] = {0};
+    memcpy(key, account_id, 32);
+    memcpy(key + 32, &name_len, sizeof(name_len));
+    memcpy(key + 36, name, name_len);
+    return snapshot_hash(key, sizeof(key));
+}
+
+// WRITER
+// ------
+
+static bool writer_write_all(int fd, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static bool writer_flush(rsa_snapshot_writer_t *writer) {
+    if (writer->buffer_used == 0) return true;
+    if (!writer_write_all(writer->fd, writer->buffer, writer->buffer_used)) {
+        writer->failed = true;
+        return false;
+    }
+    writer->buffer_used = 0;
+    return true;
+}
+
+bool rsa_snapshot_writer_open(rsa_snapshot_writer_t *writer, const char *path,
+                              uint64_t ledger_seq, const uint8_t *ledger_hash) {
+    if (!writer || !path) return false;
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+    writer->section = -1;
+
+    if (strlen(path) >= sizeof(writer->path)) return false;
+    snprintf(writer->path, sizeof(writer->path), "%s", path);
+    snprintf(writer->tmp_path, sizeof(writer->tmp_path), "%s.tmp", path);
+
+    writer->buffer = malloc(SNAPSHOT_BUFFER_SIZE);
+    if (!writer->buffer) return false;
+
+    writer->fd = open(writer->tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (writer->fd < 0) {
+        free(writer->buffer);
+        writer->buffer = NULL;
+        return false;
+    }
+
+    rsa_snapshot_header_t *header = &writer->header;
+    memcpy(header->magic, RSA_SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = RSA_SNAPSHOT_VERSION;
+    header->section_count = RSA_SNAPSHOT_SECTION_COUNT;
+    header->ledger_seq = ledger_seq;
+    if (ledger_hash) memcpy(header->ledger_hash, ledger_hash, sizeof(header->ledger_hash));
+    for (int i = 0; i < RSA_SNAPSHOT_SECTION_COUNT; i++) {
+        header->sections[i].type = (uint32_t)i;
+        header->sections[i].record_size = snapshot_record_sizes[i];
+    }
+
+    // Page 0 is the header, written last
+    writer->offset = RSA_SNAPSHOT_PAGE_SIZE;
+    if (lseek(writer->fd, (off_t)writer->offset, SEEK_SET) < 0) {
+        rsa_snapshot_writer_abort(writer);
+        return false;
+    }
+    return true;
+}
+
+void rsa_snapshot_writer_set_ledger_header(rsa_snapshot_writer_t *writer,
+                                           const rsa_ledger_header_t *header) {
+    if (writer && header) writer->header.ledger_header = *header;
+}
+
+bool rsa_snapshot_writer_begin(rsa_snapshot_writer_t *writer, rsa_snapshot_section_type_t type) {
+    if (!writer || writer->failed || writer->section >= 0) return false;
+    if ((unsigned)type >= RSA_SNAPSHOT_SECTION_COUNT || writer->sections_done[type]) return false;
+
+    writer->section = (int)type;
+    rsa_snapshot_section_t *section = &writer->header.sections[type];
+    section->count = 0;
+    section->data_offset = writer->offset;
+    SHA256_Init(&writer->data_ctx);
+    return true;
+}
+
+static bool writer_append(rsa_snapshot_writer_t *writer, rsa_snapshot_section_type_t type,
+                          const void *record, uint64_t key_hash) {
+    rsa_snapshot_section_t *section = &writer->header.sections[type];
+    if (section->count >= UINT32_MAX - 1) return false;
+
+    if (section->count == writer->hash_capacity) {
+        size_t capacity = writer->hash_capacity ? writer->hash_capacity * 2 : 4096;
+        uint64_t *hashes = realloc(writer->hashes, capacity * sizeof(*hashes));
+        if (!hashes) {
+            writer->failed = true;
+            return false;
+        }
+        writer->hashes = hashes;
+        writer->hash_capacity = capacity;
+    }
+
+    size_t size = snapshot_record_sizes[type];
+    if (writer->buffer_used + size > SNAPSHOT_BUFFER_SIZE && !writer_flush(writer)) {
+        return false;
+    }
+    memcpy(writer->buffer + writer->buffer_used, record, size);
+    size_t used = snapshot_record_used[type];
+    memset(writer->buffer + writer->buffer_used + used, 0, size - used);
+    SHA256_Update(&writer->data_ctx, writer->buffer + writer->buffer_used, size);
+    writer->buffer_used += size;
+
+    writer->hashes[section->count++] = key_hash;
+    return true;
+}
+
+static bool writer_accepts(const rsa_snapshot_writer_t *writer, rsa_snapshot_section_type_t type,
+                           const void *record) {
+    return writer && record && !writer->failed && writer->section == (int)type;
+}
+
+bool rsa_snapshot_write_account(rsa_snapshot_writer_t *writer, const rsa_account_t *account) {
+    if (!writer_accepts(writer, RSA_SNAPSHOT_ACCOUNTS, account)) return false;
+    return writer_append(writer, RSA_SNAPSHOT_ACCOUNTS, account,
+                         account_key_hash(account->account_id));
+}
+
+bool rsa_snapshot_write_trustline(rsa_snapshot_writer_t *writer, const rsa_trustline_t *trustline) {
+    if (!writer_accepts(writer, RSA_SNAPSHOT_TRUSTLINES, trustline)) return false;
+
+    rsa_trustline_t record = *trustline;
+    if (!rsa_asset_canonicalize(&trustline->asset, &record.asset)) return false;
+    return writer_append(writer, RSA_SNAPSHOT_TRUSTLINES, &record,
+                         trustline_key_hash(record.account_id, &record.asset));
+}
+
+bool rsa_snapshot_write_offer(rsa_snapshot_writer_t *writer, const rsa_offer_t *offer) {
+    if (!writer_accepts(writer, RSA_SNAPSHOT_OFFERS, offer)) return false;
+
+    rsa_offer_t record = *offer;
+    if (!rsa_asset_canonicalize(&offer->selling, &record.selling) ||
+        !rsa_asset_canonicalize(&offer->buying, &record.buying)) {
+        return false;
+    }
+    return writer_append(writer, RSA_SNAPSHOT_OFFERS, &record, offer_key_hash(record.offer_id));
+}
+
+bool rsa_snapshot_write_data(rsa_snapshot_writer_t *writer, const rsa_data_t *data) {
+    if (!writer_accepts(writer, RSA_SNAPSHOT_DATA, data)) return false;
+    if (data->data_name_len > sizeof(data->data_name) ||
+        data->data_value_len > sizeof(data->data_value)) {
+        return false;
+    }
+
+    // Bytes past the lengths are not part of the entry
+    rsa_data_t record = *data;
+    memset(record.data_name + record.data_name_len, 0,
+           sizeof(record.data_name) - record.data_name_len);
+    memset(record.data_value + record.data_value_len, 0,
+           sizeof(record.data_value) - record.data_value_len);
+    return writer_append(writer, RSA_SNAPSHOT_DATA, &record,
+                         data_key_hash(record.account_id, record.data_name, record.data_name_len));
+}
+
+// Index load stays at or below 4/5
+static uint64_t index_capacity_for(uint64_t count) {
+    uint64_t capacity = 16;
+    while (capacity - capacity / 5 < count) capacity <<= 1;
+    return capacity;
+}
+
+bool rsa_snapshot_writer_end(rsa_snapshot_writer_t *writer) {
+    if (!writer || writer->failed || writer->section < 0) return false;
+
+    rsa_snapshot_section_t *section = &writer->header.sections[writer->section];
+    if (!writer_flush(writer)) return false;
+    SHA256_Final(section->data_checksum, &writer->data_ctx);
+
+    // An empty section is stored like one never begun: no index, and
+    // readers skip its offsets
+    if (section->count == 0) {
+        section->data_offset = 0;
+        SHA256(NULL, 0, section->index_checksum);
+        writer->sections_done[writer->section] = true;
+        writer->section = -1;
+        return true;
+    }
+    section->data_length = section->count * section->record_size;
+
+    // The index is built straight into the file through a shared mapping
+    section->index_offset = align_page(section->data_offset + section->data_length);
+    section->index_capacity = index_capacity_for(section->count);
+    size_t index_bytes = (size_t)section->index_capacity * sizeof(rsa_snapshot_slot_t);
+    if (ftruncate(writer->fd, (off_t)(section->index_offset + index_bytes)) != 0) {
+        writer->failed = true;
+        return false;
+    }
+    rsa_snapshot_slot_t *slots = mmap(NULL, index_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                      writer->fd, (off_t)section->index_offset);
+    if (slots == MAP_FAILED) {
+        writer->failed = true;
+        return false;
+    }
+
+    uint64_t mask = section->index_capacity - 1;
+    for (uint64_t i = 0; i < section->count; i++) {
+        uint64_t hash = writer->hashes[i];
+        uint64_t pos = hash & mask;
+        while (slots[pos].record != 0) pos = (pos + 1) & mask;
+        slots[pos].tag = (uint32_t)(hash >> 32);
+        slots[pos].record = (uint32_t)(i + 1);
+    }
+    SHA256((const unsigned char *)slots, index_bytes, section->index_checksum);
+    munmap(slots, index_bytes);
+
+    writer->offset = align_page(section->index_offset + index_bytes);
+    if (lseek(writer->fd, (off_t)writer->offset, SEEK_SET) < 0) {
+        writer->failed = true;
+        return false;
+    }
+    writer->sections_done[writer->section] = true;
+    writer->section = -1;
+    return true;
+}
+
+static void snapshot_header_checksum(const rsa_snapshot_header_t *header,
+                                     uint8_t out[SHA256_DIGEST_LENGTH]) {
+    SHA256((const unsigned char *)header, offsetof(rsa_snapshot_header_t, header_checksum), out);
+}
+
+static void writer_release(rsa_snapshot_writer_t *writer) {
+    if (writer->fd >= 0) close(writer->fd);
+    writer->fd = -1;
+    free(writer->buffer);
+    free(writer->hashes);
+    writer->buffer = NULL;
+    writer->hashes = NULL;
+}
+
+bool rsa_snapshot_writer_commit(rsa_snapshot_writer_t *writer) {
+    if (!writer || writer->fd < 0) return false;
+    if (writer->section >= 0 && !rsa_snapshot_writer_end(writer)) return false;
+    if (writer->failed) return false;
+
+    // Sections never written are empty; their checksums cover no bytes
+    for (int i = 0; i < RSA_SNAPSHOT_SECTION_COUNT; i++) {
+        if (!writer->sections_done[i]) {
+            rsa_snapshot_section_t *section = &writer->header.sections[i];
+            SHA256(NULL, 0, section->data_checksum);
+            SHA256(NULL, 0, section->index_checksum);
+        }
+    }
+
+    rsa_snapshot_header_t *header = &writer->header;
+    header->file_length = writer->offset;
+    snapshot_header_checksum(header, header->header_checksum);
+
+    uint8_t page[RSA_SNAPSHOT_PAGE_SIZE] = {0};
+    memcpy(page, header, sizeof(*header));
+    if (ftruncate(writer->fd, (off_t)header->file_length) != 0 ||
+        pwrite(writer->fd, page, sizeof(page), 0) != (ssize_t)sizeof(page) ||
+        fsync(writer->fd) != 0) {
+        writer->failed = true;
+        return false;
+    }
+    close(writer->fd);
+    writer->fd = -1;
+
+    if (rename(writer->tmp_path, writer->path) != 0) {
+        writer->failed = true;
+        return false;
+    }
+
+    // Persist the rename itself
+    char dir_path[sizeof(writer->path)];
+    snprintf(dir_path, sizeof(dir_path), "%s", writer->path);
+    int dir_fd = open(dirname(dir_path), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+
+    writer_release(writer);
+    return true;
+}
+
+void rsa_snapshot_writer_abort(rsa_snapshot_writer_t *writer) {
+    if (!writer) return;
+    if (writer->fd >= 0 || writer->failed) {
+        unlink(writer->tmp_path);
+    }
+    writer_release(writer);
+}
+
+// READER
+// ------
+
+static bool snapshot_section_valid(const rsa_snapshot_section_t *section, int type,
+                                   uint64_t file_length) {
+    if (section->type != (uint32_t)type || section->record_size != snapshot_record_sizes[type]) {
+        return false;
+    }
+    if (section->count == 0) return true;
+    if (section->count >= UINT32_MAX ||
+        section->data_length != section->count * section->record_size) {
+        return false;
+    }
+    // Differences, not sums, so crafted offsets cannot wrap
+    if (section->data_offset % RSA_SNAPSHOT_PAGE_SIZE != 0 ||
+        section->index_offset % RSA_SNAPSHOT_PAGE_SIZE != 0 ||
+        section->data_offset < RSA_SNAPSHOT_PAGE_SIZE ||
+        section->data_offset > file_length ||
+        section->data_length > file_length - section->data_offset) {
+        return false;
+    }
+    uint64_t capacity = section->index_capacity;
+    if (capacity < section->count || (capacity & (capacity - 1)) != 0 ||
+        section->index_offset > file_length ||
+        capacity > (file_length - section->index_offset) / sizeof(rsa_snapshot_slot_t)) {
+        return false;
+    }
+    return true;
+}
+
+bool rsa_snapshot_open(rsa_snapshot_t *snapshot, const char *path) {
+    if (!snapshot || !path) return false;
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->fd = -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < RSA_SNAPSHOT_PAGE_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    size_t length = (size_t)st.st_size;
+    void *map = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    // Only page 0 is examined here; everything else is faulted in on use
+    const rsa_snapshot_header_t *header = map;
+    uint8_t checksum[SHA256_DIGEST_LENGTH];
+    snapshot_header_checksum(header, checksum);
+    bool valid = memcmp(header->magic, RSA_SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == RSA_SNAPSHOT_VERSION &&
+                 header->section_count == RSA_SNAPSHOT_SECTION_COUNT &&
+                 header->file_length == (uint64_t)length &&
+                 memcmp(checksum, header->header_checksum, sizeof(checksum)) == 0;
+    for (int i = 0; valid && i < RSA_SNAPSHOT_SECTION_COUNT; i++) {
+        valid = snapshot_section_valid(&header->sections[i], i, length);
+    }
+    if (!valid) {
+        munmap(map, length);
+        close(fd);
+        return false;
+    }
+
+    // Point lookups: read-ahead would only pull in unrelated records
+    madvise(map, length, MADV_RANDOM);
+
+    snapshot->fd = fd;
+    snapshot->map = map;
+    snapshot->length = length;
+    snapshot->header = header;
+    return true;
+}
+
+void rsa_snapshot_close(rsa_snapshot_t *snapshot) {
+    if (!snapshot || !snapshot->map) return;
+    munmap((void *)snapshot->map, snapshot->length);
+    close(snapshot->fd);
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->fd = -1;
+}
+
+bool rsa_snapshot_verify(const rsa_snapshot_t *snapshot) {
+    if (!snapshot || !snapshot->header) return false;
+
+    for (int i = 0; i < RSA_SNAPSHOT_SECTION_COUNT; i++) {
+        const rsa_snapshot_section_t *section = &snapshot->header->sections[i];
+        uint8_t checksum[SHA256_DIGEST_LENGTH];
+
+        const uint8_t *data = section->count ? snapshot->map + section->data_offset : NULL;
+        SHA256(data, section->count ? section->data_length : 0, checksum);
+        if (memcmp(checksum, section->data_checksum, sizeof(checksum)) != 0) return false;
+
+        const uint8_t *index = section->count ? snapshot->map + section->index_offset : NULL;
+        size_t index_bytes = section->count ? section->index_capacity * sizeof(rsa_snapshot_slot_t) : 0;
+        SHA256(index, index_bytes, checksum);
+        if (memcmp(checksum, section->index_checksum, sizeof(checksum)) != 0) return false;
+    }
+    return true;
+}
+
+const void *rsa_snapshot_records(const rsa_snapshot_t *snapshot,
+                                 rsa_snapshot_section_type_t type, uint64_t *count) {
+    if (count) *count = 0;
+    if (!snapshot || !snapshot->header || (unsigned)type >= RSA_SNAPSHOT_SECTION_COUNT) {
+        return NULL;
+    }
+    const rsa_snapshot_section_t *section = &snapshot->header->sections[type];
+    if (section->count == 0) return NULL;
+    if (count) *count = section->count;
+    return snapshot->map + section->data_offset;
+}
+
+typedef bool (*snapshot_match_fn)(const void *record, const void *key);
+
+static const void *snapshot_find(const rsa_snapshot_t *snapshot, rsa_snapshot_section_type_t type,
+                                 uint64_t hash, snapshot_match_fn match, const void *key) {
+    if (!snapshot || !snapshot->header) return NULL;
+    const rsa_snapshot_section_t *section = &snapshot->header->sections[type];
+    if (section->count == 0) return NULL;
+
+    const rsa_snapshot_slot_t *slots =
+        (const rsa_snapshot_slot_t *)(snapshot->map + section->index_offset);
+    const uint8_t *records = snapshot->map + section->data_offset;
+    uint64_t mask = section->index_capacity - 1;
+    uint32_t tag = (uint32_t)(hash >> 32);
+
+    // Bounded so a damaged index cannot loop forever
+    uint64_t pos = hash & mask;
+    for (uint64_t probes = 0; probes <= mask; probes++, pos = (pos + 1) & mask) {
+        uint32_t record = slots[pos].record;
+        if (record == 0) return NULL;
+        if (slots[pos].tag == tag && record <= section->count) {
+            const void *candidate = records + (uint64_t)(record - 1) * section->record_size;
+            if (match(candidate, key)) return candidate;
+        }
+    }
+    return NULL;
+}
+
+static bool match_account(const void *record, const void *key) {
+    return memcmp(((const rsa_account_t *)record)->account_id, key, 32) == 0;
+}
+
+const rsa_account_t *rsa_snapshot_find_account(const rsa_snapshot_t *snapshot,
+                                               const uint32_t account_id[8]) {
+    if (!account_id) return NULL;
+    return snapshot_find(snapshot, RSA_SNAPSHOT_ACCOUNTS, account_key_hash(account_id),
+                         match_account, account_id);
+}
+
+typedef struct {
+    const uint32_t *account_id;
+    rsa_asset_t asset;
+} trustline_key_t;
+
+static bool match_trustline(const void *record, const void *key) {
+    const rsa_trustline_t *trustline = record;
+    const trustline_key_t *k = key;
+    return memcmp(trustline->account_id, k->account_id, 32) == 0 &&
+           memcmp(&trustline->asset, &k->asset, sizeof(k->asset)) == 0;
+}
+
+const rsa_trustline_t *rsa_snapshot_find_trustline(const rsa_snapshot_t *snapshot,
+                                                   const uint32_t account_id[8],
+                                                   const rsa_asset_t *asset) {
+    trustline_key_t key = {.account_id = account_id};
+    if (!account_id || !rsa_asset_canonicalize(asset, &key.asset)) return NULL;
+    return snapshot_find(snapshot, RSA_SNAPSHOT_TRUSTLINES,
+                         trustline_key_hash(account_id, &key.asset), match_trustline, &key);
+}
+
+static bool match_offer(const void *record, const void *key) {
+    return ((const rsa_offer_t *)record)->offer_id == *(const uint64_t *)key;
+}
+
+const rsa_offer_t *rsa_snapshot_find_offer(const rsa_snapshot_t *snapshot, uint64_t offer_id) {
+    return snapshot_find(snapshot, RSA_SNAPSHOT_OFFERS, offer_key_hash(offer_id),
+                         match_offer, &offer_id);
+}
+
+typedef struct {
+    const uint32_t *account_id;
+    const char *name;
+    uint32_t name_len;
+} data_key_t;
+
+static bool match_data(const void *record, const void *key) {
+    const rsa_data_t *data = record;
+    const data_key_t *k = key;
+    return data->data_name_len == k->name_len &&
+           memcmp(data->account_id, k->account_id, 32) == 0 &&
+           memcmp(data->data_name, k->name, k->name_len) == 0;
+}
+
+const rsa_data_t *rsa_snapshot_find_data(const rsa_snapshot_t *snapshot,
+                                         const uint32_t account_id[8],
+                                         const char *name, uint32_t name_len) {
+    if (!account_id || !name || name_len > sizeof(((rsa_data_t *)0)->data_name)) return NULL;
+    data_key_t key = {.account_id = account_id, .name = name, .name_len = name_len};
+    return snapshot_find(snapshot, RSA_SNAPSHOT_DATA, data_key_hash(account_id, name, name_len),
+                         match_data, &key);
+}
@@ -0,0 +1,146 @@
+#ifndef RSA_SNAPSHOT_H
+#define RSA_SNAPSHOT_H
+
+#include "rsa_token.h"
+#include <openssl/sha.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LEDGER SNAPSHOT FILES
+// =====================
+// On-disk image of ledger state that is mmap'ed and queried in place:
+//
+//   page 0      rsa_snapshot_header_t (SHA-256 over the header itself),
+//               with the full header of the snapshot's ledger
+//   per section records    fixed-size rsa_account_t / rsa_trustline_t /
+//                          rsa_offer_t / rsa_data_t, page aligned
+//               hash index open-addressing slots, page aligned
+//
+// Each section carries SHA-256 checksums of its records and of its index.
+// Opening a snapshot validates the header and the section bounds only, so
+// startup costs a few page faults regardless of ledger size; pages are
+// faulted in as queries touch them. rsa_snapshot_verify() runs the full
+// checksum pass when wanted (e.g. from a background thread).
+//
+// Files are written to "<path>.tmp", synced and renamed into place, so a
+// crash never leaves a half-written snapshot under the final name.
+// Integers are stored in host byte order (little-endian on all supported
+// targets).
+
+#define RSA_SNAPSHOT_MAGIC "RSASNAP"            // 8 bytes with the NUL
+#define RSA_SNAPSHOT_VERSION 2             // 2: ledger header in page 0
+#define RSA_SNAPSHOT_PAGE_SIZE 4096
+
+typedef enum {
+    RSA_SNAPSHOT_ACCOUNTS = 0,
+    RSA_SNAPSHOT_TRUSTLINES,
+    RSA_SNAPSHOT_OFFERS,
+    RSA_SNAPSHOT_DATA,
+    RSA_SNAPSHOT_SECTION_COUNT
+} rsa_snapshot_section_type_t;
+
+typedef struct {
+    uint32_t type;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t data_offset;
+    uint64_t data_length;
+    uint64_t index_offset;
+    uint64_t index_capacity;                    // slots, power of two
+    uint8_t data_checksum[SHA256_DIGEST_LENGTH];
+    uint8_t index_checksum[SHA256_DIGEST_LENGTH];
+} rsa_snapshot_section_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+    uint64_t ledger_seq;
+    uint8_t ledger_hash[32];
+    rsa_ledger_header_t ledger_header;          // zero unless the writer was given one
+    uint64_t file_length;
+    rsa_snapshot_section_t sections[RSA_SNAPSHOT_SECTION_COUNT];
+    uint8_t header_checksum[SHA256_DIGEST_LENGTH]; // over all fields above
+} rsa_snapshot_header_t;
+
+// Index slot: upper key-hash bits and record number + 1 (0 = empty)
+typedef struct {
+    uint32_t tag;
+    uint32_t record;
+} rsa_snapshot_slot_t;
+
+// Writer
+// ------
+typedef struct {
+    int fd;
+    char path[512];
+    char tmp_path[516];
+    uint64_t offset;                            // end of written data
+    rsa_snapshot_header_t header;
+    int section;                                // open section or -1
+    bool sections_done[RSA_SNAPSHOT_SECTION_COUNT];
+    SHA256_CTX data_ctx;
+    uint64_t *hashes;                           // key hashes of the open section
+    size_t hash_capacity;
+    uint8_t *buffer;
+    size_t buffer_used;
+    bool failed;
+} rsa_snapshot_writer_t;
+
+bool rsa_snapshot_writer_open(rsa_snapshot_writer_t *writer, const char *path,
+                              uint64_t ledger_seq, const uint8_t *ledger_hash);
+// Header of the snapshot's ledger, so a node restarting from the file can
+// keep chaining ledgers (rsa_ledger_open)
+void rsa_snapshot_writer_set_ledger_header(rsa_snapshot_writer_t *writer,
+                                           const rsa_ledger_header_t *header);
+// Sections may be written in any order, each at most once; sections never
+// begun are stored empty
+bool rsa_snapshot_writer_begin(rsa_snapshot_writer_t *writer, rsa_snapshot_section_type_t type);
+bool rsa_snapshot_write_account(rsa_snapshot_writer_t *writer, const rsa_account_t *account);
+bool rsa_snapshot_write_trustline(rsa_snapshot_writer_t *writer, const rsa_trustline_t *trustline);
+bool rsa_snapshot_write_offer(rsa_snapshot_writer_t *writer, const rsa_offer_t *offer);
+bool rsa_snapshot_write_data(rsa_snapshot_writer_t *writer, const rsa_data_t *data);
+bool rsa_snapshot_writer_end(rsa_snapshot_writer_t *writer);
+// Writes the header, syncs and renames into place
+bool rsa_snapshot_writer_commit(rsa_snapshot_writer_t *writer);
+// Drops the temporary file (also safe after a failed commit)
+void rsa_snapshot_writer_abort(rsa_snapshot_writer_t *writer);
+
+// Reader
+// ------
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t length;
+    const rsa_snapshot_header_t *header;
+} rsa_snapshot_t;
+
+bool rsa_snapshot_open(rsa_snapshot_t *snapshot, const char *path);
+void rsa_snapshot_close(rsa_snapshot_t *snapshot);
+
+// Full checksum pass over every section
+bool rsa_snapshot_verify(const rsa_snapshot_t *snapshot);
+
+// Record array of a section, for iteration
+const void *rsa_snapshot_records(const rsa_snapshot_t *snapshot,
+                                 rsa_snapshot_section_type_t type, uint64_t *count);
+
+// Point lookups in place; results point into the mapping
+const rsa_account_t *rsa_snapshot_find_account(const rsa_snapshot_t *snapshot,
+                                               const uint32_t account_id[8]);
+const rsa_trustline_t *rsa_snapshot_find_trustline(const rsa_snapshot_t *snapshot,
+                                                   const uint32_t account_id[8],
+                                                   const rsa_asset_t *asset);
+const rsa_offer_t *rsa_snapshot_find_offer(const rsa_snapshot_t *snapshot, uint64_t offer_id);
+const rsa_data_t *rsa_snapshot_find_data(const rsa_snapshot_t *snapshot,
+                                         const uint32_t account_id[8],
+                                         const char *name, uint32_t name_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_SNAPSHOT_H
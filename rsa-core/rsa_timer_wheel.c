@@ -0,0 +1,169 @@
+#include "rsa_timer_wheel.h"
+#include <stdlib.h>
+#include <string.h>
+
+// HIERARCHICAL TIMER WHEEL
+// ========================
+// Invariant: a level's slots before the index of the next tick are empty,
+// since whatever was filed there has cascaded or fired. The scan for the
+// next tick with work and the cascade both rely on it.
+
+#define WHEEL_MASK ((uint64_t)RSA_TIMER_WHEEL_SLOTS - 1)
+#define WHEEL_SPAN_BITS (RSA_TIMER_WHEEL_BITS * RSA_TIMER_WHEEL_LEVELS)
+
+static void wheel_unlink(rsa_timer_wheel_t *wheel, uint32_t id) {
+    rsa_timer_t *timer = &wheel->timers[id];
+    uint32_t *head = &wheel->heads[timer->slot];
+    if (timer->prev != RSA_TIMER_NONE) {
+        wheel->timers[timer->prev].next = timer->next;
+    } else {
+        *head = timer->next;
+    }
+    if (timer->next != RSA_TIMER_NONE) wheel->timers[timer->next].prev = timer->prev;
+    if (*head == RSA_TIMER_NONE && timer->slot != RSA_TIMER_WHEEL_OVERFLOW) {
+        wheel->occupied[timer->slot / RSA_TIMER_WHEEL_SLOTS] &=
+            ~(1ULL << (timer->slot % RSA_TIMER_WHEEL_SLOTS));
+    }
+    timer->slot = RSA_TIMER_WHEEL_IDLE;
+}
+
+static void wheel_push(rsa_timer_wheel_t *wheel, uint32_t id, uint16_t slot) {
+    rsa_timer_t *timer = &wheel->timers[id];
+    timer->slot = slot;
+    timer->prev = RSA_TIMER_NONE;
+    timer->next = wheel->heads[slot];
+    if (timer->next != RSA_TIMER_NONE) wheel->timers[timer->next].prev = id;
+    wheel->heads[slot] = id;
+}
+
+// Files the timer against `base`, the next tick to be processed: in the
+// lowest level whose block containing `base` also contains the deadline
+static void wheel_file(rsa_timer_wheel_t *wheel, uint32_t id, uint64_t base) {
+    uint64_t deadline = wheel->timers[id].deadline < base ? base : wheel->timers[id].deadline;
+    if ((deadline >> WHEEL_SPAN_BITS) != (base >> WHEEL_SPAN_BITS)) {
+        wheel_push(wheel, id, RSA_TIMER_WHEEL_OVERFLOW);
+        return;
+    }
+    unsigned level = 0;
+    while ((deadline >> (RSA_TIMER_WHEEL_BITS * (level + 1))) !=
+           (base >> (RSA_TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    unsigned index = (unsigned)((deadline >> (RSA_TIMER_WHEEL_BITS * level)) & WHEEL_MASK);
+    wheel_push(wheel, id, (uint16_t)(level * RSA_TIMER_WHEEL_SLOTS + index));
+    wheel->occupied[level] |= 1ULL << index;
+}
+
+// Earliest tick after `now` that fires a level-0 slot or cascades a
+// non-empty higher one, or where the overflow is filed. Levels are looked
+// at independently: a cascade due on the very next tick comes before any
+// level-0 deadline of that block.
+static uint64_t wheel_next_tick(const rsa_timer_wheel_t *wheel) {
+    uint64_t tick = wheel->now + 1;
+    uint64_t best = ((tick + (1ULL << WHEEL_SPAN_BITS) - 1) >> WHEEL_SPAN_BITS) << WHEEL_SPAN_BITS;
+    for (unsigned level = 0; level < RSA_TIMER_WHEEL_LEVELS; level++) {
+        unsigned shift = RSA_TIMER_WHEEL_BITS * level;
+        uint64_t boundary = ((tick + (1ULL << shift) - 1) >> shift) << shift;
+        uint64_t ahead = wheel->occupied[level] >> ((boundary >> shift) & WHEEL_MASK);
+        if (!ahead) continue;
+        uint64_t next = boundary + ((uint64_t)__builtin_ctzll(ahead) << shift);
+        if (next < best) best = next;
+    }
+    return best;
+}
+
+// Detaches the slot's list first: overflow timers may be filed back into it
+static void wheel_cascade(rsa_timer_wheel_t *wheel, unsigned slot, uint64_t tick) {
+    uint32_t id = wheel->heads[slot];
+    wheel->heads[slot] = RSA_TIMER_NONE;
+    if (slot != RSA_TIMER_WHEEL_OVERFLOW) {
+        wheel->occupied[slot / RSA_TIMER_WHEEL_SLOTS] &= ~(1ULL << (slot % RSA_TIMER_WHEEL_SLOTS));
+    }
+    while (id != RSA_TIMER_NONE) {
+        uint32_t next = wheel->timers[id].next;
+        wheel_file(wheel, id, tick);
+        id = next;
+    }
+}
+
+void rsa_timer_wheel_init(rsa_timer_wheel_t *wheel, uint64_t now) {
+    if (!wheel) return;
+    memset(wheel, 0, sizeof(*wheel));
+    for (size_t i = 0; i <= RSA_TIMER_WHEEL_OVERFLOW; i++) {
+        wheel->heads[i] = RSA_TIMER_NONE;
+    }
+    wheel->now = now;
+}
+
+void rsa_timer_wheel_free(rsa_timer_wheel_t *wheel) {
+    if (!wheel) return;
+    free(wheel->timers);
+    wheel->timers = NULL;
+    wheel->capacity = 0;
+}
+
+bool rsa_timer_wheel_reserve(rsa_timer_wheel_t *wheel, uint32_t capacity) {
+    if (!wheel) return false;
+    if (capacity <= wheel->capacity) return true;
+    rsa_timer_t *timers = realloc(wheel->timers, capacity * sizeof(*timers));
+    if (!timers) return false;
+    for (uint32_t i = wheel->capacity; i < capacity; i++) timers[i].slot = RSA_TIMER_WHEEL_IDLE;
+    wheel->timers = timers;
+    wheel->capacity = capacity;
+    return true;
+}
+
+void rsa_timer_wheel_set(rsa_timer_wheel_t *wheel, uint32_t id, uint64_t deadline) {
+    if (!wheel || id >= wheel->capacity) return;
+    if (wheel->timers[id].slot != RSA_TIMER_WHEEL_IDLE) {
+        wheel_unlink(wheel, id);
+        wheel->count--;
+    }
+    wheel->timers[id].deadline = deadline;
+    wheel_file(wheel, id, wheel->now + 1);
+    wheel->count++;
+}
+
+void rsa_timer_wheel_cancel(rsa_timer_wheel_t *wheel, uint32_t id) {
+    if (!rsa_timer_wheel_armed(wheel, id)) return;
+    wheel_unlink(wheel, id);
+    wheel->count--;
+}
+
+bool rsa_timer_wheel_armed(const rsa_timer_wheel_t *wheel, uint32_t id) {
+    return wheel && id < wheel->capacity && wheel->timers[id].slot != RSA_TIMER_WHEEL_IDLE;
+}
+
+size_t rsa_timer_wheel_advance(rsa_timer_wheel_t *wheel, uint64_t now, rsa_timer_fire_fn fire,
+                               void *user) {
+    if (!wheel) return 0;
+
+    size_t fired = 0;
+    while (wheel->count > 0) {
+        uint64_t tick = wheel_next_tick(wheel);
+        if (tick > now) break;
+
+        // Timers armed from here on, by `fire` included, file against `tick`
+        wheel->now = tick - 1;
+        if ((tick & ((1ULL << WHEEL_SPAN_BITS) - 1)) == 0) {
+            wheel_cascade(wheel, RSA_TIMER_WHEEL_OVERFLOW, tick);
+        }
+        for (unsigned level = RSA_TIMER_WHEEL_LEVELS; level-- > 1;) {
+            unsigned shift = RSA_TIMER_WHEEL_BITS * level;
+            if (tick & ((1ULL << shift) - 1)) continue;
+            unsigned index = (unsigned)((tick >> shift) & WHEEL_MASK);
+            wheel_cascade(wheel, level * RSA_TIMER_WHEEL_SLOTS + index, tick);
+        }
+        uint32_t *head = &wheel->heads[tick & WHEEL_MASK];
+        while (*head != RSA_TIMER_NONE) {
+            uint32_t id = *head;
+            wheel_unlink(wheel, id);
+            wheel->count--;
+            fired++;
+            if (fire) fire(id, user);
+        }
+        wheel->now = tick;
+    }
+    if (now > wheel->now) wheel->now = now;
+    return fired;
+}
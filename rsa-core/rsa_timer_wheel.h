@@ -0,0 +1,73 @@
+#ifndef RSA_TIMER_WHEEL_H
+#define RSA_TIMER_WHEEL_H
+
+#include "rsa_token.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// HIERARCHICAL TIMER WHEEL
+// ========================
+// One-shot timers on a tick clock (the mempool ticks in seconds), named by
+// a uint32_t id the caller chooses, typically an index into its own table.
+// Level l has RSA_TIMER_WHEEL_SLOTS slots of 64^l ticks each; a timer is
+// filed in the lowest level whose current block holds its deadline and
+// moves down a level (cascades) when time reaches its slot. Arming,
+// cancelling and firing are O(1), and a timer cascades at most
+// RSA_TIMER_WHEEL_LEVELS - 1 times, so expiry is O(1) amortized. Empty
+// stretches of time are skipped with per-level occupancy bitmaps.
+//
+// Deadlines past the top level's span wait in an overflow list that is
+// filed again each time the top level wraps. Not thread-safe; the owner
+// locks.
+
+#define RSA_TIMER_WHEEL_BITS 6
+#define RSA_TIMER_WHEEL_SLOTS (1u << RSA_TIMER_WHEEL_BITS)
+#define RSA_TIMER_WHEEL_LEVELS 5           // 2^30 ticks, 34 years of seconds
+#define RSA_TIMER_WHEEL_OVERFLOW (RSA_TIMER_WHEEL_LEVELS * RSA_TIMER_WHEEL_SLOTS)  // slot
+#define RSA_TIMER_WHEEL_IDLE UINT16_MAX
+#define RSA_TIMER_NONE UINT32_MAX
+
+typedef struct {
+    uint64_t deadline;
+    uint32_t prev;                      // slot list, RSA_TIMER_NONE at the ends
+    uint32_t next;
+    uint16_t slot;                      // level * RSA_TIMER_WHEEL_SLOTS + index, OVERFLOW or IDLE
+} rsa_timer_t;
+
+typedef struct {
+    rsa_timer_t *timers;                // by id
+    uint32_t capacity;
+    uint32_t heads[RSA_TIMER_WHEEL_OVERFLOW + 1];
+    uint64_t occupied[RSA_TIMER_WHEEL_LEVELS];  // bit per non-empty slot
+    uint64_t now;                       // every deadline up to here has fired
+    size_t count;
+} rsa_timer_wheel_t;
+
+typedef void (*rsa_timer_fire_fn)(uint32_t id, void *user);
+
+void rsa_timer_wheel_init(rsa_timer_wheel_t *wheel, uint64_t now);
+void rsa_timer_wheel_free(rsa_timer_wheel_t *wheel);
+// Ids below `capacity` become usable; false on allocation failure
+bool rsa_timer_wheel_reserve(rsa_timer_wheel_t *wheel, uint32_t capacity);
+
+// Arms (or re-arms) timer `id`; a deadline not after `now` fires on the
+// next tick
+void rsa_timer_wheel_set(rsa_timer_wheel_t *wheel, uint32_t id, uint64_t deadline);
+void rsa_timer_wheel_cancel(rsa_timer_wheel_t *wheel, uint32_t id);
+bool rsa_timer_wheel_armed(const rsa_timer_wheel_t *wheel, uint32_t id);
+
+// Moves time forward to `now` (never back), calling `fire` for every timer
+// whose deadline is reached, in deadline order across ticks. Timers are
+// disarmed before their call; `fire` may set or cancel any timer. Returns
+// the number fired.
+size_t rsa_timer_wheel_advance(rsa_timer_wheel_t *wheel, uint64_t now, rsa_timer_fire_fn fire,
+                               void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_TIMER_WHEEL_H
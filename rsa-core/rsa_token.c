@@ -1,4 +1,8 @@
 #include "rsa_token.h"
+#include "rsa_amount.h"
+#include "rsa_validation.h"
+#include "rsa_op_validation.h"
+#include "rsa_clock.h"
 #include <openssl/rsa.h>
 #include <openssl/evp.h>
 #include <openssl/sha.h>
@@ -22,7 +26,7 @@ pthread_mutex_t g_monitor_mutex = PTHREAD_MUTEX_INITIALIZER;
 bool rsa_check_memory_corruption(void) {
     // Check for memory corruption indicators
     if (g_rsa_monitor.memory_usage > RSA_MEMORY_CORRUPTION_THRESHOLD) {
-        rsa_trigger_alert("MEMORY_CORRUPTION", "Memory usage exceeded threshold");
+        rsa_trigger_alert_throttled("MEMORY_CORRUPTION", "Memory usage exceeded threshold");
         return true;
     }
     return false;
@@ -62,7 +66,7 @@ bool rsa_check_operation_limits(void) {
     bool under_limit = g_rsa_monitor.concurrent_operations < RSA_MAX_CONCURRENT_OPS;
     
     if (!under_limit) {
-        rsa_trigger_alert("RATE_LIMIT_EXCEEDED", "Concurrent operations limit exceeded");
+        rsa_trigger_alert_throttled("RATE_LIMIT_EXCEEDED", "Concurrent operations limit exceeded");
     }
     
     pthread_mutex_unlock(&g_monitor_mutex);
@@ -521,35 +525,26 @@ bool rsa_is_valid_address(const char *address) {
 }
 
 // Parse amount string to int64 (7 decimal places like XLM)
+// Invalid or out-of-range input yields 0; use rsa_amount_parse() for the reason.
 int64_t rsa_parse_amount(const char *amount_str) {
-    double amount = atof(amount_str);
-    return (int64_t)(amount * 10000000.0); // 7 decimal places
-}
+    if (!amount_str) return 0;
 
-// Format amount from int64 to string
-void rsa_format_amount(int64_t amount, char *amount_str) {
-    double value = (double)amount / 10000000.0; // 7 decimal places
-    sprintf(amount_str, "%.7f", value);
-    
-    // Remove trailing zeros
-    int len = strlen(amount_str);
-    while (len > 0 && amount_str[len-1] == '0') {
-        len--;
-    }
-    if (len > 0 && amount_str[len-1] == '.') {
-        len--;
+    while (*amount_str == ' ' || *amount_str == '\t') {
+        amount_str++;
     }
-    amount_str[len] = '\0';
-}
 
-// Multiply amount by multiplier
-int64_t rsa_multiply_amount(int64_t amount, double multiplier) {
-    return (int64_t)((double)amount * multiplier);
+    int64_t amount = 0;
+    rsa_amount_status_t status = rsa_amount_parse(amount_str, strlen(amount_str), &amount);
+    if (status != RSA_AMOUNT_OK && status != RSA_AMOUNT_ERR_PRECISION) {
+        return 0;
+    }
+    return amount;
 }
 
-// Divide amount by divisor
-int64_t rsa_divide_amount(int64_t amount, double divisor) {
-    return (int64_t)((double)amount / divisor);
+// Format amount from int64 to string (trailing zeros removed)
+void rsa_format_amount(int64_t amount, char *amount_str) {
+    if (!amount_str) return;
+    rsa_amount_format(amount, amount_str, RSA_AMOUNT_FORMAT_TRIM);
 }
 
 // Check if asset is native RSA token
@@ -586,98 +581,41 @@ void rsa_copy_asset(rsa_asset_t *dest, const rsa_asset_t *src) {
     memcpy(dest, src, sizeof(rsa_asset_t));
 }
 
-// FIXED: Validate transaction with enhanced security checks
-bool rsa_validate_transaction(const rsa_transaction_t *tx) {
+// Check transaction and report the reason for a rejection. Ordinary
+// rejections are counted in the monitor; only anomalies raise (throttled)
+// alerts, so a flood of expired or underpriced transactions stays cheap.
+rsa_validation_result_t rsa_check_transaction(const rsa_transaction_t *tx) {
+    rsa_validation_result_t result;
+    
     // Check operational limits first
     if (!rsa_check_operation_limits()) {
-        return false;
-    }
-    rsa_increment_operation_count();
-    
-    if (!tx) {
-        rsa_trigger_alert("NULL_TRANSACTION", "Null transaction passed for validation");
-        return false;
-    }
-    
-    // Check for memory corruption
-    if (rsa_check_memory_corruption()) {
-        return false;
-    }
-    
-    // Check fee with enhanced validation
-    if (tx->fee < RSA_BASE_FEE) {
-        rsa_trigger_alert("INSUFFICIENT_FEE", "Transaction fee below minimum");
-        return false;
-    }
-    
-    // Prevent excessive fees (potential DoS)
-    if (tx->fee > RSA_BASE_FEE * 1000) {
-        rsa_trigger_alert("EXCESSIVE_FEE", "Transaction fee suspiciously high");
-        return false;
-    }
-    
-    // Check sequence number
-    if (tx->seq_num == 0) {
-        rsa_trigger_alert("INVALID_SEQUENCE", "Transaction sequence number is zero");
-        return false;
-    }
-    
-    // Check time bounds with enhanced validation
-    uint64_t current_time = rsa_get_current_time();
-    if (tx->time_bounds.min_time > 0 && current_time < tx->time_bounds.min_time) {
-        rsa_trigger_alert("TRANSACTION_TOO_EARLY", "Transaction not yet valid");
-        return false;
-    }
-    if (tx->time_bounds.max_time > 0 && current_time > tx->time_bounds.max_time) {
-        rsa_trigger_alert("TRANSACTION_EXPIRED", "Transaction has expired");
-        return false;
-    }
-    
-    // CRITICAL: Enforce reduced operations count (was 100, now 10)
-    if (tx->operations_count == 0) {
-        rsa_trigger_alert("NO_OPERATIONS", "Transaction has no operations");
-        return false;
-    }
-    if (tx->operations_count > RSA_MAX_OPERATIONS_PER_TX) {
-        rsa_trigger_alert("TOO_MANY_OPERATIONS", "Transaction exceeds maximum operations limit");
-        return false;
-    }
-    
-    // Check for time bounds consistency
-    if (tx->time_bounds.min_time > 0 && tx->time_bounds.max_time > 0 &&
-        tx->time_bounds.min_time >= tx->time_bounds.max_time) {
-        rsa_trigger_alert("INVALID_TIME_BOUNDS", "Invalid time bounds configuration");
-        return false;
+        result = RSA_VALIDATION_RATE_LIMITED;
+    } else {
+        rsa_increment_operation_count();
+        
+        if (!tx) {
+            result = RSA_VALIDATION_NULL_TRANSACTION;
+        } else if (rsa_check_memory_corruption()) {
+            result = RSA_VALIDATION_MEMORY_CORRUPTION;
+        } else {
+            // Fee, sequence, time bounds and operation count checks
+            result = rsa_check_transaction_header(tx, rsa_get_current_time());
+        }
     }
     
-    return true;
+    rsa_record_validation_result(result);
+    return result;
+}
+
+// FIXED: Validate transaction with enhanced security checks
+bool rsa_validate_transaction(const rsa_transaction_t *tx) {
+    return rsa_check_transaction(tx) == RSA_VALIDATION_OK;
 }
 
-// Validate operation
+// Validate operation (per-type rules live in rsa_op_validation.cpp)
 bool rsa_validate_operation(const rsa_operation_t *op) {
     if (!op) return false;
-    
-    switch (op->type) {
-        case RSA_OP_PAYMENT:
-            if (op->operation.payment.amount <= 0) {
-                return false;
-            }
-            break;
-        case RSA_OP_CREATE_ACCOUNT:
-            if (op->operation.create_account.starting_balance < RSA_BASE_RESERVE) {
-                return false;
-            }
-            break;
-        case RSA_OP_MANAGE_OFFER:
-            if (op->operation.manage_offer.amount <= 0) {
-                return false;
-            }
-            break;
-        default:
-            break;
-    }
-    
-    return true;
+    return rsa_op_validate(op);
 }
 
 // Validate account
@@ -702,9 +640,9 @@ bool rsa_validate_account(const rsa_account_t *account) {
     return true;
 }
 
-// Get current time in seconds since epoch
+// Get current time in seconds since epoch (cached, see rsa_clock.h)
 uint64_t rsa_get_current_time(void) {
-    return (uint64_t)time(NULL);
+    return rsa_clock_wall_seconds();
 }
 
 // Calculate transaction fee
@@ -6,6 +6,10 @@
 #include <string.h>
 #include <pthread.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // CRITICAL SECURITY CONFIGURATION
 // ===============================
 #define RSA_MAX_CONCURRENT_OPS 100        // Limit to <100 concurrent operations/sec
@@ -25,6 +29,12 @@ typedef struct {
 #define RSA_MEMORY_MAGIC_START 0xDEADBEEF
 #define RSA_MEMORY_MAGIC_END   0xCAFEBABE
 
+// Alert throttling: repeated alerts of one type are aggregated per window
+#define RSA_ALERT_THROTTLE_SECONDS 60
+#define RSA_MONITOR_REJECTION_SLOTS 32    // >= RSA_VALIDATION_RESULT_COUNT
+#define RSA_MONITOR_LEDGER_PHASES 4       // >= RSA_LEDGER_PHASE_COUNT
+#define RSA_MONITOR_SLAB_TYPES 4          // >= RSA_WAL_ENTRY_TYPE_COUNT
+
 // Operational monitoring
 typedef struct {
     uint64_t concurrent_operations;
@@ -32,6 +42,15 @@ typedef struct {
     uint64_t memory_usage;
     uint64_t last_reset_time;
     uint64_t corruption_detections;
+    uint64_t alerts_suppressed;
+    uint64_t validation_rejections[RSA_MONITOR_REJECTION_SLOTS];  // by rsa_validation_result_t
+    uint64_t ledgers_closed;
+    uint64_t ledger_phase_ns[RSA_MONITOR_LEDGER_PHASES];        // cumulative, by rsa_ledger_phase_t
+    uint64_t ledger_phase_last_ns[RSA_MONITOR_LEDGER_PHASES];   // last close
+    uint64_t ledger_apply_mismatches;   // parallel apply diverged from the serial check
+    uint64_t slab_live[RSA_MONITOR_SLAB_TYPES];     // pooled entries, by rsa_wal_entry_type_t
+    uint64_t slab_slots[RSA_MONITOR_SLAB_TYPES];    // slots in mapped slabs
+    uint64_t slab_moved[RSA_MONITOR_SLAB_TYPES];    // moved by compaction, cumulative
 } rsa_ops_monitor_t;
 
 // Global monitoring instance
@@ -300,9 +319,14 @@ typedef struct {
 // Ledger Header
 typedef struct {
     uint32_t ledger_version;
+    uint32_t ledger_seq;
     uint32_t previous_ledger_hash[8];
+    uint32_t state_hash[8];         // Merkle root of all ledger entries (rsa_merkle.h)
+    uint32_t tx_set_hash[8];        // applied transactions, in order (rsa_ledger.h)
+    uint32_t tx_set_result_hash[8];
     uint64_t scp_value[8];
     uint64_t close_time;
+    int64_t fee_pool;               // fees collected so far
     uint32_t close_time_res;
     uint32_t base_fee;
     uint32_t base_reserve;
@@ -343,6 +367,10 @@ bool rsa_safe_memcpy(void *dest, const void *src, size_t n, size_t dest_size);
 // Monitoring and alerting
 void rsa_log_security_event(const char *event, const char *details);
 void rsa_trigger_alert(const char *alert_type, const char *message);
+// At most one alert per type per RSA_ALERT_THROTTLE_SECONDS; returns false when
+// suppressed. alert_type must have static storage (it keys the throttle table).
+bool rsa_trigger_alert_throttled(const char *alert_type, const char *message);
+void rsa_flush_throttled_alerts(void);
 
 // Cryptographic Functions
 bool rsa_generate_keypair(uint8_t *public_key, uint8_t *private_key);
@@ -358,8 +386,7 @@ bool rsa_is_valid_address(const char *address);
 // Amount Functions
 int64_t rsa_parse_amount(const char *amount_str);
 void rsa_format_amount(int64_t amount, char *amount_str);
-int64_t rsa_multiply_amount(int64_t amount, double multiplier);
-int64_t rsa_divide_amount(int64_t amount, double divisor);
+// Scaling amounts by a ratio: see rsa_price.h (exact, no floating point)
 
 // Asset Functions
 bool rsa_is_native_asset(const rsa_asset_t *asset);
@@ -386,4 +413,8 @@ bool rsa_start_monitoring(void);
 void rsa_stop_monitoring(void);
 void rsa_get_monitor_stats(rsa_ops_monitor_t *stats);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // RSA_TOKEN_H 
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "rsa_trustline_store.h"
+#include <stdlib.h>
+#include <string.h>
+
+// TRUSTLINE STORE
+// ===============
+
+#define SLOT_EMPTY UINT64_MAX
+#define TRUSTLINE_BATCH_WINDOW 16
+
+static inline uint64_t trustline_key(uint32_t account_row, uint32_t asset_id) {
+    return ((uint64_t)account_row << 32) | asset_id;
+}
+
+static inline size_t trustline_home(const rsa_trustline_store_t *store, uint64_t key) {
+    return (size_t)rsa_hash_64(&store->key, key) & (store->slot_capacity - 1);
+}
+
+static bool trustline_grow(void **column, size_t element_size, size_t capacity) {
+    void *grown = realloc(*column, element_size * capacity);
+    if (!grown) return false;
+    *column = grown;
+    return true;
+}
+
+static bool trustline_reserve_entries(rsa_trustline_store_t *store, size_t capacity) {
+    if (capacity <= store->capacity) return true;
+    if (!trustline_grow((void **)&store->account_rows, sizeof(*store->account_rows), capacity) ||
+        !trustline_grow((void **)&store->asset_ids, sizeof(*store->asset_ids), capacity) ||
+        !trustline_grow((void **)&store->balances, sizeof(*store->balances), capacity) ||
+        !trustline_grow((void **)&store->limits, sizeof(*store->limits), capacity) ||
+        !trustline_grow((void **)&store->flags, sizeof(*store->flags), capacity) ||
+        !trustline_grow((void **)&store->next, sizeof(*store->next), capacity) ||
+        !trustline_grow((void **)&store->prev, sizeof(*store->prev), capacity)) {
+        return false;
+    }
+    store->capacity = capacity;
+    return true;
+}
+
+static bool trustline_reserve_accounts(rsa_trustline_store_t *store, uint32_t account_row) {
+    if (account_row < store->account_capacity) return true;
+
+    size_t capacity = store->account_capacity ? store->account_capacity : 1024;
+    while (capacity <= account_row) capacity *= 2;
+    if (!trustline_grow((void **)&store->account_heads, sizeof(*store->account_heads), capacity)) {
+        return false;
+    }
+    for (size_t i = store->account_capacity; i < capacity; i++) {
+        store->account_heads[i] = RSA_TRUSTLINE_NONE;
+    }
+    store->account_capacity = capacity;
+    return true;
+}
+
+static size_t index_find(const rsa_trustline_store_t *store, uint64_t key) {
+    size_t mask = store->slot_capacity - 1;
+    for (size_t pos = trustline_home(store, key);; pos = (pos + 1) & mask) {
+        uint64_t slot_key = store->slots[pos].key;
+        if (slot_key == key) return pos;
+        if (slot_key == SLOT_EMPTY) return SIZE_MAX;
+    }
+}
+
+static void index_insert(rsa_trustline_store_t *store, uint64_t key, uint32_t entry) {
+    size_t mask = store->slot_capacity - 1;
+    size_t pos = trustline_home(store, key);
+    while (store->slots[pos].key != SLOT_EMPTY) {
+        pos = (pos + 1) & mask;
+    }
+    store->slots[pos].key = key;
+    store->slots[pos].entry = entry;
+}
+
+// Backward-shift deletion keeps probe runs tombstone free
+static void index_erase(rsa_trustline_store_t *store, size_t pos) {
+    size_t mask = store->slot_capacity - 1;
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask; store->slots[next].key != SLOT_EMPTY;
+         next = (next + 1) & mask) {
+        size_t home = trustline_home(store, store->slots[next].key);
+        // The entry may fill the hole unless its home lies in (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            store->slots[hole] = store->slots[next];
+            hole = next;
+        }
+    }
+    store->slots[hole].key = SLOT_EMPTY;
+}
+
+static bool index_alloc(rsa_trustline_store_t *store, size_t slot_capacity) {
+    rsa_trustline_slot_t *slots = malloc(slot_capacity * sizeof(*slots));
+    if (!slots) return false;
+    for (size_t i = 0; i < slot_capacity; i++) {
+        slots[i].key = SLOT_EMPTY;
+        slots[i].entry = RSA_TRUSTLINE_NONE;
+        slots[i].reserved = 0;
+    }
+    free(store->slots);
+    store->slots = slots;
+    store->slot_capacity = slot_capacity;
+    return true;
+}
+
+// Index load is kept at or below 3/4
+static bool index_reserve(rsa_trustline_store_t *store, size_t entries) {
+    if (entries <= store->slot_capacity - store->slot_capacity / 4) return true;
+
+    size_t slot_capacity = store->slot_capacity;
+    while (entries > slot_capacity - slot_capacity / 4) slot_capacity *= 2;
+    if (!index_alloc(store, slot_capacity)) return false;
+    for (size_t e = 0; e < store->count; e++) {
+        index_insert(store, trustline_key(store->account_rows[e], store->asset_ids[e]), (uint32_t)e);
+    }
+    return true;
+}
+
+bool rsa_trustline_store_init(rsa_trustline_store_t *store, size_t capacity) {
+    if (!store) return false;
+    memset(store, 0, sizeof(*store));
+    rsa_hash_key_init(&store->key, store);
+    if (capacity < 64) capacity = 64;
+
+    size_t slot_capacity = 64;
+    while (capacity > slot_capacity - slot_capacity / 4) slot_capacity *= 2;
+    if (!trustline_reserve_entries(store, capacity) || !index_alloc(store, slot_capacity)) {
+        rsa_trustline_store_free(store);
+        return false;
+    }
+    return true;
+}
+
+void rsa_trustline_store_free(rsa_trustline_store_t *store) {
+    if (!store) return;
+    free(store->account_rows);
+    free(store->asset_ids);
+    free(store->balances);
+    free(store->limits);
+    free(store->flags);
+    free(store->next);
+    free(store->prev);
+    free(store->account_heads);
+    free(store->slots);
+    memset(store, 0, sizeof(*store));
+}
+
+uint32_t rsa_trustline_store_find(const rsa_trustline_store_t *store,
+                                  uint32_t account_row, uint32_t asset_id) {
+    if (!store || !store->slots) return RSA_TRUSTLINE_NONE;
+    size_t pos = index_find(store, trustline_key(account_row, asset_id));
+    return pos == SIZE_MAX ? RSA_TRUSTLINE_NONE : store->slots[pos].entry;
+}
+
+size_t rsa_trustline_store_find_batch(const rsa_trustline_store_t *store,
+                                      const uint32_t *account_rows, const uint32_t *asset_ids,
+                                      size_t count, uint32_t *entries) {
+    if (!store || !store->slots || !account_rows || !asset_ids || !entries) return 0;
+
+    size_t found = 0;
+    for (size_t base = 0; base < count; base += TRUSTLINE_BATCH_WINDOW) {
+        size_t n = count - base < TRUSTLINE_BATCH_WINDOW ? count - base : TRUSTLINE_BATCH_WINDOW;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t key = trustline_key(account_rows[base + i], asset_ids[base + i]);
+            __builtin_prefetch(&store->slots[trustline_home(store, key)]);
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint32_t entry = rsa_trustline_store_find(store, account_rows[base + i],
+                                                      asset_ids[base + i]);
+            entries[base + i] = entry;
+            found += (entry != RSA_TRUSTLINE_NONE);
+        }
+    }
+    return found;
+}
+
+uint32_t rsa_trustline_store_add(rsa_trustline_store_t *store, uint32_t account_row,
+                                 uint32_t asset_id, int64_t limit, uint32_t flags,
+                                 bool *created) {
+    if (created) *created = false;
+    if (!store || !store->slots || account_row == RSA_TRUSTLINE_NONE) return RSA_TRUSTLINE_NONE;
+
+    uint64_t key = trustline_key(account_row, asset_id);
+    size_t pos = index_find(store, key);
+    if (pos != SIZE_MAX) return store->slots[pos].entry;
+
+    if (store->count >= RSA_TRUSTLINE_NONE ||
+        (store->count == store->capacity &&
+         !trustline_reserve_entries(store, store->capacity * 2)) ||
+        !trustline_reserve_accounts(store, account_row) ||
+        !index_reserve(store, store->count + 1)) {
+        return RSA_TRUSTLINE_NONE;
+    }
+
+    uint32_t entry = (uint32_t)store->count++;
+    store->account_rows[entry] = account_row;
+    store->asset_ids[entry] = asset_id;
+    store->balances[entry] = 0;
+    store->limits[entry] = limit;
+    store->flags[entry] = flags;
+
+    uint32_t head = store->account_heads[account_row];
+    store->next[entry] = head;
+    store->prev[entry] = RSA_TRUSTLINE_NONE;
+    if (head != RSA_TRUSTLINE_NONE) store->prev[head] = entry;
+    store->account_heads[account_row] = entry;
+
+    index_insert(store, key, entry);
+    if (created) *created = true;
+    return entry;
+}
+
+static void trustline_unlink(rsa_trustline_store_t *store, uint32_t entry) {
+    uint32_t prev = store->prev[entry];
+    uint32_t next = store->next[entry];
+    if (prev != RSA_TRUSTLINE_NONE) {
+        store->next[prev] = next;
+    } else {
+        store->account_heads[store->account_rows[entry]] = next;
+    }
+    if (next != RSA_TRUSTLINE_NONE) store->prev[next] = prev;
+}
+
+bool rsa_trustline_store_remove(rsa_trustline_store_t *store,
+                                uint32_t account_row, uint32_t asset_id) {
+    if (!store || !store->slots) return false;
+
+    size_t pos = index_find(store, trustline_key(account_row, asset_id));
+    if (pos == SIZE_MAX) return false;
+    uint32_t entry = store->slots[pos].entry;
+
+    trustline_unlink(store, entry);
+    index_erase(store, pos);
+
+    // Move the last entry into the hole and re-point everything that
+    // referenced it
+    uint32_t last = (uint32_t)store->count - 1;
+    if (entry != last) {
+        store->account_rows[entry] = store->account_rows[last];
+        store->asset_ids[entry] = store->asset_ids[last];
+        store->balances[entry] = store->balances[last];
+        store->limits[entry] = store->limits[last];
+        store->flags[entry] = store->flags[last];
+        store->next[entry] = store->next[last];
+        store->prev[entry] = store->prev[last];
+
+        if (store->prev[entry] != RSA_TRUSTLINE_NONE) {
+            store->next[store->prev[entry]] = entry;
+        } else {
+            store->account_heads[store->account_rows[entry]] = entry;
+        }
+        if (store->next[entry] != RSA_TRUSTLINE_NONE) {
+            store->prev[store->next[entry]] = entry;
+        }
+
+        size_t moved = index_find(store, trustline_key(store->account_rows[entry],
+                                                       store->asset_ids[entry]));
+        store->slots[moved].entry = entry;
+    }
+    store->count--;
+    return true;
+}
+
+uint32_t rsa_trustline_store_first(const rsa_trustline_store_t *store, uint32_t account_row) {
+    if (!store || account_row >= store->account_capacity) return RSA_TRUSTLINE_NONE;
+    return store->account_heads[account_row];
+}
+
+uint32_t rsa_trustline_store_next(const rsa_trustline_store_t *store, uint32_t entry) {
+    if (!store || entry >= store->count) return RSA_TRUSTLINE_NONE;
+    return store->next[entry];
+}
+
+size_t rsa_trustline_store_count_for(const rsa_trustline_store_t *store, uint32_t account_row) {
+    size_t count = 0;
+    for (uint32_t e = rsa_trustline_store_first(store, account_row); e != RSA_TRUSTLINE_NONE;
+         e = store->next[e]) {
+        count++;
+    }
+    return count;
+}
+
+bool rsa_trustline_store_move_account(rsa_trustline_store_t *store,
+                                      uint32_t from_row, uint32_t to_row) {
+    if (!store || from_row == to_row || to_row == RSA_TRUSTLINE_NONE) return false;
+    if (rsa_trustline_store_first(store, to_row) != RSA_TRUSTLINE_NONE) return false;
+    if (!trustline_reserve_accounts(store, to_row)) return false;
+
+    uint32_t head = rsa_trustline_store_first(store, from_row);
+    for (uint32_t e = head; e != RSA_TRUSTLINE_NONE; e = store->next[e]) {
+        index_erase(store, index_find(store, trustline_key(from_row, store->asset_ids[e])));
+        store->account_rows[e] = to_row;
+        index_insert(store, trustline_key(to_row, store->asset_ids[e]), e);
+    }
+    store->account_heads[to_row] = head;
+    if (from_row < store->account_capacity) {
+        store->account_heads[from_row] = RSA_TRUSTLINE_NONE;
+    }
+    return true;
+}
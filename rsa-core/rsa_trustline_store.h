@@ -0,0 +1,90 @@
+#ifndef RSA_TRUSTLINE_STORE_H
+#define RSA_TRUSTLINE_STORE_H
+
+#include "rsa_token.h"
+#include "rsa_hash.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// TRUSTLINE STORE
+// ===============
+// Trustlines keyed by (account row, asset id): the account's dense row in
+// rsa_account_soa_t and the asset's interned 32-bit id. Balances, limits
+// and flags live in dense parallel arrays indexed by entry; a hash index
+// maps the packed 64-bit key to an entry, and a doubly linked per-account
+// list answers "all trustlines of X" without a scan.
+//
+// Entries are kept dense: removal moves the last entry into the hole, so
+// entry indices are only stable until the next removal.
+
+#define RSA_TRUSTLINE_NONE UINT32_MAX
+
+typedef struct {
+    uint64_t key;                   // account_row << 32 | asset_id; empty = UINT64_MAX
+    uint32_t entry;
+    uint32_t reserved;
+} rsa_trustline_slot_t;
+
+typedef struct {
+    size_t count;
+    size_t capacity;
+
+    // Columns, indexed by entry
+    uint32_t *account_rows;
+    uint32_t *asset_ids;
+    int64_t *balances;
+    int64_t *limits;
+    uint32_t *flags;
+    uint32_t *next;                 // per-account list links
+    uint32_t *prev;
+
+    // List heads, indexed by account row
+    uint32_t *account_heads;
+    size_t account_capacity;
+
+    // Hash index (linear probing, backward-shift deletion)
+    rsa_trustline_slot_t *slots;
+    size_t slot_capacity;           // power of two
+    rsa_hash_key_t key;
+} rsa_trustline_store_t;
+
+bool rsa_trustline_store_init(rsa_trustline_store_t *store, size_t capacity);
+void rsa_trustline_store_free(rsa_trustline_store_t *store);
+
+// Entry for (account_row, asset_id), or RSA_TRUSTLINE_NONE
+uint32_t rsa_trustline_store_find(const rsa_trustline_store_t *store,
+                                  uint32_t account_row, uint32_t asset_id);
+
+// Looks up count keys with prefetching across the batch (e.g. the source
+// and destination lines of a payment set). Returns the number found.
+size_t rsa_trustline_store_find_batch(const rsa_trustline_store_t *store,
+                                      const uint32_t *account_rows, const uint32_t *asset_ids,
+                                      size_t count, uint32_t *entries);
+
+// Creates a zero-balance trustline; returns the existing entry (with
+// *created = false) when there already is one
+uint32_t rsa_trustline_store_add(rsa_trustline_store_t *store, uint32_t account_row,
+                                 uint32_t asset_id, int64_t limit, uint32_t flags,
+                                 bool *created);
+
+bool rsa_trustline_store_remove(rsa_trustline_store_t *store,
+                                uint32_t account_row, uint32_t asset_id);
+
+// Per-account iteration: first entry of an account, then the next one
+uint32_t rsa_trustline_store_first(const rsa_trustline_store_t *store, uint32_t account_row);
+uint32_t rsa_trustline_store_next(const rsa_trustline_store_t *store, uint32_t entry);
+size_t rsa_trustline_store_count_for(const rsa_trustline_store_t *store, uint32_t account_row);
+
+// Re-keys every trustline of from_row to to_row, following an account row
+// move in rsa_account_soa_remove(). to_row must have no trustlines.
+bool rsa_trustline_store_move_account(rsa_trustline_store_t *store,
+                                      uint32_t from_row, uint32_t to_row);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_TRUSTLINE_STORE_H
@@ -0,0 +1,193 @@
+#include "rsa_txset.h"
+#include <unistd.h>
+
+// TX-SET VALIDATION STAGE
+// =======================
+
+typedef struct {
+    const rsa_tx_envelope_ref_t *envelopes;
+    rsa_validation_result_t *results;
+    size_t begin;
+    size_t end;
+    size_t valid;
+    uint32_t counts[RSA_VALIDATION_RESULT_COUNT];
+    uint64_t now;
+    bool verify_signatures;
+} txset_chunk_t;
+
+rsa_validation_result_t rsa_validate_tx_envelope(const rsa_tx_envelope_ref_t *envelope,
+                                                 uint64_t now, bool verify_signature) {
+    if (!envelope || !envelope->tx) {
+        return RSA_VALIDATION_NULL_TRANSACTION;
+    }
+
+    const rsa_transaction_t *tx = envelope->tx;
+    rsa_validation_result_t result = rsa_check_transaction_header(tx, now);
+    if (result != RSA_VALIDATION_OK) {
+        return result;
+    }
+
+    if (tx->fee < rsa_calculate_fee(tx)) {
+        return RSA_VALIDATION_INSUFFICIENT_FEE;
+    }
+
+    if (!envelope->operations) {
+        return RSA_VALIDATION_INVALID_OPERATION;
+    }
+    for (uint32_t i = 0; i < tx->operations_count; i++) {
+        if (!rsa_validate_operation(&envelope->operations[i])) {
+            return RSA_VALIDATION_INVALID_OPERATION;
+        }
+    }
+
+    // Signatures last: the RSA verify dwarfs every other check
+    if (verify_signature) {
+        if (!envelope->public_key || !envelope->signature ||
+            !rsa_verify_signature(envelope->public_key, tx, envelope->signature)) {
+            return RSA_VALIDATION_BAD_SIGNATURE;
+        }
+    }
+
+    return RSA_VALIDATION_OK;
+}
+
+static void txset_validate_chunk(void *arg, unsigned worker) {
+    txset_chunk_t *chunk = (txset_chunk_t *)arg + worker;
+    size_t valid = 0;
+
+    for (size_t i = chunk->begin; i < chunk->end; i++) {
+        rsa_validation_result_t result =
+            rsa_validate_tx_envelope(&chunk->envelopes[i], chunk->now, chunk->verify_signatures);
+        chunk->results[i] = result;
+        chunk->counts[result]++;
+        valid += (result == RSA_VALIDATION_OK);
+    }
+
+    chunk->valid = valid;
+}
+
+static uint32_t txset_thread_count(size_t count, const rsa_txset_validate_options_t *options) {
+    uint32_t threads = options ? options->threads : 0;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (uint32_t)online : 1;
+    }
+    if (threads > RSA_TXSET_MAX_THREADS) {
+        threads = RSA_TXSET_MAX_THREADS;
+    }
+
+    // Without signatures a transaction costs well under a microsecond, so
+    // small sets are not worth a thread start
+    size_t min_chunk = (options && options->verify_signatures) ? RSA_TXSET_MIN_SIGNED_CHUNK
+                                                               : RSA_TXSET_MIN_CHUNK;
+    size_t useful = (count + min_chunk - 1) / min_chunk;
+    if (useful < threads) {
+        threads = useful > 0 ? (uint32_t)useful : 1;
+    }
+    return threads;
+}
+
+size_t rsa_validate_tx_set(const rsa_tx_envelope_ref_t *envelopes, size_t count,
+                           const rsa_txset_validate_options_t *options,
+                           rsa_validation_result_t *results) {
+    if (!results || count == 0) return 0;
+
+    rsa_validation_result_t rejection = RSA_VALIDATION_OK;
+    if (!envelopes) {
+        rejection = RSA_VALIDATION_NULL_TRANSACTION;
+    } else if (count > RSA_MAX_TX_SET_SIZE) {
+        rejection = RSA_VALIDATION_TX_SET_TOO_LARGE;
+    } else if (!rsa_check_operation_limits()) {
+        rejection = RSA_VALIDATION_RATE_LIMITED;
+    } else if (rsa_check_memory_corruption()) {
+        rejection = RSA_VALIDATION_MEMORY_CORRUPTION;
+    }
+    if (rejection != RSA_VALIDATION_OK) {
+        for (size_t i = 0; i < count; i++) results[i] = rejection;
+        rsa_record_validation_result(rejection);
+        return 0;
+    }
+    rsa_increment_operation_count();
+
+    txset_chunk_t chunks[RSA_TXSET_MAX_THREADS];
+
+    uint32_t threads = txset_thread_count(count, options);
+    rsa_worker_pool_t *pool = options ? options->pool : NULL;
+    if (pool && threads > rsa_worker_pool_size(pool)) threads = rsa_worker_pool_size(pool);
+    uint64_t now = (options && options->now) ? options->now : rsa_get_current_time();
+    bool verify = options && options->verify_signatures;
+    size_t per_thread = (count + threads - 1) / threads;
+
+    for (uint32_t t = 0; t < threads; t++) {
+        size_t begin = (size_t)t * per_thread;
+        chunks[t] = (txset_chunk_t){
+            .envelopes = envelopes,
+            .results = results,
+            .begin = begin < count ? begin : count,
+            .end = begin + per_thread < count ? begin + per_thread : count,
+            .valid = 0,
+            .counts = {0},
+            .now = now,
+            .verify_signatures = verify
+        };
+    }
+
+    // Chunk 0 runs on the calling thread; a worker that fails to start
+    // falls back to the caller as well
+    if (pool) {
+        rsa_worker_pool_run(pool, threads, txset_validate_chunk, chunks);
+    } else {
+        rsa_worker_pool_t call_pool;
+        if (!rsa_worker_pool_init(&call_pool, threads)) {
+            rsa_worker_pool_run(NULL, threads, txset_validate_chunk, chunks);
+        } else {
+            rsa_worker_pool_run(&call_pool, threads, txset_validate_chunk, chunks);
+            rsa_worker_pool_free(&call_pool);
+        }
+    }
+
+    size_t valid = 0;
+    uint32_t counts[RSA_VALIDATION_RESULT_COUNT] = {0};
+    for (uint32_t t = 0; t < threads; t++) {
+        valid += chunks[t].valid;
+        for (int r = 0; r < RSA_VALIDATION_RESULT_COUNT; r++) {
+            counts[r] += chunks[t].counts[r];
+        }
+    }
+
+    rsa_record_validation_counts(counts);
+    return valid;
+}
+
+uint32_t rsa_collect_tx_envelope_failures(const rsa_tx_envelope_ref_t *envelope,
+                                          uint64_t now, bool verify_signature) {
+    if (!envelope || !envelope->tx) {
+        return RSA_VALIDATION_BIT(RSA_VALIDATION_NULL_TRANSACTION);
+    }
+
+    const rsa_transaction_t *tx = envelope->tx;
+    uint32_t failures = rsa_collect_transaction_failures(tx, now);
+    if (tx->fee < rsa_calculate_fee(tx)) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_INSUFFICIENT_FEE);
+    }
+
+    uint32_t op_count = tx->operations_count;
+    if (op_count > RSA_MAX_OPERATIONS_PER_TX) op_count = RSA_MAX_OPERATIONS_PER_TX;
+    if (!envelope->operations && op_count > 0) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_INVALID_OPERATION);
+    } else {
+        for (uint32_t i = 0; i < op_count; i++) {
+            if (!rsa_validate_operation(&envelope->operations[i])) {
+                failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_INVALID_OPERATION);
+                break;
+            }
+        }
+    }
+
+    if (verify_signature &&
+        (!envelope->public_key || !envelope->signature ||
+         !rsa_verify_signature(envelope->public_key, tx, envelope->signature))) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_BAD_SIGNATURE);
+    }
+    return failures;
+}
@@ -0,0 +1,61 @@
+#ifndef RSA_TXSET_H
+#define RSA_TXSET_H
+
+#include "rsa_token.h"
+#include "rsa_validation.h"
+#include "rsa_worker_pool.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// TX-SET VALIDATION STAGE
+// =======================
+// Stateless validation of a whole candidate transaction set: header checks,
+// every trailing operation, the rsa_calculate_fee() minimum and time bounds,
+// optionally fused with signature verification so each transaction is
+// visited once while it is hot in cache. Work is split into contiguous
+// chunks across worker threads; the set is charged to the global limiter
+// once rather than per transaction, and rejections are counted in the
+// monitor per result code.
+
+#define RSA_TXSET_MAX_THREADS 16
+#define RSA_TXSET_MIN_CHUNK 64          // transactions per thread without signatures
+#define RSA_TXSET_MIN_SIGNED_CHUNK 4    // transactions per thread with signatures
+
+// One transaction and its trailing operations
+typedef struct {
+    const rsa_transaction_t *tx;
+    const rsa_operation_t *operations;  // tx->operations_count entries
+    const uint8_t *public_key;          // signer key, for verify_signatures
+    const uint8_t *signature;           // may be NULL when not verifying
+} rsa_tx_envelope_ref_t;
+
+typedef struct {
+    uint64_t now;                       // time-bound reference; 0 = current time
+    uint32_t threads;                   // 0 = online CPUs (capped)
+    bool verify_signatures;
+    rsa_worker_pool_t *pool;            // threads kept across calls; NULL starts them per call
+} rsa_txset_validate_options_t;
+
+// Fills results[0..count) and returns the number of valid transactions.
+// `options` may be NULL for defaults. Sets larger than RSA_MAX_TX_SET_SIZE
+// are rejected as a whole with RSA_VALIDATION_TX_SET_TOO_LARGE.
+size_t rsa_validate_tx_set(const rsa_tx_envelope_ref_t *envelopes, size_t count,
+                           const rsa_txset_validate_options_t *options,
+                           rsa_validation_result_t *results);
+
+// Single-envelope form of the per-transaction stage (no limiter, no alerts)
+rsa_validation_result_t rsa_validate_tx_envelope(const rsa_tx_envelope_ref_t *envelope,
+                                                 uint64_t now, bool verify_signature);
+
+// Diagnostics: every failing check of one envelope as RSA_VALIDATION_BIT()s
+uint32_t rsa_collect_tx_envelope_failures(const rsa_tx_envelope_ref_t *envelope,
+                                          uint64_t now, bool verify_signature);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_TXSET_H
@@ -0,0 +1,167 @@
+#include "rsa_validation.h"
+#include "rsa_clock.h"
+
+// STATELESS VALIDATION RESULTS
+// ============================
+
+_Static_assert(RSA_VALIDATION_RESULT_COUNT <= RSA_MONITOR_REJECTION_SLOTS,
+               "rsa_ops_monitor_t.validation_rejections is too small");
+_Static_assert(RSA_VALIDATION_RESULT_COUNT <= 32, "failure mask is 32 bits");
+
+static const char *const validation_result_names[RSA_VALIDATION_RESULT_COUNT] = {
+    [RSA_VALIDATION_OK]                  = "OK",
+    [RSA_VALIDATION_NULL_TRANSACTION]    = "NULL_TRANSACTION",
+    [RSA_VALIDATION_RATE_LIMITED]        = "RATE_LIMIT_EXCEEDED",
+    [RSA_VALIDATION_MEMORY_CORRUPTION]   = "MEMORY_CORRUPTION",
+    [RSA_VALIDATION_INSUFFICIENT_FEE]    = "INSUFFICIENT_FEE",
+    [RSA_VALIDATION_EXCESSIVE_FEE]       = "EXCESSIVE_FEE",
+    [RSA_VALIDATION_INVALID_SEQUENCE]    = "INVALID_SEQUENCE",
+    [RSA_VALIDATION_TOO_EARLY]           = "TRANSACTION_TOO_EARLY",
+    [RSA_VALIDATION_EXPIRED]             = "TRANSACTION_EXPIRED",
+    [RSA_VALIDATION_NO_OPERATIONS]       = "NO_OPERATIONS",
+    [RSA_VALIDATION_TOO_MANY_OPERATIONS] = "TOO_MANY_OPERATIONS",
+    [RSA_VALIDATION_INVALID_TIME_BOUNDS] = "INVALID_TIME_BOUNDS",
+    [RSA_VALIDATION_INVALID_OPERATION]   = "INVALID_OPERATION",
+    [RSA_VALIDATION_BAD_SIGNATURE]       = "BAD_SIGNATURE",
+    [RSA_VALIDATION_TX_SET_TOO_LARGE]    = "TX_SET_TOO_LARGE"
+};
+
+static const char *const validation_result_messages[RSA_VALIDATION_RESULT_COUNT] = {
+    [RSA_VALIDATION_OK]                  = "Transaction is valid",
+    [RSA_VALIDATION_NULL_TRANSACTION]    = "Null transaction passed for validation",
+    [RSA_VALIDATION_RATE_LIMITED]        = "Concurrent operations limit exceeded",
+    [RSA_VALIDATION_MEMORY_CORRUPTION]   = "Memory usage exceeded threshold",
+    [RSA_VALIDATION_INSUFFICIENT_FEE]    = "Transaction fee below minimum",
+    [RSA_VALIDATION_EXCESSIVE_FEE]       = "Transaction fee suspiciously high",
+    [RSA_VALIDATION_INVALID_SEQUENCE]    = "Transaction sequence number is zero",
+    [RSA_VALIDATION_TOO_EARLY]           = "Transaction not yet valid",
+    [RSA_VALIDATION_EXPIRED]             = "Transaction has expired",
+    [RSA_VALIDATION_NO_OPERATIONS]       = "Transaction has no operations",
+    [RSA_VALIDATION_TOO_MANY_OPERATIONS] = "Transaction exceeds maximum operations limit",
+    [RSA_VALIDATION_INVALID_TIME_BOUNDS] = "Invalid time bounds configuration",
+    [RSA_VALIDATION_INVALID_OPERATION]   = "Transaction contains an invalid operation",
+    [RSA_VALIDATION_BAD_SIGNATURE]       = "Transaction signature verification failed",
+    [RSA_VALIDATION_TX_SET_TOO_LARGE]    = "Transaction set exceeds maximum size"
+};
+
+const char *rsa_validation_result_str(rsa_validation_result_t result) {
+    if ((unsigned)result >= RSA_VALIDATION_RESULT_COUNT) return "UNKNOWN";
+    return validation_result_names[result];
+}
+
+const char *rsa_validation_result_message(rsa_validation_result_t result) {
+    if ((unsigned)result >= RSA_VALIDATION_RESULT_COUNT) return "Unknown validation result";
+    return validation_result_messages[result];
+}
+
+rsa_validation_result_t rsa_check_transaction_header(const rsa_transaction_t *tx, uint64_t now) {
+    if (!tx) {
+        return RSA_VALIDATION_NULL_TRANSACTION;
+    }
+
+    // Fee bounds (upper bound guards against fee-based DoS)
+    if (tx->fee < RSA_BASE_FEE) {
+        return RSA_VALIDATION_INSUFFICIENT_FEE;
+    }
+    if (tx->fee > RSA_BASE_FEE * 1000) {
+        return RSA_VALIDATION_EXCESSIVE_FEE;
+    }
+
+    if (tx->seq_num == 0) {
+        return RSA_VALIDATION_INVALID_SEQUENCE;
+    }
+
+    switch (rsa_clock_check_bounds(&tx->time_bounds, now)) {
+        case RSA_CLOCK_TOO_EARLY:
+            return RSA_VALIDATION_TOO_EARLY;
+        case RSA_CLOCK_EXPIRED:
+            return RSA_VALIDATION_EXPIRED;
+        default:
+            break;
+    }
+
+    // CRITICAL: Enforce reduced operations count (was 100, now 10)
+    if (tx->operations_count == 0) {
+        return RSA_VALIDATION_NO_OPERATIONS;
+    }
+    if (tx->operations_count > RSA_MAX_OPERATIONS_PER_TX) {
+        return RSA_VALIDATION_TOO_MANY_OPERATIONS;
+    }
+
+    if (tx->time_bounds.min_time > 0 && tx->time_bounds.max_time > 0 &&
+        tx->time_bounds.min_time >= tx->time_bounds.max_time) {
+        return RSA_VALIDATION_INVALID_TIME_BOUNDS;
+    }
+
+    return RSA_VALIDATION_OK;
+}
+
+uint32_t rsa_collect_transaction_failures(const rsa_transaction_t *tx, uint64_t now) {
+    if (!tx) {
+        return RSA_VALIDATION_BIT(RSA_VALIDATION_NULL_TRANSACTION);
+    }
+
+    uint32_t failures = 0;
+    if (tx->fee < RSA_BASE_FEE) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_INSUFFICIENT_FEE);
+    }
+    if (tx->fee > RSA_BASE_FEE * 1000) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_EXCESSIVE_FEE);
+    }
+    if (tx->seq_num == 0) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_INVALID_SEQUENCE);
+    }
+    if (tx->time_bounds.min_time > 0 && now < tx->time_bounds.min_time) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_TOO_EARLY);
+    }
+    if (tx->time_bounds.max_time > 0 && now > tx->time_bounds.max_time) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_EXPIRED);
+    }
+    if (tx->operations_count == 0) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_NO_OPERATIONS);
+    }
+    if (tx->operations_count > RSA_MAX_OPERATIONS_PER_TX) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_TOO_MANY_OPERATIONS);
+    }
+    if (tx->time_bounds.min_time > 0 && tx->time_bounds.max_time > 0 &&
+        tx->time_bounds.min_time >= tx->time_bounds.max_time) {
+        failures |= RSA_VALIDATION_BIT(RSA_VALIDATION_INVALID_TIME_BOUNDS);
+    }
+    return failures;
+}
+
+bool rsa_validation_is_anomaly(rsa_validation_result_t result) {
+    switch (result) {
+        case RSA_VALIDATION_NULL_TRANSACTION:
+        case RSA_VALIDATION_TX_SET_TOO_LARGE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void rsa_record_validation_result(rsa_validation_result_t result) {
+    if (result == RSA_VALIDATION_OK || (unsigned)result >= RSA_VALIDATION_RESULT_COUNT) {
+        return;
+    }
+
+    __atomic_fetch_add(&g_rsa_monitor.validation_rejections[result], 1, __ATOMIC_RELAXED);
+
+    if (rsa_validation_is_anomaly(result)) {
+        rsa_trigger_alert_throttled(rsa_validation_result_str(result),
+                                    rsa_validation_result_message(result));
+    }
+}
+
+void rsa_record_validation_counts(const uint32_t *counts) {
+    if (!counts) return;
+
+    for (int i = 1; i < RSA_VALIDATION_RESULT_COUNT; i++) {
+        if (counts[i] == 0) continue;
+        __atomic_fetch_add(&g_rsa_monitor.validation_rejections[i], counts[i], __ATOMIC_RELAXED);
+        if (rsa_validation_is_anomaly((rsa_validation_result_t)i)) {
+            rsa_trigger_alert_throttled(rsa_validation_result_str((rsa_validation_result_t)i),
+                                        rsa_validation_result_message((rsa_validation_result_t)i));
+        }
+    }
+}
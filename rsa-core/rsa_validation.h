@@ -0,0 +1,68 @@
+#ifndef RSA_VALIDATION_H
+#define RSA_VALIDATION_H
+
+#include "rsa_token.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// STATELESS VALIDATION RESULTS
+// ============================
+// Side-effect free checks shared by rsa_validate_transaction() and the
+// tx-set validation stage. They never alert or touch the limiter; callers
+// decide what a rejection means.
+
+typedef enum {
+    RSA_VALIDATION_OK = 0,
+    RSA_VALIDATION_NULL_TRANSACTION,
+    RSA_VALIDATION_RATE_LIMITED,
+    RSA_VALIDATION_MEMORY_CORRUPTION,
+    RSA_VALIDATION_INSUFFICIENT_FEE,
+    RSA_VALIDATION_EXCESSIVE_FEE,
+    RSA_VALIDATION_INVALID_SEQUENCE,
+    RSA_VALIDATION_TOO_EARLY,
+    RSA_VALIDATION_EXPIRED,
+    RSA_VALIDATION_NO_OPERATIONS,
+    RSA_VALIDATION_TOO_MANY_OPERATIONS,
+    RSA_VALIDATION_INVALID_TIME_BOUNDS,
+    RSA_VALIDATION_INVALID_OPERATION,
+    RSA_VALIDATION_BAD_SIGNATURE,
+    RSA_VALIDATION_TX_SET_TOO_LARGE,
+    RSA_VALIDATION_RESULT_COUNT
+} rsa_validation_result_t;
+
+// Bit for a result code in a failure mask (see rsa_collect_transaction_failures)
+#define RSA_VALIDATION_BIT(result) (1u << (result))
+
+// Alert-style name of a result code, e.g. "TRANSACTION_EXPIRED"
+const char *rsa_validation_result_str(rsa_validation_result_t result);
+// Human-readable description used in alerts and logs
+const char *rsa_validation_result_message(rsa_validation_result_t result);
+
+// Header checks of rsa_validate_transaction(), evaluated against `now`
+rsa_validation_result_t rsa_check_transaction_header(const rsa_transaction_t *tx, uint64_t now);
+
+// Every failing header check as a mask of RSA_VALIDATION_BIT()s, for
+// diagnostics; 0 when the header is valid
+uint32_t rsa_collect_transaction_failures(const rsa_transaction_t *tx, uint64_t now);
+
+// Anomalies (null input, oversized sets) point at a broken or hostile caller
+// and alert; ordinary rejections are only counted. The limiter and the
+// corruption check raise their own throttled alerts at the source.
+bool rsa_validation_is_anomaly(rsa_validation_result_t result);
+
+// Count a rejection in the monitor and raise a throttled alert for anomalies
+void rsa_record_validation_result(rsa_validation_result_t result);
+// Add per-code counts (indexed by rsa_validation_result_t) in one step
+void rsa_record_validation_counts(const uint32_t *counts);
+
+// Full transaction check (limiter, corruption, header) returning the reason
+// instead of alerting on every failure. rsa_validate_transaction() wraps it.
+rsa_validation_result_t rsa_check_transaction(const rsa_transaction_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_VALIDATION_H
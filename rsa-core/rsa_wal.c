@@ -0,0 +1,906 @@
+#define _GNU_SOURCE                     // fallocate
+#include "rsa_wal.h"
+#include "rsa_asset_intern.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// LEDGER WRITE-AHEAD LOG
+// ======================
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t crc;                       // CRC32C of the header with this field zeroed
+    uint64_t first_lsn;
+    uint64_t segment_size;
+    uint8_t reserved[32];
+} wal_segment_header_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t kind;
+    uint16_t run_count;
+    uint32_t body_length;
+} wal_change_header_t;
+
+_Static_assert(sizeof(wal_segment_header_t) == RSA_WAL_SEGMENT_HEADER_SIZE,
+               "segment header size");
+_Static_assert(sizeof(rsa_wal_record_header_t) == 32, "record header is 32 bytes");
+_Static_assert(sizeof(wal_change_header_t) == 8, "change header is 8 bytes");
+
+#define WAL_RECORD_HEADER_SIZE sizeof(rsa_wal_record_header_t)
+#define WAL_RUN_MERGE_GAP 8             // equal bytes cheaper to log than a new run header
+
+static inline uint64_t align8(uint64_t value) {
+    return (value + 7) & ~(uint64_t)7;
+}
+
+// CRC32C
+// ------
+// SSE4.2 crc32 instruction when the CPU has it, slicing-by-8 otherwise
+
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+        crc_table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            crc_table[k][i] = (crc_table[k - 1][i] >> 8) ^ crc_table[0][crc_table[k - 1][i] & 0xFF];
+        }
+    }
+}
+
+static uint32_t crc_software(uint32_t crc, const uint8_t *data, size_t length) {
+    pthread_once(&crc_table_once, crc_table_init);
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        word ^= crc;
+        crc = crc_table[7][word & 0xFF] ^ crc_table[6][(word >> 8) & 0xFF] ^
+              crc_table[5][(word >> 16) & 0xFF] ^ crc_table[4][(word >> 24) & 0xFF] ^
+              crc_table[3][(word >> 32) & 0xFF] ^ crc_table[2][(word >> 40) & 0xFF] ^
+              crc_table[1][(word >> 48) & 0xFF] ^ crc_table[0][word >> 56];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) crc = crc_table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc_hardware(uint32_t crc, const uint8_t *data, size_t length) {
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+        data += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)crc64;
+    while (length--) crc = __builtin_ia32_crc32qi(crc, *data++);
+    return crc;
+}
+#endif
+
+uint32_t rsa_wal_crc32c(uint32_t crc, const void *data, size_t length) {
+    crc = ~crc;
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) return ~crc_hardware(crc, data, length);
+#endif
+    return ~crc_software(crc, data, length);
+}
+
+// CHANGE ENCODING
+// ---------------
+
+typedef union {
+    rsa_account_t account;
+    rsa_trustline_t trustline;
+    rsa_offer_t offer;
+    rsa_data_t data;
+} wal_record_t;
+
+const uint32_t rsa_wal_entry_size[RSA_WAL_ENTRY_TYPE_COUNT] = {
+    [RSA_WAL_ACCOUNT]   = sizeof(rsa_account_t),
+    [RSA_WAL_TRUSTLINE] = sizeof(rsa_trustline_t),
+    [RSA_WAL_OFFER]     = sizeof(rsa_offer_t),
+    [RSA_WAL_DATA]      = sizeof(rsa_data_t)
+};
+
+// Bytes up to and including the last field; the rest is struct padding
+const uint32_t rsa_wal_entry_used[RSA_WAL_ENTRY_TYPE_COUNT] = {
+    [RSA_WAL_ACCOUNT]   = offsetof(rsa_account_t, reserved) + 4 * sizeof(uint32_t),
+    [RSA_WAL_TRUSTLINE] = offsetof(rsa_trustline_t, reserved) + 2 * sizeof(uint32_t),
+    [RSA_WAL_OFFER]     = offsetof(rsa_offer_t, reserved) + 2 * sizeof(uint32_t),
+    [RSA_WAL_DATA]      = offsetof(rsa_data_t, reserved) + 2 * sizeof(uint32_t)
+};
+
+const uint32_t rsa_wal_key_size[RSA_WAL_ENTRY_TYPE_COUNT] = {
+    [RSA_WAL_ACCOUNT]   = offsetof(rsa_account_t, balance),
+    [RSA_WAL_TRUSTLINE] = offsetof(rsa_trustline_t, balance),
+    [RSA_WAL_OFFER]     = offsetof(rsa_offer_t, selling),
+    [RSA_WAL_DATA]      = offsetof(rsa_data_t, data_value_len)
+};
+
+bool rsa_wal_entry_normalize(rsa_wal_entry_type_t type, const void *record, void *image) {
+    if ((unsigned)type >= RSA_WAL_ENTRY_TYPE_COUNT || !record || !image) return false;
+    wal_record_t *out = image;
+    memcpy(out, record, rsa_wal_entry_size[type]);
+    memset((uint8_t *)out + rsa_wal_entry_used[type], 0,
+           rsa_wal_entry_size[type] - rsa_wal_entry_used[type]);
+
+    switch (type) {
+        case RSA_WAL_TRUSTLINE:
+            return rsa_asset_canonicalize(&((const rsa_trustline_t *)record)->asset,
+                                          &out->trustline.asset);
+        case RSA_WAL_OFFER:
+            return rsa_asset_canonicalize(&((const rsa_offer_t *)record)->selling,
+                                          &out->offer.selling) &&
+                   rsa_asset_canonicalize(&((const rsa_offer_t *)record)->buying,
+                                          &out->offer.buying);
+        case RSA_WAL_DATA: {
+            rsa_data_t *data = &out->data;
+            if (data->data_name_len > sizeof(data->data_name) ||
+                data->data_value_len > sizeof(data->data_value)) {
+                return false;
+            }
+            memset(data->data_name + data->data_name_len, 0,
+                   sizeof(data->data_name) - data->data_name_len);
+            memset(data->data_value + data->data_value_len, 0,
+                   sizeof(data->data_value) - data->data_value_len);
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+void rsa_wal_batch_init(rsa_wal_batch_t *batch) {
+    if (batch) memset(batch, 0, sizeof(*batch));
+}
+
+void rsa_wal_batch_free(rsa_wal_batch_t *batch) {
+    if (!batch) return;
+    free(batch->data);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void rsa_wal_batch_reset(rsa_wal_batch_t *batch) {
+    if (!batch) return;
+    batch->length = 0;
+    batch->count = 0;
+}
+
+static uint8_t *batch_reserve(rsa_wal_batch_t *batch, size_t extra) {
+    if (batch->length + extra > batch->capacity) {
+        size_t capacity = batch->capacity ? batch->capacity : 4096;
+        while (capacity < batch->length + extra) capacity *= 2;
+        uint8_t *data = realloc(batch->data, capacity);
+        if (!data) return NULL;
+        batch->data = data;
+        batch->capacity = capacity;
+    }
+    return batch->data + batch->length;
+}
+
+static void batch_put_header(uint8_t *out, rsa_wal_entry_type_t type, rsa_wal_change_kind_t kind,
+                             uint16_t run_count, uint32_t body_length) {
+    wal_change_header_t header = {
+        .type = (uint8_t)type, .kind = (uint8_t)kind,
+        .run_count = run_count, .body_length = body_length
+    };
+    memcpy(out, &header, sizeof(header));
+}
+
+bool rsa_wal_batch_create(rsa_wal_batch_t *batch, rsa_wal_entry_type_t type, const void *record) {
+    wal_record_t image;
+    if (!batch || !rsa_wal_entry_normalize(type, record, &image)) return false;
+
+    uint32_t size = rsa_wal_entry_size[type];
+    uint8_t *out = batch_reserve(batch, sizeof(wal_change_header_t) + size);
+    if (!out) return false;
+    batch_put_header(out, type, RSA_WAL_CREATE, 0, size - rsa_wal_key_size[type]);
+    memcpy(out + sizeof(wal_change_header_t), &image, size);
+    batch->length += sizeof(wal_change_header_t) + size;
+    batch->count++;
+    return true;
+}
+
+bool rsa_wal_batch_delete(rsa_wal_batch_t *batch, rsa_wal_entry_type_t type, const void *record) {
+    wal_record_t image;
+    if (!batch || !rsa_wal_entry_normalize(type, record, &image)) return false;
+
+    uint32_t key_size = rsa_wal_key_size[type];
+    uint8_t *out = batch_reserve(batch, sizeof(wal_change_header_t) + key_size);
+    if (!out) return false;
+    batch_put_header(out, type, RSA_WAL_DELETE, 0, 0);
+    memcpy(out + sizeof(wal_change_header_t), &image, key_size);
+    batch->length += sizeof(wal_change_header_t) + key_size;
+    batch->count++;
+    return true;
+}
+
+// First offset in [from, end) where a and b differ, or end
+static uint32_t diff_next(const uint8_t *a, const uint8_t *b, uint32_t from, uint32_t end) {
+    uint32_t i = from;
+#if defined(__SSE2__)
+    for (; i + 16 <= end; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(const void *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(const void *)(b + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xFFFFu;
+        if (mask) return i + (uint32_t)__builtin_ctz(mask);
+    }
+#endif
+    for (; i + 8 <= end; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, sizeof(x));
+        memcpy(&y, b + i, sizeof(y));
+        if (x != y) return i + (uint32_t)__builtin_ctzll(x ^ y) / 8;
+    }
+    for (; i < end; i++) {
+        if (a[i] != b[i]) return i;
+    }
+    return end;
+}
+
+bool rsa_wal_batch_update(rsa_wal_batch_t *batch, rsa_wal_entry_type_t type,
+                          const void *before, const void *after) {
+    if (!batch || !before || !after || (unsigned)type >= RSA_WAL_ENTRY_TYPE_COUNT) return false;
+
+    // Accounts need no normalization (padding is never compared), so the
+    // hot case diffs the caller's records without copying them
+    wal_record_t old_image, new_image;
+    const uint8_t *a = before;
+    const uint8_t *b = after;
+    if (type != RSA_WAL_ACCOUNT) {
+        if (!rsa_wal_entry_normalize(type, before, &old_image) ||
+            !rsa_wal_entry_normalize(type, after, &new_image)) {
+            return false;
+        }
+        a = (const uint8_t *)&old_image;
+        b = (const uint8_t *)&new_image;
+    }
+    uint32_t key_size = rsa_wal_key_size[type];
+    uint32_t used = rsa_wal_entry_used[type];
+    if (memcmp(a, b, key_size) != 0) return false;
+
+    // Worst case: runs separated by WAL_RUN_MERGE_GAP equal bytes
+    size_t worst = sizeof(wal_change_header_t) + key_size + used + 4 * (used / WAL_RUN_MERGE_GAP + 1);
+    uint8_t *out = batch_reserve(batch, worst);
+    if (!out) return false;
+
+    uint8_t *body = out + sizeof(wal_change_header_t) + key_size;
+    uint8_t *cursor = body;
+    uint16_t runs = 0;
+    uint32_t i = diff_next(a, b, key_size, used);
+    while (i < used) {
+        // Extend the run while the next difference is within the merge gap
+        uint32_t start = i, end = i + 1, next;
+        while ((next = diff_next(a, b, end, used)) < used && next - end < WAL_RUN_MERGE_GAP) {
+            end = next + 1;
+        }
+        uint16_t run[2] = {(uint16_t)start, (uint16_t)(end - start)};
+        memcpy(cursor, run, sizeof(run));
+        memcpy(cursor + sizeof(run), b + start, end - start);
+        cursor += sizeof(run) + (end - start);
+        runs++;
+        i = next;
+    }
+    if (runs == 0) return true;         // nothing changed
+
+    uint32_t body_length = (uint32_t)(cursor - body);
+    batch_put_header(out, type, RSA_WAL_UPDATE, runs, body_length);
+    memcpy(out + sizeof(wal_change_header_t), b, key_size);
+    batch->length += sizeof(wal_change_header_t) + key_size + body_length;
+    batch->count++;
+    return true;
+}
+
+bool rsa_wal_change_apply(const rsa_wal_change_t *change, void *record) {
+    if (!change || !record || (unsigned)change->type >= RSA_WAL_ENTRY_TYPE_COUNT) return false;
+    uint32_t size = rsa_wal_entry_size[change->type];
+    uint32_t key_size = rsa_wal_key_size[change->type];
+    uint8_t *out = record;
+
+    if (change->kind == RSA_WAL_CREATE) {
+        if (change->body_length != size - key_size) return false;
+        memcpy(out, change->key, key_size);
+        memcpy(out + key_size, change->body, change->body_length);
+        return true;
+    }
+    if (change->kind != RSA_WAL_UPDATE) return false;
+
+    // Validate every run before touching the record
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t pos = 0;
+        for (uint32_t r = 0; r < change->run_count; r++) {
+            uint16_t run[2];
+            if (change->body_length - pos < sizeof(run)) return false;
+            memcpy(run, change->body + pos, sizeof(run));
+            pos += sizeof(run);
+            if (run[0] < key_size || run[0] + run[1] > size || change->body_length - pos < run[1]) {
+                return false;
+            }
+            if (pass == 1) memcpy(out + run[0], change->body + pos, run[1]);
+            pos += run[1];
+        }
+        if (pos != change->body_length) return false;
+    }
+    return true;
+}
+
+// Decodes the changes of a CHANGES record payload
+static bool wal_decode_changes(const uint8_t *payload, uint32_t length, uint32_t count,
+                               uint64_t ledger_seq, rsa_wal_replay_fn fn, void *ctx) {
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        wal_change_header_t header;
+        if (length - pos < sizeof(header)) return false;
+        memcpy(&header, payload + pos, sizeof(header));
+        pos += sizeof(header);
+        if (header.type >= RSA_WAL_ENTRY_TYPE_COUNT || header.kind > RSA_WAL_DELETE) return false;
+
+        uint32_t key_size = rsa_wal_key_size[header.type];
+        if (length - pos < key_size || length - pos - key_size < header.body_length) return false;
+
+        rsa_wal_change_t change = {
+            .type = (rsa_wal_entry_type_t)header.type,
+            .kind = (rsa_wal_change_kind_t)header.kind,
+            .key = payload + pos,
+            .body = payload + pos + key_size,
+            .body_length = header.body_length,
+            .run_count = header.run_count
+        };
+        pos += key_size + header.body_length;
+        if (!fn(ctx, ledger_seq, &change)) return false;
+    }
+    return pos == length;
+}
+
+// SEGMENTS
+// --------
+
+static void wal_segment_path(const char *dir, uint64_t first_lsn, char *out, size_t size) {
+    snprintf(out, size, "%s/%016" PRIx64 ".wal", dir, first_lsn);
+}
+
+static uint32_t wal_segment_header_crc(const wal_segment_header_t *header) {
+    wal_segment_header_t copy = *header;
+    copy.crc = 0;
+    return rsa_wal_crc32c(0, &copy, sizeof(copy));
+}
+
+static int compare_lsn(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Sorted first LSNs of the segment files in dir; a missing dir is empty
+static bool wal_list_segments(const char *dir, uint64_t **out, size_t *count) {
+    *out = NULL;
+    *count = 0;
+    DIR *handle = opendir(dir);
+    if (!handle) return errno == ENOENT;
+
+    size_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        const char *name = entry->d_name;
+        if (strlen(name) != 20 || strcmp(name + 16, ".wal") != 0) continue;
+        if (strspn(name, "0123456789abcdef") != 16) continue;
+
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            uint64_t *grown = realloc(*out, capacity * sizeof(uint64_t));
+            if (!grown) {
+                closedir(handle);
+                free(*out);
+                *out = NULL;
+                return false;
+            }
+            *out = grown;
+        }
+        (*out)[(*count)++] = strtoull(name, NULL, 16);
+    }
+    closedir(handle);
+    if (*count > 1) qsort(*out, *count, sizeof(uint64_t), compare_lsn);
+    return true;
+}
+
+// Record visitor; returning false aborts the scan
+typedef bool (*wal_visit_fn)(void *ctx, const rsa_wal_record_header_t *header,
+                             const uint8_t *payload);
+
+// Walks the unbroken LSN chain from the first segment. Records of a
+// segment end at the first bad CRC, LSN gap or the next segment's first
+// LSN (anything past that was superseded by a reopen). Fills the
+// per-segment max ledger and returns in *chained how many segments the
+// chain covers.
+static bool wal_scan(const char *dir, const uint64_t *firsts, size_t count,
+                     wal_visit_fn visit, void *ctx, uint64_t *max_ledgers, size_t *chained) {
+    *chained = 0;
+    uint64_t expected = count ? firsts[0] : 1;
+
+    for (size_t i = 0; i < count && expected == firsts[i]; i++) {
+        char path[600];
+        wal_segment_path(dir, firsts[i], path, sizeof(path));
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) break;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < RSA_WAL_SEGMENT_HEADER_SIZE) {
+            close(fd);
+            break;
+        }
+        size_t size = (size_t)st.st_size;
+        const uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) break;
+        madvise((void *)map, size, MADV_SEQUENTIAL);
+
+        wal_segment_header_t segment;
+        memcpy(&segment, map, sizeof(segment));
+        if (memcmp(segment.magic, RSA_WAL_SEGMENT_MAGIC, sizeof(segment.magic)) != 0 ||
+            segment.version != RSA_WAL_VERSION || segment.first_lsn != firsts[i] ||
+            segment.crc != wal_segment_header_crc(&segment)) {
+            munmap((void *)map, size);
+            break;
+        }
+
+        uint64_t next_first = i + 1 < count ? firsts[i + 1] : UINT64_MAX;
+        uint64_t max_ledger = 0;
+        size_t pos = RSA_WAL_SEGMENT_HEADER_SIZE;
+        while (size - pos >= WAL_RECORD_HEADER_SIZE && expected < next_first) {
+            rsa_wal_record_header_t header;
+            memcpy(&header, map + pos, sizeof(header));
+            if (header.lsn != expected || header.length > size - pos - WAL_RECORD_HEADER_SIZE) break;
+            const uint8_t *payload = map + pos + WAL_RECORD_HEADER_SIZE;
+            uint32_t crc = rsa_wal_crc32c(rsa_wal_crc32c(0, payload, header.length),
+                                          map + pos + sizeof(uint32_t),
+                                          WAL_RECORD_HEADER_SIZE - sizeof(uint32_t));
+            if (crc != header.crc) break;
+
+            if (!visit(ctx, &header, payload)) {
+                munmap((void *)map, size);
+                return false;
+            }
+            if (header.ledger_seq > max_ledger) max_ledger = header.ledger_seq;
+            expected++;
+            pos += align8(WAL_RECORD_HEADER_SIZE + header.length);
+        }
+        munmap((void *)map, size);
+        if (max_ledgers) max_ledgers[i] = max_ledger;
+        *chained = i + 1;
+    }
+    return true;
+}
+
+// RECOVERY
+// --------
+
+typedef struct {
+    uint64_t close_lsn;
+    uint64_t close_ledger;
+    uint8_t close_hash[32];
+    bool has_header;
+    rsa_ledger_header_t close_header;
+} wal_close_scan_t;
+
+static bool visit_find_close(void *ctx, const rsa_wal_record_header_t *header,
+                             const uint8_t *payload) {
+    wal_close_scan_t *scan = ctx;
+    if (header->type == RSA_WAL_RECORD_LEDGER_CLOSE && header->length >= 32) {
+        scan->close_lsn = header->lsn;
+        scan->close_ledger = header->ledger_seq;
+        memcpy(scan->close_hash, payload, 32);
+        scan->has_header = header->length >= 32 + sizeof(rsa_ledger_header_t);
+        if (scan->has_header) memcpy(&scan->close_header, payload + 32, sizeof(scan->close_header));
+    }
+    return true;
+}
+
+typedef struct {
+    uint64_t close_lsn;
+    uint64_t after_ledger_seq;
+    rsa_wal_replay_fn fn;
+    void *ctx;
+    rsa_wal_recovery_t *info;
+} wal_replay_scan_t;
+
+static bool visit_replay(void *ctx, const rsa_wal_record_header_t *header,
+                         const uint8_t *payload) {
+    wal_replay_scan_t *scan = ctx;
+    if (header->type != RSA_WAL_RECORD_CHANGES || header->lsn > scan->close_lsn ||
+        header->ledger_seq <= scan->after_ledger_seq) {
+        return true;
+    }
+    scan->info->records++;
+    scan->info->changes += header->count;
+    return wal_decode_changes(payload, header->length, header->count, header->ledger_seq,
+                              scan->fn, scan->ctx);
+}
+
+bool rsa_wal_replay(const char *dir, uint64_t after_ledger_seq, rsa_wal_replay_fn fn, void *ctx,
+                    rsa_wal_recovery_t *info) {
+    rsa_wal_recovery_t local;
+    if (!info) info = &local;
+    memset(info, 0, sizeof(*info));
+    if (!dir || !fn) return false;
+
+    uint64_t *firsts;
+    size_t count, chained;
+    if (!wal_list_segments(dir, &firsts, &count)) return false;
+
+    wal_close_scan_t close = {0};
+    bool ok = wal_scan(dir, firsts, count, visit_find_close, &close, NULL, &chained);
+    if (ok && close.close_lsn != 0) {
+        wal_replay_scan_t replay = {
+            .close_lsn = close.close_lsn, .after_ledger_seq = after_ledger_seq,
+            .fn = fn, .ctx = ctx, .info = info
+        };
+        ok = wal_scan(dir, firsts, count, visit_replay, &replay, NULL, &chained);
+        info->last_lsn = close.close_lsn;
+        info->closed_ledger_seq = close.close_ledger;
+        memcpy(info->closed_ledger_hash, close.close_hash, 32);
+        info->has_header = close.has_header;
+        info->closed_ledger_header = close.close_header;
+    }
+    free(firsts);
+    return ok;
+}
+
+// WRITER
+// ------
+
+static bool write_all_at(int fd, const uint8_t *data, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t written = pwrite(fd, data, length, (off_t)offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+        offset += (uint64_t)written;
+    }
+    return true;
+}
+
+// Creates, preallocates and switches to the segment starting at first_lsn.
+// Called by open or by the leader, the only threads that touch `fd`;
+// everyone else tests `dir_fd` for an open log.
+static bool wal_create_segment(rsa_wal_t *wal, uint64_t first_lsn) {
+    char path[600];
+    wal_segment_path(wal->dir, first_lsn, path, sizeof(path));
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) return false;
+
+    // Allocating up front keeps block allocation out of every sync
+    uint64_t size = wal->options.segment_size;
+    if (fallocate(fd, 0, 0, (off_t)size) != 0 &&
+        (errno != EOPNOTSUPP || ftruncate(fd, (off_t)size) != 0)) {
+        close(fd);
+        unlink(path);
+        return false;
+    }
+
+    wal_segment_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RSA_WAL_SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = RSA_WAL_VERSION;
+    header.first_lsn = first_lsn;
+    header.segment_size = size;
+    header.crc = wal_segment_header_crc(&header);
+    if (!write_all_at(fd, (const uint8_t *)&header, sizeof(header), 0) ||
+        fdatasync(fd) != 0 || fsync(wal->dir_fd) != 0) {
+        close(fd);
+        unlink(path);
+        return false;
+    }
+
+    if (wal->fd >= 0) close(wal->fd);
+    wal->fd = fd;
+    wal->segment_offset = RSA_WAL_SEGMENT_HEADER_SIZE;
+    return true;
+}
+
+static bool wal_add_segment(rsa_wal_t *wal, uint64_t first_lsn, uint64_t max_ledger_seq) {
+    if (wal->segment_count == wal->segment_capacity) {
+        size_t capacity = wal->segment_capacity ? wal->segment_capacity * 2 : 16;
+        rsa_wal_segment_t *grown = realloc(wal->segments, capacity * sizeof(*grown));
+        if (!grown) return false;
+        wal->segments = grown;
+        wal->segment_capacity = capacity;
+    }
+    wal->segments[wal->segment_count++] = (rsa_wal_segment_t){first_lsn, max_ledger_seq};
+    return true;
+}
+
+static void wal_release(rsa_wal_t *wal) {
+    if (wal->fd >= 0) close(wal->fd);
+    if (wal->dir_fd >= 0) close(wal->dir_fd);
+    free(wal->pending);
+    free(wal->flushing);
+    free(wal->segments);
+    pthread_cond_destroy(&wal->cond);
+    pthread_mutex_destroy(&wal->mutex);
+    memset(wal, 0, sizeof(*wal));
+    wal->fd = -1;
+    wal->dir_fd = -1;
+}
+
+bool rsa_wal_open(rsa_wal_t *wal, const char *dir, const rsa_wal_options_t *options) {
+    if (!wal || !dir) return false;
+    memset(wal, 0, sizeof(*wal));
+    wal->fd = -1;
+    wal->dir_fd = -1;
+    if (strlen(dir) >= sizeof(wal->dir)) return false;
+    snprintf(wal->dir, sizeof(wal->dir), "%s", dir);
+    if (options) wal->options = *options;
+    if (wal->options.segment_size == 0) wal->options.segment_size = RSA_WAL_DEFAULT_SEGMENT_SIZE;
+    if (wal->options.segment_size < RSA_WAL_MIN_SEGMENT_SIZE) return false;
+
+    pthread_mutex_init(&wal->mutex, NULL);
+    pthread_cond_init(&wal->cond, NULL);
+
+    if (mkdir(dir, 0750) != 0 && errno != EEXIST) {
+        wal_release(wal);
+        return false;
+    }
+    wal->dir_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    uint64_t *firsts;
+    size_t count, chained;
+    if (wal->dir_fd < 0 || !wal_list_segments(dir, &firsts, &count)) {
+        wal_release(wal);
+        return false;
+    }
+    uint64_t *max_ledgers = calloc(count ? count : 1, sizeof(uint64_t));
+    wal_close_scan_t close = {0};
+    if (!max_ledgers ||
+        !wal_scan(dir, firsts, count, visit_find_close, &close, max_ledgers, &chained)) {
+        free(firsts);
+        free(max_ledgers);
+        wal_release(wal);
+        return false;
+    }
+
+    // Keep segments up to the last close record; anything later is an
+    // unfinished ledger and is dropped along with its segments
+    uint64_t start = close.close_lsn + 1;
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; i++) {
+        if (firsts[i] < start && i < chained) {
+            ok = wal_add_segment(wal, firsts[i], max_ledgers[i]);
+        } else {
+            char path[600];
+            wal_segment_path(dir, firsts[i], path, sizeof(path));
+            unlink(path);
+        }
+    }
+    free(firsts);
+    free(max_ledgers);
+
+    wal->next_lsn = start;
+    wal->durable_lsn = close.close_lsn;
+    wal->closed_ledger_seq = close.close_ledger;
+    if (!ok || !wal_create_segment(wal, start) || !wal_add_segment(wal, start, 0)) {
+        wal_release(wal);
+        return false;
+    }
+    return true;
+}
+
+bool rsa_wal_close(rsa_wal_t *wal) {
+    if (!wal || wal->dir_fd < 0) return false;
+    pthread_mutex_lock(&wal->mutex);
+    uint64_t last = wal->next_lsn - 1;
+    pthread_mutex_unlock(&wal->mutex);
+    bool ok = rsa_wal_sync(wal, last);
+    wal_release(wal);
+    return ok;
+}
+
+// Appends one record to the pending buffer. The payload CRC is computed
+// before taking the lock; only the header bytes are folded in under it.
+static bool wal_append_record(rsa_wal_t *wal, rsa_wal_record_type_t type, uint64_t ledger_seq,
+                              uint32_t count, const uint8_t *payload, size_t length,
+                              uint64_t *lsn) {
+    if (!wal || wal->dir_fd < 0 || length > UINT32_MAX) return false;
+    uint64_t record_size = align8(WAL_RECORD_HEADER_SIZE + length);
+    if (record_size > wal->options.segment_size - RSA_WAL_SEGMENT_HEADER_SIZE) return false;
+    uint32_t payload_crc = rsa_wal_crc32c(0, payload, length);
+
+    pthread_mutex_lock(&wal->mutex);
+    if (wal->failed || ledger_seq <= wal->closed_ledger_seq) {
+        pthread_mutex_unlock(&wal->mutex);
+        return false;
+    }
+    if (wal->pending_used + record_size > wal->pending_capacity) {
+        size_t capacity = wal->pending_capacity ? wal->pending_capacity : 1 << 16;
+        while (capacity < wal->pending_used + record_size) capacity *= 2;
+        uint8_t *grown = realloc(wal->pending, capacity);
+        if (!grown) {
+            pthread_mutex_unlock(&wal->mutex);
+            return false;
+        }
+        wal->pending = grown;
+        wal->pending_capacity = capacity;
+    }
+
+    rsa_wal_record_header_t header = {
+        .length = (uint32_t)length, .lsn = wal->next_lsn++, .ledger_seq = ledger_seq,
+        .type = (uint32_t)type, .count = count
+    };
+    header.crc = rsa_wal_crc32c(payload_crc, (const uint8_t *)&header + sizeof(uint32_t),
+                                WAL_RECORD_HEADER_SIZE - sizeof(uint32_t));
+    uint8_t *out = wal->pending + wal->pending_used;
+    memcpy(out, &header, sizeof(header));
+    if (length) memcpy(out + WAL_RECORD_HEADER_SIZE, payload, length);
+    memset(out + WAL_RECORD_HEADER_SIZE + length, 0, record_size - WAL_RECORD_HEADER_SIZE - length);
+    wal->pending_used += record_size;
+    if (type == RSA_WAL_RECORD_LEDGER_CLOSE) wal->closed_ledger_seq = ledger_seq;
+    if (lsn) *lsn = header.lsn;
+    pthread_mutex_unlock(&wal->mutex);
+    return true;
+}
+
+bool rsa_wal_append(rsa_wal_t *wal, uint64_t ledger_seq, const rsa_wal_batch_t *batch,
+                    uint64_t *lsn) {
+    if (!batch) return false;
+    return wal_append_record(wal, RSA_WAL_RECORD_CHANGES, ledger_seq, batch->count,
+                             batch->data, batch->length, lsn);
+}
+
+bool rsa_wal_append_close(rsa_wal_t *wal, uint64_t ledger_seq, const uint8_t ledger_hash[32],
+                          const rsa_ledger_header_t *header, uint64_t *lsn) {
+    uint8_t payload[32 + sizeof(rsa_ledger_header_t)] = {0};
+    if (ledger_hash) memcpy(payload, ledger_hash, 32);
+    if (header) memcpy(payload + 32, header, sizeof(*header));
+    return wal_append_record(wal, RSA_WAL_RECORD_LEDGER_CLOSE, ledger_seq, 0,
+                             payload, header ? sizeof(payload) : 32, lsn);
+}
+
+// Leader only: writes buffered records, rolling over to new segments as
+// they fill, then syncs
+static bool wal_write_out(rsa_wal_t *wal, const uint8_t *buffer, size_t used) {
+    size_t pos = 0;
+    while (pos < used) {
+        size_t start = pos;
+        uint64_t room = wal->options.segment_size - wal->segment_offset;
+        uint64_t max_ledger = 0;
+        while (pos < used) {
+            rsa_wal_record_header_t header;
+            memcpy(&header, buffer + pos, sizeof(header));
+            uint64_t record_size = align8(WAL_RECORD_HEADER_SIZE + header.length);
+            if (pos - start + record_size > room) break;
+            if (header.ledger_seq > max_ledger) max_ledger = header.ledger_seq;
+            pos += record_size;
+        }
+
+        if (pos > start) {
+            if (!write_all_at(wal->fd, buffer + start, pos - start, wal->segment_offset)) {
+                return false;
+            }
+            wal->segment_offset += pos - start;
+            pthread_mutex_lock(&wal->mutex);
+            rsa_wal_segment_t *current = &wal->segments[wal->segment_count - 1];
+            if (max_ledger > current->max_ledger_seq) current->max_ledger_seq = max_ledger;
+            pthread_mutex_unlock(&wal->mutex);
+        }
+
+        if (pos < used) {
+            rsa_wal_record_header_t header;
+            memcpy(&header, buffer + pos, sizeof(header));
+            if (fdatasync(wal->fd) != 0 || !wal_create_segment(wal, header.lsn)) return false;
+            pthread_mutex_lock(&wal->mutex);
+            bool added = wal_add_segment(wal, header.lsn, 0);
+            pthread_mutex_unlock(&wal->mutex);
+            if (!added) return false;
+        }
+    }
+    return fdatasync(wal->fd) == 0;
+}
+
+bool rsa_wal_sync(rsa_wal_t *wal, uint64_t lsn) {
+    if (!wal || wal->dir_fd < 0) return false;
+
+    pthread_mutex_lock(&wal->mutex);
+    while (!wal->failed && wal->durable_lsn < lsn && lsn < wal->next_lsn) {
+        if (wal->leader_active) {
+            pthread_cond_wait(&wal->cond, &wal->mutex);
+            continue;
+        }
+        wal->leader_active = true;
+        if (wal->options.commit_window_us) {
+            pthread_mutex_unlock(&wal->mutex);
+            usleep(wal->options.commit_window_us);
+            pthread_mutex_lock(&wal->mutex);
+        }
+
+        // Take everything appended so far; later appends fill the other buffer
+        uint8_t *buffer = wal->pending;
+        size_t capacity = wal->pending_capacity;
+        size_t used = wal->pending_used;
+        uint64_t last = wal->next_lsn - 1;
+        wal->pending = wal->flushing;
+        wal->pending_capacity = wal->flushing_capacity;
+        wal->pending_used = 0;
+        pthread_mutex_unlock(&wal->mutex);
+
+        bool ok = wal_write_out(wal, buffer, used);
+
+        pthread_mutex_lock(&wal->mutex);
+        wal->flushing = buffer;
+        wal->flushing_capacity = capacity;
+        if (ok) {
+            wal->synced_records += last - wal->durable_lsn;
+            wal->durable_lsn = last;
+            wal->sync_count++;
+        } else {
+            // A failed fdatasync may have dropped dirty pages: never retry
+            wal->failed = true;
+        }
+        wal->leader_active = false;
+        pthread_cond_broadcast(&wal->cond);
+    }
+    bool ok = wal->durable_lsn >= lsn;
+    pthread_mutex_unlock(&wal->mutex);
+    return ok;
+}
+
+bool rsa_wal_commit_ledger(rsa_wal_t *wal, uint64_t ledger_seq, const uint8_t ledger_hash[32],
+                           const rsa_ledger_header_t *header, const rsa_wal_batch_t *batch) {
+    uint64_t lsn;
+    if (batch && batch->count && !rsa_wal_append(wal, ledger_seq, batch, NULL)) return false;
+    return rsa_wal_append_close(wal, ledger_seq, ledger_hash, header, &lsn) &&
+           rsa_wal_sync(wal, lsn);
+}
+
+uint64_t rsa_wal_durable_lsn(rsa_wal_t *wal) {
+    if (!wal || wal->dir_fd < 0) return 0;
+    pthread_mutex_lock(&wal->mutex);
+    uint64_t lsn = wal->durable_lsn;
+    pthread_mutex_unlock(&wal->mutex);
+    return lsn;
+}
+
+size_t rsa_wal_remove_through(rsa_wal_t *wal, uint64_t ledger_seq) {
+    if (!wal || wal->dir_fd < 0) return 0;
+
+    pthread_mutex_lock(&wal->mutex);
+    size_t removed = 0;
+    while (removed + 1 < wal->segment_count &&
+           wal->segments[removed].max_ledger_seq <= ledger_seq) {
+        char path[600];
+        wal_segment_path(wal->dir, wal->segments[removed].first_lsn, path, sizeof(path));
+        if (unlink(path) != 0 && errno != ENOENT) break;
+        removed++;
+    }
+    if (removed) {
+        memmove(wal->segments, wal->segments + removed,
+                (wal->segment_count - removed) * sizeof(*wal->segments));
+        wal->segment_count -= removed;
+        fsync(wal->dir_fd);
+    }
+    pthread_mutex_unlock(&wal->mutex);
+    return removed;
+}
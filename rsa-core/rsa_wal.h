@@ -0,0 +1,212 @@
+#ifndef RSA_WAL_H
+#define RSA_WAL_H
+
+#include "rsa_token.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LEDGER WRITE-AHEAD LOG
+// ======================
+// Append-only log of ledger entry changes, replayed onto the last snapshot
+// (rsa_snapshot.h) after a crash. The log is a directory of segments named
+// by the LSN of their first record ("<16 hex digits>.wal"); each segment is
+// preallocated with fallocate and holds CRC32C-protected records:
+//
+//   CHANGES       entry deltas (create / update / delete) for one ledger
+//   LEDGER_CLOSE  ledger_seq, hash and optionally the full ledger header;
+//                 marks every earlier change durable
+//
+// Group commit: appends only copy into a shared buffer and return an LSN.
+// rsa_wal_sync(lsn) blocks until that LSN is on disk; the first waiter
+// becomes the leader, writes everything buffered so far with one write and
+// one fdatasync, and wakes every writer it covered. Concurrent writers and
+// back-to-back ledger closes therefore share syncs.
+//
+// Changes of a ledger must be appended after the close record of the
+// previous ledger. Changes whose ledger never got a durable close record
+// are discarded by replay, and reopening the log starts a new segment so
+// they can never be mistaken for later records.
+
+#define RSA_WAL_SEGMENT_MAGIC "RSAWAL1"         // 8 bytes with the NUL
+#define RSA_WAL_VERSION 1
+#define RSA_WAL_SEGMENT_HEADER_SIZE 64
+#define RSA_WAL_DEFAULT_SEGMENT_SIZE (64u << 20)
+#define RSA_WAL_MIN_SEGMENT_SIZE (64u << 10)
+
+typedef enum {
+    RSA_WAL_ACCOUNT = 0,
+    RSA_WAL_TRUSTLINE,
+    RSA_WAL_OFFER,
+    RSA_WAL_DATA,
+    RSA_WAL_ENTRY_TYPE_COUNT
+} rsa_wal_entry_type_t;
+
+typedef enum {
+    RSA_WAL_CREATE = 0,     // full record image
+    RSA_WAL_UPDATE,         // changed byte runs against the previous image
+    RSA_WAL_DELETE          // key only
+} rsa_wal_change_kind_t;
+
+typedef enum {
+    RSA_WAL_RECORD_CHANGES = 1,
+    RSA_WAL_RECORD_LEDGER_CLOSE = 2
+} rsa_wal_record_type_t;
+
+// Key bytes are a prefix of the record: account_id; account_id + asset;
+// seller_id + offer_id; account_id + data_name_len + data_name
+extern const uint32_t rsa_wal_key_size[RSA_WAL_ENTRY_TYPE_COUNT];
+// sizeof the record, and the bytes up to its last field (the rest is padding)
+extern const uint32_t rsa_wal_entry_size[RSA_WAL_ENTRY_TYPE_COUNT];
+extern const uint32_t rsa_wal_entry_used[RSA_WAL_ENTRY_TYPE_COUNT];
+
+// Canonical image of an entry as logged: padding zeroed, assets
+// canonical, bytes past data name/value lengths zeroed. `image` holds
+// rsa_wal_entry_size[type] bytes. False for malformed entries.
+bool rsa_wal_entry_normalize(rsa_wal_entry_type_t type, const void *record, void *image);
+
+// On-disk record header; records are padded to 8 bytes
+typedef struct {
+    uint32_t crc;           // CRC32C of the payload, then the rest of the header
+    uint32_t length;        // payload bytes
+    uint64_t lsn;
+    uint64_t ledger_seq;
+    uint32_t type;          // rsa_wal_record_type_t
+    uint32_t count;         // changes in the payload
+} rsa_wal_record_header_t;
+
+// Change batch
+// ------------
+// Encoded changes for one CHANGES record. Trustline and offer assets are
+// stored canonically and bytes past data name/value lengths are dropped,
+// matching snapshot records.
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    uint32_t count;
+} rsa_wal_batch_t;
+
+void rsa_wal_batch_init(rsa_wal_batch_t *batch);
+void rsa_wal_batch_free(rsa_wal_batch_t *batch);
+void rsa_wal_batch_reset(rsa_wal_batch_t *batch);
+
+// `record` points to an rsa_account_t / rsa_trustline_t / rsa_offer_t /
+// rsa_data_t matching `type`
+bool rsa_wal_batch_create(rsa_wal_batch_t *batch, rsa_wal_entry_type_t type, const void *record);
+// Only the bytes that differ are logged; false if the keys differ
+bool rsa_wal_batch_update(rsa_wal_batch_t *batch, rsa_wal_entry_type_t type,
+                          const void *before, const void *after);
+bool rsa_wal_batch_delete(rsa_wal_batch_t *batch, rsa_wal_entry_type_t type, const void *record);
+
+// Decoded change, pointing into the log
+typedef struct {
+    rsa_wal_entry_type_t type;
+    rsa_wal_change_kind_t kind;
+    const uint8_t *key;             // rsa_wal_key_size[type] bytes
+    const uint8_t *body;            // rest of the image, or the runs
+    uint32_t body_length;
+    uint32_t run_count;
+} rsa_wal_change_t;
+
+// Applies a CREATE or UPDATE to a record of the change's type (for CREATE
+// the previous contents are irrelevant). False for DELETE or bad runs.
+bool rsa_wal_change_apply(const rsa_wal_change_t *change, void *record);
+
+// Log
+// ---
+typedef struct {
+    uint64_t segment_size;          // bytes, 0 = RSA_WAL_DEFAULT_SEGMENT_SIZE
+    uint32_t commit_window_us;      // leader waits this long for more writers
+} rsa_wal_options_t;
+
+typedef struct {
+    uint64_t first_lsn;
+    uint64_t max_ledger_seq;
+} rsa_wal_segment_t;
+
+typedef struct {
+    char dir[512];
+    rsa_wal_options_t options;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int dir_fd;                     // set by open and close only; >= 0 while open
+
+    // Guarded by mutex
+    uint8_t *pending;               // appended, not yet handed to a leader
+    size_t pending_used;
+    size_t pending_capacity;
+    uint64_t next_lsn;
+    uint64_t durable_lsn;
+    uint64_t closed_ledger_seq;     // last close record appended
+    bool leader_active;
+    bool failed;                    // a write or sync failed; the log is read-only
+    rsa_wal_segment_t *segments;
+    size_t segment_count;
+    size_t segment_capacity;
+    uint64_t sync_count;
+    uint64_t synced_records;
+
+    // Owned by the current leader; other threads never read them
+    uint8_t *flushing;
+    size_t flushing_capacity;
+    int fd;                         // current segment, swapped at rollover
+    uint64_t segment_offset;
+} rsa_wal_t;
+
+// Opens (creating if needed) the log in `dir` and starts a new segment
+// after the last durable close record. Options may be NULL.
+bool rsa_wal_open(rsa_wal_t *wal, const char *dir, const rsa_wal_options_t *options);
+// Syncs whatever is buffered, then closes
+bool rsa_wal_close(rsa_wal_t *wal);
+
+// Buffer a record; *lsn (optional) is what to pass to rsa_wal_sync
+bool rsa_wal_append(rsa_wal_t *wal, uint64_t ledger_seq, const rsa_wal_batch_t *batch,
+                    uint64_t *lsn);
+// `header` (optional) is logged after the hash, for restarting from the log
+bool rsa_wal_append_close(rsa_wal_t *wal, uint64_t ledger_seq, const uint8_t ledger_hash[32],
+                          const rsa_ledger_header_t *header, uint64_t *lsn);
+// Blocks until every record up to lsn is durable
+bool rsa_wal_sync(rsa_wal_t *wal, uint64_t lsn);
+
+// Appends the ledger's changes and close record and waits for both
+bool rsa_wal_commit_ledger(rsa_wal_t *wal, uint64_t ledger_seq, const uint8_t ledger_hash[32],
+                           const rsa_ledger_header_t *header, const rsa_wal_batch_t *batch);
+
+uint64_t rsa_wal_durable_lsn(rsa_wal_t *wal);
+
+// Deletes whole segments holding nothing past ledger_seq, once a snapshot
+// of that ledger is durable. The current segment is always kept.
+size_t rsa_wal_remove_through(rsa_wal_t *wal, uint64_t ledger_seq);
+
+// Recovery
+// --------
+typedef struct {
+    uint64_t last_lsn;              // last durable close record, 0 if none
+    uint64_t closed_ledger_seq;
+    uint8_t closed_ledger_hash[32];
+    bool has_header;                // the close record carried closed_ledger_header
+    rsa_ledger_header_t closed_ledger_header;
+    uint64_t records;               // CHANGES records replayed
+    uint64_t changes;
+} rsa_wal_recovery_t;
+
+// Return false to stop the replay
+typedef bool (*rsa_wal_replay_fn)(void *ctx, uint64_t ledger_seq, const rsa_wal_change_t *change);
+
+// Calls fn, in log order, for every change of a ledger after
+// after_ledger_seq (the snapshot's ledger) that has a durable close record.
+// Read-only; run it before rsa_wal_open. A missing directory is an empty log.
+bool rsa_wal_replay(const char *dir, uint64_t after_ledger_seq, rsa_wal_replay_fn fn, void *ctx,
+                    rsa_wal_recovery_t *info);
+
+uint32_t rsa_wal_crc32c(uint32_t crc, const void *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_WAL_H
@@ -0,0 +1,117 @@
+#include "rsa_worker_pool.h"
+#include <string.h>
+
+// PERSISTENT WORKER POOL
+// ======================
+
+typedef struct {
+    rsa_worker_pool_t *pool;
+    unsigned worker;
+} worker_start_t;
+
+static void *worker_main(void *arg) {
+    worker_start_t *start = arg;
+    rsa_worker_pool_t *pool = start->pool;
+    unsigned worker = start->worker;
+
+    pthread_mutex_lock(&pool->mutex);
+    uint64_t seen = pool->round;
+    // The starter waits for this before reusing `start`
+    start->pool = NULL;
+    pthread_cond_broadcast(&pool->done);
+    for (;;) {
+        while (!pool->stopping && pool->round == seen) pthread_cond_wait(&pool->wake, &pool->mutex);
+        if (pool->stopping) break;
+        seen = pool->round;
+        if (worker > pool->wanted) continue;
+
+        rsa_worker_fn_t fn = pool->fn;
+        void *fn_arg = pool->arg;
+        pthread_mutex_unlock(&pool->mutex);
+        fn(fn_arg, worker);
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->pending == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+bool rsa_worker_pool_init(rsa_worker_pool_t *pool, unsigned workers) {
+    if (!pool) return false;
+    memset(pool, 0, sizeof(*pool));
+    if (workers < 1) workers = 1;
+    if (workers > RSA_WORKER_POOL_MAX_THREADS) workers = RSA_WORKER_POOL_MAX_THREADS;
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0) return false;
+    if (pthread_cond_init(&pool->wake, NULL) != 0) {
+        pthread_mutex_destroy(&pool->mutex);
+        return false;
+    }
+    if (pthread_cond_init(&pool->done, NULL) != 0) {
+        pthread_cond_destroy(&pool->wake);
+        pthread_mutex_destroy(&pool->mutex);
+        return false;
+    }
+    pool->size = workers;
+
+    // Threads are numbered in start order, so a failure leaves the highest
+    // indices to the caller
+    worker_start_t start = {pool, 0};
+    pthread_mutex_lock(&pool->mutex);
+    for (unsigned w = 1; w < workers; w++) {
+        start.pool = pool;
+        start.worker = w;
+        if (pthread_create(&pool->threads[pool->started], NULL, worker_main, &start) != 0) break;
+        pool->started++;
+        while (start.pool) pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return true;
+}
+
+void rsa_worker_pool_free(rsa_worker_pool_t *pool) {
+    if (!pool || pool->size == 0) return;
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+    for (unsigned i = 0; i < pool->started; i++) pthread_join(pool->threads[i], NULL);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->mutex);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void rsa_worker_pool_run(rsa_worker_pool_t *pool, unsigned workers, rsa_worker_fn_t fn, void *arg) {
+    if (!fn) return;
+    if (!pool || pool->size == 0) {
+        for (unsigned w = 0; w < workers; w++) fn(arg, w);
+        return;
+    }
+    if (workers > pool->size) workers = pool->size;
+    if (workers == 0) return;
+
+    unsigned threaded = workers - 1 < pool->started ? workers - 1 : pool->started;
+    if (threaded > 0) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->fn = fn;
+        pool->arg = arg;
+        pool->wanted = threaded;
+        pool->pending = threaded;
+        pool->round++;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    fn(arg, 0);
+    for (unsigned w = threaded + 1; w < workers; w++) fn(arg, w);
+
+    if (threaded > 0) {
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->pending > 0) pthread_cond_wait(&pool->done, &pool->mutex);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+unsigned rsa_worker_pool_size(const rsa_worker_pool_t *pool) {
+    return pool && pool->size ? pool->size : 1;
+}
@@ -0,0 +1,62 @@
+#ifndef RSA_WORKER_POOL_H
+#define RSA_WORKER_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PERSISTENT WORKER POOL
+// ======================
+// Threads started once and parked on a condition variable between runs, for
+// fork-join phases that recur every ledger (parallel apply segments, the
+// state tree update, tx-set validation). A run wakes the workers it needs
+// instead of creating and joining threads each time.
+//
+// rsa_worker_pool_run() calls fn(arg, w) once for every w in [0, workers):
+// w = 0 on the calling thread, the others on pool threads. Indices whose
+// thread could not be started run on the caller after its own, so every
+// index runs exactly once either way. The run returns when all have.
+//
+// A NULL or zeroed pool runs every index inline. One run at a time; the
+// owner serializes callers.
+
+#define RSA_WORKER_POOL_MAX_THREADS 16
+
+typedef void (*rsa_worker_fn_t)(void *arg, unsigned worker);
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;                // a run started, or stopping
+    pthread_cond_t done;                // the last worker of a run finished
+    pthread_t threads[RSA_WORKER_POOL_MAX_THREADS];
+    unsigned size;                      // workers, the caller included
+    unsigned started;                   // pool threads running; thread i is worker i + 1
+    uint64_t round;                     // bumped by every run
+    unsigned wanted;                    // workers on pool threads this round
+    unsigned pending;                   // of those, not finished yet
+    rsa_worker_fn_t fn;
+    void *arg;
+    bool stopping;
+} rsa_worker_pool_t;
+
+// `workers` counts the caller (capped at RSA_WORKER_POOL_MAX_THREADS); 0 or
+// 1 starts no threads and runs everything inline. A thread that fails to
+// start leaves its index to the caller.
+bool rsa_worker_pool_init(rsa_worker_pool_t *pool, unsigned workers);
+void rsa_worker_pool_free(rsa_worker_pool_t *pool);
+
+// fn(arg, w) for w in [0, workers), workers capped at the pool's size
+// (not capped for a NULL pool)
+void rsa_worker_pool_run(rsa_worker_pool_t *pool, unsigned workers, rsa_worker_fn_t fn, void *arg);
+
+unsigned rsa_worker_pool_size(const rsa_worker_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_WORKER_POOL_H
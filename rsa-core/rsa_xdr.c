@@ -0,0 +1,883 @@
+#include "rsa_xdr.h"
+#include <string.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// XDR CODEC
+// =========
+
+#define XDR_ACCOUNT_ID 36               // discriminant and uint256
+#define XDR_SIGNER 40                   // SignerKey and weight
+#define XDR_PAD(n) (((n) + 3) & ~(size_t)3)
+
+#define MAX_MEMO_TEXT sizeof(((rsa_memo_t *)0)->memo.text)
+#define MAX_PATH (sizeof(((rsa_operation_t *)0)->operation.path_payment.path) / sizeof(rsa_asset_t))
+#define MAX_HOME_DOMAIN sizeof(((rsa_account_t *)0)->home_domain)
+#define MAX_SIGNERS (sizeof(((rsa_account_t *)0)->signers) / sizeof(rsa_signer_t))
+#define MAX_DATA_NAME sizeof(((rsa_data_t *)0)->data_name)
+#define MAX_DATA_VALUE sizeof(((rsa_data_t *)0)->data_value)
+
+static const uint32_t zero_account[8];
+
+// Byte order
+// ----------
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    x = __builtin_bswap32(x);
+#endif
+    return x;
+}
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+}
+
+static inline void store_be32(uint8_t *p, uint32_t x) {
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    x = __builtin_bswap32(x);
+#endif
+    memcpy(p, &x, sizeof(x));
+}
+
+static inline void store_be64(uint8_t *p, uint64_t x) {
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    memcpy(p, &x, sizeof(x));
+}
+
+// Copies `words` 32-bit words reversing the bytes of each, which converts
+// either way between host and XDR order; no alignment needed
+static inline void swap_words(uint8_t *dst, const uint8_t *src, size_t words) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    memcpy(dst, src, 4 * words);
+#else
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i reverse = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= words; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(const void *)(src + 4 * i));
+        _mm_storeu_si128((__m128i *)(void *)(dst + 4 * i), _mm_shuffle_epi8(x, reverse));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= words; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(const void *)(src + 4 * i));
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));  // bytes in halves
+        x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));           // halves in words
+        x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i *)(void *)(dst + 4 * i), x);
+    }
+#endif
+    for (; i < words; i++) {
+        uint32_t x;
+        memcpy(&x, src + 4 * i, sizeof(x));
+        x = __builtin_bswap32(x);
+        memcpy(dst + 4 * i, &x, sizeof(x));
+    }
+#endif
+}
+
+static inline bool zero_bytes(const uint8_t *p, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (p[i]) return false;
+    }
+    return true;
+}
+
+// Stores, unchecked: callers reserve the exact size first
+// ---------------------------------------------------------
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    store_be32(p, v);
+    return p + 4;
+}
+
+static inline uint8_t *put_u64(uint8_t *p, uint64_t v) {
+    store_be64(p, v);
+    return p + 8;
+}
+
+static inline uint8_t *put_bytes(uint8_t *p, const void *src, size_t n) {
+    memcpy(p, src, n);
+    return p + n;
+}
+
+// Account ids as uint32_t[8], issuers as the same words in bytes
+static inline uint8_t *put_account_id(uint8_t *p, const void *id) {
+    p = put_u32(p, 0);
+    swap_words(p, (const uint8_t *)id, 8);
+    return p + 32;
+}
+
+static inline uint8_t *put_var_opaque(uint8_t *p, const void *src, uint32_t len) {
+    p = put_u32(p, len);
+    memcpy(p, src, len);
+    memset(p + len, 0, XDR_PAD(len) - len);
+    return p + XDR_PAD(len);
+}
+
+static inline uint8_t *put_optional(uint8_t *p, bool present) {
+    return put_u32(p, present ? 1 : 0);
+}
+
+static uint8_t *put_asset_body(uint8_t *p, const rsa_asset_t *asset) {
+    p = put_u32(p, (uint32_t)asset->type);
+    if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+        p = put_bytes(p, asset->asset.credit_alphanum4.code, 4);
+        p = put_account_id(p, asset->asset.credit_alphanum4.issuer);
+    } else if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM12) {
+        p = put_bytes(p, asset->asset.credit_alphanum12.code, 12);
+        p = put_account_id(p, asset->asset.credit_alphanum12.issuer);
+    }
+    return p;
+}
+
+static inline uint8_t *put_signers(uint8_t *p, const rsa_signer_t *signers, uint32_t count) {
+    p = put_u32(p, count);
+    for (uint32_t i = 0; i < count; i++) {
+        p = put_u32(p, 0);
+        p = put_bytes(p, signers[i].key, 32);
+        p = put_u32(p, signers[i].weight);
+    }
+    return p;
+}
+
+static inline uint8_t *writer_reserve(rsa_xdr_writer_t *writer, size_t n) {
+    if (writer->overflow || writer->capacity - writer->size < n) {
+        writer->overflow = true;
+        return NULL;
+    }
+    uint8_t *p = writer->data + writer->size;
+    writer->size += n;
+    return p;
+}
+
+// Loads, checked per run of fixed fields
+// --------------------------------------
+
+static inline const uint8_t *reader_take(rsa_xdr_reader_t *reader, size_t n) {
+    if (reader->error || reader->size - reader->pos < n) {
+        reader->error = true;
+        return NULL;
+    }
+    const uint8_t *p = reader->data + reader->pos;
+    reader->pos += n;
+    return p;
+}
+
+static inline bool reader_fail(rsa_xdr_reader_t *reader) {
+    reader->error = true;
+    return false;
+}
+
+static inline bool get_account_id(const uint8_t *p, void *id) {
+    if (load_be32(p) != 0) return false;
+    swap_words((uint8_t *)id, p + 4, 8);
+    return true;
+}
+
+static inline bool get_optional(const uint8_t *p, bool *present) {
+    uint32_t flag = load_be32(p);
+    *present = flag == 1;
+    return flag <= 1;
+}
+
+// Length (at most `max`), bytes, zero padding
+static bool take_var_opaque(rsa_xdr_reader_t *reader, void *dst, size_t max, uint32_t *len) {
+    const uint8_t *p = reader_take(reader, 4);
+    if (!p) return false;
+    uint32_t n = load_be32(p);
+    if (n > max) return reader_fail(reader);
+    p = reader_take(reader, XDR_PAD(n));
+    if (!p) return false;
+    if (!zero_bytes(p + n, XDR_PAD(n) - n)) return reader_fail(reader);
+    memcpy(dst, p, n);
+    *len = n;
+    return true;
+}
+
+static bool take_asset(rsa_xdr_reader_t *reader, rsa_asset_t *asset) {
+    const uint8_t *p = reader_take(reader, 4);
+    if (!p) return false;
+    uint32_t type = load_be32(p);
+    asset->type = (rsa_asset_type_t)type;
+    if (type == RSA_ASSET_TYPE_NATIVE) return true;
+    if (type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+        p = reader_take(reader, 4 + XDR_ACCOUNT_ID);
+        if (!p) return false;
+        memcpy(asset->asset.credit_alphanum4.code, p, 4);
+        return get_account_id(p + 4, asset->asset.credit_alphanum4.issuer) || reader_fail(reader);
+    }
+    if (type == RSA_ASSET_TYPE_CREDIT_ALPHANUM12) {
+        p = reader_take(reader, 12 + XDR_ACCOUNT_ID);
+        if (!p) return false;
+        memcpy(asset->asset.credit_alphanum12.code, p, 12);
+        return get_account_id(p + 12, asset->asset.credit_alphanum12.issuer) || reader_fail(reader);
+    }
+    return reader_fail(reader);
+}
+
+static bool take_signers(rsa_xdr_reader_t *reader, rsa_signer_t *signers, uint32_t *count) {
+    const uint8_t *p = reader_take(reader, 4);
+    if (!p) return false;
+    uint32_t n = load_be32(p);
+    if (n > MAX_SIGNERS) return reader_fail(reader);
+    p = reader_take(reader, (size_t)n * XDR_SIGNER);
+    if (!p) return false;
+    for (uint32_t i = 0; i < n; i++, p += XDR_SIGNER) {
+        if (load_be32(p) != 0) return reader_fail(reader);
+        memcpy(signers[i].key, p + 4, 32);
+        signers[i].weight = load_be32(p + 36);
+    }
+    *count = n;
+    return true;
+}
+
+static inline bool take_ext(rsa_xdr_reader_t *reader) {
+    const uint8_t *p = reader_take(reader, 4);
+    return p && (load_be32(p) == 0 || reader_fail(reader));
+}
+
+void rsa_xdr_writer_init(rsa_xdr_writer_t *writer, uint8_t *data, size_t capacity) {
+    writer->data = data;
+    writer->capacity = data ? capacity : 0;
+    writer->size = 0;
+    writer->overflow = false;
+}
+
+void rsa_xdr_reader_init(rsa_xdr_reader_t *reader, const uint8_t *data, size_t size) {
+    reader->data = data;
+    reader->size = data ? size : 0;
+    reader->pos = 0;
+    reader->error = false;
+}
+
+// Sizes
+// -----
+
+size_t rsa_xdr_asset_size(const rsa_asset_t *asset) {
+    switch (asset->type) {
+        case RSA_ASSET_TYPE_NATIVE: return 4;
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM4: return 4 + 4 + XDR_ACCOUNT_ID;
+        case RSA_ASSET_TYPE_CREDIT_ALPHANUM12: return 4 + 12 + XDR_ACCOUNT_ID;
+    }
+    return 0;
+}
+
+// Memo text is NUL-padded, or fills the field
+static size_t memo_text_len(const rsa_memo_t *memo) {
+    const char *nul = memchr(memo->memo.text, 0, MAX_MEMO_TEXT);
+    return nul ? (size_t)(nul - memo->memo.text) : MAX_MEMO_TEXT;
+}
+
+static size_t memo_size(const rsa_memo_t *memo) {
+    switch (memo->type) {
+        case RSA_MEMO_NONE: return 4;
+        case RSA_MEMO_TEXT: return 4 + 4 + XDR_PAD(memo_text_len(memo));
+        case RSA_MEMO_ID: return 4 + 8;
+        case RSA_MEMO_HASH:
+        case RSA_MEMO_RETURN: return 4 + 32;
+    }
+    return 0;
+}
+
+// The account the operation's source field carries, or NULL when it
+// stays absent (it is the transaction's)
+static const void *op_source(const rsa_operation_t *op, const uint32_t tx_source[8]) {
+    const void *source = NULL;
+    if (op->type == RSA_OP_ALLOW_TRUST) {
+        const rsa_asset_t *asset = &op->operation.allow_trust.asset;
+        source = asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4 ? asset->asset.credit_alphanum4.issuer
+                                                                : asset->asset.credit_alphanum12.issuer;
+    }
+    return source && memcmp(source, tx_source, 32) != 0 ? source : NULL;
+}
+
+// Discriminant and body; 0 when the operation cannot be encoded
+static size_t op_size(const rsa_operation_t *op) {
+    size_t a, b, size;
+    switch (op->type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            return 4 + XDR_ACCOUNT_ID + 8;
+        case RSA_OP_PAYMENT:
+            a = rsa_xdr_asset_size(&op->operation.payment.asset);
+            return a ? 4 + XDR_ACCOUNT_ID + a + 8 : 0;
+        case RSA_OP_PATH_PAYMENT:
+            a = rsa_xdr_asset_size(&op->operation.path_payment.send_asset);
+            b = rsa_xdr_asset_size(&op->operation.path_payment.dest_asset);
+            if (!a || !b || op->operation.path_payment.path_len > MAX_PATH) return 0;
+            size = a + 8 + XDR_ACCOUNT_ID + b + 8 + 4;
+            for (uint32_t i = 0; i < op->operation.path_payment.path_len; i++) {
+                a = rsa_xdr_asset_size(&op->operation.path_payment.path[i]);
+                if (!a) return 0;
+                size += a;
+            }
+            return 4 + size;
+        case RSA_OP_MANAGE_OFFER:
+        case RSA_OP_CREATE_PASSIVE_OFFER:
+            a = rsa_xdr_asset_size(&op->operation.manage_offer.selling);
+            b = rsa_xdr_asset_size(&op->operation.manage_offer.buying);
+            if (!a || !b) return 0;
+            return 4 + a + b + 8 + 8 + (op->type == RSA_OP_MANAGE_OFFER ? 8 : 0);
+        case RSA_OP_SET_OPTIONS:
+            if (op->operation.set_options.home_domain_len > MAX_HOME_DOMAIN ||
+                op->operation.set_options.signer_count > MAX_SIGNERS) {
+                return 0;
+            }
+            return 4 + 4 + 4 + XDR_PAD(op->operation.set_options.home_domain_len) + 4 +
+                   op->operation.set_options.signer_count * XDR_SIGNER;
+        case RSA_OP_CHANGE_TRUST:
+            a = rsa_xdr_asset_size(&op->operation.change_trust.asset);
+            return a ? 4 + a + 8 : 0;
+        case RSA_OP_ALLOW_TRUST:
+            if (op->operation.allow_trust.asset.type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+                return 4 + XDR_ACCOUNT_ID + 4 + 4 + 4;
+            }
+            if (op->operation.allow_trust.asset.type == RSA_ASSET_TYPE_CREDIT_ALPHANUM12) {
+                return 4 + XDR_ACCOUNT_ID + 4 + 12 + 4;
+            }
+            return 0;
+        case RSA_OP_ACCOUNT_MERGE:
+            return 4 + XDR_ACCOUNT_ID;
+        case RSA_OP_INFLATION:
+            return 4;
+        case RSA_OP_MANAGE_DATA:
+            if (op->operation.manage_data.data_name_len > MAX_DATA_NAME ||
+                op->operation.manage_data.data_value_len > MAX_DATA_VALUE) {
+                return 0;
+            }
+            size = 4 + XDR_PAD(op->operation.manage_data.data_name_len) + 4;
+            if (op->operation.manage_data.data_value_len) {
+                size += 4 + XDR_PAD(op->operation.manage_data.data_value_len);
+            }
+            return 4 + size;
+        case RSA_OP_BUMP_SEQUENCE:
+            return 4 + 8;
+    }
+    return 0;
+}
+
+size_t rsa_xdr_transaction_size(const rsa_transaction_t *tx, const rsa_operation_t *operations) {
+    if (!tx || tx->operations_count > RSA_MAX_OPERATIONS_PER_TX) return 0;
+    if (tx->operations_count > 0 && !operations) return 0;
+    size_t memo = memo_size(&tx->memo);
+    if (!memo) return 0;
+    bool bounded = tx->time_bounds.min_time || tx->time_bounds.max_time;
+    size_t size = XDR_ACCOUNT_ID + 4 + 8 + 4 + (bounded ? 16 : 0) + memo + 4 + 4;
+    for (uint32_t i = 0; i < tx->operations_count; i++) {
+        size_t op = op_size(&operations[i]);
+        if (!op) return 0;
+        // A payment only ever debits the transaction's source
+        const rsa_operation_t *o = &operations[i];
+        if (o->type == RSA_OP_PAYMENT && memcmp(o->operation.payment.from, zero_account, 32) != 0 &&
+            memcmp(o->operation.payment.from, tx->tx_source_account, 32) != 0) {
+            return 0;
+        }
+        size += 4 + (op_source(&operations[i], tx->tx_source_account) ? XDR_ACCOUNT_ID : 0) + op;
+    }
+    return size;
+}
+
+size_t rsa_xdr_account_size(const rsa_account_t *account) {
+    if (account->home_domain_len > MAX_HOME_DOMAIN || account->signer_count > MAX_SIGNERS) {
+        return 0;
+    }
+    bool inflation = memcmp(account->inflation_dest, zero_account, 32) != 0;
+    return XDR_ACCOUNT_ID + 8 + 8 + 4 + 4 + (inflation ? XDR_ACCOUNT_ID : 0) + 4 + 4 +
+           XDR_PAD(account->home_domain_len) + 4 + 4 + account->signer_count * XDR_SIGNER + 4;
+}
+
+size_t rsa_xdr_trustline_size(const rsa_trustline_t *trustline) {
+    size_t asset = rsa_xdr_asset_size(&trustline->asset);
+    return asset ? XDR_ACCOUNT_ID + asset + 8 + 8 + 4 + 4 : 0;
+}
+
+size_t rsa_xdr_offer_size(const rsa_offer_t *offer) {
+    size_t selling = rsa_xdr_asset_size(&offer->selling);
+    size_t buying = rsa_xdr_asset_size(&offer->buying);
+    return selling && buying ? XDR_ACCOUNT_ID + 8 + selling + buying + 8 + 8 + 4 + 4 : 0;
+}
+
+size_t rsa_xdr_data_size(const rsa_data_t *data) {
+    if (data->data_name_len > MAX_DATA_NAME || data->data_value_len > MAX_DATA_VALUE) return 0;
+    return XDR_ACCOUNT_ID + 4 + XDR_PAD(data->data_name_len) + 4 +
+           XDR_PAD(data->data_value_len) + 4;
+}
+
+// Encoders
+// --------
+
+static uint8_t *put_op(uint8_t *p, const rsa_operation_t *op, const uint32_t tx_source[8]) {
+    const void *source = op_source(op, tx_source);
+    p = put_optional(p, source != NULL);
+    if (source) p = put_account_id(p, source);
+    p = put_u32(p, (uint32_t)op->type);
+    switch (op->type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            p = put_account_id(p, op->operation.create_account.destination);
+            p = put_u64(p, (uint64_t)op->operation.create_account.starting_balance);
+            break;
+        case RSA_OP_PAYMENT:
+            p = put_account_id(p, op->operation.payment.to);
+            p = put_asset_body(p, &op->operation.payment.asset);
+            p = put_u64(p, (uint64_t)op->operation.payment.amount);
+            break;
+        case RSA_OP_PATH_PAYMENT:
+            p = put_asset_body(p, &op->operation.path_payment.send_asset);
+            p = put_u64(p, (uint64_t)op->operation.path_payment.send_max);
+            p = put_account_id(p, op->operation.path_payment.destination);
+            p = put_asset_body(p, &op->operation.path_payment.dest_asset);
+            p = put_u64(p, (uint64_t)op->operation.path_payment.dest_amount);
+            p = put_u32(p, op->operation.path_payment.path_len);
+            for (uint32_t i = 0; i < op->operation.path_payment.path_len; i++) {
+                p = put_asset_body(p, &op->operation.path_payment.path[i]);
+            }
+            break;
+        case RSA_OP_MANAGE_OFFER:
+        case RSA_OP_CREATE_PASSIVE_OFFER:
+            p = put_asset_body(p, &op->operation.manage_offer.selling);
+            p = put_asset_body(p, &op->operation.manage_offer.buying);
+            p = put_u64(p, (uint64_t)op->operation.manage_offer.amount);
+            p = put_u32(p, (uint32_t)op->operation.manage_offer.price.n);
+            p = put_u32(p, (uint32_t)op->operation.manage_offer.price.d);
+            if (op->type == RSA_OP_MANAGE_OFFER) {
+                p = put_u64(p, op->operation.manage_offer.offer_id);
+            }
+            break;
+        case RSA_OP_SET_OPTIONS:
+            p = put_bytes(p, &op->operation.set_options.thresholds, 4);
+            p = put_var_opaque(p, op->operation.set_options.home_domain,
+                               op->operation.set_options.home_domain_len);
+            p = put_signers(p, op->operation.set_options.signers,
+                            op->operation.set_options.signer_count);
+            break;
+        case RSA_OP_CHANGE_TRUST:
+            p = put_asset_body(p, &op->operation.change_trust.asset);
+            p = put_u64(p, (uint64_t)op->operation.change_trust.limit);
+            break;
+        case RSA_OP_ALLOW_TRUST:
+            p = put_account_id(p, op->operation.allow_trust.trustor);
+            p = put_u32(p, (uint32_t)op->operation.allow_trust.asset.type);
+            if (op->operation.allow_trust.asset.type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+                p = put_bytes(p, op->operation.allow_trust.asset.asset.credit_alphanum4.code, 4);
+            } else {
+                p = put_bytes(p, op->operation.allow_trust.asset.asset.credit_alphanum12.code, 12);
+            }
+            p = put_u32(p, op->operation.allow_trust.authorize);
+            break;
+        case RSA_OP_ACCOUNT_MERGE:
+            p = put_account_id(p, op->operation.account_merge.destination);
+            break;
+        case RSA_OP_INFLATION:
+            break;
+        case RSA_OP_MANAGE_DATA:
+            p = put_var_opaque(p, op->operation.manage_data.data_name,
+                               op->operation.manage_data.data_name_len);
+            p = put_optional(p, op->operation.manage_data.data_value_len != 0);
+            if (op->operation.manage_data.data_value_len) {
+                p = put_var_opaque(p, op->operation.manage_data.data_value,
+                                   op->operation.manage_data.data_value_len);
+            }
+            break;
+        case RSA_OP_BUMP_SEQUENCE:
+            p = put_u64(p, op->operation.bump_sequence.bump_to);
+            break;
+    }
+    return p;
+}
+
+bool rsa_xdr_put_asset(rsa_xdr_writer_t *writer, const rsa_asset_t *asset) {
+    size_t size = rsa_xdr_asset_size(asset);
+    uint8_t *p = size ? writer_reserve(writer, size) : NULL;
+    if (!p) return false;
+    put_asset_body(p, asset);
+    return true;
+}
+
+bool rsa_xdr_put_transaction(rsa_xdr_writer_t *writer, const rsa_transaction_t *tx,
+                             const rsa_operation_t *operations) {
+    size_t size = rsa_xdr_transaction_size(tx, operations);
+    uint8_t *p = size ? writer_reserve(writer, size) : NULL;
+    if (!p) return false;
+
+    p = put_account_id(p, tx->tx_source_account);
+    p = put_u32(p, tx->fee);
+    p = put_u64(p, tx->seq_num);
+    bool bounded = tx->time_bounds.min_time || tx->time_bounds.max_time;
+    p = put_optional(p, bounded);
+    if (bounded) {
+        p = put_u64(p, tx->time_bounds.min_time);
+        p = put_u64(p, tx->time_bounds.max_time);
+    }
+    p = put_u32(p, (uint32_t)tx->memo.type);
+    switch (tx->memo.type) {
+        case RSA_MEMO_TEXT:
+            p = put_var_opaque(p, tx->memo.memo.text, (uint32_t)memo_text_len(&tx->memo));
+            break;
+        case RSA_MEMO_ID:
+            p = put_u64(p, tx->memo.memo.id);
+            break;
+        case RSA_MEMO_HASH:
+            p = put_bytes(p, tx->memo.memo.hash, 32);
+            break;
+        case RSA_MEMO_RETURN:
+            p = put_bytes(p, tx->memo.memo.ret_hash, 32);
+            break;
+        case RSA_MEMO_NONE:
+            break;
+    }
+    p = put_u32(p, tx->operations_count);
+    for (uint32_t i = 0; i < tx->operations_count; i++) {
+        p = put_op(p, &operations[i], tx->tx_source_account);
+    }
+    put_u32(p, 0);
+    return true;
+}
+
+bool rsa_xdr_put_account(rsa_xdr_writer_t *writer, const rsa_account_t *account) {
+    size_t size = rsa_xdr_account_size(account);
+    uint8_t *p = size ? writer_reserve(writer, size) : NULL;
+    if (!p) return false;
+
+    p = put_account_id(p, account->account_id);
+    p = put_u64(p, (uint64_t)account->balance);
+    p = put_u64(p, account->seq_num);
+    p = put_u32(p, account->num_sub_entries);
+    bool inflation = memcmp(account->inflation_dest, zero_account, 32) != 0;
+    p = put_optional(p, inflation);
+    if (inflation) p = put_account_id(p, account->inflation_dest);
+    p = put_u32(p, account->flags);
+    p = put_var_opaque(p, account->home_domain, account->home_domain_len);
+    p = put_bytes(p, &account->thresholds, 4);
+    p = put_signers(p, account->signers, account->signer_count);
+    put_u32(p, 0);
+    return true;
+}
+
+bool rsa_xdr_put_trustline(rsa_xdr_writer_t *writer, const rsa_trustline_t *trustline) {
+    size_t size = rsa_xdr_trustline_size(trustline);
+    uint8_t *p = size ? writer_reserve(writer, size) : NULL;
+    if (!p) return false;
+
+    p = put_account_id(p, trustline->account_id);
+    p = put_asset_body(p, &trustline->asset);
+    p = put_u64(p, (uint64_t)trustline->balance);
+    p = put_u64(p, (uint64_t)trustline->limit);
+    p = put_u32(p, trustline->flags);
+    put_u32(p, 0);
+    return true;
+}
+
+bool rsa_xdr_put_offer(rsa_xdr_writer_t *writer, const rsa_offer_t *offer) {
+    size_t size = rsa_xdr_offer_size(offer);
+    uint8_t *p = size ? writer_reserve(writer, size) : NULL;
+    if (!p) return false;
+
+    p = put_account_id(p, offer->seller_id);
+    p = put_u64(p, offer->offer_id);
+    p = put_asset_body(p, &offer->selling);
+    p = put_asset_body(p, &offer->buying);
+    p = put_u64(p, (uint64_t)offer->amount);
+    p = put_u32(p, (uint32_t)offer->price.n);
+    p = put_u32(p, (uint32_t)offer->price.d);
+    p = put_u32(p, offer->flags);
+    put_u32(p, 0);
+    return true;
+}
+
+bool rsa_xdr_put_data(rsa_xdr_writer_t *writer, const rsa_data_t *data) {
+    size_t size = rsa_xdr_data_size(data);
+    uint8_t *p = size ? writer_reserve(writer, size) : NULL;
+    if (!p) return false;
+
+    p = put_account_id(p, data->account_id);
+    p = put_var_opaque(p, data->data_name, data->data_name_len);
+    p = put_var_opaque(p, data->data_value, data->data_value_len);
+    put_u32(p, 0);
+    return true;
+}
+
+// Decoders
+// --------
+
+// The operation's source, when present, becomes the allow_trust issuer;
+// other operations cannot carry one. payment.from is the transaction's
+// source.
+static bool take_op(rsa_xdr_reader_t *reader, rsa_operation_t *op, const uint32_t tx_source[8]) {
+    uint32_t source[8];
+    bool has_source;
+    const uint8_t *p = reader_take(reader, 4);
+    if (!p) return false;
+    if (!get_optional(p, &has_source)) return reader_fail(reader);
+    if (has_source) {
+        p = reader_take(reader, XDR_ACCOUNT_ID);
+        if (!p) return false;
+        if (!get_account_id(p, source)) return reader_fail(reader);
+    } else {
+        memcpy(source, tx_source, 32);
+    }
+    p = reader_take(reader, 4);
+    if (!p) return false;
+    uint32_t type = load_be32(p);
+    if (has_source && type != RSA_OP_ALLOW_TRUST) {
+        return reader_fail(reader);
+    }
+    op->type = (rsa_operation_type_t)type;
+
+    uint32_t len;
+    bool present;
+    switch (type) {
+        case RSA_OP_CREATE_ACCOUNT:
+            p = reader_take(reader, XDR_ACCOUNT_ID + 8);
+            if (!p) return false;
+            if (!get_account_id(p, op->operation.create_account.destination)) break;
+            op->operation.create_account.starting_balance = (int64_t)load_be64(p + XDR_ACCOUNT_ID);
+            return true;
+        case RSA_OP_PAYMENT:
+            memcpy(op->operation.payment.from, source, 32);
+            p = reader_take(reader, XDR_ACCOUNT_ID);
+            if (!p) return false;
+            if (!get_account_id(p, op->operation.payment.to)) break;
+            if (!take_asset(reader, &op->operation.payment.asset)) return false;
+            p = reader_take(reader, 8);
+            if (!p) return false;
+            op->operation.payment.amount = (int64_t)load_be64(p);
+            return true;
+        case RSA_OP_PATH_PAYMENT:
+            if (!take_asset(reader, &op->operation.path_payment.send_asset)) return false;
+            p = reader_take(reader, 8 + XDR_ACCOUNT_ID);
+            if (!p) return false;
+            op->operation.path_payment.send_max = (int64_t)load_be64(p);
+            if (!get_account_id(p + 8, op->operation.path_payment.destination)) break;
+            if (!take_asset(reader, &op->operation.path_payment.dest_asset)) return false;
+            p = reader_take(reader, 8 + 4);
+            if (!p) return false;
+            op->operation.path_payment.dest_amount = (int64_t)load_be64(p);
+            len = load_be32(p + 8);
+            if (len > MAX_PATH) break;
+            op->operation.path_payment.path_len = len;
+            for (uint32_t i = 0; i < len; i++) {
+                if (!take_asset(reader, &op->operation.path_payment.path[i])) return false;
+            }
+            return true;
+        case RSA_OP_MANAGE_OFFER:
+        case RSA_OP_CREATE_PASSIVE_OFFER:
+            if (!take_asset(reader, &op->operation.manage_offer.selling) ||
+                !take_asset(reader, &op->operation.manage_offer.buying)) {
+                return false;
+            }
+            p = reader_take(reader, 8 + 8 + (type == RSA_OP_MANAGE_OFFER ? 8 : 0));
+            if (!p) return false;
+            op->operation.manage_offer.amount = (int64_t)load_be64(p);
+            op->operation.manage_offer.price.n = (int32_t)load_be32(p + 8);
+            op->operation.manage_offer.price.d = (int32_t)load_be32(p + 12);
+            if (type == RSA_OP_MANAGE_OFFER) {
+                uint64_t offer_id = load_be64(p + 16);
+                if (offer_id > UINT32_MAX) break;
+                op->operation.manage_offer.offer_id = (uint32_t)offer_id;
+            }
+            return true;
+        case RSA_OP_SET_OPTIONS:
+            p = reader_take(reader, 4);
+            if (!p) return false;
+            memcpy(&op->operation.set_options.thresholds, p, 4);
+            return take_var_opaque(reader, op->operation.set_options.home_domain, MAX_HOME_DOMAIN,
+                                   &op->operation.set_options.home_domain_len) &&
+                   take_signers(reader, op->operation.set_options.signers,
+                                &op->operation.set_options.signer_count);
+        case RSA_OP_CHANGE_TRUST:
+            if (!take_asset(reader, &op->operation.change_trust.asset)) return false;
+            p = reader_take(reader, 8);
+            if (!p) return false;
+            op->operation.change_trust.limit = (int64_t)load_be64(p);
+            return true;
+        case RSA_OP_ALLOW_TRUST: {
+            rsa_asset_t *asset = &op->operation.allow_trust.asset;
+            p = reader_take(reader, XDR_ACCOUNT_ID + 4);
+            if (!p) return false;
+            if (!get_account_id(p, op->operation.allow_trust.trustor)) break;
+            asset->type = (rsa_asset_type_t)load_be32(p + XDR_ACCOUNT_ID);
+            if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM4) {
+                p = reader_take(reader, 4 + 4);
+                if (!p) return false;
+                memcpy(asset->asset.credit_alphanum4.code, p, 4);
+                memcpy(asset->asset.credit_alphanum4.issuer, source, 32);
+                op->operation.allow_trust.authorize = load_be32(p + 4);
+                return true;
+            }
+            if (asset->type == RSA_ASSET_TYPE_CREDIT_ALPHANUM12) {
+                p = reader_take(reader, 12 + 4);
+                if (!p) return false;
+                memcpy(asset->asset.credit_alphanum12.code, p, 12);
+                memcpy(asset->asset.credit_alphanum12.issuer, source, 32);
+                op->operation.allow_trust.authorize = load_be32(p + 12);
+                return true;
+            }
+            break;
+        }
+        case RSA_OP_ACCOUNT_MERGE:
+            p = reader_take(reader, XDR_ACCOUNT_ID);
+            if (!p) return false;
+            if (!get_account_id(p, op->operation.account_merge.destination)) break;
+            return true;
+        case RSA_OP_INFLATION:
+            return true;
+        case RSA_OP_MANAGE_DATA:
+            if (!take_var_opaque(reader, op->operation.manage_data.data_name, MAX_DATA_NAME,
+                                 &op->operation.manage_data.data_name_len)) {
+                return false;
+            }
+            p = reader_take(reader, 4);
+            if (!p) return false;
+            if (!get_optional(p, &present)) break;
+            return !present ||
+                   take_var_opaque(reader, op->operation.manage_data.data_value, MAX_DATA_VALUE,
+                                   &op->operation.manage_data.data_value_len);
+        case RSA_OP_BUMP_SEQUENCE:
+            p = reader_take(reader, 8);
+            if (!p) return false;
+            op->operation.bump_sequence.bump_to = load_be64(p);
+            return true;
+    }
+    return reader_fail(reader);
+}
+
+bool rsa_xdr_get_asset(rsa_xdr_reader_t *reader, rsa_asset_t *asset) {
+    memset(asset, 0, sizeof(*asset));
+    return take_asset(reader, asset);
+}
+
+bool rsa_xdr_get_transaction(rsa_xdr_reader_t *reader, rsa_transaction_t *tx,
+                             rsa_operation_t operations[RSA_MAX_OPERATIONS_PER_TX]) {
+    memset(tx, 0, sizeof(*tx));
+    const uint8_t *p = reader_take(reader, XDR_ACCOUNT_ID + 4 + 8 + 4);
+    if (!p) return false;
+    if (!get_account_id(p, tx->tx_source_account)) return reader_fail(reader);
+    tx->fee = load_be32(p + XDR_ACCOUNT_ID);
+    tx->seq_num = load_be64(p + XDR_ACCOUNT_ID + 4);
+    bool bounded;
+    if (!get_optional(p + XDR_ACCOUNT_ID + 12, &bounded)) return reader_fail(reader);
+    if (bounded) {
+        p = reader_take(reader, 16);
+        if (!p) return false;
+        tx->time_bounds.min_time = load_be64(p);
+        tx->time_bounds.max_time = load_be64(p + 8);
+    }
+
+    p = reader_take(reader, 4);
+    if (!p) return false;
+    uint32_t memo = load_be32(p);
+    uint32_t len;
+    tx->memo.type = (rsa_memo_type_t)memo;
+    switch (memo) {
+        case RSA_MEMO_NONE:
+            break;
+        case RSA_MEMO_TEXT:
+            if (!take_var_opaque(reader, tx->memo.memo.text, MAX_MEMO_TEXT, &len)) return false;
+            break;
+        case RSA_MEMO_ID:
+            p = reader_take(reader, 8);
+            if (!p) return false;
+            tx->memo.memo.id = load_be64(p);
+            break;
+        case RSA_MEMO_HASH:
+        case RSA_MEMO_RETURN:
+            p = reader_take(reader, 32);
+            if (!p) return false;
+            memcpy(tx->memo.memo.hash, p, 32);
+            break;
+        default:
+            return reader_fail(reader);
+    }
+
+    p = reader_take(reader, 4);
+    if (!p) return false;
+    uint32_t op_count = load_be32(p);
+    if (op_count > RSA_MAX_OPERATIONS_PER_TX) return reader_fail(reader);
+    tx->operations_count = op_count;
+    for (uint32_t i = 0; i < op_count; i++) {
+        memset(&operations[i], 0, sizeof(operations[i]));
+        if (!take_op(reader, &operations[i], tx->tx_source_account)) return false;
+    }
+    return take_ext(reader);
+}
+
+bool rsa_xdr_get_account(rsa_xdr_reader_t *reader, rsa_account_t *account) {
+    memset(account, 0, sizeof(*account));
+    const uint8_t *p = reader_take(reader, XDR_ACCOUNT_ID + 8 + 8 + 4 + 4);
+    if (!p) return false;
+    if (!get_account_id(p, account->account_id)) return reader_fail(reader);
+    p += XDR_ACCOUNT_ID;
+    account->balance = (int64_t)load_be64(p);
+    account->seq_num = load_be64(p + 8);
+    account->num_sub_entries = load_be32(p + 16);
+    bool inflation;
+    if (!get_optional(p + 20, &inflation)) return reader_fail(reader);
+    if (inflation) {
+        p = reader_take(reader, XDR_ACCOUNT_ID);
+        if (!p) return false;
+        if (!get_account_id(p, account->inflation_dest)) return reader_fail(reader);
+    }
+    p = reader_take(reader, 4);
+    if (!p) return false;
+    account->flags = load_be32(p);
+    if (!take_var_opaque(reader, account->home_domain, MAX_HOME_DOMAIN, &account->home_domain_len)) {
+        return false;
+    }
+    p = reader_take(reader, 4);
+    if (!p) return false;
+    memcpy(&account->thresholds, p, 4);
+    return take_signers(reader, account->signers, &account->signer_count) && take_ext(reader);
+}
+
+bool rsa_xdr_get_trustline(rsa_xdr_reader_t *reader, rsa_trustline_t *trustline) {
+    memset(trustline, 0, sizeof(*trustline));
+    const uint8_t *p = reader_take(reader, XDR_ACCOUNT_ID);
+    if (!p) return false;
+    if (!get_account_id(p, trustline->account_id)) return reader_fail(reader);
+    if (!take_asset(reader, &trustline->asset)) return false;
+    p = reader_take(reader, 8 + 8 + 4);
+    if (!p) return false;
+    trustline->balance = (int64_t)load_be64(p);
+    trustline->limit = (int64_t)load_be64(p + 8);
+    trustline->flags = load_be32(p + 16);
+    return take_ext(reader);
+}
+
+bool rsa_xdr_get_offer(rsa_xdr_reader_t *reader, rsa_offer_t *offer) {
+    memset(offer, 0, sizeof(*offer));
+    const uint8_t *p = reader_take(reader, XDR_ACCOUNT_ID + 8);
+    if (!p) return false;
+    if (!get_account_id(p, offer->seller_id)) return reader_fail(reader);
+    offer->offer_id = load_be64(p + XDR_ACCOUNT_ID);
+    if (!take_asset(reader, &offer->selling) || !take_asset(reader, &offer->buying)) return false;
+    p = reader_take(reader, 8 + 8 + 4);
+    if (!p) return false;
+    offer->amount = (int64_t)load_be64(p);
+    offer->price.n = (int32_t)load_be32(p + 8);
+    offer->price.d = (int32_t)load_be32(p + 12);
+    offer->flags = load_be32(p + 16);
+    return take_ext(reader);
+}
+
+bool rsa_xdr_get_data(rsa_xdr_reader_t *reader, rsa_data_t *data) {
+    memset(data, 0, sizeof(*data));
+    const uint8_t *p = reader_take(reader, XDR_ACCOUNT_ID);
+    if (!p) return false;
+    if (!get_account_id(p, data->account_id)) return reader_fail(reader);
+    return take_var_opaque(reader, data->data_name, MAX_DATA_NAME, &data->data_name_len) &&
+           take_var_opaque(reader, data->data_value, MAX_DATA_VALUE, &data->data_value_len) &&
+           take_ext(reader);
+}
@@ -0,0 +1,118 @@
+#ifndef RSA_XDR_H
+#define RSA_XDR_H
+
+#include "rsa_token.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// XDR CODEC
+// =========
+// RFC 4506 encoding of the rsa_token.h types, laid out as Stellar's
+// schema lays them out so Stellar-style tooling and history archives can
+// read them: big-endian 32-bit units, opaque data padded with zeros to a
+// multiple of 4, variable arrays and strings length-prefixed, optionals as
+// a bool followed by the value, unions as an int32 discriminant.
+//
+//   AccountID          PublicKey: int32 0 (ED25519), then the 8 words as
+//                      uint256 (each word big-endian); asset issuers, which
+//                      hold account ids, encode the same way
+//   Asset              int32 type, then opaque code[4] or code[12] and issuer
+//   Price              int32 n, int32 d
+//   Memo               int32 type; string text<28>, uint64 id or Hash
+//   Transaction        source, uint32 fee, int64 seqNum, TimeBounds* (absent
+//                      when both bounds are 0), Memo, Operation ops<10>,
+//                      int32 ext 0
+//   Operation          AccountID* source, int32 type, then the body
+//   AccountEntry       accountID, int64 balance, int64 seqNum, uint32
+//                      numSubEntries, AccountID* inflationDest (absent when
+//                      0), uint32 flags, string homeDomain<32>, opaque
+//                      thresholds[4], Signer signers<20>, int32 ext 0
+//   TrustLineEntry     accountID, Asset, int64 balance, int64 limit, uint32
+//                      flags, int32 ext 0
+//   OfferEntry         sellerID, int64 offerID, selling, buying, int64 amount,
+//                      Price, uint32 flags, int32 ext 0
+//   DataEntry          accountID, string dataName<64>, opaque dataValue<64>,
+//                      int32 ext 0
+//   Signer             SignerKey (int32 0, opaque key[32]), uint32 weight
+//
+// Operation bodies follow Stellar's, with these mappings: the operation
+// source carries the allow_trust asset's issuer (Stellar takes it from the
+// source), and is present only when it differs from the transaction's
+// source; payment.from is always the transaction's source, so a payment
+// from any other account cannot be encoded; ALLOW_TRUST sends an AssetCode; MANAGE_DATA's
+// value is absent when empty; CREATE_PASSIVE_OFFER has no offer id.
+// SET_OPTIONS replaces thresholds, home domain and the whole signer set
+// here, so its body is opaque thresholds[4], string homeDomain<32>,
+// Signer signers<20> rather than Stellar's optional fields. Reserved
+// fields are not encoded and decode as 0.
+//
+// Each type has its own straight-line encoder over inline primitives: the
+// exact size is computed first and bounds-checked once, then fields are
+// stored without checks. Word arrays (account ids, issuers) are byte-
+// swapped 16 bytes at a time with SSE2/SSSE3 where available. Decoders
+// check lengths as they go and reject what the schema forbids (unknown
+// discriminants, over-long arrays, non-zero padding or ext).
+
+// Output buffer; a put that does not fit writes nothing and sets
+// `overflow`, which stays set
+typedef struct {
+    uint8_t *data;
+    size_t capacity;
+    size_t size;
+    bool overflow;
+} rsa_xdr_writer_t;
+
+// Input buffer; a malformed or truncated value sets `error`, which stays
+// set, and leaves `pos` undefined
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool error;
+} rsa_xdr_reader_t;
+
+void rsa_xdr_writer_init(rsa_xdr_writer_t *writer, uint8_t *data, size_t capacity);
+void rsa_xdr_reader_init(rsa_xdr_reader_t *reader, const uint8_t *data, size_t size);
+
+// Encoded sizes; 0 when the value cannot be encoded (a count or
+// discriminant out of range)
+size_t rsa_xdr_asset_size(const rsa_asset_t *asset);
+size_t rsa_xdr_transaction_size(const rsa_transaction_t *tx, const rsa_operation_t *operations);
+size_t rsa_xdr_account_size(const rsa_account_t *account);
+size_t rsa_xdr_trustline_size(const rsa_trustline_t *trustline);
+size_t rsa_xdr_offer_size(const rsa_offer_t *offer);
+size_t rsa_xdr_data_size(const rsa_data_t *data);
+
+// Encoders
+// --------
+
+bool rsa_xdr_put_asset(rsa_xdr_writer_t *writer, const rsa_asset_t *asset);
+// `operations` holds tx->operations_count
+bool rsa_xdr_put_transaction(rsa_xdr_writer_t *writer, const rsa_transaction_t *tx,
+                             const rsa_operation_t *operations);
+bool rsa_xdr_put_account(rsa_xdr_writer_t *writer, const rsa_account_t *account);
+bool rsa_xdr_put_trustline(rsa_xdr_writer_t *writer, const rsa_trustline_t *trustline);
+bool rsa_xdr_put_offer(rsa_xdr_writer_t *writer, const rsa_offer_t *offer);
+bool rsa_xdr_put_data(rsa_xdr_writer_t *writer, const rsa_data_t *data);
+
+// Decoders
+// --------
+// Outputs are zero-filled first, so decoding what was encoded reproduces
+// the struct byte for byte when it was zero-initialized.
+
+bool rsa_xdr_get_asset(rsa_xdr_reader_t *reader, rsa_asset_t *asset);
+bool rsa_xdr_get_transaction(rsa_xdr_reader_t *reader, rsa_transaction_t *tx,
+                             rsa_operation_t operations[RSA_MAX_OPERATIONS_PER_TX]);
+bool rsa_xdr_get_account(rsa_xdr_reader_t *reader, rsa_account_t *account);
+bool rsa_xdr_get_trustline(rsa_xdr_reader_t *reader, rsa_trustline_t *trustline);
+bool rsa_xdr_get_offer(rsa_xdr_reader_t *reader, rsa_offer_t *offer);
+bool rsa_xdr_get_data(rsa_xdr_reader_t *reader, rsa_data_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_XDR_H